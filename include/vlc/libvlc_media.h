@@ -141,6 +141,30 @@ typedef struct libvlc_media_stats_t
     int         i_sent_bytes;
     float       f_send_bitrate;
 } libvlc_media_stats_t;
+
+/** Number of buckets of libvlc_media_video_timing_t::i_late_pictures */
+#define LIBVLC_VIDEO_LATE_BUCKETS 10
+
+typedef struct libvlc_media_video_timing_t
+{
+    /* Displayed pictures by lateness: less than 1 ms late in the first
+     * bucket, less than 2^i ms late in the bucket i, later in the last one */
+    int         i_late_pictures[LIBVLC_VIDEO_LATE_BUCKETS];
+
+    /* Average and maximum durations of the rendering stages (microseconds) */
+    int64_t     i_filter_average;
+    int64_t     i_filter_max;
+    int64_t     i_spu_average;
+    int64_t     i_spu_max;
+    int64_t     i_prepare_average;
+    int64_t     i_prepare_max;
+    int64_t     i_display_average;
+    int64_t     i_display_max;
+
+    /* Decoded pictures waiting to be displayed */
+    float       f_queue_average;
+    int         i_queue_max;
+} libvlc_media_video_timing_t;
 /** @}*/
 
 typedef struct libvlc_media_track_info_t
@@ -394,6 +418,24 @@ LIBVLC_API libvlc_state_t libvlc_media_get_state(
 LIBVLC_API int libvlc_media_get_stats( libvlc_media_t *p_md,
                                            libvlc_media_stats_t *p_stats );
 
+/**
+ * Get the current video output timing statistics about the media
+ *
+ * They tell how late the pictures were displayed, how long each rendering
+ * stage (video filters, subpictures, preparation, display) took and how many
+ * decoded pictures were waiting.
+ *
+ * \param p_md: media descriptor object
+ * \param p_timing: structure that contain the timing statistics
+ *                  (this structure must be allocated by the caller)
+ * \return true if the statistics are available, false otherwise
+ * \version LibVLC 2.1.0 or later
+ *
+ * \libvlc_return_bool
+ */
+LIBVLC_API int libvlc_media_get_video_timing( libvlc_media_t *p_md,
+                                    libvlc_media_video_timing_t *p_timing );
+
 /**
  * Get subitems of media descriptor object. This will increment
  * the reference count of supplied media descriptor object. Use
@@ -514,6 +556,58 @@ LIBVLC_API
 int libvlc_media_get_tracks_info( libvlc_media_t *p_md,
                                   libvlc_media_track_info_t **tracks );
 
+/**
+ * A video thumbnail, see libvlc_media_get_thumbnails()
+ */
+typedef struct libvlc_media_thumbnail_t
+{
+    libvlc_time_t  i_time;   /**< time of the picture in the media, in ms */
+    unsigned       i_width;
+    unsigned       i_height;
+    unsigned       i_pitch;  /**< bytes per line */
+    unsigned char *p_pixels; /**< RGBA pixels, NULL if none was extracted */
+} libvlc_media_thumbnail_t;
+
+/**
+ * Get thumbnails of a media
+ *
+ * The media is opened and only the video keyframes the nearest to the
+ * requested times are decoded: the audio is not decoded and no video output
+ * is created. The pictures are scaled to fit in the requested size while
+ * keeping their aspect ratio; a dimension set to 0 is computed from the other
+ * one, and both set to 0 keep the video size.
+ *
+ * This function is synchronous and may take a while: do not call it from the
+ * thread of a libvlc event callback.
+ *
+ * \param p_md media descriptor object
+ * \param times times of the thumbnails in ms
+ * \param count number of times
+ * \param width maximum width of the thumbnails
+ * \param height maximum height of the thumbnails
+ * \param thumbnails address to store an allocated array of count thumbnails
+ *        (must be released with libvlc_media_thumbnails_release()) [OUT]
+ *
+ * \return 0 on success, -1 if the media has no decodable video
+ * \version LibVLC 2.1.0 or later
+ */
+LIBVLC_API
+int libvlc_media_get_thumbnails( libvlc_media_t *p_md,
+                                 const libvlc_time_t *times, unsigned count,
+                                 unsigned width, unsigned height,
+                                 libvlc_media_thumbnail_t **thumbnails );
+
+/**
+ * Release thumbnails returned by libvlc_media_get_thumbnails()
+ *
+ * \param thumbnails array of thumbnails
+ * \param count number of thumbnails in the array
+ * \version LibVLC 2.1.0 or later
+ */
+LIBVLC_API
+void libvlc_media_thumbnails_release( libvlc_media_thumbnail_t *thumbnails,
+                                      unsigned count );
+
 /** @}*/
 
 # ifdef __cplusplus
@@ -252,6 +252,43 @@ VLC_API int filter_Blend( filter_t *, picture_t *p_dst, int i_dst_x, int i_dst_y
  */
 VLC_API void filter_DeleteBlend( filter_t * );
 
+/**
+ * Callback processing one slice of some work split by filter_RunSlices().
+ */
+typedef void (*filter_slice_cb)( filter_t *, void *p_data,
+                                 unsigned i_slice, unsigned i_slices );
+
+/**
+ * It returns the number of slices a filter should split its work into to
+ * use all the video filter threads (see the "filter-threads" option).
+ */
+VLC_API unsigned filter_GetSlices( filter_t * );
+
+/**
+ * It calls pf_slice for every slice from 0 to i_slices - 1, in parallel on
+ * the shared video filter threads and on the calling thread, and returns
+ * once all of them are done.
+ *
+ * The slices must not depend on each other.
+ */
+VLC_API void filter_RunSlices( filter_t *, unsigned i_slices, filter_slice_cb pf_slice, void *p_data );
+
+/**
+ * It gives the lines [*pi_first, *pi_end) of a horizontal band of a plane
+ * of i_lines lines split into i_slices bands.
+ *
+ * The bands start on a multiple of i_align lines, and may be empty.
+ */
+static inline void filter_GetSliceLines( int i_lines, unsigned i_slice, unsigned i_slices,
+                                         int i_align, int *pi_first, int *pi_end )
+{
+    int i_step = (i_lines + i_slices - 1) / i_slices;
+    i_step = (i_step + i_align - 1) / i_align * i_align;
+
+    *pi_first = __MIN( i_lines, (int)i_slice * i_step );
+    *pi_end   = __MIN( i_lines, *pi_first + i_step );
+}
+
 /**
  * Create a picture_t *(*)( filter_t *, picture_t * ) compatible wrapper
  * using a void (*)( filter_t *, picture_t *, picture_t * ) function
@@ -137,8 +137,10 @@ VLC_API void httpd_RedirectDelete( httpd_redirect_t * );
 typedef struct httpd_stream_t httpd_stream_t;
 VLC_API httpd_stream_t * httpd_StreamNew( httpd_host_t *, const char *psz_url, const char *psz_mime, const char *psz_user, const char *psz_password ) VLC_USED;
 VLC_API void httpd_StreamDelete( httpd_stream_t * );
+VLC_API int httpd_StreamGetLag( httpd_stream_t *, int64_t **ppi_lag );
 VLC_API int httpd_StreamHeader( httpd_stream_t *, uint8_t *p_data, int i_data );
 VLC_API int httpd_StreamSend( httpd_stream_t *, uint8_t *p_data, int i_data );
+VLC_API int httpd_StreamSendBlock( httpd_stream_t *, block_t * );
 
 
 /* Msg functions facilities */
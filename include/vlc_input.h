@@ -517,6 +517,9 @@ enum input_query_e
     /* External clock managments */
     INPUT_GET_PCR_SYSTEM,   /* arg1=mtime_t *, arg2=mtime_t *       res=can fail */
     INPUT_MODIFY_PCR_SYSTEM,/* arg1=int absolute, arg2=mtime_t      res=can fail */
+
+    /* Statistics */
+    INPUT_ADD_LOST_PACKETS, /* arg1=unsigned                        res=cannot fail */
 };
 
 /** @}*/
@@ -538,6 +541,9 @@ VLC_API void input_Stop( input_thread_t *, bool b_abort );
 VLC_API int input_Read( vlc_object_t *, input_item_t * );
 #define input_Read(a,b) input_Read(VLC_OBJECT(a),b)
 
+VLC_API int input_GetThumbnails( vlc_object_t *, input_item_t *, const mtime_t *, unsigned, const video_format_t *, picture_t ** );
+#define input_GetThumbnails(a,b,c,d,e,f) input_GetThumbnails(VLC_OBJECT(a),b,c,d,e,f)
+
 VLC_API int input_vaControl( input_thread_t *, int i_query, va_list  );
 
 VLC_API int input_Control( input_thread_t *, int i_query, ...  );
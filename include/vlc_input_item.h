@@ -280,6 +280,56 @@ VLC_API void input_item_Release(input_item_t *);
 /******************
  * Input stats
  ******************/
+
+/* Number of buckets of the late pictures histogram */
+#define VOUT_TIMING_LATE_BUCKETS 10
+
+/* Stages of the video output rendering */
+enum vout_timing_stage_e
+{
+    VOUT_TIMING_FILTER,     /* Video filter chains */
+    VOUT_TIMING_SPU,        /* Subpicture rendering */
+    VOUT_TIMING_PREPARE,    /* Copies, blending and display preparation */
+    VOUT_TIMING_DISPLAY,    /* Display */
+    VOUT_TIMING_STAGES
+};
+
+typedef struct vout_timing_t
+{
+    /* Displayed pictures by lateness against their date: the first bucket
+     * counts the ones less than 1 ms late, the bucket i the ones less than
+     * 2^i ms late, and the last one all the later ones. */
+    uint64_t late[VOUT_TIMING_LATE_BUCKETS];
+
+    /* Number of runs, total and maximum durations of each stage */
+    struct
+    {
+        uint64_t count;
+        mtime_t  total;
+        mtime_t  max;
+    } stage[VOUT_TIMING_STAGES];
+
+    /* Decoded pictures waiting in the vout, sampled on each display */
+    uint64_t queue_total;
+    unsigned queue_max;
+} vout_timing_t;
+
+static inline void vout_timing_Merge( vout_timing_t *p_dst,
+                                      const vout_timing_t *p_src )
+{
+    for( unsigned i = 0; i < VOUT_TIMING_LATE_BUCKETS; i++ )
+        p_dst->late[i] += p_src->late[i];
+    for( unsigned i = 0; i < VOUT_TIMING_STAGES; i++ )
+    {
+        p_dst->stage[i].count += p_src->stage[i].count;
+        p_dst->stage[i].total += p_src->stage[i].total;
+        p_dst->stage[i].max = __MAX( p_dst->stage[i].max,
+                                     p_src->stage[i].max );
+    }
+    p_dst->queue_total += p_src->queue_total;
+    p_dst->queue_max = __MAX( p_dst->queue_max, p_src->queue_max );
+}
+
 struct input_stats_t
 {
     vlc_mutex_t         lock;
@@ -289,6 +339,7 @@ struct input_stats_t
     int64_t i_read_bytes;
     float f_input_bitrate;
     float f_average_input_bitrate;
+    int64_t i_lost_packets; /* dropped before they could be read */
 
     /* Demux */
     int64_t i_demux_read_packets;
@@ -305,6 +356,7 @@ struct input_stats_t
     /* Vout */
     int64_t i_displayed_pictures;
     int64_t i_lost_pictures;
+    vout_timing_t vout_timing;
 
     /* Sout */
     int64_t i_sent_packets;
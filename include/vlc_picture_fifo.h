@@ -66,6 +66,11 @@ VLC_API picture_t * picture_fifo_Pop( picture_fifo_t * ) VLC_USED;
  */
 VLC_API picture_t * picture_fifo_Peek( picture_fifo_t * ) VLC_USED;
 
+/**
+ * It returns the number of pictures inside the fifo.
+ */
+VLC_API unsigned picture_fifo_Count( picture_fifo_t * ) VLC_USED;
+
 /**
  * It saves a picture_t into the fifo.
  */
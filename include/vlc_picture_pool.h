@@ -121,6 +121,16 @@ VLC_API picture_pool_t * picture_pool_Reserve(picture_pool_t *, int picture_coun
  */
 VLC_API int picture_pool_GetSize(picture_pool_t *);
 
+/**
+ * It returns the occupancy statistics of the given pool.
+ *
+ * used is the number of pictures currently obtained from the pool, peak
+ * the highest value it ever reached and starved the number of
+ * picture_pool_Get calls that failed because all pictures were in use.
+ * Any of the pointers may be NULL.
+ */
+VLC_API void picture_pool_GetStats(picture_pool_t *, unsigned *used, unsigned *peak, unsigned *starved);
+
 
 #endif /* VLC_PICTURE_POOL_H */
 
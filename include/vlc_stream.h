@@ -111,8 +111,27 @@ enum stream_query_e
 
     /* XXX only data read through stream_Read/Block will be recorded */
     STREAM_SET_RECORD_STATE,     /**< arg1=bool, arg2=const char *psz_ext (if arg1 is true)  res=can fail */
+
+    STREAM_GET_STATS,           /**< arg1= stream_stats_t *  res=can fail */
+    STREAM_GET_FILL_LEVEL,      /**< arg1= uint64_t *buffered, arg2= uint64_t *size res=can fail */
 };
 
+/**
+ * Cache statistics of a stream, see STREAM_GET_STATS.
+ *
+ * A request (read, peek or seek) is a hit when it was served without
+ * reading from the access.
+ */
+typedef struct
+{
+    uint64_t i_hits;        /**< Requests served from the cache */
+    uint64_t i_misses;      /**< Requests that had to read from the access */
+    uint64_t i_read;        /**< Bytes read from the access */
+    uint64_t i_consumed;    /**< Bytes read or skipped by the stream user */
+    unsigned i_seek;        /**< Seeks done on the access */
+    unsigned i_read_ahead;  /**< Current read-ahead size (0 if not adaptive) */
+} stream_stats_t;
+
 VLC_API int stream_Read( stream_t *s, void *p_read, int i_read );
 VLC_API int stream_Peek( stream_t *s, const uint8_t **pp_peek, int i_peek );
 VLC_API int stream_vaControl( stream_t *s, int i_query, va_list args );
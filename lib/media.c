@@ -35,6 +35,7 @@
 #include <vlc_common.h>
 #include <vlc_input.h>
 #include <vlc_meta.h>
+#include <vlc_picture.h>
 #include <vlc_playlist.h> /* For the preparser */
 #include <vlc_url.h>
 
@@ -557,6 +558,47 @@ int libvlc_media_get_stats( libvlc_media_t *p_md,
     return true;
 }
 
+/**************************************************************************
+ * Get the video output timing statistics
+ **************************************************************************/
+#if LIBVLC_VIDEO_LATE_BUCKETS != VOUT_TIMING_LATE_BUCKETS
+# error The late pictures histograms do not match
+#endif
+
+int libvlc_media_get_video_timing( libvlc_media_t *p_md,
+                                   libvlc_media_video_timing_t *p_timing )
+{
+    if( !p_md->p_input_item )
+        return false;
+
+    input_stats_t *p_itm_stats = p_md->p_input_item->p_stats;
+    vlc_mutex_lock( &p_itm_stats->lock );
+    const vout_timing_t *p_vt = &p_itm_stats->vout_timing;
+
+    uint64_t i_displayed = 0;
+    for( unsigned i = 0; i < LIBVLC_VIDEO_LATE_BUCKETS; i++ )
+    {
+        p_timing->i_late_pictures[i] = p_vt->late[i];
+        i_displayed += p_vt->late[i];
+    }
+
+#define STAGE( name, s ) \
+    p_timing->i_##name##_average = p_vt->stage[s].count > 0 ? \
+        p_vt->stage[s].total / p_vt->stage[s].count : 0; \
+    p_timing->i_##name##_max = p_vt->stage[s].max;
+    STAGE( filter, VOUT_TIMING_FILTER )
+    STAGE( spu, VOUT_TIMING_SPU )
+    STAGE( prepare, VOUT_TIMING_PREPARE )
+    STAGE( display, VOUT_TIMING_DISPLAY )
+#undef STAGE
+
+    p_timing->f_queue_average = i_displayed > 0 ?
+        (float)p_vt->queue_total / i_displayed : 0.f;
+    p_timing->i_queue_max = p_vt->queue_max;
+    vlc_mutex_unlock( &p_itm_stats->lock );
+    return true;
+}
+
 /**************************************************************************
  * event_manager
  **************************************************************************/
@@ -734,3 +776,90 @@ libvlc_media_get_tracks_info( libvlc_media_t *p_md, libvlc_media_track_info_t **
     vlc_mutex_unlock( &p_input_item->lock );
     return i_es;
 }
+
+/**************************************************************************
+ * Get thumbnails of the video keyframes
+ **************************************************************************/
+int
+libvlc_media_get_thumbnails( libvlc_media_t *p_md,
+                             const libvlc_time_t *pi_times, unsigned i_count,
+                             unsigned i_width, unsigned i_height,
+                             libvlc_media_thumbnail_t **pp_thumbnails )
+{
+    assert( p_md );
+
+    libvlc_media_thumbnail_t *p_thumbnails =
+        calloc( i_count ? i_count : 1, sizeof( *p_thumbnails ) );
+    mtime_t *pi_dates = malloc( (i_count ? i_count : 1) * sizeof( *pi_dates ) );
+    picture_t **pp_pictures =
+        malloc( (i_count ? i_count : 1) * sizeof( *pp_pictures ) );
+    if( !p_thumbnails || !pi_dates || !pp_pictures )
+    {
+        free( p_thumbnails );
+        free( pi_dates );
+        free( pp_pictures );
+        libvlc_printerr( "Not enough memory" );
+        return -1;
+    }
+
+    for( unsigned i = 0; i < i_count; i++ )
+        pi_dates[i] = pi_times[i] * 1000;
+
+    video_format_t fmt;
+    video_format_Init( &fmt, VLC_CODEC_RGBA );
+    fmt.i_width = i_width;
+    fmt.i_height = i_height;
+
+    libvlc_int_t *p_libvlc = p_md->p_libvlc_instance->p_libvlc_int;
+    if( input_GetThumbnails( p_libvlc, p_md->p_input_item, pi_dates, i_count,
+                             &fmt, pp_pictures ) )
+    {
+        free( p_thumbnails );
+        free( pi_dates );
+        free( pp_pictures );
+        libvlc_printerr( "Cannot decode the video of the media" );
+        return -1;
+    }
+
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        libvlc_media_thumbnail_t *p_thumb = &p_thumbnails[i];
+        picture_t *p_pic = pp_pictures[i];
+
+        p_thumb->i_time = pi_times[i];
+        if( p_pic == NULL )
+            continue;
+
+        const plane_t *p_plane = &p_pic->p[0];
+        p_thumb->i_width = p_pic->format.i_visible_width;
+        p_thumb->i_height = p_pic->format.i_visible_height;
+        p_thumb->i_pitch = p_plane->i_visible_pitch;
+        p_thumb->p_pixels = malloc( p_thumb->i_pitch * p_thumb->i_height );
+        if( p_thumb->p_pixels )
+        {
+            p_thumb->i_time = p_pic->date / 1000;
+            for( unsigned y = 0; y < p_thumb->i_height; y++ )
+                memcpy( &p_thumb->p_pixels[y * p_thumb->i_pitch],
+                        &p_plane->p_pixels[y * p_plane->i_pitch],
+                        p_thumb->i_pitch );
+        }
+        picture_Release( p_pic );
+    }
+
+    free( pi_dates );
+    free( pp_pictures );
+    *pp_thumbnails = p_thumbnails;
+    return 0;
+}
+
+/**************************************************************************
+ * Release the thumbnails
+ **************************************************************************/
+void
+libvlc_media_thumbnails_release( libvlc_media_thumbnail_t *p_thumbnails,
+                                 unsigned i_count )
+{
+    for( unsigned i = 0; i < i_count; i++ )
+        free( p_thumbnails[i].p_pixels );
+    free( p_thumbnails );
+}
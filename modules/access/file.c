@@ -52,6 +52,9 @@
 #   include <unistd.h>
 #endif
 #include <dirent.h>
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include "fs.h"
@@ -72,6 +75,7 @@ struct access_sys_t
 
     /* */
     bool b_pace_control;
+    size_t i_map_size; /* Memory mapping window size (or 0 if unused) */
 };
 
 #if !defined (WIN32) && !defined (__OS2__)
@@ -129,8 +133,14 @@ static bool IsRemote (const char *path)
 #ifndef HAVE_POSIX_FADVISE
 # define posix_fadvise(fd, off, len, adv)
 #endif
+#ifndef HAVE_POSIX_MADVISE
+# define posix_madvise(addr, len, adv)
+#endif
 
 static ssize_t FileRead (access_t *, uint8_t *, size_t);
+#ifdef HAVE_MMAP
+static block_t *FileBlock (access_t *);
+#endif
 static int FileSeek (access_t *, uint64_t);
 static ssize_t StreamRead (access_t *, uint8_t *, size_t);
 static int NoSeek (access_t *, uint64_t);
@@ -224,6 +234,7 @@ int FileOpen( vlc_object_t *p_this )
     p_access->p_sys = p_sys;
     p_sys->i_nb_reads = 0;
     p_sys->fd = fd;
+    p_sys->i_map_size = 0;
 
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
@@ -232,6 +243,27 @@ int FileOpen( vlc_object_t *p_this )
         p_access->info.i_size = st.st_size;
         p_sys->b_pace_control = true;
 
+#ifdef HAVE_MMAP
+        /* Mapping a file that gets truncated would crash with SIGBUS, and
+         * network file systems are even more prone to that. */
+        if (S_ISREG (st.st_mode) && var_InheritBool (p_access, "file-mmap")
+         && !IsRemote (fd, p_access->psz_filepath))
+        {
+            long pagesize = sysconf (_SC_PAGESIZE);
+            size_t window = var_InheritInteger (p_access, "file-mmap-size");
+
+            window = (window << 10) & ~(size_t)(pagesize - 1);
+            if (window > 0)
+            {
+                msg_Dbg (p_access, "using %zu KiB memory mapping window",
+                         window >> 10);
+                p_access->pf_read = NULL;
+                p_access->pf_block = FileBlock;
+                p_sys->i_map_size = window;
+            }
+        }
+#endif
+
         /* Demuxers will need the beginning of the file for probing. */
         posix_fadvise (fd, 0, 4096, POSIX_FADV_WILLNEED);
         /* In most cases, we only read the file once. */
@@ -268,8 +300,8 @@ void FileClose (vlc_object_t * p_this)
 {
     access_t     *p_access = (access_t*)p_this;
 
-    if (p_access->pf_read == NULL)
-    {
+    if (p_access->pf_seek == NULL)
+    {   /* Only the directory reader cannot seek */
         DirClose (p_this);
         return;
     }
@@ -328,6 +360,72 @@ static ssize_t FileRead (access_t *p_access, uint8_t *p_buffer, size_t i_len)
 }
 
 
+#ifdef HAVE_MMAP
+/**
+ * Maps the next window of a regular file.
+ *
+ * Each block is a private mapping, so that demuxers and decoders can use
+ * the data in place (it is copied on write by the kernel). The stream layer
+ * can also hand out slices of it without copying (see block_shared_Slice()).
+ */
+static block_t *FileBlock (access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    uint64_t pos = p_access->info.i_pos;
+    struct stat st;
+
+    if (pos >= p_access->info.i_size)
+    {   /* The file may be growing */
+        if (fstat (p_sys->fd, &st) == 0
+         && p_access->info.i_size != (uint64_t)st.st_size)
+        {
+            p_access->info.i_size = st.st_size;
+            p_access->info.i_update |= INPUT_UPDATE_SIZE;
+        }
+        if (pos >= p_access->info.i_size)
+        {
+            p_access->info.b_eof = true;
+            return NULL;
+        }
+    }
+
+    /* Align the mapping on the window size, as mmap() requires page
+     * alignment and this keeps successive mappings contiguous. */
+    uint64_t offset = pos - (pos % p_sys->i_map_size);
+    size_t length = p_sys->i_map_size;
+    if (offset + length > p_access->info.i_size)
+        length = p_access->info.i_size - offset;
+
+    void *addr = mmap (NULL, length, PROT_READ|PROT_WRITE, MAP_PRIVATE,
+                       p_sys->fd, offset);
+    if (addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "memory mapping failed (%m)");
+        dialog_Fatal (p_access, _("File reading failed"),
+                      _("VLC could not read the file (%m)."));
+        p_access->info.b_eof = true;
+        return NULL;
+    }
+
+    /* Ask the kernel to fetch this window and the next one. */
+    posix_madvise (addr, length, POSIX_MADV_SEQUENTIAL);
+    posix_madvise (addr, length, POSIX_MADV_WILLNEED);
+    if (offset + length < p_access->info.i_size)
+        posix_fadvise (p_sys->fd, offset + length, p_sys->i_map_size,
+                       POSIX_FADV_WILLNEED);
+
+    block_t *block = block_mmap_Alloc (addr, length);
+    if (block == NULL)
+        return NULL;
+
+    block->p_buffer += pos - offset;
+    block->i_buffer -= pos - offset;
+    p_access->info.i_pos = offset + length;
+    p_sys->i_nb_reads++;
+    return block_shared_Alloc (block);
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
@@ -58,6 +58,15 @@ static const char *const psz_sort_list_text[] = {
 #define SORT_LONGTEXT N_( \
     "Define the sort algorithm used when adding items from a directory." )
 
+#define MMAP_TEXT N_("Use file memory mapping")
+#define MMAP_LONGTEXT N_( \
+    "Map local files in memory instead of reading them. This saves a " \
+    "memory copy, but VLC may crash if the file is truncated while in use." )
+
+#define MMAP_SIZE_TEXT N_("Memory mapping window (KiB)")
+#define MMAP_SIZE_LONGTEXT N_( \
+    "Size of the part of the file that is mapped at a time." )
+
 vlc_module_begin ()
     set_description( N_("File input") )
     set_shortname( N_("File") )
@@ -67,6 +76,12 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+#ifdef HAVE_MMAP
+    add_bool( "file-mmap", false, MMAP_TEXT, MMAP_LONGTEXT, true )
+    add_integer( "file-mmap-size", 4096, MMAP_SIZE_TEXT,
+                 MMAP_SIZE_LONGTEXT, true )
+        change_integer_range( 64, 1 << 20 )
+#endif
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
@@ -28,7 +28,9 @@
 #include <vlc_demux.h>
 #include <vlc_block.h>
 #include <vlc_network.h>
+#include <vlc_input.h>
 
+#include <errno.h>
 #include <limits.h>
 #include <unistd.h>
 #ifdef HAVE_POLL
@@ -79,6 +81,104 @@ drop:
     block_Release (block);
 }
 
+#ifdef HAVE_RECVMMSG
+/* Largest number of datagrams received at once */
+# define RTP_BATCH 16
+
+/**
+ * Reports the datagrams dropped by the kernel since the last report.
+ */
+static void rtp_check_drops (demux_t *demux, const struct msghdr *hdr)
+{
+# ifdef SO_RXQ_OVFL
+    demux_sys_t *sys = demux->p_sys;
+
+    for (const struct cmsghdr *cmsg = CMSG_FIRSTHDR (hdr); cmsg != NULL;
+         cmsg = CMSG_NXTHDR ((struct msghdr *)hdr, (struct cmsghdr *)cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_RXQ_OVFL)
+            continue;
+
+        uint32_t dropped;
+        memcpy (&dropped, CMSG_DATA (cmsg), sizeof (dropped));
+        if (dropped == sys->rxq_dropped)
+            continue;
+
+        unsigned lost = dropped - sys->rxq_dropped;
+        sys->rxq_dropped = dropped;
+        msg_Dbg (demux, "%u RTP packet(s) dropped by the kernel", lost);
+        if (demux->p_input != NULL)
+            input_Control (demux->p_input, INPUT_ADD_LOST_PACKETS, lost);
+    }
+# else
+    (void) demux; (void) hdr;
+# endif
+}
+
+/**
+ * Receives the pending datagrams with a single system call,
+ * into buffers kept from call to call. Each datagram is then copied into a
+ * block of its own size, so the large buffers are not held by the queue.
+ * @return -1 if out of memory, 0 otherwise.
+ */
+static int rtp_recv_batch (demux_t *demux, int fd, block_t **blocks)
+{
+    struct mmsghdr msg[RTP_BATCH];
+    struct iovec iov[RTP_BATCH];
+    union
+    {
+        char           buf[CMSG_SPACE (sizeof (uint32_t))];
+        struct cmsghdr align;
+    } ctrl[RTP_BATCH];
+
+    for (unsigned i = 0; i < RTP_BATCH; i++)
+    {
+        if (blocks[i] == NULL)
+        {
+            blocks[i] = block_Alloc (0xffff); /* TODO: p_sys->mru */
+            if (unlikely(blocks[i] == NULL))
+                return -1;
+        }
+        iov[i].iov_base = blocks[i]->p_buffer;
+        iov[i].iov_len = blocks[i]->i_buffer;
+        memset (&msg[i].msg_hdr, 0, sizeof (msg[i].msg_hdr));
+        msg[i].msg_hdr.msg_iov = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+        msg[i].msg_hdr.msg_control = ctrl[i].buf;
+        msg[i].msg_hdr.msg_controllen = sizeof (ctrl[i].buf);
+    }
+
+    int n = recvmmsg (fd, msg, RTP_BATCH, MSG_DONTWAIT, NULL);
+    if (n == -1)
+    {
+        if (errno != EAGAIN && errno != EINTR)
+            msg_Warn (demux, "RTP network error: %m");
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        rtp_check_drops (demux, &msg[i].msg_hdr);
+
+        block_t *block = block_Alloc (msg[i].msg_len);
+        if (unlikely(block == NULL))
+            return -1;
+        memcpy (block->p_buffer, blocks[i]->p_buffer, msg[i].msg_len);
+        rtp_process (demux, block);
+    }
+    return 0;
+}
+
+static void rtp_release_blocks (void *data)
+{
+    block_t **blocks = data;
+
+    for (unsigned i = 0; i < RTP_BATCH; i++)
+        if (blocks[i] != NULL)
+            block_Release (blocks[i]);
+}
+#endif
+
 static int rtp_timeout (mtime_t deadline)
 {
     if (deadline == VLC_TS_INVALID)
@@ -108,6 +208,10 @@ void *rtp_dgram_thread (void *opaque)
     ufd[0].fd = rtp_fd;
     ufd[0].events = POLLIN;
 
+#ifdef HAVE_RECVMMSG
+    block_t *blocks[RTP_BATCH] = { NULL };
+    vlc_cleanup_push (rtp_release_blocks, blocks);
+#endif
     for (;;)
     {
         int n = poll (ufd, 1, rtp_timeout (deadline));
@@ -124,6 +228,10 @@ void *rtp_dgram_thread (void *opaque)
             if (unlikely(ufd[0].revents & POLLHUP))
                 break; /* RTP socket dead (DCCP only) */
 
+#ifdef HAVE_RECVMMSG
+            if (unlikely(rtp_recv_batch (demux, rtp_fd, blocks)))
+                break; /* we are totallly screwed */
+#else
             block_t *block = block_Alloc (0xffff); /* TODO: p_sys->mru */
             if (unlikely(block == NULL))
                 break; /* we are totallly screwed */
@@ -139,6 +247,7 @@ void *rtp_dgram_thread (void *opaque)
                 msg_Warn (demux, "RTP network error: %m");
                 block_Release (block);
             }
+#endif
         }
 
     dequeue:
@@ -146,6 +255,9 @@ void *rtp_dgram_thread (void *opaque)
             deadline = VLC_TS_INVALID;
         vlc_restorecancel (canc);
     }
+#ifdef HAVE_RECVMMSG
+    vlc_cleanup_run ();
+#endif
     return NULL;
 }
 
@@ -243,6 +243,11 @@ static int Open (vlc_object_t *obj)
     if (fd == -1)
         return VLC_EGENERIC;
     net_SetCSCov (fd, -1, 12);
+#ifdef SO_RXQ_OVFL
+    /* Count datagrams dropped by the kernel (see rtp_dgram_thread()) */
+    if (tp != IPPROTO_TCP)
+        setsockopt (fd, SOL_SOCKET, SO_RXQ_OVFL, &(int){ 1 }, sizeof (int));
+#endif
 
     /* Initializes demux */
     demux_sys_t *p_sys = malloc (sizeof (*p_sys));
@@ -260,6 +265,7 @@ static int Open (vlc_object_t *obj)
 #endif
     p_sys->fd           = fd;
     p_sys->rtcp_fd      = rtcp_fd;
+    p_sys->rxq_dropped  = 0;
     p_sys->max_src      = var_CreateGetInteger (obj, "rtp-max-src");
     p_sys->timeout      = var_CreateGetInteger (obj, "rtp-timeout")
                         * CLOCK_FREQ;
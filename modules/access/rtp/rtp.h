@@ -69,6 +69,7 @@ struct demux_sys_t
     int           fd;
     int           rtcp_fd;
     vlc_thread_t  thread;
+    uint32_t      rxq_dropped; /**< Last kernel drop count */
 
     mtime_t       timeout;
     uint16_t      max_dropout; /**< Max packet forward misordering */
@@ -39,8 +39,14 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_access.h>
+#include <vlc_input.h>
 #include <vlc_network.h>
 
+#include <errno.h>
+#ifdef HAVE_POLL
+# include <poll.h>
+#endif
+
 #define MTU 65535
 
 /*****************************************************************************
@@ -49,6 +55,11 @@
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
+#define BATCH_TEXT N_("Datagrams per read")
+#define BATCH_LONGTEXT N_( \
+    "Largest number of datagrams received with a single system call, " \
+    "if supported. Higher values help to keep up with high bit rates." )
+
 vlc_module_begin ()
     set_shortname( N_("UDP" ) )
     set_description( N_("UDP input") )
@@ -56,6 +67,8 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_INPUT_ACCESS )
 
     add_obsolete_integer( "server-port" ) /* since 2.0.0 */
+    add_integer( "udp-batch", 16, BATCH_TEXT, BATCH_LONGTEXT, true )
+        change_integer_range( 1, 1024 )
 
     set_capability( "access", 0 )
     add_shortcut( "udp", "udpstream", "udp4", "udp6" )
@@ -69,6 +82,16 @@ vlc_module_end ()
 static block_t *BlockUDP( access_t * );
 static int Control( access_t *, int, va_list );
 
+struct access_sys_t
+{
+    int       fd;
+#ifdef HAVE_RECVMMSG
+    unsigned  i_batch;
+    block_t **pp_blocks; /* receive buffers, kept from call to call */
+    uint32_t  i_dropped; /* last kernel drop count (SO_RXQ_OVFL) */
+#endif
+};
+
 /*****************************************************************************
  * Open: open the socket
  *****************************************************************************/
@@ -136,7 +159,29 @@ static int Open( vlc_object_t *p_this )
         msg_Err( p_access, "cannot open socket" );
         return VLC_EGENERIC;
     }
-    p_access->p_sys = (void *)(intptr_t)fd;
+
+    access_sys_t *p_sys = malloc( sizeof( *p_sys ) );
+    if( unlikely(p_sys == NULL) )
+    {
+        net_Close( fd );
+        return VLC_ENOMEM;
+    }
+    p_sys->fd = fd;
+#ifdef HAVE_RECVMMSG
+    p_sys->i_batch = var_InheritInteger( p_access, "udp-batch" );
+    p_sys->pp_blocks = calloc( p_sys->i_batch, sizeof( block_t * ) );
+    p_sys->i_dropped = 0;
+    if( unlikely(p_sys->pp_blocks == NULL) )
+    {
+        net_Close( fd );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+# ifdef SO_RXQ_OVFL
+    setsockopt( fd, SOL_SOCKET, SO_RXQ_OVFL, &(int){ 1 }, sizeof (int) );
+# endif
+#endif
+    p_access->p_sys = p_sys;
 
     return VLC_SUCCESS;
 }
@@ -147,8 +192,16 @@ static int Open( vlc_object_t *p_this )
 static void Close( vlc_object_t *p_this )
 {
     access_t     *p_access = (access_t*)p_this;
+    access_sys_t *p_sys = p_access->p_sys;
 
-    net_Close( (intptr_t)p_access->p_sys );
+#ifdef HAVE_RECVMMSG
+    for( unsigned i = 0; i < p_sys->i_batch; i++ )
+        if( p_sys->pp_blocks[i] != NULL )
+            block_Release( p_sys->pp_blocks[i] );
+    free( p_sys->pp_blocks );
+#endif
+    net_Close( p_sys->fd );
+    free( p_sys );
 }
 
 /*****************************************************************************
@@ -196,6 +249,107 @@ static int Control( access_t *p_access, int i_query, va_list args )
 /*****************************************************************************
  * BlockUDP:
  *****************************************************************************/
+#ifdef HAVE_RECVMMSG
+/* Reports the datagrams the kernel dropped since the previous report */
+static void CheckDrops( access_t *p_access, const struct msghdr *hdr )
+{
+# ifdef SO_RXQ_OVFL
+    access_sys_t *p_sys = p_access->p_sys;
+
+    for( const struct cmsghdr *cmsg = CMSG_FIRSTHDR( hdr ); cmsg != NULL;
+         cmsg = CMSG_NXTHDR( (struct msghdr *)hdr, (struct cmsghdr *)cmsg ) )
+    {
+        if( cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_RXQ_OVFL )
+            continue;
+
+        uint32_t i_dropped;
+        memcpy( &i_dropped, CMSG_DATA( cmsg ), sizeof( i_dropped ) );
+        if( i_dropped == p_sys->i_dropped )
+            continue;
+
+        unsigned i_lost = i_dropped - p_sys->i_dropped;
+        p_sys->i_dropped = i_dropped;
+        msg_Dbg( p_access, "%u datagram(s) dropped by the kernel", i_lost );
+        if( p_access->p_input != NULL )
+            input_Control( p_access->p_input, INPUT_ADD_LOST_PACKETS, i_lost );
+    }
+# else
+    (void) p_access; (void) hdr;
+# endif
+}
+
+/* Receives all pending datagrams (up to the batch size) at once, as a chain
+ * of blocks. The datagrams are copied out of the receive buffers into blocks
+ * of their own size, as the MTU-sized buffers would otherwise stay attached
+ * to the data. */
+static block_t *BlockUDP( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    const unsigned n = p_sys->i_batch;
+    struct mmsghdr msg[n];
+    struct iovec iov[n];
+    union
+    {
+        char           buf[CMSG_SPACE(sizeof (uint32_t))];
+        struct cmsghdr align;
+    } ctrl[n];
+
+    if( p_access->info.b_eof )
+        return NULL;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        if( p_sys->pp_blocks[i] == NULL )
+        {
+            p_sys->pp_blocks[i] = block_Alloc( MTU );
+            if( unlikely(p_sys->pp_blocks[i] == NULL) )
+                return NULL;
+        }
+        iov[i].iov_base = p_sys->pp_blocks[i]->p_buffer;
+        iov[i].iov_len = MTU;
+        memset( &msg[i].msg_hdr, 0, sizeof( msg[i].msg_hdr ) );
+        msg[i].msg_hdr.msg_iov = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+        msg[i].msg_hdr.msg_control = ctrl[i].buf;
+        msg[i].msg_hdr.msg_controllen = sizeof( ctrl[i].buf );
+    }
+
+    /* Wait for data. On timeout, the stream calls again after checking
+     * whether the access is being killed. */
+    struct pollfd ufd = { .fd = p_sys->fd, .events = POLLIN };
+    if( poll( &ufd, 1, 50 ) <= 0 )
+        return NULL;
+
+    /* Take the first datagram and the others already pending, each with its
+     * control data */
+    int val = recvmmsg( p_sys->fd, msg, n, MSG_DONTWAIT, NULL );
+    if( val < 0 )
+    {
+        if( errno != EAGAIN && errno != EINTR )
+            msg_Err( p_access, "receive error: %m" );
+        return NULL;
+    }
+
+    block_t *p_chain = NULL;
+    block_t **pp_last = &p_chain;
+
+    for( int i = 0; i < val; i++ )
+    {
+        CheckDrops( p_access, &msg[i].msg_hdr );
+        if( msg[i].msg_len == 0 )
+            continue;
+
+        block_t *p_block = block_Alloc( msg[i].msg_len );
+        if( unlikely(p_block == NULL) )
+            break;
+        memcpy( p_block->p_buffer, p_sys->pp_blocks[i]->p_buffer,
+                msg[i].msg_len );
+        *pp_last = p_block;
+        pp_last = &p_block->p_next;
+    }
+    return p_chain;
+}
+#else
 static block_t *BlockUDP( access_t *p_access )
 {
     access_sys_t *p_sys = p_access->p_sys;
@@ -207,7 +361,7 @@ static block_t *BlockUDP( access_t *p_access )
 
     /* Read data */
     p_block = block_Alloc( MTU );
-    len = net_Read( p_access, (intptr_t)p_sys, NULL,
+    len = net_Read( p_access, p_sys->fd, NULL,
                     p_block->p_buffer, MTU, false );
     if( len < 0 )
     {
@@ -217,3 +371,4 @@ static block_t *BlockUDP( access_t *p_access )
 
     return block_Realloc( p_block, 0, len );
 }
+#endif
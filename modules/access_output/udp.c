@@ -34,6 +34,7 @@
 
 #include <sys/types.h>
 #include <assert.h>
+#include <errno.h>
 
 #include <vlc_sout.h>
 #include <vlc_block.h>
@@ -48,10 +49,16 @@
 #else
 #   include <sys/socket.h>
 #endif
+#ifdef HAVE_SENDMMSG
+#   include <netinet/in.h>
+#   include <netinet/udp.h>
+#endif
 
 #include <vlc_network.h>
 
 #define MAX_EMPTY_BLOCKS 200
+/* Largest number of datagrams in one GSO super-datagram */
+#define MAX_GSO_SEGMENTS 64
 
 /*****************************************************************************
  * Module descriptor
@@ -73,6 +80,12 @@ static void Close( vlc_object_t * );
                           "helps reducing the scheduling load on " \
                           "heavily-loaded systems." )
 
+#define BATCH_TEXT N_("Batch packets")
+#define BATCH_LONGTEXT N_("Packets of a same group (see the grouping " \
+                          "option), or already late, can be sent with " \
+                          "a single system call. This is the largest " \
+                          "number of packets sent at once (0 disables)." )
+
 vlc_module_begin ()
     set_description( N_("UDP stream output") )
     set_shortname( "UDP" )
@@ -81,6 +94,9 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000, CACHING_TEXT, CACHING_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "group", 1, GROUP_TEXT, GROUP_LONGTEXT,
                                  true )
+    add_integer( SOUT_CFG_PREFIX "batch", 0, BATCH_TEXT, BATCH_LONGTEXT,
+                                 true )
+        change_integer_range( 0, 1024 )
 
     set_capability( "sout access", 0 )
     add_shortcut( "udp" )
@@ -94,6 +110,7 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "caching",
     "group",
+    "batch",
     NULL
 };
 
@@ -111,6 +128,7 @@ static int Control( sout_access_out_t *, int, va_list );
 
 static void* ThreadWrite( void * );
 static block_t *NewUDPPacket( sout_access_out_t *, mtime_t );
+static void SendPackets( sout_access_out_t *, block_t **, unsigned );
 
 struct sout_access_out_sys_t
 {
@@ -123,6 +141,11 @@ struct sout_access_out_sys_t
     block_fifo_t *p_empty_blocks;
     block_t      *p_buffer;
 
+    unsigned      i_batch;
+    bool          b_gso;
+    uint64_t      i_datagrams; /* sent datagrams... */
+    uint64_t      i_syscalls;  /* ...and system calls used to send them */
+
     vlc_thread_t  thread;
 };
 
@@ -212,10 +235,33 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_handle = i_handle;
     p_sys->i_mtu = var_CreateGetInteger( p_this, "mtu" );
     p_sys->b_mtu_warning = false;
-    p_sys->p_fifo = block_FifoNew();
-    p_sys->p_empty_blocks = block_FifoNew();
+    /* Each FIFO has exactly one writer and one reader: Write() and
+     * ThreadWrite(), in opposite directions. */
+    p_sys->p_fifo = block_FifoNewSPSC( 4 * MAX_EMPTY_BLOCKS );
+    p_sys->p_empty_blocks = block_FifoNewSPSC( 2 * MAX_EMPTY_BLOCKS );
     p_sys->p_buffer = NULL;
 
+    p_sys->i_batch = var_GetInteger( p_access, SOUT_CFG_PREFIX "batch" );
+    if( p_sys->i_batch < 1 )
+        p_sys->i_batch = 1;
+    p_sys->b_gso = false;
+#if defined( HAVE_SENDMMSG ) && defined( UDP_SEGMENT )
+    /* Kernels without UDP segmentation offload would ignore the control
+     * message and send huge datagrams: check for it first. */
+    if( p_sys->i_batch > 1 )
+    {
+        int val;
+        socklen_t len = sizeof( val );
+
+        p_sys->b_gso = !getsockopt( i_handle, IPPROTO_UDP, UDP_SEGMENT,
+                                    &val, &len );
+        msg_Dbg( p_access, "sending up to %u packets at once%s",
+                 p_sys->i_batch, p_sys->b_gso ? " with segmentation" : "" );
+    }
+#endif
+    p_sys->i_datagrams = 0;
+    p_sys->i_syscalls = 0;
+
     if( vlc_clone( &p_sys->thread, ThreadWrite, p_access,
                            VLC_THREAD_PRIORITY_HIGHEST ) )
     {
@@ -244,6 +290,10 @@ static void Close( vlc_object_t * p_this )
 
     vlc_cancel( p_sys->thread );
     vlc_join( p_sys->thread, NULL );
+    if( p_sys->i_syscalls > 0 )
+        msg_Dbg( p_access, "sent %"PRIu64" packets in %"PRIu64" system calls "
+                 "(%.2f per call)", p_sys->i_datagrams, p_sys->i_syscalls,
+                 (double)p_sys->i_datagrams / p_sys->i_syscalls );
     block_FifoRelease( p_sys->p_fifo );
     block_FifoRelease( p_sys->p_empty_blocks );
 
@@ -442,10 +492,38 @@ static void* ThreadWrite( void *data )
             mwait( i_date );
             i_to_send = i_group;
         }
-        if ( send( p_sys->i_handle, p_pk->p_buffer, p_pk->i_buffer, 0 ) == -1 )
-            msg_Warn( p_access, "send error: %m" );
         vlc_cleanup_pop();
 
+        int canc = vlc_savecancel();
+        block_t *pp_pk[p_sys->i_batch];
+        unsigned i_pk = 0;
+
+        pp_pk[i_pk++] = p_pk;
+        /* Gather the queued packets that would be sent right after this one
+         * without waiting: the rest of the current group, and then those
+         * already due (which is all that can be batched with the default
+         * group of 1). The others are left to the pacing above. */
+        const mtime_t i_now = mdate();
+        while( i_pk < p_sys->i_batch && block_FifoCount( p_sys->p_fifo ) > 0 )
+        {
+            const block_t *p_next = block_FifoShow( p_sys->p_fifo );
+            mtime_t i_next_date = p_sys->i_caching + p_next->i_dts;
+
+            if( (p_next->i_flags & BLOCK_FLAG_CLOCK)
+             || i_next_date - i_date > 2000000 )
+                break;
+            if( i_to_send > 1 )
+                i_to_send--;
+            else if( i_next_date > i_now )
+                break;
+
+            pp_pk[i_pk++] = block_FifoGet( p_sys->p_fifo );
+            i_date = i_next_date;
+        }
+
+        SendPackets( p_access, pp_pk, i_pk );
+        vlc_restorecancel( canc );
+
         if( i_dropped_packets )
         {
             msg_Dbg( p_access, "dropped %i packets", i_dropped_packets );
@@ -461,9 +539,100 @@ static void* ThreadWrite( void *data )
         }
 #endif
 
-        block_FifoPut( p_sys->p_empty_blocks, p_pk );
+        for( unsigned i = 0; i < i_pk; i++ )
+            block_FifoPut( p_sys->p_empty_blocks, pp_pk[i] );
 
         i_date_last = i_date;
     }
     return NULL;
 }
+
+/*****************************************************************************
+ * SendPackets: send datagrams with as few system calls as possible.
+ *****************************************************************************/
+static void SendPackets( sout_access_out_t *p_access, block_t **pp_pk,
+                         unsigned i_pk )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    p_sys->i_datagrams += i_pk;
+#ifdef HAVE_SENDMMSG
+    if( i_pk > 1 )
+    {
+        struct mmsghdr msg[i_pk];
+        struct iovec iov[i_pk];
+# ifdef UDP_SEGMENT
+        union
+        {
+            char           buf[CMSG_SPACE(sizeof (uint16_t))];
+            struct cmsghdr align;
+        } ctrl[i_pk];
+# endif
+        unsigned i_msg = 0;
+
+        memset( msg, 0, sizeof( msg ) );
+        for( unsigned i = 0; i < i_pk; i_msg++ )
+        {
+            struct msghdr *hdr = &msg[i_msg].msg_hdr;
+            unsigned n = 1;
+
+# ifdef UDP_SEGMENT
+            /* The kernel splits a GSO datagram in segments of the size of
+             * the first one; only the last one may be shorter. */
+            while( p_sys->b_gso && i + n < i_pk && n < MAX_GSO_SEGMENTS
+                && pp_pk[i + n - 1]->i_buffer == pp_pk[i]->i_buffer
+                && pp_pk[i + n]->i_buffer <= pp_pk[i]->i_buffer
+                && (n + 1) * pp_pk[i]->i_buffer <= 65000 )
+                n++;
+# endif
+            for( unsigned j = i; j < i + n; j++ )
+            {
+                iov[j].iov_base = pp_pk[j]->p_buffer;
+                iov[j].iov_len = pp_pk[j]->i_buffer;
+            }
+            hdr->msg_iov = &iov[i];
+            hdr->msg_iovlen = n;
+
+# ifdef UDP_SEGMENT
+            if( n > 1 )
+            {
+                struct cmsghdr *cmsg;
+
+                hdr->msg_control = ctrl[i_msg].buf;
+                hdr->msg_controllen = sizeof( ctrl[i_msg].buf );
+                cmsg = CMSG_FIRSTHDR( hdr );
+                cmsg->cmsg_level = IPPROTO_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof (uint16_t));
+                *(uint16_t *)CMSG_DATA(cmsg) = pp_pk[i]->i_buffer;
+            }
+# endif
+            i += n;
+        }
+
+        for( unsigned i_sent = 0; i_sent < i_msg; )
+        {
+            int val = sendmmsg( p_sys->i_handle, msg + i_sent,
+                                i_msg - i_sent, 0 );
+            p_sys->i_syscalls++;
+            if( val == -1 )
+            {
+                if( errno == EINTR )
+                    continue;
+                msg_Warn( p_access, "send error: %m" );
+                break;
+            }
+            i_sent += val;
+        }
+        return;
+    }
+#endif
+
+    for( unsigned i = 0; i < i_pk; i++ )
+    {
+        p_sys->i_syscalls++;
+        if( send( p_sys->i_handle, pp_pk[i]->p_buffer,
+                  pp_pk[i]->i_buffer, 0 ) == -1 )
+            msg_Warn( p_access, "send error: %m" );
+    }
+}
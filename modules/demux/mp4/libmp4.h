@@ -462,7 +462,7 @@ typedef struct MP4_Box_data_stts_s
 
     uint32_t i_entry_count;
     uint32_t *i_sample_count; /* these are array */
-    int32_t  *i_sample_delta;
+    uint32_t *i_sample_delta;
 
 } MP4_Box_data_stts_t;
 
@@ -1275,14 +1275,18 @@ typedef struct
     /* now provide way to calculate pts, dts, and offset without too
         much memory and with fast access */
 
-    /* with this we can calculate dts/pts without waste memory */
+    /* with this we can calculate dts/pts without waste memory: the runs
+     * point into the stts and ctts boxes unless b_fragmented, and the first
+     * one can start in the previous chunks (see sample_table.h) */
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_last_dts;    /* DTS of the last sample */
     uint32_t     *p_sample_count_dts;
     uint32_t     *p_sample_delta_dts;   /* dts delta */
+    uint32_t     i_sample_skip_dts;     /* samples of the first run before */
 
     uint32_t     *p_sample_count_pts;
     int32_t      *p_sample_offset_pts;  /* pts-dts */
+    uint32_t     i_sample_skip_pts;     /* samples of the first run before */
 
     uint8_t      **p_sample_data;     /* set when b_fragmented is true */
     uint32_t     *p_sample_size;
@@ -1334,8 +1338,8 @@ typedef struct
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-                                    too much time to do sumations each time*/
+    uint32_t         *p_sample_size; /* in the stsz box, XXX perhaps add file
+                            offset if take too much time to do sumations */
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
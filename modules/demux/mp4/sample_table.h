@@ -0,0 +1,228 @@
+/*****************************************************************************
+ * sample_table.h: MP4 chunks timing from the stts and ctts runs
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_MP4_SAMPLE_TABLE_H
+#define VLC_MP4_SAMPLE_TABLE_H
+
+/*
+ * The chunks do not copy their part of the stts and ctts tables: they point
+ * to the run of their first sample in the boxes, which stay loaded, and
+ * the samples of that run in the previous chunks are skipped. The sample
+ * times are then computed on demand, around the play position.
+ *
+ * The chunks of fragmented files have their own tables, one run per sample.
+ */
+
+/* It sets the timing of the chunks from the stts and optional ctts boxes,
+ * and gives the duration of the track. A ctts box too short is ignored
+ * from the first chunk it does not cover. */
+static inline int MP4_ChunksSetTiming( mp4_chunk_t *p_chunk,
+                                       uint32_t i_chunk_count,
+                                       MP4_Box_data_stts_t *stts,
+                                       MP4_Box_data_ctts_t *ctts,
+                                       uint64_t *pi_duration )
+{
+    uint64_t i_dts = 0;
+    uint32_t i_stts = 0, i_stts_used = 0;
+    uint32_t i_ctts = 0, i_ctts_used = 0;
+
+    for( uint32_t i_chunk = 0; i_chunk < i_chunk_count; i_chunk++ )
+    {
+        mp4_chunk_t *ck = &p_chunk[i_chunk];
+
+        /* decoding time */
+        while( i_stts < stts->i_entry_count &&
+               i_stts_used >= stts->i_sample_count[i_stts] )
+        {
+            i_stts++;
+            i_stts_used = 0;
+        }
+        ck->i_first_dts = i_dts;
+        ck->i_last_dts  = i_dts;
+        ck->p_sample_count_dts = &stts->i_sample_count[i_stts];
+        ck->p_sample_delta_dts = &stts->i_sample_delta[i_stts];
+        ck->i_sample_skip_dts  = i_stts_used;
+
+        for( uint32_t i_left = ck->i_sample_count; i_left > 0; )
+        {
+            if( i_stts >= stts->i_entry_count )
+                return VLC_EGENERIC;
+
+            const uint32_t i_used =
+                __MIN( i_left, stts->i_sample_count[i_stts] - i_stts_used );
+            i_dts += (uint64_t)i_used * stts->i_sample_delta[i_stts];
+            if( i_used > 0 )
+                ck->i_last_dts = i_dts - stts->i_sample_delta[i_stts];
+
+            i_left -= i_used;
+            i_stts_used += i_used;
+            if( i_stts_used >= stts->i_sample_count[i_stts] )
+            {
+                i_stts++;
+                i_stts_used = 0;
+            }
+        }
+
+        /* composition time offset */
+        ck->p_sample_count_pts = NULL;
+        ck->p_sample_offset_pts = NULL;
+        ck->i_sample_skip_pts = 0;
+        if( ctts == NULL )
+            continue;
+
+        while( i_ctts < ctts->i_entry_count &&
+               i_ctts_used >= ctts->i_sample_count[i_ctts] )
+        {
+            i_ctts++;
+            i_ctts_used = 0;
+        }
+        const uint32_t i_first = i_ctts, i_skip = i_ctts_used;
+
+        for( uint32_t i_left = ck->i_sample_count; i_left > 0; )
+        {
+            if( i_ctts >= ctts->i_entry_count )
+            {
+                ctts = NULL;
+                break;
+            }
+
+            const uint32_t i_used =
+                __MIN( i_left, ctts->i_sample_count[i_ctts] - i_ctts_used );
+            i_left -= i_used;
+            i_ctts_used += i_used;
+            if( i_ctts_used >= ctts->i_sample_count[i_ctts] )
+            {
+                i_ctts++;
+                i_ctts_used = 0;
+            }
+        }
+        if( ctts == NULL )
+            continue;
+
+        ck->p_sample_count_pts = &ctts->i_sample_count[i_first];
+        ck->p_sample_offset_pts = &ctts->i_sample_offset[i_first];
+        ck->i_sample_skip_pts = i_skip;
+    }
+
+    *pi_duration = i_dts;
+    return VLC_SUCCESS;
+}
+
+/* It returns the DTS of the i_sample-th sample of the chunk (from 0, up to
+ * its sample count), in track timescale */
+static inline uint64_t MP4_ChunkGetDTS( const mp4_chunk_t *ck,
+                                        uint32_t i_sample )
+{
+    uint64_t i_dts = ck->i_first_dts;
+    uint32_t i_skip = ck->i_sample_skip_dts;
+
+    for( uint32_t i = 0; i_sample > 0; i++ )
+    {
+        const uint32_t i_run =
+            __MIN( i_sample, ck->p_sample_count_dts[i] - i_skip );
+        i_dts += (uint64_t)i_run * ck->p_sample_delta_dts[i];
+        i_sample -= i_run;
+        i_skip = 0;
+    }
+    return i_dts;
+}
+
+/* It gives the PTS - DTS of the i_sample-th sample of the chunk, if any */
+static inline bool MP4_ChunkGetPTSDelta( const mp4_chunk_t *ck,
+                                         uint32_t i_sample, int32_t *pi_delta )
+{
+    if( ck->p_sample_count_pts == NULL || ck->p_sample_offset_pts == NULL )
+        return false;
+
+    i_sample += ck->i_sample_skip_pts;
+    for( uint32_t i = 0; ; i++ )
+    {
+        if( i_sample < ck->p_sample_count_pts[i] )
+        {
+            *pi_delta = ck->p_sample_offset_pts[i];
+            return true;
+        }
+        i_sample -= ck->p_sample_count_pts[i];
+    }
+}
+
+/* It returns the last chunk starting at or before i_dts */
+static inline uint32_t MP4_ChunksFind( const mp4_chunk_t *p_chunk,
+                                       uint32_t i_chunk_count, uint64_t i_dts )
+{
+    uint32_t i_low = 0, i_high = i_chunk_count;
+
+    while( i_high - i_low > 1 )
+    {
+        const uint32_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if( p_chunk[i_mid].i_first_dts <= i_dts )
+            i_low = i_mid;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/* It returns the sample of the chunk (from 0) playing at i_dts, or its
+ * sample count if the chunk ends before */
+static inline uint32_t MP4_ChunkFindSample( const mp4_chunk_t *ck,
+                                            uint64_t i_dts )
+{
+    uint64_t i_time = ck->i_first_dts;
+    uint32_t i_skip = ck->i_sample_skip_dts;
+    uint32_t i_sample = 0;
+
+    for( uint32_t i = 0; i_sample < ck->i_sample_count; i++ )
+    {
+        if( i_dts <= i_time )
+            break;
+
+        const uint32_t i_run = __MIN( ck->i_sample_count - i_sample,
+                                      ck->p_sample_count_dts[i] - i_skip );
+        const uint64_t i_end =
+            i_time + (uint64_t)i_run * ck->p_sample_delta_dts[i];
+        if( i_dts < i_end )
+            return i_sample + ( i_dts - i_time ) / ck->p_sample_delta_dts[i];
+
+        i_time = i_end;
+        i_sample += i_run;
+        i_skip = 0;
+    }
+    return i_sample;
+}
+
+/* It returns the index of the last sync sample at or before i_sample, or 0 */
+static inline uint32_t MP4_SyncSampleFind( const MP4_Box_data_stss_t *stss,
+                                           uint32_t i_sample )
+{
+    uint32_t i_low = 0, i_high = stss->i_entry_count;
+
+    while( i_high - i_low > 1 )
+    {
+        const uint32_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if( stss->i_sample_number[i_mid] <= i_sample )
+            i_low = i_mid;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+#endif
@@ -44,6 +44,8 @@
 #include <vlc_network.h>   /* net_ for ts-out mode */
 
 #include "../mux/mpeg/csa.h"
+#include "ts_index.h"
+#include "ts_pid.h"
 
 /* Include dvbpsi headers */
 # include <dvbpsi/dvbpsi.h>
@@ -135,6 +137,17 @@ static void Close ( vlc_object_t * );
     "Seek and position based on a percent byte position, not a PCR generated " \
     "time position. If seeking doesn't work property, turn on this option." )
 
+#define INDEX_TEXT N_("Seek index")
+#define INDEX_LONGTEXT N_( \
+    "Index the PCR and random access points of the files while playing " \
+    "them, and keep the index of the last 100 files in the cache " \
+    "directory for exact seeking." )
+
+#define INDEX_SCAN_TEXT N_("Index the whole file")
+#define INDEX_SCAN_LONGTEXT N_( \
+    "Scan the whole file in the background to complete its seek index, " \
+    "which gives its exact length." )
+
 
 vlc_module_begin ()
     set_description( N_("MPEG Transport Stream demuxer") )
@@ -160,6 +173,8 @@ vlc_module_begin ()
 
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT, false )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT, true )
+    add_bool( "ts-index", true, INDEX_TEXT, INDEX_LONGTEXT, true )
+    add_bool( "ts-index-scan", false, INDEX_SCAN_TEXT, INDEX_SCAN_LONGTEXT, true )
 
     set_capability( "demux", 10 )
     set_callbacks( Open, Close )
@@ -222,7 +237,7 @@ typedef struct
 
 } ts_prg_psi_t;
 
-typedef struct
+struct ts_psi_t
 {
     /* for special PAT/SDT case */
     dvbpsi_handle   handle; /* PAT/SDT/EIT */
@@ -233,7 +248,7 @@ typedef struct
     int             i_prg;
     ts_prg_psi_t    **prg;
 
-} ts_psi_t;
+};
 
 typedef enum
 {
@@ -241,42 +256,18 @@ typedef enum
     TS_ES_DATA_TABLE_SECTION
 } ts_es_data_type_t;
 
-typedef struct
+struct ts_es_t
 {
     es_format_t  fmt;
     es_out_id_t *id;
     ts_es_data_type_t data_type;
     int         i_data_size;
     int         i_data_gathered;
-    block_t     *p_data;
-    block_t     **pp_last;
+    block_t     *p_data; /* the unit being gathered, in one block */
 
     es_mpeg4_descriptor_t *p_mpeg4desc;
 
-} ts_es_t;
-
-typedef struct
-{
-    int         i_pid;
-
-    bool        b_seen;
-    bool        b_valid;
-    int         i_cc;   /* countinuity counter */
-    bool        b_scrambled;
-
-    /* PSI owner (ie PMT -> PAT, ES -> PMT */
-    ts_psi_t   *p_owner;
-    int         i_owner_number;
-
-    /* */
-    ts_psi_t    *psi;
-    ts_es_t     *es;
-
-    /* Some private streams encapsulate several ES (eg. DVB subtitles)*/
-    ts_es_t     **extra_es;
-    int         i_extra_es;
-
-} ts_pid_t;
+};
 
 struct demux_sys_t
 {
@@ -285,9 +276,13 @@ struct demux_sys_t
     /* TS packet size (188, 192, 204) */
     int         i_packet_size;
 
-    /* how many TS packet we read at once */
+    /* how many TS packet we demux at once */
     int         i_ts_read;
 
+    /* how many TS packet we read in one block, and the ones not demuxed */
+    int         i_ts_batch;
+    block_t     *p_packets;
+
     /* to determine length and time */
     int         i_pid_ref_pcr;
     mtime_t     i_first_pcr;
@@ -298,8 +293,12 @@ struct demux_sys_t
     mtime_t     *p_pcrs;
     int64_t     *p_pos;
 
-    /* All pid */
-    ts_pid_t    pid[8192];
+    /* seek index, and the PID of its random access points */
+    ts_index_t  *p_index;
+    int         i_pid_rai;
+
+    /* All pid, created at their first use */
+    ts_pid_table_t pids;
 
     /* All PMT */
     bool        b_user_pmt;
@@ -349,21 +348,25 @@ static void PSINewTableCallBack( demux_t *, dvbpsi_handle,
                                  uint8_t  i_table_id, uint16_t i_extension );
 static int ChangeKeyCallback( vlc_object_t *, char const *, vlc_value_t, vlc_value_t, void * );
 
-static inline int PIDGet( block_t *p )
+static inline int PIDGet( const uint8_t *p )
 {
-    return ( (p->p_buffer[1]&0x1f)<<8 )|p->p_buffer[2];
+    return ( (p[1]&0x1f)<<8 )|p[2];
 }
 
-static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk );
+static bool GatherData( demux_t *p_demux, ts_pid_t *pid, uint8_t *p );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
-static mtime_t GetPCR( block_t *p_pkt );
+static uint8_t *NextTSPacket( demux_t *p_demux );
+static void FlushTSPackets( demux_t *p_demux );
+static int64_t TellTSPacket( demux_t *p_demux );
+static mtime_t GetPCR( const uint8_t *p );
 static int SeekToPCR( demux_t *p_demux, int64_t i_pos );
+static int SeekIndex( demux_t *p_demux, mtime_t i_target_pcr, bool b_precise );
 static int Seek( demux_t *p_demux, double f_percent );
 static void GetFirstPCR( demux_t *p_demux );
 static void GetLastPCR( demux_t *p_demux );
 static void CheckPCR( demux_t *p_demux );
-static void PCRHandle( demux_t *p_demux, ts_pid_t *, block_t * );
+static void PCRHandle( demux_t *p_demux, ts_pid_t *, const uint8_t * );
 
 static void              IODFree( iod_descriptor_t * );
 
@@ -536,16 +539,19 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->b_broken_charset = false;
 
-    for( int i = 0; i < 8192; i++ )
+    /* The chunks of the PSI PIDs (0x00 to 0x14) and of the padding are
+     * created here, so that their PIDs can always be looked up later */
+    if( ts_pid_Get( &p_sys->pids, 0 ) == NULL
+     || ts_pid_Get( &p_sys->pids, 8191 ) == NULL )
     {
-        ts_pid_t *pid = &p_sys->pid[i];
-
-        pid->i_pid      = i;
-        pid->b_seen     = false;
-        pid->b_valid    = false;
+        ts_pid_TableClean( &p_sys->pids );
+        vlc_mutex_destroy( &p_sys->csa_lock );
+        free( p_sys );
+        return VLC_ENOMEM;
     }
+
     /* PID 8191 is padding */
-    p_sys->pid[8191].b_seen = true;
+    ts_pid_Get( &p_sys->pids, 8191 )->b_seen = true;
     p_sys->i_packet_size = i_packet_size;
     p_sys->b_udp_out = false;
     p_sys->fd = -1;
@@ -554,13 +560,13 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_start_record = false;
 
     /* Init PAT handler */
-    pat = &p_sys->pid[0];
+    pat = ts_pid_Get( &p_sys->pids, 0 );
     PIDInit( pat, true, NULL );
     pat->psi->handle = dvbpsi_AttachPAT( PATCallBack, p_demux );
     if( p_sys->b_dvb_meta )
     {
-        ts_pid_t *sdt = &p_sys->pid[0x11];
-        ts_pid_t *eit = &p_sys->pid[0x12];
+        ts_pid_t *sdt = ts_pid_Get( &p_sys->pids, 0x11 );
+        ts_pid_t *eit = ts_pid_Get( &p_sys->pids, 0x12 );
 
         PIDInit( sdt, true, NULL );
         sdt->psi->handle =
@@ -571,7 +577,7 @@ static int Open( vlc_object_t *p_this )
             dvbpsi_AttachDemux( (dvbpsi_demux_new_cb_t)PSINewTableCallBack,
                                 p_demux );
 
-        ts_pid_t *tdt = &p_sys->pid[0x14];
+        ts_pid_t *tdt = ts_pid_Get( &p_sys->pids, 0x14 );
         PIDInit( tdt, true, NULL );
         tdt->psi->handle =
             dvbpsi_AttachDemux( (dvbpsi_demux_new_cb_t)PSINewTableCallBack,
@@ -695,6 +701,12 @@ static int Open( vlc_object_t *p_this )
 
     bool can_seek = false;
     stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &can_seek );
+
+    /* Read the TS packets of local files in large runs. Live inputs are
+     * read one datagram (7 TS packets) at a time, not to wait for more data
+     * than needed before demuxing */
+    p_sys->i_ts_batch = can_seek ? 4 * p_sys->i_ts_read : 7;
+
     if( can_seek  )
     {
         GetFirstPCR( p_demux );
@@ -706,12 +718,35 @@ static int Open( vlc_object_t *p_this )
         p_sys->b_force_seek_per_percent = true;
     }
 
+    p_sys->p_index = NULL;
+    p_sys->i_pid_rai = -1;
+    if( can_seek && p_sys->i_pid_ref_pcr >= 0 &&
+        var_CreateGetBool( p_demux, "ts-index" ) )
+        p_sys->p_index = ts_index_New( p_demux, p_sys->i_packet_size,
+                                       p_sys->i_pid_ref_pcr );
+
     while( p_sys->i_pmt_es <= 0 && vlc_object_alive( p_demux ) )
     {
         if( p_demux->pf_demux( p_demux ) != 1 )
             break;
     }
 
+    if( p_sys->p_index )
+    {
+        /* The random access points are indexed on the first video PID */
+        ts_pid_Foreach( &p_sys->pids, pid )
+        {
+            if( pid->b_valid && !pid->psi && pid->es &&
+                pid->es->fmt.i_cat == VIDEO_ES )
+            {
+                p_sys->i_pid_rai = pid->i_pid;
+                break;
+            }
+        }
+        if( var_CreateGetBool( p_demux, "ts-index-scan" ) )
+            ts_index_StartScan( p_sys->p_index, p_sys->i_pid_rai );
+    }
+
     return VLC_SUCCESS;
 }
 
@@ -724,10 +759,8 @@ static void Close( vlc_object_t *p_this )
     demux_sys_t *p_sys = p_demux->p_sys;
 
     msg_Dbg( p_demux, "pid list:" );
-    for( int i = 0; i < 8192; i++ )
+    ts_pid_Foreach( &p_sys->pids, pid )
     {
-        ts_pid_t *pid = &p_sys->pid[i];
-
         if( pid->b_valid && pid->psi )
         {
             switch( pid->i_pid )
@@ -788,10 +821,16 @@ static void Close( vlc_object_t *p_this )
     }
 
     free( p_sys->buffer );
+    if( p_sys->p_packets )
+        block_Release( p_sys->p_packets );
+    if( p_sys->p_index )
+        ts_index_Delete( p_sys->p_index );
 
     free( p_sys->p_pcrs );
     free( p_sys->p_pos );
 
+    ts_pid_TableClean( &p_sys->pids );
+
     vlc_mutex_destroy( &p_sys->csa_lock );
     free( p_sys );
 }
@@ -826,12 +865,13 @@ static int Demux( demux_t *p_demux )
     demux_sys_t *p_sys = p_demux->p_sys;
     bool b_wait_es = p_sys->i_pmt_es <= 0;
 
-    /* We read at most 100 TS packet or until a frame is completed */
-    for( int i_pkt = 0; i_pkt < p_sys->i_ts_read; i_pkt++ )
+    /* We demux at most i_ts_read TS packet or until a frame is completed */
+    int i_pkt = 0;
+    while( i_pkt < p_sys->i_ts_read )
     {
         bool         b_frame = false;
-        block_t     *p_pkt;
-        if( !(p_pkt = ReadTSPacket( p_demux )) )
+        uint8_t     *p_pkt;
+        if( !(p_pkt = NextTSPacket( p_demux )) )
         {
             return 0;
         }
@@ -846,11 +886,14 @@ static int Demux( demux_t *p_demux )
         if( p_sys->b_udp_out )
         {
             memcpy( &p_sys->buffer[i_pkt * p_sys->i_packet_size],
-                    p_pkt->p_buffer, p_sys->i_packet_size );
+                    p_pkt, p_sys->i_packet_size );
         }
+        i_pkt++;
 
         /* Parse the TS packet */
-        ts_pid_t *p_pid = &p_sys->pid[PIDGet( p_pkt )];
+        ts_pid_t *p_pid = ts_pid_Get( &p_sys->pids, PIDGet( p_pkt ) );
+        if( unlikely( p_pid == NULL ) )
+            continue; /* out of memory: drop the packet */
 
         if( p_pid->b_valid )
         {
@@ -858,17 +901,16 @@ static int Demux( demux_t *p_demux )
             {
                 if( p_pid->i_pid == 0 || ( p_sys->b_dvb_meta && ( p_pid->i_pid == 0x11 || p_pid->i_pid == 0x12 || p_pid->i_pid == 0x14 ) ) )
                 {
-                    dvbpsi_PushPacket( p_pid->psi->handle, p_pkt->p_buffer );
+                    dvbpsi_PushPacket( p_pid->psi->handle, p_pkt );
                 }
                 else
                 {
                     for( int i_prg = 0; i_prg < p_pid->psi->i_prg; i_prg++ )
                     {
                         dvbpsi_PushPacket( p_pid->psi->prg[i_prg]->handle,
-                                           p_pkt->p_buffer );
+                                           p_pkt );
                     }
                 }
-                block_Release( p_pkt );
             }
             else if( !p_sys->b_udp_out )
             {
@@ -877,7 +919,6 @@ static int Demux( demux_t *p_demux )
             else
             {
                 PCRHandle( p_demux, p_pid, p_pkt );
-                block_Release( p_pkt );
             }
         }
         else
@@ -888,7 +929,6 @@ static int Demux( demux_t *p_demux )
             }
             /* We have to handle PCR if present */
             PCRHandle( p_demux, p_pid, p_pkt );
-            block_Release( p_pkt );
         }
         p_pid->b_seen = true;
 
@@ -900,7 +940,7 @@ static int Demux( demux_t *p_demux )
     {
         /* Send the complete block */
         net_Write( p_demux, p_sys->fd, NULL, p_sys->buffer,
-                   p_sys->i_ts_read * p_sys->i_packet_size );
+                   i_pkt * p_sys->i_packet_size );
     }
 
     return 1;
@@ -942,6 +982,10 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     int64_t *pi64;
     int i_int;
 
+    /* The last PCR is exact once the whole file is indexed */
+    if( p_sys->p_index )
+        ts_index_GetLast( p_sys->p_index, &p_sys->i_last_pcr );
+
     switch( i_query )
     {
     case DEMUX_GET_POSITION:
@@ -956,7 +1000,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             if( !DVBEventInformation( p_demux, &i_time, &i_length ) && i_length > 0 )
                 *pf = (double)i_time/(double)i_length;
             else if( (i64 = stream_Size( p_demux->s) ) > 0 )
-                *pf = (double)stream_Tell( p_demux->s ) / (double)i64;
+                *pf = (double)TellTSPacket( p_demux ) / (double)i64;
             else
                 *pf = 0.0;
         }
@@ -973,6 +1017,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             (p_sys->b_dvb_meta && p_sys->b_access_control) ||
             p_sys->i_last_pcr - p_sys->i_first_pcr <= 0 )
         {
+            FlushTSPackets( p_demux );
             i64 = stream_Size( p_demux->s );
             if( stream_Seek( p_demux->s, (int64_t)(i64 * f) ) )
                 return VLC_EGENERIC;
@@ -1086,8 +1131,15 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         p_sys->b_start_record = b_bool;
         return VLC_SUCCESS;
 
-    case DEMUX_GET_FPS:
     case DEMUX_SET_TIME:
+        i64 = (int64_t)va_arg( args, int64_t );
+        b_bool = (bool)va_arg( args, int );
+
+        if( p_sys->b_force_seek_per_percent || p_sys->i_first_pcr < 0 )
+            return VLC_EGENERIC;
+        return SeekIndex( p_demux, p_sys->i_first_pcr + i64 * 9 / 100, b_bool );
+
+    case DEMUX_GET_FPS:
     default:
         return VLC_EGENERIC;
     }
@@ -1118,9 +1170,11 @@ static int UserPmt( demux_t *p_demux, const char *psz_fmt )
         i_number = strtol( &psz[1], &psz, 0 );
 
     /* */
-    ts_pid_t *pmt = &p_sys->pid[i_pid];
+    ts_pid_t *pmt = ts_pid_Get( &p_sys->pids, i_pid );
     ts_prg_psi_t *prg;
 
+    if( unlikely( pmt == NULL ) )
+        goto error;
     msg_Dbg( p_demux, "user pmt specified (pid=%d,number=%d)", i_pid, i_number );
     PIDInit( pmt, true, NULL );
 
@@ -1155,14 +1209,16 @@ static int UserPmt( demux_t *p_demux, const char *psz_fmt )
             goto next;
 
         char *psz_opt = &psz[1];
+        ts_pid_t *pid = ts_pid_Get( &p_sys->pids, i_pid );
+        if( unlikely( pid == NULL ) )
+            goto next;
+
         if( !strcmp( psz_opt, "pcr" ) )
         {
             prg->i_pid_pcr = i_pid;
         }
-        else if( !p_sys->pid[i_pid].b_valid )
+        else if( !pid->b_valid )
         {
-            ts_pid_t *pid = &p_sys->pid[i_pid];
-
             char *psz_arg = strchr( psz_opt, '=' );
             if( psz_arg )
                 *psz_arg++ = '\0';
@@ -1228,6 +1284,10 @@ static int SetPIDFilter( demux_t *p_demux, int i_pid, bool b_selected )
     if( !p_sys->b_access_control )
         return VLC_EGENERIC;
 
+    /* Close() only unselects the PIDs of the table */
+    if( b_selected && ts_pid_Get( &p_sys->pids, i_pid ) == NULL )
+        return VLC_ENOMEM;
+
     return stream_Control( p_demux->s, STREAM_CONTROL_ACCESS,
                            ACCESS_SET_PRIVATE_ID_STATE, i_pid, b_selected );
 }
@@ -1264,11 +1324,9 @@ static void SetPrgFilter( demux_t *p_demux, int i_prg_id, bool b_selected )
         SetPIDFilter( p_demux, p_prg->i_pid_pcr, b_selected );
 
     /* All ES */
-    for( int i = 2; i < 8192; i++ )
+    ts_pid_Foreach( &p_sys->pids, pid )
     {
-        ts_pid_t *pid = &p_sys->pid[i];
-
-        if( !pid->b_valid || pid->psi )
+        if( pid->i_pid < 2 || !pid->b_valid || pid->psi )
             continue;
 
         for( int i_prg = 0; i_prg < pid->p_owner->i_prg; i_prg++ )
@@ -1276,7 +1334,7 @@ static void SetPrgFilter( demux_t *p_demux, int i_prg_id, bool b_selected )
             if( pid->p_owner->prg[i_prg]->i_pid_pmt == i_pmt_pid && pid->es->id )
             {
                 /* We only remove/select es that aren't defined by extra pmt */
-                SetPIDFilter( p_demux, i, b_selected );
+                SetPIDFilter( p_demux, pid->i_pid, b_selected );
                 break;
             }
         }
@@ -1335,7 +1393,6 @@ static void PIDInit( ts_pid_t *pid, bool b_psi, ts_psi_t *p_owner )
 
         es_format_Init( &pid->es->fmt, UNKNOWN_ES, 0 );
         pid->es->data_type = TS_ES_DATA_PES;
-        pid->es->pp_last = &pid->es->p_data;
     }
 }
 
@@ -1674,7 +1731,6 @@ static void ParseData( demux_t *p_demux, ts_pid_t *pid )
     pid->es->p_data = NULL;
     pid->es->i_data_size = 0;
     pid->es->i_data_gathered = 0;
-    pid->es->pp_last = &pid->es->p_data;
 
     if( pid->es->data_type == TS_ES_DATA_PES )
     {
@@ -1747,6 +1803,96 @@ static block_t* ReadTSPacket( demux_t *p_demux )
     return p_pkt;
 }
 
+/* It reads up to i_count TS packets in one block, as long as they are
+ * in sync */
+static block_t* ReadTSPackets( demux_t *p_demux, int i_count )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const int   i_size = p_sys->i_packet_size;
+    const uint8_t *p_peek;
+
+    int i_peek = stream_Peek( p_demux->s, &p_peek, i_size * i_count );
+    if( i_peek < i_size )
+    {
+        msg_Dbg( p_demux, "eof ?" );
+        return NULL;
+    }
+
+    block_t *p_packets;
+    if( p_peek[0] == 0x47 )
+    {
+        int i_run = 1;
+        while( ( i_run + 1 ) * i_size <= i_peek &&
+               p_peek[i_run * i_size] == 0x47 )
+            i_run++;
+
+        p_packets = stream_Block( p_demux->s, i_run * i_size );
+    }
+    else
+    {
+        /* Let ReadTSPacket() re-sync */
+        p_packets = ReadTSPacket( p_demux );
+    }
+
+    if( p_packets && p_packets->i_buffer < (size_t)i_size )
+    {
+        msg_Dbg( p_demux, "eof ?" );
+        block_Release( p_packets );
+        return NULL;
+    }
+    return p_packets;
+}
+
+/* It returns the next TS packet to demux, from the packets read at once.
+ * It stays valid until the next call or FlushTSPackets() */
+static uint8_t *NextTSPacket( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    block_t     *p_packets = p_sys->p_packets;
+
+    if( p_packets && p_packets->i_buffer < (size_t)p_sys->i_packet_size )
+    {
+        block_Release( p_packets );
+        p_packets = p_sys->p_packets = NULL;
+    }
+    if( !p_packets )
+    {
+        p_packets = ReadTSPackets( p_demux, p_sys->i_ts_batch );
+        if( !p_packets )
+            return NULL;
+        p_sys->p_packets = p_packets;
+    }
+
+    uint8_t *p_pkt = p_packets->p_buffer;
+    p_packets->p_buffer += p_sys->i_packet_size;
+    p_packets->i_buffer -= p_sys->i_packet_size;
+    return p_pkt;
+}
+
+/* It drops the packets read ahead, before seeking */
+static void FlushTSPackets( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->p_packets )
+        block_Release( p_sys->p_packets );
+    p_sys->p_packets = NULL;
+
+    if( p_sys->p_index )
+        ts_index_Discontinuity( p_sys->p_index );
+}
+
+/* Stream position of the next TS packet to demux */
+static int64_t TellTSPacket( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    int64_t     i_pos = stream_Tell( p_demux->s );
+
+    if( p_sys->p_packets )
+        i_pos -= p_sys->p_packets->i_buffer;
+    return i_pos;
+}
+
 static mtime_t AdjustPCRWrapAround( demux_t *p_demux, mtime_t i_pcr )
 {
     demux_sys_t   *p_sys = p_demux->p_sys;
@@ -1755,7 +1901,7 @@ static mtime_t AdjustPCRWrapAround( demux_t *p_demux, mtime_t i_pcr )
      * So, need to add 0x1FFFFFFFF, for calculating duration or current position.
      */
     mtime_t i_adjust = 0;
-    int64_t i_pos = stream_Tell( p_demux->s );
+    int64_t i_pos = TellTSPacket( p_demux );
     int i;
     for( i = 1; i < p_sys->i_pcrs_num && p_sys->p_pos[i] <= i_pos; ++i )
     {
@@ -1768,10 +1914,8 @@ static mtime_t AdjustPCRWrapAround( demux_t *p_demux, mtime_t i_pcr )
     return i_pcr + i_adjust;
 }
 
-static mtime_t GetPCR( block_t *p_pkt )
+static mtime_t GetPCR( const uint8_t *p )
 {
-    const uint8_t *p = p_pkt->p_buffer;
-
     mtime_t i_pcr = -1;
 
     if( ( p[3]&0x20 ) && /* adaptation */
@@ -1814,9 +1958,9 @@ static int SeekToPCR( demux_t *p_demux, int64_t i_pos )
         {
             break;
         }
-        if( PIDGet( p_pkt ) == p_sys->i_pid_ref_pcr )
+        if( PIDGet( p_pkt->p_buffer ) == p_sys->i_pid_ref_pcr )
         {
-            i_pcr = GetPCR( p_pkt );
+            i_pcr = GetPCR( p_pkt->p_buffer );
         }
         block_Release( p_pkt );
         if( i_pcr >= 0 )
@@ -1836,18 +1980,48 @@ static int SeekToPCR( demux_t *p_demux, int64_t i_pos )
     }
 }
 
+/* It seeks to the indexed random access point before a PCR */
+static int SeekIndex( demux_t *p_demux, mtime_t i_target_pcr, bool b_precise )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    int64_t i_pcr, i_pos;
+
+    if( !p_sys->p_index ||
+        ts_index_Find( p_sys->p_index, i_target_pcr, &i_pcr, &i_pos ) )
+        return VLC_EGENERIC;
+
+    FlushTSPackets( p_demux );
+    if( stream_Seek( p_demux->s, i_pos ) )
+        return VLC_EGENERIC;
+    msg_Dbg( p_demux, "SeekIndex(): %"PRId64" at %"PRId64, i_pcr, i_pos );
+
+    p_sys->i_current_pcr = i_pcr;
+    if( b_precise )
+    {
+        /* The timestamps of the ES are not wrap around adjusted */
+        es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
+                        (int64_t)(VLC_TS_0 + (i_target_pcr % TS_INDEX_PCR_WRAP) * 100 / 9) );
+    }
+    return VLC_SUCCESS;
+}
+
 static int Seek( demux_t *p_demux, double f_percent )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    int64_t i_initial_pos = stream_Tell( p_demux->s );
+    int64_t i_initial_pos = TellTSPacket( p_demux );
     mtime_t i_initial_pcr = p_sys->i_current_pcr;
 
+    FlushTSPackets( p_demux );
+
     /*
      * Find the time position by using binary search algorithm.
      */
     mtime_t i_target_pcr = (p_sys->i_last_pcr - p_sys->i_first_pcr) * f_percent + p_sys->i_first_pcr;
 
+    if( !SeekIndex( p_demux, i_target_pcr, false ) )
+        return VLC_SUCCESS;
+
     int64_t i_head_pos = 0;
     int64_t i_tail_pos = stream_Size( p_demux->s );
     {
@@ -1920,10 +2094,10 @@ static void GetFirstPCR( demux_t *p_demux )
         {
             break;
         }
-        mtime_t i_pcr = GetPCR( p_pkt );
+        mtime_t i_pcr = GetPCR( p_pkt->p_buffer );
         if( i_pcr >= 0 )
         {
-            p_sys->i_pid_ref_pcr = PIDGet( p_pkt );
+            p_sys->i_pid_ref_pcr = PIDGet( p_pkt->p_buffer );
             p_sys->i_first_pcr = i_pcr;
             p_sys->i_current_pcr = i_pcr;
         }
@@ -2008,19 +2182,25 @@ static void CheckPCR( demux_t *p_demux )
     p_sys->i_current_pcr = i_initial_pcr;
 }
 
-static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
+static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, const uint8_t *p )
 {
     demux_sys_t   *p_sys = p_demux->p_sys;
 
     if( p_sys->i_pmt_es <= 0 )
         return;
 
-    mtime_t i_pcr = GetPCR( p_bk );
+    mtime_t i_pcr = GetPCR( p );
     if( i_pcr < 0 )
         return;
 
     if( p_sys->i_pid_ref_pcr == pid->i_pid )
+    {
         p_sys->i_current_pcr = AdjustPCRWrapAround( p_demux, i_pcr );
+        if( p_sys->p_index )
+            ts_index_Add( p_sys->p_index, p_sys->i_current_pcr,
+                          TellTSPacket( p_demux ) - p_sys->i_packet_size,
+                          false );
+    }
 
     /* Search program and set the PCR */
     for( int i = 0; i < p_sys->i_pmt; i++ )
@@ -2034,15 +2214,67 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
             }
 }
 
-static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
+/* It tells if the data of an ES PID are used by any of its ES */
+static bool PIDIsSelected( demux_t *p_demux, ts_pid_t *pid )
+{
+    bool b_selected = false;
+
+    if( es_out_Control( p_demux->out, ES_OUT_GET_ES_STATE,
+                        pid->es->id, &b_selected ) )
+        return true;
+
+    for( int i = 0; !b_selected && i < pid->i_extra_es; i++ )
+    {
+        if( pid->extra_es[i]->id &&
+            es_out_Control( p_demux->out, ES_OUT_GET_ES_STATE,
+                            pid->extra_es[i]->id, &b_selected ) )
+            return true;
+    }
+    return b_selected;
+}
+
+/* It appends a TS payload to the unit being gathered. The unit is kept in
+ * one block, allocated at its final size when it is known */
+static void AppendData( ts_es_t *es, const uint8_t *p, size_t i_size )
+{
+    block_t *p_data = es->p_data;
+    size_t  i_gathered = 0;
+
+    if( p_data == NULL )
+    {
+        /* Room for the whole PES if its size is known */
+        const size_t i_alloc = es->i_data_size > 0 ? es->i_data_size
+                                                   : 16 * TS_PACKET_SIZE_188;
+        p_data = block_Alloc( __MAX( i_alloc, i_size ) );
+    }
+    else
+    {
+        i_gathered = p_data->i_buffer;
+        if( &p_data->p_buffer[i_gathered + i_size] >
+            &p_data->p_start[p_data->i_size] )
+            p_data = block_Realloc( p_data, 0, 2 * (i_gathered + i_size) );
+    }
+
+    es->p_data = p_data;
+    if( p_data == NULL )
+    {
+        es->i_data_gathered = 0;
+        return;
+    }
+    memcpy( &p_data->p_buffer[i_gathered], p, i_size );
+    p_data->i_buffer = i_gathered + i_size;
+    es->i_data_gathered += i_size;
+}
+
+static bool GatherData( demux_t *p_demux, ts_pid_t *pid, uint8_t *p )
 {
-    const uint8_t *p = p_bk->p_buffer;
     const bool b_unit_start = p[1]&0x40;
     const bool b_scrambled  = p[3]&0x80;
     const bool b_adaptation = p[3]&0x20;
     const bool b_payload    = p[3]&0x10;
     const int  i_cc         = p[3]&0x0f; /* continuity counter */
     bool       b_discontinuity = false;  /* discontinuity */
+    bool       b_random_access = false;  /* random access point */
 
     /* transport_scrambling_control is ignored */
     int         i_skip = 0;
@@ -2056,7 +2288,7 @@ static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
 
     /* For now, ignore additional error correction
      * TODO: handle Reed-Solomon 204,188 error correction */
-    p_bk->i_buffer = TS_PACKET_SIZE_188;
+    const uint8_t *p_end = &p[TS_PACKET_SIZE_188];
 
     if( p[1]&0x80 )
     {
@@ -2066,13 +2298,6 @@ static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
             pid->es->p_data->i_flags |= BLOCK_FLAG_CORRUPTED;
     }
 
-    if( p_demux->p_sys->csa )
-    {
-        vlc_mutex_lock( &p_demux->p_sys->csa_lock );
-        csa_Decrypt( p_demux->p_sys->csa, p_bk->p_buffer, p_demux->p_sys->i_csa_pkt_size );
-        vlc_mutex_unlock( &p_demux->p_sys->csa_lock );
-    }
-
     if( !b_adaptation )
     {
         /* We don't have any adaptation_field, so payload starts
@@ -2093,8 +2318,9 @@ static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
                             pid->i_pid );
                 /* pid->es->p_data->i_flags |= BLOCK_FLAG_DISCONTINUITY; */
             }
+            b_random_access = (p[5]&0x40) ? true : false;
 #if 0
-            if( p[5]&0x40 )
+            if( b_random_access )
                 msg_Dbg( p_demux, "random access indicator (pid=%d) ", pid->i_pid );
 #endif
         }
@@ -2135,12 +2361,40 @@ static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
         }
     }
 
-    PCRHandle( p_demux, pid, p_bk );
+    PCRHandle( p_demux, pid, p );
+
+    if( b_random_access && b_unit_start && p_demux->p_sys->p_index &&
+        pid->i_pid == p_demux->p_sys->i_pid_rai &&
+        p_demux->p_sys->i_current_pcr >= 0 )
+    {
+        ts_index_Add( p_demux->p_sys->p_index, p_demux->p_sys->i_current_pcr,
+                      TellTSPacket( p_demux ) - p_demux->p_sys->i_packet_size,
+                      true );
+    }
 
     if( i_skip >= 188 || pid->es->id == NULL || p_demux->p_sys->b_udp_out )
+        return i_ret;
+
+    /* The units of the ES not selected are skipped, untouched */
+    if( b_unit_start )
     {
-        block_Release( p_bk );
+        pid->b_selected = PIDIsSelected( p_demux, pid );
+        if( !pid->b_selected && pid->es->p_data )
+        {
+            block_Release( pid->es->p_data );
+            pid->es->p_data = NULL;
+            pid->es->i_data_size = 0;
+            pid->es->i_data_gathered = 0;
+        }
+    }
+    if( !pid->b_selected )
         return i_ret;
+
+    if( p_demux->p_sys->csa )
+    {
+        vlc_mutex_lock( &p_demux->p_sys->csa_lock );
+        csa_Decrypt( p_demux->p_sys->csa, p, p_demux->p_sys->i_csa_pkt_size );
+        vlc_mutex_unlock( &p_demux->p_sys->csa_lock );
     }
 
     /* */
@@ -2161,23 +2415,16 @@ static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
     }
 
     /* We have to gather it */
-    p_bk->p_buffer += i_skip;
-    p_bk->i_buffer -= i_skip;
+    p += i_skip;
 
     if( b_unit_start )
     {
-        if( pid->es->data_type == TS_ES_DATA_TABLE_SECTION && p_bk->i_buffer > 0 )
+        if( pid->es->data_type == TS_ES_DATA_TABLE_SECTION && p < p_end )
         {
-            int i_pointer_field = __MIN( p_bk->p_buffer[0], p_bk->i_buffer - 1 );
-            block_t *p = block_Duplicate( p_bk );
-            if( p )
-            {
-                p->i_buffer = i_pointer_field;
-                p->p_buffer++;
-                block_ChainLastAppend( &pid->es->pp_last, p );
-            }
-            p_bk->i_buffer -= 1 + i_pointer_field;
-            p_bk->p_buffer += 1 + i_pointer_field;
+            int i_pointer_field = __MIN( p[0], p_end - p - 1 );
+            if( pid->es->p_data )
+                AppendData( pid->es, &p[1], i_pointer_field );
+            p += 1 + i_pointer_field;
         }
         if( pid->es->p_data )
         {
@@ -2185,12 +2432,11 @@ static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
             i_ret = true;
         }
 
-        block_ChainLastAppend( &pid->es->pp_last, p_bk );
         if( pid->es->data_type == TS_ES_DATA_PES )
         {
-            if( p_bk->i_buffer > 6 )
+            if( p_end - p > 6 )
             {
-                pid->es->i_data_size = GetWBE( &p_bk->p_buffer[4] );
+                pid->es->i_data_size = GetWBE( &p[4] );
                 if( pid->es->i_data_size > 0 )
                 {
                     pid->es->i_data_size += 6;
@@ -2199,12 +2445,12 @@ static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
         }
         else if( pid->es->data_type == TS_ES_DATA_TABLE_SECTION )
         {
-            if( p_bk->i_buffer > 3 && p_bk->p_buffer[0] != 0xff )
+            if( p_end - p > 3 && p[0] != 0xff )
             {
-                pid->es->i_data_size = 3 + (((p_bk->p_buffer[1] & 0xf) << 8) | p_bk->p_buffer[2]);
+                pid->es->i_data_size = 3 + (((p[1] & 0xf) << 8) | p[2]);
             }
         }
-        pid->es->i_data_gathered += p_bk->i_buffer;
+        AppendData( pid->es, p, p_end - p );
         if( pid->es->i_data_size > 0 &&
             pid->es->i_data_gathered >= pid->es->i_data_size )
         {
@@ -2212,26 +2458,18 @@ static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
             i_ret = true;
         }
     }
-    else
+    else if( pid->es->p_data )
     {
-        if( pid->es->p_data == NULL )
-        {
-            /* msg_Dbg( p_demux, "broken packet" ); */
-            block_Release( p_bk );
-        }
-        else
-        {
-            block_ChainLastAppend( &pid->es->pp_last, p_bk );
-            pid->es->i_data_gathered += p_bk->i_buffer;
+        AppendData( pid->es, p, p_end - p );
 
-            if( pid->es->i_data_size > 0 &&
-                pid->es->i_data_gathered >= pid->es->i_data_size )
-            {
-                ParseData( p_demux, pid );
-                i_ret = true;
-            }
+        if( pid->es->i_data_size > 0 &&
+            pid->es->i_data_gathered >= pid->es->i_data_size )
+        {
+            ParseData( p_demux, pid );
+            i_ret = true;
         }
     }
+    /* else: broken packet */
 
     return i_ret;
 }
@@ -2574,7 +2812,7 @@ static void ValidateDVBMeta( demux_t *p_demux, int i_pid )
     for( int i = 0x11; i <= 0x14; i++ )
     {
         if( i == 0x13 ) continue;
-        ts_pid_t *p_pid = &p_sys->pid[i];
+        ts_pid_t *p_pid = ts_pid_Get( &p_sys->pids, i );
         if( p_pid->psi )
         {
             dvbpsi_DetachDemux( p_pid->psi->handle );
@@ -2608,7 +2846,7 @@ static char *EITConvertToUTF8( const unsigned char *psz_instring,
 static void SDTCallBack( demux_t *p_demux, dvbpsi_sdt_t *p_sdt )
 {
     demux_sys_t          *p_sys = p_demux->p_sys;
-    ts_pid_t             *sdt = &p_sys->pid[0x11];
+    ts_pid_t             *sdt = ts_pid_Get( &p_sys->pids, 0x11 );
     dvbpsi_sdt_service_t *p_srv;
 
     msg_Dbg( p_demux, "SDTCallBack called" );
@@ -2972,7 +3210,9 @@ static void PSINewTableCallBack( demux_t *p_demux, dvbpsi_handle h,
     msg_Dbg( p_demux, "PSINewTableCallBack: table 0x%x(%d) ext=0x%x(%d)",
              i_table_id, i_table_id, i_extension, i_extension );
 #endif
-    if( p_demux->p_sys->pid[0].psi->i_pat_version != -1 && i_table_id == 0x42 )
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( ts_pid_Get( &p_sys->pids, 0 )->psi->i_pat_version != -1 && i_table_id == 0x42 )
     {
         msg_Dbg( p_demux, "PSINewTableCallBack: table 0x%x(%d) ext=0x%x(%d)",
                  i_table_id, i_table_id, i_extension, i_extension );
@@ -2980,7 +3220,7 @@ static void PSINewTableCallBack( demux_t *p_demux, dvbpsi_handle h,
         dvbpsi_AttachSDT( h, i_table_id, i_extension,
                           (dvbpsi_sdt_callback)SDTCallBack, p_demux );
     }
-    else if( p_demux->p_sys->pid[0x11].psi->i_sdt_version != -1 &&
+    else if( ts_pid_Get( &p_sys->pids, 0x11 )->psi->i_sdt_version != -1 &&
              ( i_table_id == 0x4e || /* Current/Following */
                (i_table_id >= 0x50 && i_table_id <= 0x5f) ) ) /* Schedule */
     {
@@ -2992,7 +3232,7 @@ static void PSINewTableCallBack( demux_t *p_demux, dvbpsi_handle h,
                                     (dvbpsi_eit_callback)EITCallBackSchedule;
         dvbpsi_AttachEIT( h, i_table_id, i_extension, cb, p_demux );
     }
-    else if( p_demux->p_sys->pid[0x11].psi->i_sdt_version != -1 &&
+    else if( ts_pid_Get( &p_sys->pids, 0x11 )->psi->i_sdt_version != -1 &&
               i_table_id == 0x70 )  /* TDT */
     {
          msg_Dbg( p_demux, "PSINewTableCallBack: table 0x%x(%d) ext=0x%x(%d)",
@@ -3275,7 +3515,6 @@ static void PMTSetupEsTeletext( demux_t *p_demux, ts_pid_t *pid,
                 p_es->p_data  = NULL;
                 p_es->i_data_size = 0;
                 p_es->i_data_gathered = 0;
-                p_es->pp_last = &p_es->p_data;
                 p_es->data_type = TS_ES_DATA_PES;
                 p_es->p_mpeg4desc = NULL;
 
@@ -3359,7 +3598,6 @@ static void PMTSetupEsDvbSubtitle( demux_t *p_demux, ts_pid_t *pid,
                 p_es->p_data   = NULL;
                 p_es->i_data_size = 0;
                 p_es->i_data_gathered = 0;
-                p_es->pp_last = &p_es->p_data;
                 p_es->data_type = TS_ES_DATA_PES;
                 p_es->p_mpeg4desc = NULL;
 
@@ -3751,10 +3989,8 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_pmt )
     ts_pid_t **pp_clean = NULL;
     int      i_clean = 0;
     /* Clean this program (remove all es) */
-    for( int i = 0; i < 8192; i++ )
+    ts_pid_Foreach( &p_sys->pids, pid )
     {
-        ts_pid_t *pid = &p_sys->pid[i];
-
         if( pid->b_valid && pid->p_owner == pmt->psi &&
             pid->i_owner_number == prg->i_number && pid->psi == NULL )
         {
@@ -3813,11 +4049,14 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_pmt )
     for( p_es = p_pmt->p_first_es; p_es != NULL; p_es = p_es->p_next )
     {
         ts_pid_t tmp_pid, *old_pid = 0, *pid = &tmp_pid;
+        ts_pid_t *es_pid = ts_pid_Get( &p_sys->pids, p_es->i_pid );
+        if( unlikely( es_pid == NULL ) )
+            continue;
 
         /* Find out if the PID was already declared */
         for( int i = 0; i < i_clean; i++ )
         {
-            if( pp_clean[i] == &p_sys->pid[p_es->i_pid] )
+            if( pp_clean[i] == es_pid )
             {
                 old_pid = pp_clean[i];
                 break;
@@ -3825,7 +4064,7 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_pmt )
         }
         ValidateDVBMeta( p_demux, p_es->i_pid );
 
-        if( !old_pid && p_sys->pid[p_es->i_pid].b_valid )
+        if( !old_pid && es_pid->b_valid )
         {
             msg_Warn( p_demux, "pmt error: pid=%d already defined",
                       p_es->i_pid );
@@ -3843,7 +4082,7 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_pmt )
         PIDFillFormat( pid->es, p_es->i_type );
         pid->i_owner_number = prg->i_number;
         pid->i_pid          = p_es->i_pid;
-        pid->b_seen         = p_sys->pid[p_es->i_pid].b_seen;
+        pid->b_seen         = es_pid->b_seen;
 
         if( p_es->i_type == 0x10 || p_es->i_type == 0x11 ||
             p_es->i_type == 0x12 || p_es->i_type == 0x0f )
@@ -3945,7 +4184,7 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_pmt )
             PIDClean( p_demux, old_pid );
             TAB_REMOVE( i_clean, pp_clean, old_pid );
         }
-        p_sys->pid[p_es->i_pid] = *pid;
+        *es_pid = *pid;
 
         p_dr = PMTEsFindDescriptor( p_es, 0x09 );
         if( p_dr && p_dr->i_length >= 2 )
@@ -3981,7 +4220,7 @@ static void PATCallBack( void *data, dvbpsi_pat_t *p_pat )
     demux_t              *p_demux = data;
     demux_sys_t          *p_sys = p_demux->p_sys;
     dvbpsi_pat_program_t *p_program;
-    ts_pid_t             *pat = &p_sys->pid[0];
+    ts_pid_t             *pat = ts_pid_Get( &p_sys->pids, 0 );
 
     msg_Dbg( p_demux, "PATCallBack called" );
 
@@ -4027,11 +4266,9 @@ static void PATCallBack( void *data, dvbpsi_pat_t *p_pat )
         }
 
         /* Delete all ES attached to thoses PMT */
-        for( int i = 2; i < 8192; i++ )
+        ts_pid_Foreach( &p_sys->pids, pid )
         {
-            ts_pid_t *pid = &p_sys->pid[i];
-
-            if( !pid->b_valid || pid->psi )
+            if( pid->i_pid < 2 || !pid->b_valid || pid->psi )
                 continue;
 
             for( int j = 0; j < i_pmt_rm && pid->b_valid; j++ )
@@ -4043,7 +4280,7 @@ static void PATCallBack( void *data, dvbpsi_pat_t *p_pat )
                         continue;
 
                     if( pid->es->id )
-                        SetPIDFilter( p_demux, i, false );
+                        SetPIDFilter( p_demux, pid->i_pid, false );
 
                     PIDClean( p_demux, pid );
                     break;
@@ -4063,7 +4300,7 @@ static void PATCallBack( void *data, dvbpsi_pat_t *p_pat )
                 es_out_Control( p_demux->out, ES_OUT_DEL_GROUP, i_number );
             }
 
-            PIDClean( p_demux, &p_sys->pid[pid->i_pid] );
+            PIDClean( p_demux, pid );
             TAB_REMOVE( p_sys->i_pmt, p_sys->pmt, pid );
         }
 
@@ -4079,7 +4316,9 @@ static void PATCallBack( void *data, dvbpsi_pat_t *p_pat )
         if( p_program->i_number == 0 )
             continue;
 
-        ts_pid_t *pmt = &p_sys->pid[p_program->i_pid];
+        ts_pid_t *pmt = ts_pid_Get( &p_sys->pids, p_program->i_pid );
+        if( unlikely( pmt == NULL ) )
+            continue;
 
         ValidateDVBMeta( p_demux, p_program->i_pid );
 
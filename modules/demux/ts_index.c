@@ -0,0 +1,693 @@
+/*****************************************************************************
+ * ts_index.c: persistent PCR and random access index for the TS demuxer
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_atomic.h>
+
+#include <sys/stat.h>
+
+#include "ts_index.h"
+
+/* At most one PCR entry per second, the random access points are all kept */
+#define INDEX_PCR_INTERVAL  90000
+/* The random access points further back than that are not used */
+#define INDEX_RAI_MAX_DELAY (10 * 90000)
+
+#define INDEX_FLAG_RAI       0x01 /* random access point */
+#define INDEX_FLAG_CONTINUED 0x02 /* nothing missing since the previous entry */
+
+/* Cache file: header, then big endian entries */
+#define INDEX_MAGIC         "VLCTSIDX"
+#define INDEX_VERSION       1
+#define INDEX_HEADER_SIZE   (8 + 4 + 8 + 8 + 2 + 2 + 1 + 4)
+#define INDEX_ENTRY_SIZE    (8 + 8 + 1)
+/* Cache files kept, the least recently saved ones are removed beyond */
+#define INDEX_CACHE_FILES   100
+
+/* Packets read at once by the scan */
+#define INDEX_SCAN_PACKETS  1024
+
+typedef struct
+{
+    int64_t i_pcr;
+    int64_t i_pos;
+    int     i_flags;
+} ts_index_entry_t;
+
+typedef struct
+{
+    ts_index_entry_t *p_entry;
+    int              i_count;
+    int              i_alloc;
+} ts_index_table_t;
+
+struct ts_index_t
+{
+    vlc_object_t *p_obj;
+    vlc_mutex_t  lock;
+
+    /* Identity of the file */
+    char         *psz_url;
+    char         *psz_cache; /* NULL if the index is not saved */
+    int64_t      i_size;
+    int64_t      i_mtime;
+    int          i_packet_size;
+    int          i_pid_pcr;
+
+    ts_index_table_t table;
+    int          i_last; /* entry added last while demuxing, -1 if none */
+    bool         b_complete;
+    bool         b_modified;
+
+    /* Background scan */
+    bool         b_scan;
+    vlc_thread_t thread;
+    atomic_bool  b_stop;
+    int          i_pid_rai;
+};
+
+/*****************************************************************************
+ * Table
+ *****************************************************************************/
+static ts_index_entry_t *TableInsert( ts_index_table_t *t, int i_at )
+{
+    if( t->i_count >= t->i_alloc )
+    {
+        const int i_alloc = __MAX( 2 * t->i_alloc, 256 );
+        ts_index_entry_t *p_entry = realloc( t->p_entry,
+                                             i_alloc * sizeof(*p_entry) );
+        if( !p_entry )
+            return NULL;
+        t->p_entry = p_entry;
+        t->i_alloc = i_alloc;
+    }
+    memmove( &t->p_entry[i_at + 1], &t->p_entry[i_at],
+             (t->i_count - i_at) * sizeof(*t->p_entry) );
+    t->i_count++;
+    return &t->p_entry[i_at];
+}
+
+static void TableClean( ts_index_table_t *t )
+{
+    free( t->p_entry );
+    t->p_entry = NULL;
+    t->i_count = t->i_alloc = 0;
+}
+
+/* It returns the first entry at or after i_pos */
+static int TableLookupPos( const ts_index_table_t *t, int64_t i_pos )
+{
+    int i_low = 0, i_high = t->i_count;
+
+    while( i_low < i_high )
+    {
+        const int i_mid = (i_low + i_high) / 2;
+        if( t->p_entry[i_mid].i_pos < i_pos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/* It returns the last entry with a PCR not after i_pcr, or -1 */
+static int TableLookupPCR( const ts_index_table_t *t, int64_t i_pcr )
+{
+    int i_low = 0, i_high = t->i_count;
+
+    while( i_low < i_high )
+    {
+        const int i_mid = (i_low + i_high) / 2;
+        if( t->p_entry[i_mid].i_pcr <= i_pcr )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low - 1;
+}
+
+/*****************************************************************************
+ * Cache file
+ *****************************************************************************/
+static char *CachePath( const char *psz_url )
+{
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( !psz_dir )
+        return NULL;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, psz_url, strlen( psz_url ) );
+    EndMD5( &md5 );
+    char *psz_hash = psz_md5_hash( &md5 );
+
+    char *psz_path = NULL;
+    if( psz_hash )
+    {
+        vlc_mkdir( psz_dir, 0700 );
+        if( asprintf( &psz_path, "%s"DIR_SEP"ts-index", psz_dir ) >= 0 )
+        {
+            vlc_mkdir( psz_path, 0700 );
+            free( psz_path );
+            if( asprintf( &psz_path, "%s"DIR_SEP"ts-index"DIR_SEP"%s",
+                          psz_dir, psz_hash ) < 0 )
+                psz_path = NULL;
+        }
+        else
+            psz_path = NULL;
+        free( psz_hash );
+    }
+    free( psz_dir );
+    return psz_path;
+}
+
+static void Load( ts_index_t *p_index )
+{
+    FILE *f = vlc_fopen( p_index->psz_cache, "rb" );
+    if( !f )
+        return;
+
+    uint8_t header[INDEX_HEADER_SIZE];
+    if( fread( header, sizeof(header), 1, f ) != 1 ||
+        memcmp( header, INDEX_MAGIC, 8 ) ||
+        GetDWBE( &header[8] ) != INDEX_VERSION ||
+        (int64_t)GetQWBE( &header[12] ) != p_index->i_size ||
+        (int64_t)GetQWBE( &header[20] ) != p_index->i_mtime ||
+        GetWBE( &header[28] ) != p_index->i_packet_size ||
+        GetWBE( &header[30] ) != p_index->i_pid_pcr )
+    {
+        msg_Dbg( p_index->p_obj, "ignoring the outdated index %s",
+                 p_index->psz_cache );
+        fclose( f );
+        return;
+    }
+
+    const bool b_complete = header[32] != 0;
+    const uint32_t i_count = GetDWBE( &header[33] );
+    if( i_count == 0 || i_count > p_index->i_size / p_index->i_packet_size )
+    {
+        fclose( f );
+        return;
+    }
+
+    ts_index_table_t table = { NULL, 0, 0 };
+    for( uint32_t i = 0; i < i_count; i++ )
+    {
+        uint8_t entry[INDEX_ENTRY_SIZE];
+        if( fread( entry, sizeof(entry), 1, f ) != 1 )
+            break;
+
+        ts_index_entry_t *p_entry = TableInsert( &table, table.i_count );
+        if( !p_entry )
+            break;
+        p_entry->i_pcr = GetQWBE( &entry[0] );
+        p_entry->i_pos = GetQWBE( &entry[8] );
+        p_entry->i_flags = entry[16];
+
+        /* The entries are sorted by position and PCR */
+        if( p_entry->i_pos < 0 || p_entry->i_pos >= p_index->i_size ||
+            ( table.i_count > 1 &&
+              ( p_entry[-1].i_pos >= p_entry->i_pos ||
+                p_entry[-1].i_pcr > p_entry->i_pcr ) ) )
+        {
+            table.i_count--;
+            break;
+        }
+    }
+    fclose( f );
+
+    if( (uint32_t)table.i_count != i_count )
+    {
+        msg_Warn( p_index->p_obj, "invalid index %s", p_index->psz_cache );
+        TableClean( &table );
+        return;
+    }
+
+    msg_Dbg( p_index->p_obj, "loaded %s index of %d entries",
+             b_complete ? "complete" : "partial", table.i_count );
+    p_index->table = table;
+    p_index->b_complete = b_complete;
+}
+
+typedef struct
+{
+    char   *psz_path;
+    time_t i_mtime;
+} ts_index_file_t;
+
+static int CacheFileCompare( const void *a, const void *b )
+{
+    const ts_index_file_t *fa = a, *fb = b;
+
+    /* Most recent first */
+    return fa->i_mtime < fb->i_mtime ? 1 : fa->i_mtime > fb->i_mtime ? -1 : 0;
+}
+
+/* It removes the oldest files of the cache directory of the index beyond
+ * INDEX_CACHE_FILES, so that it does not grow with every file played. */
+static void Prune( ts_index_t *p_index )
+{
+    char *psz_dir = strdup( p_index->psz_cache );
+    if( !psz_dir )
+        return;
+    char *psz_sep = strrchr( psz_dir, DIR_SEP_CHAR );
+    DIR *dir = NULL;
+    if( psz_sep )
+    {
+        *psz_sep = '\0';
+        dir = vlc_opendir( psz_dir );
+    }
+    if( !dir )
+    {
+        free( psz_dir );
+        return;
+    }
+
+    ts_index_file_t *p_files = NULL;
+    int i_files = 0, i_alloc = 0;
+    char *psz_name;
+    while( (psz_name = vlc_readdir( dir )) != NULL )
+    {
+        char *psz_path;
+        struct stat st;
+
+        if( psz_name[0] == '.' ||
+            asprintf( &psz_path, "%s"DIR_SEP"%s", psz_dir, psz_name ) < 0 )
+        {
+            free( psz_name );
+            continue;
+        }
+        free( psz_name );
+
+        if( vlc_stat( psz_path, &st ) || !S_ISREG( st.st_mode ) )
+        {
+            free( psz_path );
+            continue;
+        }
+        if( i_files == i_alloc )
+        {
+            const int i_new = i_alloc > 0 ? 2 * i_alloc : 128;
+            ts_index_file_t *p_new = realloc( p_files,
+                                              i_new * sizeof(*p_new) );
+            if( !p_new )
+            {
+                free( psz_path );
+                break;
+            }
+            p_files = p_new;
+            i_alloc = i_new;
+        }
+        p_files[i_files].psz_path = psz_path;
+        p_files[i_files].i_mtime = st.st_mtime;
+        i_files++;
+    }
+    closedir( dir );
+
+    if( i_files > INDEX_CACHE_FILES )
+    {
+        qsort( p_files, i_files, sizeof(*p_files), CacheFileCompare );
+        msg_Dbg( p_index->p_obj, "removing %d old index files",
+                 i_files - INDEX_CACHE_FILES );
+        for( int i = INDEX_CACHE_FILES; i < i_files; i++ )
+            vlc_unlink( p_files[i].psz_path );
+    }
+    for( int i = 0; i < i_files; i++ )
+        free( p_files[i].psz_path );
+    free( p_files );
+    free( psz_dir );
+}
+
+static void Save( ts_index_t *p_index )
+{
+    const ts_index_table_t *t = &p_index->table;
+    char *psz_tmp;
+
+    if( asprintf( &psz_tmp, "%s.tmp", p_index->psz_cache ) < 0 )
+        return;
+
+    FILE *f = vlc_fopen( psz_tmp, "wb" );
+    if( !f )
+    {
+        free( psz_tmp );
+        return;
+    }
+
+    uint8_t header[INDEX_HEADER_SIZE];
+    memcpy( header, INDEX_MAGIC, 8 );
+    SetDWBE( &header[8], INDEX_VERSION );
+    SetQWBE( &header[12], p_index->i_size );
+    SetQWBE( &header[20], p_index->i_mtime );
+    SetWBE( &header[28], p_index->i_packet_size );
+    SetWBE( &header[30], p_index->i_pid_pcr );
+    header[32] = p_index->b_complete;
+    SetDWBE( &header[33], t->i_count );
+
+    bool b_error = fwrite( header, sizeof(header), 1, f ) != 1;
+    for( int i = 0; i < t->i_count && !b_error; i++ )
+    {
+        uint8_t entry[INDEX_ENTRY_SIZE];
+        SetQWBE( &entry[0], t->p_entry[i].i_pcr );
+        SetQWBE( &entry[8], t->p_entry[i].i_pos );
+        entry[16] = t->p_entry[i].i_flags;
+        b_error = fwrite( entry, sizeof(entry), 1, f ) != 1;
+    }
+
+    if( fclose( f ) || b_error ||
+        vlc_rename( psz_tmp, p_index->psz_cache ) )
+    {
+        msg_Warn( p_index->p_obj, "cannot save the index %s",
+                  p_index->psz_cache );
+        vlc_unlink( psz_tmp );
+    }
+    else
+        Prune( p_index );
+    free( psz_tmp );
+}
+
+/*****************************************************************************
+ * Background scan
+ *****************************************************************************/
+static void ScanAdd( ts_index_table_t *t, int64_t i_pcr, int64_t i_pos,
+                     bool b_rai )
+{
+    ts_index_entry_t *p_prev = t->i_count > 0 ? &t->p_entry[t->i_count - 1]
+                                              : NULL;
+    if( p_prev && p_prev->i_pos == i_pos )
+    {
+        /* Random access point carrying the PCR */
+        if( b_rai )
+            p_prev->i_flags |= INDEX_FLAG_RAI;
+        return;
+    }
+    if( p_prev && !b_rai && i_pcr < p_prev->i_pcr + INDEX_PCR_INTERVAL )
+        return;
+
+    ts_index_entry_t *p_entry = TableInsert( t, t->i_count );
+    if( p_entry )
+    {
+        p_entry->i_pcr = i_pcr;
+        p_entry->i_pos = i_pos;
+        p_entry->i_flags = (b_rai ? INDEX_FLAG_RAI : 0) |
+                           (p_prev ? INDEX_FLAG_CONTINUED : 0);
+    }
+}
+
+static void *Scan( void *data )
+{
+    ts_index_t *p_index = data;
+    const int i_size = p_index->i_packet_size;
+
+    stream_t *s = stream_UrlNew( p_index->p_obj, p_index->psz_url );
+    if( !s )
+        return NULL;
+
+    ts_index_table_t table = { NULL, 0, 0 };
+    int64_t i_pos = 0;
+    int64_t i_pcr = -1;
+    int64_t i_pcr_raw = -1;
+    int64_t i_wrap = 0;
+    bool    b_eof = false;
+
+    while( !atomic_load( &p_index->b_stop ) )
+    {
+        const uint8_t *p_peek;
+        const int i_peek = stream_Peek( s, &p_peek, i_size * INDEX_SCAN_PACKETS );
+        if( i_peek < i_size )
+        {
+            b_eof = true;
+            break;
+        }
+
+        int i = 0;
+        while( i + i_size <= i_peek )
+        {
+            const uint8_t *p = &p_peek[i];
+            if( p[0] != 0x47 )
+            {
+                /* Re-sync */
+                i++;
+                continue;
+            }
+            const int i_pid = ( (p[1]&0x1f)<<8 )|p[2];
+            const bool b_adaptation = (p[3]&0x20) && p[4] > 0;
+
+            if( i_pid == p_index->i_pid_pcr && b_adaptation &&
+                (p[5]&0x10) && p[4] >= 7 )
+            {
+                const int64_t i_raw = ( (int64_t)p[6] << 25 ) |
+                                      ( (int64_t)p[7] << 17 ) |
+                                      ( (int64_t)p[8] << 9 ) |
+                                      ( (int64_t)p[9] << 1 ) |
+                                      ( (int64_t)p[10] >> 7 );
+                /* Same wrap around handling as while demuxing */
+                if( i_pcr_raw > i_raw )
+                    i_wrap += TS_INDEX_PCR_WRAP;
+                i_pcr_raw = i_raw;
+                i_pcr = i_raw + i_wrap;
+                ScanAdd( &table, i_pcr, i_pos + i, false );
+            }
+            if( i_pid == p_index->i_pid_rai && (p[1]&0x40) &&
+                b_adaptation && (p[5]&0x40) && i_pcr >= 0 )
+                ScanAdd( &table, i_pcr, i_pos + i, true );
+
+            i += i_size;
+        }
+        if( stream_Read( s, NULL, i ) < i || i == 0 )
+        {
+            b_eof = true;
+            break;
+        }
+        i_pos += i;
+    }
+    stream_Delete( s );
+
+    if( !b_eof || table.i_count == 0 )
+    {
+        TableClean( &table );
+        return NULL;
+    }
+
+    /* The scan has everything the demuxing could have indexed */
+    vlc_mutex_lock( &p_index->lock );
+    TableClean( &p_index->table );
+    p_index->table = table;
+    p_index->i_last = -1;
+    p_index->b_complete = true;
+    p_index->b_modified = true;
+    vlc_mutex_unlock( &p_index->lock );
+
+    msg_Dbg( p_index->p_obj, "scanned index of %d entries", table.i_count );
+    return NULL;
+}
+
+/*****************************************************************************
+ * API
+ *****************************************************************************/
+ts_index_t *ts_index_New( demux_t *p_demux, int i_packet_size, int i_pid_pcr )
+{
+    const int64_t i_size = stream_Size( p_demux->s );
+    if( i_size <= 0 || i_pid_pcr < 0 )
+        return NULL;
+
+    ts_index_t *p_index = calloc( 1, sizeof(*p_index) );
+    if( !p_index )
+        return NULL;
+
+    if( asprintf( &p_index->psz_url, "%s://%s", p_demux->psz_access,
+                  p_demux->psz_location ) < 0 )
+    {
+        free( p_index );
+        return NULL;
+    }
+    p_index->p_obj = VLC_OBJECT(p_demux);
+    vlc_mutex_init( &p_index->lock );
+    p_index->i_size = i_size;
+    p_index->i_packet_size = i_packet_size;
+    p_index->i_pid_pcr = i_pid_pcr;
+    p_index->i_last = -1;
+    p_index->b_scan = false;
+    atomic_init( &p_index->b_stop, false );
+
+    /* Local files are also identified by their modification date */
+    struct stat st;
+    if( !strcmp( p_demux->psz_access, "file" ) && p_demux->psz_file &&
+        !vlc_stat( p_demux->psz_file, &st ) )
+        p_index->i_mtime = st.st_mtime;
+
+    p_index->psz_cache = CachePath( p_index->psz_url );
+    if( p_index->psz_cache )
+        Load( p_index );
+
+    return p_index;
+}
+
+void ts_index_Delete( ts_index_t *p_index )
+{
+    if( p_index->b_scan )
+    {
+        atomic_store( &p_index->b_stop, true );
+        vlc_join( p_index->thread, NULL );
+    }
+
+    if( p_index->b_modified && p_index->psz_cache &&
+        p_index->table.i_count > 0 )
+        Save( p_index );
+
+    TableClean( &p_index->table );
+    vlc_mutex_destroy( &p_index->lock );
+    free( p_index->psz_cache );
+    free( p_index->psz_url );
+    free( p_index );
+}
+
+void ts_index_Add( ts_index_t *p_index, int64_t i_pcr, int64_t i_pos,
+                   bool b_rai )
+{
+    vlc_mutex_lock( &p_index->lock );
+
+    /* The PCR of a random access point is not known since a discontinuity */
+    if( b_rai && p_index->i_last < 0 )
+    {
+        vlc_mutex_unlock( &p_index->lock );
+        return;
+    }
+
+    ts_index_table_t *t = &p_index->table;
+    const int  i_at = TableLookupPos( t, i_pos );
+    const bool b_continued = p_index->i_last >= 0 &&
+                             p_index->i_last == i_at - 1;
+    const int  i_flags = (b_rai ? INDEX_FLAG_RAI : 0) |
+                         (b_continued ? INDEX_FLAG_CONTINUED : 0);
+
+    if( i_at < t->i_count && t->p_entry[i_at].i_pos == i_pos )
+    {
+        /* Already known: only what was missing is added */
+        ts_index_entry_t *p_entry = &t->p_entry[i_at];
+        if( (p_entry->i_flags | i_flags) != p_entry->i_flags )
+        {
+            p_entry->i_flags |= i_flags;
+            p_index->b_modified = true;
+        }
+        p_index->i_last = i_at;
+    }
+    else if( b_continued && !b_rai &&
+             i_pcr < t->p_entry[i_at - 1].i_pcr + INDEX_PCR_INTERVAL )
+    {
+        /* Too close to the previous entry, that still is the last one */
+    }
+    else if( ( i_at > 0 && t->p_entry[i_at - 1].i_pcr > i_pcr ) ||
+             ( i_at < t->i_count && t->p_entry[i_at].i_pcr < i_pcr ) )
+    {
+        /* Not in order (PCR discontinuity): the table has to stay sorted */
+        p_index->i_last = -1;
+    }
+    else
+    {
+        ts_index_entry_t *p_entry = TableInsert( t, i_at );
+        if( p_entry )
+        {
+            p_entry->i_pcr = i_pcr;
+            p_entry->i_pos = i_pos;
+            p_entry->i_flags = i_flags;
+            p_index->b_modified = true;
+        }
+        p_index->i_last = p_entry ? i_at : -1;
+    }
+
+    vlc_mutex_unlock( &p_index->lock );
+}
+
+void ts_index_Discontinuity( ts_index_t *p_index )
+{
+    vlc_mutex_lock( &p_index->lock );
+    p_index->i_last = -1;
+    vlc_mutex_unlock( &p_index->lock );
+}
+
+int ts_index_Find( ts_index_t *p_index, int64_t i_pcr, int64_t *pi_pcr,
+                   int64_t *pi_pos )
+{
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_index->lock );
+
+    const ts_index_table_t *t = &p_index->table;
+    const int i = TableLookupPCR( t, i_pcr );
+
+    /* Nothing must be missing up to the next entry (or the end) */
+    if( i >= 0 &&
+        ( ( i + 1 < t->i_count &&
+            (t->p_entry[i + 1].i_flags & INDEX_FLAG_CONTINUED) ) ||
+          ( i + 1 == t->i_count && p_index->b_complete ) ) )
+    {
+        /* Go back to the previous random access point */
+        int j = i;
+        while( j > 0 && !(t->p_entry[j].i_flags & INDEX_FLAG_RAI) &&
+               (t->p_entry[j].i_flags & INDEX_FLAG_CONTINUED) &&
+               t->p_entry[i].i_pcr - t->p_entry[j - 1].i_pcr <= INDEX_RAI_MAX_DELAY )
+            j--;
+        if( !(t->p_entry[j].i_flags & INDEX_FLAG_RAI) )
+            j = i;
+
+        *pi_pcr = t->p_entry[j].i_pcr;
+        *pi_pos = t->p_entry[j].i_pos;
+        i_ret = VLC_SUCCESS;
+    }
+
+    vlc_mutex_unlock( &p_index->lock );
+    return i_ret;
+}
+
+int ts_index_GetLast( ts_index_t *p_index, int64_t *pi_pcr )
+{
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_index->lock );
+    if( p_index->b_complete && p_index->table.i_count > 0 )
+    {
+        *pi_pcr = p_index->table.p_entry[p_index->table.i_count - 1].i_pcr;
+        i_ret = VLC_SUCCESS;
+    }
+    vlc_mutex_unlock( &p_index->lock );
+    return i_ret;
+}
+
+int ts_index_StartScan( ts_index_t *p_index, int i_pid_rai )
+{
+    if( p_index->b_scan || p_index->b_complete )
+        return VLC_EGENERIC;
+
+    p_index->i_pid_rai = i_pid_rai;
+    if( vlc_clone( &p_index->thread, Scan, p_index,
+                   VLC_THREAD_PRIORITY_LOW ) )
+        return VLC_EGENERIC;
+    p_index->b_scan = true;
+    return VLC_SUCCESS;
+}
@@ -0,0 +1,58 @@
+/*****************************************************************************
+ * ts_index.h: persistent PCR and random access index for the TS demuxer
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TS_INDEX_H
+#define VLC_TS_INDEX_H
+
+/*
+ * The index maps PCR values (90kHz, wrap arounds included) to the byte
+ * position of their packet. It is filled while demuxing, and optionally by a
+ * scan of the whole file in the background, then saved in the cache
+ * directory so that the next openings of the same file can seek with it.
+ *
+ * An entry is only used for seeking when nothing is missing between it and
+ * the next one, so a partial index never gives a wrong position.
+ */
+typedef struct ts_index_t ts_index_t;
+
+/* Increment of the PCR at each of its wrap arounds */
+#define TS_INDEX_PCR_WRAP INT64_C(0x1FFFFFFFF)
+
+ts_index_t *ts_index_New( demux_t *, int i_packet_size, int i_pid_pcr );
+void ts_index_Delete( ts_index_t * );
+
+/* The packet at i_pos carries the PCR i_pcr, or is a random access point
+ * (b_rai) demuxed after the PCR i_pcr */
+void ts_index_Add( ts_index_t *, int64_t i_pcr, int64_t i_pos, bool b_rai );
+/* The next entries do not follow the previous ones (seek) */
+void ts_index_Discontinuity( ts_index_t * );
+
+/* It gives the position of the last random access point (or PCR) before
+ * i_pcr, and its PCR */
+int ts_index_Find( ts_index_t *, int64_t i_pcr, int64_t *pi_pcr,
+                   int64_t *pi_pos );
+/* It gives the last PCR of the file, once it has been fully indexed */
+int ts_index_GetLast( ts_index_t *, int64_t *pi_pcr );
+
+/* It indexes the whole file in the background, with the random access
+ * points of the PID i_pid_rai (-1 for none) */
+int ts_index_StartScan( ts_index_t *, int i_pid_rai );
+
+#endif
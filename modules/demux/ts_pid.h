@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * ts_pid.h: sparse PID table for the TS demuxer
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TS_PID_H
+#define VLC_TS_PID_H
+
+/* Defined by the demuxer */
+typedef struct ts_psi_t ts_psi_t;
+typedef struct ts_es_t  ts_es_t;
+
+typedef struct
+{
+    int         i_pid;
+
+    bool        b_seen;
+    bool        b_valid;
+    int         i_cc;   /* countinuity counter */
+    bool        b_scrambled;
+    bool        b_selected; /* ES state when the current unit started */
+
+    /* PSI owner (ie PMT -> PAT, ES -> PMT */
+    ts_psi_t   *p_owner;
+    int         i_owner_number;
+
+    /* */
+    ts_psi_t    *psi;
+    ts_es_t     *es;
+
+    /* Some private streams encapsulate several ES (eg. DVB subtitles)*/
+    ts_es_t     **extra_es;
+    int         i_extra_es;
+
+} ts_pid_t;
+
+/*
+ * A stream only uses a few of the 8192 PIDs, usually grouped, so the PIDs are
+ * kept by chunks of 64 allocated at their first use, found in two indexings.
+ * The chunks are never moved nor freed before ts_pid_TableClean(), so the
+ * pointers to the PIDs stay valid.
+ */
+#define TS_PID_COUNT      8192
+#define TS_PID_CHUNK_BITS 6
+#define TS_PID_CHUNK_SIZE (1 << TS_PID_CHUNK_BITS)
+
+typedef struct
+{
+    ts_pid_t *chunk[TS_PID_COUNT / TS_PID_CHUNK_SIZE];
+} ts_pid_table_t;
+
+static inline ts_pid_t *ts_pid_NewChunk( ts_pid_table_t *p_table, int i_chunk )
+{
+    ts_pid_t *p_chunk = calloc( TS_PID_CHUNK_SIZE, sizeof( *p_chunk ) );
+
+    if( unlikely( p_chunk == NULL ) )
+        return NULL;
+    for( int i = 0; i < TS_PID_CHUNK_SIZE; i++ )
+        p_chunk[i].i_pid = (i_chunk << TS_PID_CHUNK_BITS) | i;
+    p_table->chunk[i_chunk] = p_chunk;
+    return p_chunk;
+}
+
+/* It returns the PID i_pid (0 to 8191), created unused if needed, or NULL if
+ * out of memory. It cannot fail once a PID of the same chunk was created. */
+static inline ts_pid_t *ts_pid_Get( ts_pid_table_t *p_table, int i_pid )
+{
+    const int i_chunk = i_pid >> TS_PID_CHUNK_BITS;
+    ts_pid_t *p_chunk = p_table->chunk[i_chunk];
+
+    if( unlikely( p_chunk == NULL ) )
+    {
+        p_chunk = ts_pid_NewChunk( p_table, i_chunk );
+        if( unlikely( p_chunk == NULL ) )
+            return NULL;
+    }
+    return &p_chunk[i_pid & (TS_PID_CHUNK_SIZE - 1)];
+}
+
+/* It returns the first created PID from i_pid, or NULL */
+static inline ts_pid_t *ts_pid_Next( const ts_pid_table_t *p_table, int i_pid )
+{
+    while( i_pid < TS_PID_COUNT )
+    {
+        ts_pid_t *p_chunk = p_table->chunk[i_pid >> TS_PID_CHUNK_BITS];
+        if( p_chunk )
+            return &p_chunk[i_pid & (TS_PID_CHUNK_SIZE - 1)];
+        i_pid = (i_pid | (TS_PID_CHUNK_SIZE - 1)) + 1;
+    }
+    return NULL;
+}
+
+/* Iteration on all the created PIDs, by increasing values */
+#define ts_pid_Foreach( p_table, pid ) \
+    for( ts_pid_t *pid = ts_pid_Next( p_table, 0 ); pid != NULL; \
+         pid = ts_pid_Next( p_table, pid->i_pid + 1 ) )
+
+static inline void ts_pid_TableClean( ts_pid_table_t *p_table )
+{
+    for( int i = 0; i < TS_PID_COUNT / TS_PID_CHUNK_SIZE; i++ )
+    {
+        free( p_table->chunk[i] );
+        p_table->chunk[i] = NULL;
+    }
+}
+
+#endif
@@ -196,6 +196,34 @@ static int vlclua_input_item_stats( lua_State *L )
         STATS_INT( lost_abuffers )
 #undef STATS_INT
 #undef STATS_FLOAT
+
+        /* Flat fields, so that they can be graphed from the HTTP status */
+        const vout_timing_t *p_vt = &p_item->p_stats->vout_timing;
+        uint64_t i_displayed = 0;
+        for( unsigned i = 0; i < VOUT_TIMING_LATE_BUCKETS; i++ )
+        {
+            char psz_name[sizeof("late_pictures_") + 3];
+            snprintf( psz_name, sizeof(psz_name), "late_pictures_%u", i );
+            lua_pushinteger( L, p_vt->late[i] );
+            lua_setfield( L, -2, psz_name );
+            i_displayed += p_vt->late[i];
+        }
+#define STATS_STAGE( n, s ) \
+        lua_pushinteger( L, p_vt->stage[s].count > 0 ? \
+                 p_vt->stage[s].total / p_vt->stage[s].count : 0 ); \
+        lua_setfield( L, -2, #n "_time" ); \
+        lua_pushinteger( L, p_vt->stage[s].max ); \
+        lua_setfield( L, -2, #n "_time_max" );
+        STATS_STAGE( filter, VOUT_TIMING_FILTER )
+        STATS_STAGE( spu, VOUT_TIMING_SPU )
+        STATS_STAGE( prepare, VOUT_TIMING_PREPARE )
+        STATS_STAGE( display, VOUT_TIMING_DISPLAY )
+#undef STATS_STAGE
+        lua_pushnumber( L, i_displayed > 0 ?
+                        (double)p_vt->queue_total / i_displayed : 0. );
+        lua_setfield( L, -2, "picture_queue" );
+        lua_pushinteger( L, p_vt->queue_max );
+        lua_setfield( L, -2, "picture_queue_max" );
         vlc_mutex_unlock( &p_item->p_stats->lock );
     }
     return 1;
@@ -0,0 +1,173 @@
+/*****************************************************************************
+ * startcode_helper.h: fast 00 00 01 startcode lookup
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_STARTCODE_HELPER_H_
+#define VLC_STARTCODE_HELPER_H_
+
+#include <vlc_cpu.h>
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
+/*
+ * All these functions return a pointer to the first 00 00 01 startcode
+ * entirely within [p, end), or NULL. They are meant to be given to
+ * block_FindStartcodeFromOffset(), which handles the startcodes crossing
+ * the block boundaries.
+ */
+
+/* Reference, one byte at a time */
+static inline const uint8_t *startcode_FindAnnexB_C( const uint8_t *p,
+                                                     const uint8_t *end )
+{
+    for( end -= 2; p < end; p++ )
+    {
+        if( p[0] == 0 && p[1] == 0 && p[2] == 1 )
+            return p;
+    }
+    return NULL;
+}
+
+/* Word at a time: a startcode starts with a null byte, so only the words
+ * with one are looked at byte per byte */
+static inline const uint8_t *startcode_FindAnnexB_Bits( const uint8_t *p,
+                                                        const uint8_t *end )
+{
+    for( ; p + sizeof(uint64_t) + 2 <= end; p += sizeof(uint64_t) )
+    {
+        uint64_t x;
+        memcpy( &x, p, sizeof(x) );
+
+        if( !((x - UINT64_C(0x0101010101010101)) & ~x &
+              UINT64_C(0x8080808080808080)) )
+            continue;
+
+        for( unsigned i = 0; i < sizeof(uint64_t); i++ )
+        {
+            if( p[i] == 0 && p[i + 1] == 0 && p[i + 2] == 1 )
+                return &p[i];
+        }
+    }
+    return startcode_FindAnnexB_C( p, end );
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+__attribute__ ((__target__ ("sse2")))
+static inline const uint8_t *startcode_FindAnnexB_SSE2( const uint8_t *p,
+                                                        const uint8_t *end )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8( 1 );
+
+    for( ; p + 16 + 2 <= end; p += 16 )
+    {
+        const __m128i b0 = _mm_loadu_si128( (const __m128i *)&p[0] );
+        const __m128i b1 = _mm_loadu_si128( (const __m128i *)&p[1] );
+        const __m128i b2 = _mm_loadu_si128( (const __m128i *)&p[2] );
+        const __m128i match = _mm_and_si128(
+            _mm_and_si128( _mm_cmpeq_epi8( b0, zero ),
+                           _mm_cmpeq_epi8( b1, zero ) ),
+            _mm_cmpeq_epi8( b2, one ) );
+
+        const unsigned mask = _mm_movemask_epi8( match );
+        if( mask )
+            return &p[__builtin_ctz( mask )];
+    }
+    return startcode_FindAnnexB_C( p, end );
+}
+#endif
+
+#if defined(HAVE_AVX2_INTRINSICS)
+__attribute__ ((__target__ ("avx2")))
+static inline const uint8_t *startcode_FindAnnexB_AVX2( const uint8_t *p,
+                                                        const uint8_t *end )
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8( 1 );
+
+    for( ; p + 32 + 2 <= end; p += 32 )
+    {
+        const __m256i b0 = _mm256_loadu_si256( (const __m256i *)&p[0] );
+        const __m256i b1 = _mm256_loadu_si256( (const __m256i *)&p[1] );
+        const __m256i b2 = _mm256_loadu_si256( (const __m256i *)&p[2] );
+        const __m256i match = _mm256_and_si256(
+            _mm256_and_si256( _mm256_cmpeq_epi8( b0, zero ),
+                              _mm256_cmpeq_epi8( b1, zero ) ),
+            _mm256_cmpeq_epi8( b2, one ) );
+
+        const unsigned mask = _mm256_movemask_epi8( match );
+        if( mask )
+            return &p[__builtin_ctz( mask )];
+    }
+    return startcode_FindAnnexB_C( p, end );
+}
+#endif
+
+#if defined(__ARM_NEON__)
+static inline const uint8_t *startcode_FindAnnexB_NEON( const uint8_t *p,
+                                                        const uint8_t *end )
+{
+    const uint8x16_t zero = vdupq_n_u8( 0 );
+    const uint8x16_t one = vdupq_n_u8( 1 );
+
+    for( ; p + 16 + 2 <= end; p += 16 )
+    {
+        const uint8x16_t match = vandq_u8(
+            vandq_u8( vceqq_u8( vld1q_u8( &p[0] ), zero ),
+                      vceqq_u8( vld1q_u8( &p[1] ), zero ) ),
+            vceqq_u8( vld1q_u8( &p[2] ), one ) );
+
+        /* There is no movemask: find the byte once one is known to match */
+        const uint8x8_t any = vorr_u8( vget_low_u8( match ),
+                                       vget_high_u8( match ) );
+        if( vget_lane_u64( vreinterpret_u64_u8( any ), 0 ) )
+            return startcode_FindAnnexB_C( p, p + 16 + 2 );
+    }
+    return startcode_FindAnnexB_C( p, end );
+}
+#endif
+
+/* It uses the fastest of the functions above for the CPU */
+static inline const uint8_t *startcode_FindAnnexB( const uint8_t *p,
+                                                   const uint8_t *end )
+{
+#if defined(HAVE_AVX2_INTRINSICS)
+    if( vlc_CPU_AVX2() )
+        return startcode_FindAnnexB_AVX2( p, end );
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if( vlc_CPU_SSE2() )
+        return startcode_FindAnnexB_SSE2( p, end );
+#endif
+#if defined(__ARM_NEON__)
+    if( vlc_CPU_ARM_NEON() )
+        return startcode_FindAnnexB_NEON( p, end );
+#endif
+    return startcode_FindAnnexB_Bits( p, end );
+}
+
+#endif
@@ -0,0 +1,430 @@
+/*****************************************************************************
+ * prefetch.c: asynchronous read-ahead stream filter
+ *****************************************************************************
+ * Copyright © 2012 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_stream.h>
+
+#define BUFFER_TEXT N_("Buffer size")
+#define BUFFER_LONGTEXT N_( \
+    "Size (in KiB) of the read-ahead buffer.")
+#define READ_TEXT N_("Read size")
+#define READ_LONGTEXT N_( \
+    "Size (in bytes) of each read from the underlying stream. Seeking " \
+    "waits for at most one such read to complete.")
+
+static int  Open (vlc_object_t *);
+static void Close (vlc_object_t *);
+
+vlc_module_begin ()
+    set_category (CAT_INPUT)
+    set_subcategory (SUBCAT_INPUT_STREAM_FILTER)
+    set_capability ("stream_filter", 0)
+    set_shortname (N_("Prefetch"))
+    set_description (N_("Asynchronous read-ahead"))
+    add_shortcut ("prefetch")
+    set_callbacks (Open, Close)
+
+    add_integer_with_range ("prefetch-buffer-size", 16384, 4, 1 << 20,
+                            BUFFER_TEXT, BUFFER_LONGTEXT, true)
+    add_integer_with_range ("prefetch-read-size", 16384, 512, 1 << 22,
+                            READ_TEXT, READ_LONGTEXT, true)
+vlc_module_end ()
+
+/*
+ * The buffer is a ring holding the data from the current reading offset
+ * (buffer_offset) onward. The thread appends to it while the reader
+ * consumes from its head, so each side only touches its own part of the
+ * ring and the data is copied out of the lock.
+ *
+ * The source stream is only ever used with source_lock held. A seek
+ * outside the buffer bumps the generation so that the data being read by
+ * the thread, if any, is dropped; it then waits for that read (at most
+ * read_size bytes) to complete before seeking the source. The generation
+ * is protected by lock, which may be taken with source_lock held, but not
+ * the other way around.
+ */
+struct stream_sys_t
+{
+    vlc_mutex_t  lock;
+    vlc_mutex_t  source_lock;
+    vlc_cond_t   wait_data;
+    vlc_cond_t   wait_space;
+    vlc_thread_t thread;
+
+    uint64_t     buffer_offset; /* Stream offset of the ring head */
+    size_t       buffer_length; /* Bytes available from the ring head */
+    size_t       buffer_size;
+    size_t       read_size;
+    unsigned     generation;
+    bool         eof;
+    bool         can_seek;
+
+    uint8_t     *buffer;
+    uint8_t     *peek;
+    size_t       peek_size;
+};
+
+static size_t RingIndex (const stream_sys_t *sys, uint64_t offset)
+{
+    return offset % sys->buffer_size;
+}
+
+static void *Thread (void *data)
+{
+    stream_t *stream = data;
+    stream_sys_t *sys = stream->p_sys;
+
+    vlc_mutex_lock (&sys->lock);
+    mutex_cleanup_push (&sys->lock);
+    for (;;)
+    {
+        vlc_testcancel ();
+
+        if (sys->eof || sys->buffer_length == sys->buffer_size)
+        {
+            vlc_cond_wait (&sys->wait_space, &sys->lock);
+            continue;
+        }
+
+        const unsigned generation = sys->generation;
+        const uint64_t offset = sys->buffer_offset + sys->buffer_length;
+        const size_t index = RingIndex (sys, offset);
+        size_t length = sys->buffer_size - sys->buffer_length;
+
+        if (length > sys->buffer_size - index)
+            length = sys->buffer_size - index;
+        if (length > sys->read_size)
+            length = sys->read_size;
+        vlc_mutex_unlock (&sys->lock);
+
+        int canc = vlc_savecancel ();
+        vlc_mutex_lock (&sys->source_lock);
+        /* A seek may have happened while waiting for the source */
+        vlc_mutex_lock (&sys->lock);
+        bool current = generation == sys->generation;
+        vlc_mutex_unlock (&sys->lock);
+
+        int val = -1;
+        if (current)
+            val = stream_Read (stream->p_source, sys->buffer + index, length);
+        vlc_mutex_unlock (&sys->source_lock);
+        vlc_restorecancel (canc);
+
+        vlc_mutex_lock (&sys->lock);
+        if (generation != sys->generation)
+            continue; /* Seek: drop the data */
+
+        if (val <= 0)
+            sys->eof = true;
+        else
+            sys->buffer_length += val;
+        vlc_cond_signal (&sys->wait_data);
+    }
+    vlc_cleanup_pop ();
+    assert (0);
+    return NULL;
+}
+
+/**
+ * Waits until at least len bytes are buffered, or the end of the stream.
+ * \return the number of buffered bytes (possibly less than len)
+ */
+static size_t WaitData (stream_t *stream, size_t len)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    if (len > sys->buffer_size)
+        len = sys->buffer_size;
+
+    while (sys->buffer_length < len && !sys->eof)
+        vlc_cond_wait (&sys->wait_data, &sys->lock);
+    return sys->buffer_length;
+}
+
+/** Moves the ring head forward by len bytes (that must be buffered). */
+static void Consume (stream_sys_t *sys, size_t len)
+{
+    assert (len <= sys->buffer_length);
+
+    sys->buffer_offset += len;
+    sys->buffer_length -= len;
+    if (len > 0)
+        vlc_cond_signal (&sys->wait_space);
+}
+
+/** Restarts the ring at the given offset, the source lock must be held. */
+static void Reset (stream_sys_t *sys, uint64_t offset)
+{
+    vlc_mutex_lock (&sys->lock);
+    sys->generation++;
+    sys->buffer_offset = offset;
+    sys->buffer_length = 0;
+    sys->eof = false;
+    vlc_cond_signal (&sys->wait_space);
+    vlc_mutex_unlock (&sys->lock);
+}
+
+static int Seek (stream_t *stream, uint64_t offset)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    vlc_mutex_lock (&sys->lock);
+    if (offset >= sys->buffer_offset
+     && offset - sys->buffer_offset <= sys->buffer_length)
+    {   /* Already buffered: no need to touch the source */
+        Consume (sys, offset - sys->buffer_offset);
+        vlc_mutex_unlock (&sys->lock);
+        return VLC_SUCCESS;
+    }
+
+    if (!sys->can_seek)
+    {
+        vlc_mutex_unlock (&sys->lock);
+        return VLC_EGENERIC;
+    }
+
+    /* Cancel the pending read-ahead */
+    sys->generation++;
+    vlc_mutex_unlock (&sys->lock);
+
+    vlc_mutex_lock (&sys->source_lock);
+    int ret = stream_Seek (stream->p_source, offset);
+    if (ret != VLC_SUCCESS)
+        offset = stream_Tell (stream->p_source);
+    Reset (sys, offset);
+    vlc_mutex_unlock (&sys->source_lock);
+    return ret;
+}
+
+static int Read (stream_t *stream, void *buf, unsigned len)
+{
+    stream_sys_t *sys = stream->p_sys;
+    uint8_t *p = buf;
+    unsigned total = 0;
+
+    if (buf == NULL)
+    {
+        vlc_mutex_lock (&sys->lock);
+        const uint64_t offset = sys->buffer_offset + len;
+        vlc_mutex_unlock (&sys->lock);
+
+        if (sys->can_seek)
+            return Seek (stream, offset) ? 0 : len;
+    }
+
+    vlc_mutex_lock (&sys->lock);
+    while (total < len)
+    {
+        size_t avail = WaitData (stream, 1);
+        if (avail == 0)
+            break; /* EOF */
+
+        size_t index = RingIndex (sys, sys->buffer_offset);
+        size_t copy = len - total;
+
+        if (copy > avail)
+            copy = avail;
+        if (copy > sys->buffer_size - index)
+            copy = sys->buffer_size - index;
+
+        /* The thread does not write to buffered data, nor does anybody
+         * else consume it: copy it without holding the lock. */
+        vlc_mutex_unlock (&sys->lock);
+        if (p != NULL)
+        {
+            memcpy (p, sys->buffer + index, copy);
+            p += copy;
+        }
+        vlc_mutex_lock (&sys->lock);
+
+        Consume (sys, copy);
+        total += copy;
+    }
+    vlc_mutex_unlock (&sys->lock);
+    return total;
+}
+
+static int Peek (stream_t *stream, const uint8_t **restrict pp, unsigned len)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    vlc_mutex_lock (&sys->lock);
+    size_t avail = WaitData (stream, len);
+    size_t index = RingIndex (sys, sys->buffer_offset);
+    vlc_mutex_unlock (&sys->lock);
+
+    if (len > avail)
+        len = avail;
+
+    /* Contiguous data: no copy */
+    if (len <= sys->buffer_size - index)
+    {
+        *pp = sys->buffer + index;
+        return len;
+    }
+
+    if (sys->peek_size < len)
+    {
+        uint8_t *peek = realloc (sys->peek, len);
+        if (unlikely(peek == NULL))
+            return 0;
+        sys->peek = peek;
+        sys->peek_size = len;
+    }
+
+    size_t head = sys->buffer_size - index;
+    memcpy (sys->peek, sys->buffer + index, head);
+    memcpy (sys->peek + head, sys->buffer, len - head);
+    *pp = sys->peek;
+    return len;
+}
+
+static int Control (stream_t *stream, int query, va_list args)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+            *va_arg (args, bool *) = sys->can_seek;
+            break;
+
+        case STREAM_CAN_FASTSEEK:
+            *va_arg (args, bool *) = false;
+            break;
+
+        case STREAM_GET_POSITION:
+            vlc_mutex_lock (&sys->lock);
+            *va_arg (args, uint64_t *) = sys->buffer_offset;
+            vlc_mutex_unlock (&sys->lock);
+            break;
+
+        case STREAM_SET_POSITION:
+            return Seek (stream, va_arg (args, uint64_t));
+
+        case STREAM_GET_FILL_LEVEL:
+        {
+            uint64_t *fill = va_arg (args, uint64_t *);
+            uint64_t *size = va_arg (args, uint64_t *);
+
+            vlc_mutex_lock (&sys->lock);
+            *fill = sys->buffer_length;
+            *size = sys->buffer_size;
+            vlc_mutex_unlock (&sys->lock);
+            break;
+        }
+
+        case STREAM_CONTROL_ACCESS:
+        case STREAM_UPDATE_SIZE:
+        {   /* These may move the source position: restart from there */
+            vlc_mutex_lock (&sys->source_lock);
+            int ret = stream_vaControl (stream->p_source, query, args);
+            Reset (sys, stream_Tell (stream->p_source));
+            vlc_mutex_unlock (&sys->source_lock);
+            return ret;
+        }
+
+        default:
+        {
+            vlc_mutex_lock (&sys->source_lock);
+            int ret = stream_vaControl (stream->p_source, query, args);
+            vlc_mutex_unlock (&sys->source_lock);
+            return ret;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+static int Open (vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+    stream_sys_t *sys = malloc (sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    sys->buffer_size = var_InheritInteger (obj, "prefetch-buffer-size") << 10;
+    sys->read_size = var_InheritInteger (obj, "prefetch-read-size");
+    if (sys->read_size > sys->buffer_size)
+        sys->read_size = sys->buffer_size;
+
+    sys->buffer = malloc (sys->buffer_size);
+    if (unlikely(sys->buffer == NULL))
+    {
+        free (sys);
+        return VLC_ENOMEM;
+    }
+
+    stream_Control (stream->p_source, STREAM_CAN_SEEK, &sys->can_seek);
+    sys->buffer_offset = stream_Tell (stream->p_source);
+    sys->buffer_length = 0;
+    sys->generation = 0;
+    sys->eof = false;
+    sys->peek = NULL;
+    sys->peek_size = 0;
+
+    vlc_mutex_init (&sys->lock);
+    vlc_mutex_init (&sys->source_lock);
+    vlc_cond_init (&sys->wait_data);
+    vlc_cond_init (&sys->wait_space);
+
+    stream->p_sys = sys;
+    stream->pf_read = Read;
+    stream->pf_peek = Peek;
+    stream->pf_control = Control;
+
+    if (vlc_clone (&sys->thread, Thread, stream, VLC_THREAD_PRIORITY_INPUT))
+    {
+        vlc_cond_destroy (&sys->wait_space);
+        vlc_cond_destroy (&sys->wait_data);
+        vlc_mutex_destroy (&sys->source_lock);
+        vlc_mutex_destroy (&sys->lock);
+        free (sys->buffer);
+        free (sys);
+        return VLC_ENOMEM;
+    }
+
+    msg_Dbg (stream, "using %zu KiB buffer, %zu bytes reads",
+             sys->buffer_size >> 10, sys->read_size);
+    return VLC_SUCCESS;
+}
+
+static void Close (vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+    stream_sys_t *sys = stream->p_sys;
+
+    vlc_cancel (sys->thread);
+    vlc_join (sys->thread, NULL);
+
+    vlc_cond_destroy (&sys->wait_space);
+    vlc_cond_destroy (&sys->wait_data);
+    vlc_mutex_destroy (&sys->source_lock);
+    vlc_mutex_destroy (&sys->lock);
+    free (sys->peek);
+    free (sys->buffer);
+    free (sys);
+}
@@ -162,6 +162,14 @@ static void Destroy( vlc_object_t * );
 #define SHADOW_ANGLE_TEXT N_("Shadow angle")
 #define SHADOW_DISTANCE_TEXT N_("Shadow distance")
 
+#define GLYPH_CACHE_TEXT N_("Glyph cache size")
+#define GLYPH_CACHE_LONGTEXT N_("Maximum number of rendered glyphs kept " \
+    "for reuse. 0 disables the cache." )
+#define TEXT_CACHE_TEXT N_("Text cache size")
+#define TEXT_CACHE_LONGTEXT N_("Maximum number of rendered texts kept, so " \
+    "that identical subtitles or marquees are not rendered again. " \
+    "0 disables the cache." )
+
 
 static const int pi_sizes[] = { 20, 18, 16, 12, 6 };
 static const char *const ppsz_sizes_text[] = {
@@ -261,6 +269,13 @@ vlc_module_begin ()
 
     add_bool( "freetype-yuvp", false, YUVP_TEXT,
               YUVP_LONGTEXT, true )
+
+    add_integer( "freetype-glyph-cache", 1024, GLYPH_CACHE_TEXT,
+                 GLYPH_CACHE_LONGTEXT, true )
+        change_integer_range( 0, 65536 )
+    add_integer( "freetype-text-cache", 16, TEXT_CACHE_TEXT,
+                 TEXT_CACHE_LONGTEXT, true )
+        change_integer_range( 0, 1024 )
     set_capability( "text renderer", 100 )
     add_shortcut( "text" )
     set_callbacks( Create, Destroy )
@@ -292,6 +307,83 @@ struct line_desc_t
     line_character_t *p_character;
 };
 
+/* Loaded faces, by font name and style */
+#define FACE_CACHE_MAX 16
+typedef struct
+{
+    char    *psz_fontname;
+    int     i_style_flags;          /* STYLE_BOLD | STYLE_ITALIC */
+    FT_Face p_face;                 /* NULL when the default face is used */
+} face_cache_entry_t;
+
+/* Rendered glyphs, by face, size, synthetic style, glyph index and
+ * subpixel pen positions. The bitmaps are rendered with the pen inside
+ * the first pixel, and moved to the actual pen position when used. */
+typedef struct
+{
+    FT_Face  p_face;
+    int      i_size;
+    int      i_style_flags;         /* STYLE_BOLD | STYLE_ITALIC */
+    FT_UInt  i_glyph_index;
+    FT_Pos   i_pen_x, i_pen_y;      /* 0..63 */
+    FT_Pos   i_shadow_x, i_shadow_y;
+} glyph_key_t;
+
+typedef struct glyph_cache_entry_t glyph_cache_entry_t;
+struct glyph_cache_entry_t
+{
+    glyph_cache_entry_t *p_hash_next;
+    glyph_cache_entry_t *p_prev;    /* Least recently used order */
+    glyph_cache_entry_t *p_next;
+
+    glyph_key_t key;
+    FT_Glyph    p_glyph;
+    FT_Glyph    p_outline;
+    FT_Glyph    p_shadow;
+    FT_Vector   advance;
+};
+
+typedef struct
+{
+    glyph_cache_entry_t **pp_hash;
+    unsigned            i_hash_mask;
+    glyph_cache_entry_t *p_first;   /* Most recently used */
+    glyph_cache_entry_t *p_last;
+    unsigned            i_count;
+    unsigned            i_max;
+
+    unsigned            i_hits;
+    unsigned            i_misses;
+} glyph_cache_t;
+
+/* Rendered regions, by text and style */
+typedef struct text_cache_entry_t text_cache_entry_t;
+struct text_cache_entry_t
+{
+    text_cache_entry_t *p_next;     /* Most recently used first */
+
+    bool           b_html;
+    char           *psz_text;
+    text_style_t   *p_style;
+    int            i_font_size;
+    int            i_align;         /* Lines are aligned in the picture */
+    unsigned       i_width;         /* Visible size of the video */
+    unsigned       i_height;
+
+    video_format_t fmt;
+    picture_t      *p_picture;
+};
+
+typedef struct
+{
+    text_cache_entry_t *p_first;
+    unsigned           i_count;
+    unsigned           i_max;
+
+    unsigned           i_hits;
+    unsigned           i_misses;
+} text_cache_t;
+
 typedef struct font_stack_t font_stack_t;
 struct font_stack_t
 {
@@ -341,6 +433,11 @@ struct filter_sys_t
 
     input_attachment_t **pp_font_attachments;
     int                  i_font_attachments;
+
+    face_cache_entry_t   face_cache[FACE_CACHE_MAX];
+    int                  i_face_cache;
+    glyph_cache_t        glyph_cache;
+    text_cache_t         text_cache;
 };
 
 /* */
@@ -1881,6 +1978,56 @@ static bool FaceStyleEquals( const text_style_t *p_style1,
            !strcmp( p_style1->psz_fontname, p_style2->psz_fontname );
 }
 
+/* It returns the face to use for a style, NULL for the default one, and
+ * whether the face cache owns it (otherwise the caller must release it) */
+static FT_Face GetFace( filter_t *p_filter, const text_style_t *p_style,
+                        bool *pb_cached )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const int i_style_flags = p_style->i_style_flags & (STYLE_BOLD | STYLE_ITALIC);
+
+    for( int i = 0; i < p_sys->i_face_cache; i++ )
+    {
+        const face_cache_entry_t *p_entry = &p_sys->face_cache[i];
+        if( p_entry->i_style_flags == i_style_flags &&
+            !strcmp( p_entry->psz_fontname, p_style->psz_fontname ) )
+        {
+            *pb_cached = true;
+            return p_entry->p_face;
+        }
+    }
+
+    FT_Face p_face = LoadFace( p_filter, p_style );
+
+    char *psz_fontname = NULL;
+    if( p_sys->i_face_cache < FACE_CACHE_MAX )
+        psz_fontname = strdup( p_style->psz_fontname );
+    if( !psz_fontname )
+    {
+        *pb_cached = false;
+        return p_face;
+    }
+    p_sys->face_cache[p_sys->i_face_cache++] = (face_cache_entry_t){
+        .psz_fontname = psz_fontname,
+        .i_style_flags = i_style_flags,
+        .p_face = p_face,
+    };
+    *pb_cached = true;
+    return p_face;
+}
+
+static void FaceCacheClean( filter_sys_t *p_sys )
+{
+    for( int i = 0; i < p_sys->i_face_cache; i++ )
+    {
+        face_cache_entry_t *p_entry = &p_sys->face_cache[i];
+        if( p_entry->p_face )
+            FT_Done_Face( p_entry->p_face );
+        free( p_entry->psz_fontname );
+    }
+    p_sys->i_face_cache = 0;
+}
+
 static int GetGlyph( filter_t *p_filter,
                      FT_Glyph *pp_glyph,   FT_BBox *p_glyph_bbox,
                      FT_Glyph *pp_outline, FT_BBox *p_outline_bbox,
@@ -1960,19 +2107,251 @@ static int GetGlyph( filter_t *p_filter,
     return VLC_SUCCESS;
 }
 
-static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox, FT_Face face, const FT_Vector *p_pen )
+static void GlyphCacheInit( glyph_cache_t *p_cache, unsigned i_max )
+{
+    memset( p_cache, 0, sizeof(*p_cache) );
+    if( i_max == 0 )
+        return;
+
+    unsigned i_size = 1;
+    while( i_size < i_max )
+        i_size <<= 1;
+    p_cache->pp_hash = calloc( i_size, sizeof(*p_cache->pp_hash) );
+    if( !p_cache->pp_hash )
+        return;
+    p_cache->i_hash_mask = i_size - 1;
+    p_cache->i_max = i_max;
+}
+
+static void GlyphCacheEntryDelete( glyph_cache_entry_t *p_entry )
+{
+    FT_Done_Glyph( p_entry->p_glyph );
+    if( p_entry->p_outline )
+        FT_Done_Glyph( p_entry->p_outline );
+    if( p_entry->p_shadow )
+        FT_Done_Glyph( p_entry->p_shadow );
+    free( p_entry );
+}
+
+static void GlyphCacheClean( glyph_cache_t *p_cache )
+{
+    for( glyph_cache_entry_t *p_entry = p_cache->p_first; p_entry != NULL; )
+    {
+        glyph_cache_entry_t *p_next = p_entry->p_next;
+        GlyphCacheEntryDelete( p_entry );
+        p_entry = p_next;
+    }
+    free( p_cache->pp_hash );
+}
+
+static unsigned GlyphKeyHash( const glyph_key_t *p_key )
+{
+    uint32_t i_hash = (uintptr_t)p_key->p_face >> 4;
+    i_hash = i_hash * 31 + p_key->i_size;
+    i_hash = i_hash * 31 + p_key->i_style_flags;
+    i_hash = i_hash * 31 + p_key->i_glyph_index;
+    i_hash = i_hash * 31 + (p_key->i_pen_x << 6 | p_key->i_pen_y);
+    i_hash = i_hash * 31 + (p_key->i_shadow_x << 6 | p_key->i_shadow_y);
+    i_hash ^= i_hash >> 15;
+    i_hash *= 0x2c1b3c6d;
+    i_hash ^= i_hash >> 12;
+    return i_hash;
+}
+
+static bool GlyphKeyEquals( const glyph_key_t *p_key1, const glyph_key_t *p_key2 )
+{
+    return p_key1->p_face == p_key2->p_face &&
+           p_key1->i_size == p_key2->i_size &&
+           p_key1->i_style_flags == p_key2->i_style_flags &&
+           p_key1->i_glyph_index == p_key2->i_glyph_index &&
+           p_key1->i_pen_x == p_key2->i_pen_x &&
+           p_key1->i_pen_y == p_key2->i_pen_y &&
+           p_key1->i_shadow_x == p_key2->i_shadow_x &&
+           p_key1->i_shadow_y == p_key2->i_shadow_y;
+}
+
+static void GlyphCacheUnlink( glyph_cache_t *p_cache, glyph_cache_entry_t *p_entry )
+{
+    if( p_entry->p_prev )
+        p_entry->p_prev->p_next = p_entry->p_next;
+    else
+        p_cache->p_first = p_entry->p_next;
+    if( p_entry->p_next )
+        p_entry->p_next->p_prev = p_entry->p_prev;
+    else
+        p_cache->p_last = p_entry->p_prev;
+}
+
+static void GlyphCacheLinkFirst( glyph_cache_t *p_cache, glyph_cache_entry_t *p_entry )
+{
+    p_entry->p_prev = NULL;
+    p_entry->p_next = p_cache->p_first;
+    if( p_cache->p_first )
+        p_cache->p_first->p_prev = p_entry;
+    else
+        p_cache->p_last = p_entry;
+    p_cache->p_first = p_entry;
+}
+
+static glyph_cache_entry_t *GlyphCacheFind( glyph_cache_t *p_cache,
+                                            const glyph_key_t *p_key,
+                                            unsigned i_hash )
+{
+    glyph_cache_entry_t *p_entry = p_cache->pp_hash[i_hash & p_cache->i_hash_mask];
+    while( p_entry && !GlyphKeyEquals( &p_entry->key, p_key ) )
+        p_entry = p_entry->p_hash_next;
+
+    if( p_entry && p_entry != p_cache->p_first )
+    {
+        GlyphCacheUnlink( p_cache, p_entry );
+        GlyphCacheLinkFirst( p_cache, p_entry );
+    }
+    return p_entry;
+}
+
+static void GlyphCacheInsert( glyph_cache_t *p_cache,
+                              glyph_cache_entry_t *p_entry, unsigned i_hash )
+{
+    if( p_cache->i_count >= p_cache->i_max )
+    {
+        /* Drop the least recently used glyph */
+        glyph_cache_entry_t *p_old = p_cache->p_last;
+        glyph_cache_entry_t **pp_hash =
+            &p_cache->pp_hash[GlyphKeyHash( &p_old->key ) & p_cache->i_hash_mask];
+        while( *pp_hash != p_old )
+            pp_hash = &(*pp_hash)->p_hash_next;
+        *pp_hash = p_old->p_hash_next;
+
+        GlyphCacheUnlink( p_cache, p_old );
+        GlyphCacheEntryDelete( p_old );
+        p_cache->i_count--;
+    }
+
+    glyph_cache_entry_t **pp_hash = &p_cache->pp_hash[i_hash & p_cache->i_hash_mask];
+    p_entry->p_hash_next = *pp_hash;
+    *pp_hash = p_entry;
+    GlyphCacheLinkFirst( p_cache, p_entry );
+    p_cache->i_count++;
+}
+
+/* It copies a cached bitmap glyph to the given pen position */
+static FT_Glyph CopyGlyph( FT_Glyph glyph, const FT_Vector *p_pen, FT_BBox *p_bbox )
+{
+    FT_Glyph copy;
+    if( FT_Glyph_Copy( glyph, &copy ) )
+        return NULL;
+
+    FT_BitmapGlyph glyph_bmp = (FT_BitmapGlyph)copy;
+    glyph_bmp->left += FT_FLOOR(p_pen->x);
+    glyph_bmp->top  += FT_FLOOR(p_pen->y);
+    FT_Glyph_Get_CBox( copy, ft_glyph_bbox_pixels, p_bbox );
+    return copy;
+}
+
+/* Same as GetGlyph() but going through the glyph cache when b_cache is
+ * true, which requires p_face to outlive the cache */
+static int GetCachedGlyph( filter_t *p_filter, bool b_cache,
+                           FT_Glyph *pp_glyph,   FT_BBox *p_glyph_bbox,
+                           FT_Glyph *pp_outline, FT_BBox *p_outline_bbox,
+                           FT_Glyph *pp_shadow,  FT_BBox *p_shadow_bbox,
+                           FT_Vector *p_advance,
+
+                           FT_Face  p_face,
+                           int i_size,
+                           int i_glyph_index,
+                           int i_style_flags,
+                           FT_Vector *p_pen,
+                           FT_Vector *p_pen_shadow )
+{
+    glyph_cache_t *p_cache = &p_filter->p_sys->glyph_cache;
+
+    if( !b_cache || p_cache->i_max == 0 )
+    {
+        if( GetGlyph( p_filter,
+                      pp_glyph, p_glyph_bbox,
+                      pp_outline, p_outline_bbox,
+                      pp_shadow, p_shadow_bbox,
+                      p_face, i_glyph_index, i_style_flags,
+                      p_pen, p_pen_shadow ) )
+            return VLC_EGENERIC;
+        *p_advance = p_face->glyph->advance;
+        return VLC_SUCCESS;
+    }
+
+    const glyph_key_t key = {
+        .p_face = p_face,
+        .i_size = i_size,
+        .i_style_flags = i_style_flags & (STYLE_BOLD | STYLE_ITALIC),
+        .i_glyph_index = i_glyph_index,
+        .i_pen_x = p_pen->x & 63,
+        .i_pen_y = p_pen->y & 63,
+        .i_shadow_x = p_pen_shadow->x & 63,
+        .i_shadow_y = p_pen_shadow->y & 63,
+    };
+    const unsigned i_hash = GlyphKeyHash( &key );
+
+    glyph_cache_entry_t *p_entry = GlyphCacheFind( p_cache, &key, i_hash );
+    if( p_entry )
+    {
+        p_cache->i_hits++;
+    }
+    else
+    {
+        p_cache->i_misses++;
+
+        p_entry = malloc( sizeof(*p_entry) );
+        if( !p_entry )
+            return VLC_ENOMEM;
+
+        FT_Vector pen = { .x = key.i_pen_x, .y = key.i_pen_y };
+        FT_Vector pen_shadow = { .x = key.i_shadow_x, .y = key.i_shadow_y };
+        FT_BBox bbox;
+        if( GetGlyph( p_filter,
+                      &p_entry->p_glyph, &bbox,
+                      &p_entry->p_outline, &bbox,
+                      &p_entry->p_shadow, &bbox,
+                      p_face, i_glyph_index, i_style_flags,
+                      &pen, &pen_shadow ) )
+        {
+            free( p_entry );
+            return VLC_EGENERIC;
+        }
+        /* Only bitmaps can be moved to the pen position */
+        if( p_entry->p_outline && p_entry->p_outline->format != FT_GLYPH_FORMAT_BITMAP )
+        {
+            FT_Done_Glyph( p_entry->p_outline );
+            p_entry->p_outline = NULL;
+        }
+        p_entry->key     = key;
+        p_entry->advance = p_face->glyph->advance;
+
+        GlyphCacheInsert( p_cache, p_entry, i_hash );
+    }
+
+    *pp_glyph = CopyGlyph( p_entry->p_glyph, p_pen, p_glyph_bbox );
+    if( !*pp_glyph )
+        return VLC_ENOMEM;
+    *pp_outline = p_entry->p_outline ? CopyGlyph( p_entry->p_outline, p_pen, p_outline_bbox )
+                                     : NULL;
+    *pp_shadow = p_entry->p_shadow ? CopyGlyph( p_entry->p_shadow, p_pen_shadow, p_shadow_bbox )
+                                   : NULL;
+    *p_advance = p_entry->advance;
+    return VLC_SUCCESS;
+}
+
+static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox, const FT_Vector *p_advance, const FT_Vector *p_pen )
 {
     FT_BitmapGlyph glyph_bmp = (FT_BitmapGlyph)glyph;
     if( p_bbox->xMin >= p_bbox->xMax )
     {
         p_bbox->xMin = FT_CEIL(p_pen->x);
-        p_bbox->xMax = FT_CEIL(p_pen->x + face->glyph->advance.x);
+        p_bbox->xMax = FT_CEIL(p_pen->x + p_advance->x);
         glyph_bmp->left = p_bbox->xMin;
     }
     if( p_bbox->yMin >= p_bbox->yMax )
     {
         p_bbox->yMax = FT_CEIL(p_pen->y);
-        p_bbox->yMin = FT_CEIL(p_pen->y + face->glyph->advance.y);
+        p_bbox->yMin = FT_CEIL(p_pen->y + p_advance->y);
         glyph_bmp->top  = p_bbox->yMax;
     }
 }
@@ -2098,6 +2477,7 @@ static int ProcessLines( filter_t *p_filter,
     int i_base_line = 0;
     const text_style_t *p_previous_style = NULL;
     FT_Face p_face = NULL;
+    bool b_face_cached = false;
     for( int i_start = 0; i_start < i_len; )
     {
         /* Compute the length of the current text line */
@@ -2161,13 +2541,14 @@ static int ProcessLines( filter_t *p_filter,
             /* (Re)load/reconfigure the face if needed */
             if( !FaceStyleEquals( p_current_style, p_previous_style ) )
             {
-                if( p_face )
+                if( p_face && !b_face_cached )
                     FT_Done_Face( p_face );
                 p_previous_style = NULL;
 
-                p_face = LoadFace( p_filter, p_current_style );
+                p_face = GetFace( p_filter, p_current_style, &b_face_cached );
             }
             FT_Face p_current_face = p_face ? p_face : p_sys->p_face;
+            const bool b_glyph_cache = !p_face || b_face_cached;
             if( !p_previous_style || p_previous_style->i_font_size != p_current_style->i_font_size )
             {
                 if( FT_Set_Pixel_Sizes( p_current_face, 0, p_current_style->i_font_size ) )
@@ -2215,20 +2596,23 @@ static int ProcessLines( filter_t *p_filter,
                 FT_BBox  outline_bbox;
                 FT_Glyph shadow;
                 FT_BBox  shadow_bbox;
-
-                if( GetGlyph( p_filter,
-                              &glyph, &glyph_bbox,
-                              &outline, &outline_bbox,
-                              &shadow, &shadow_bbox,
-                              p_current_face, i_glyph_index, p_glyph_style->i_style_flags,
-                              &pen_new, &pen_shadow_new ) )
+                FT_Vector advance;
+
+                if( GetCachedGlyph( p_filter, b_glyph_cache,
+                                    &glyph, &glyph_bbox,
+                                    &outline, &outline_bbox,
+                                    &shadow, &shadow_bbox,
+                                    &advance,
+                                    p_current_face, p_current_style->i_font_size,
+                                    i_glyph_index, p_glyph_style->i_style_flags,
+                                    &pen_new, &pen_shadow_new ) )
                     goto next;
 
-                FixGlyph( glyph, &glyph_bbox, p_current_face, &pen_new );
+                FixGlyph( glyph, &glyph_bbox, &advance, &pen_new );
                 if( outline )
-                    FixGlyph( outline, &outline_bbox, p_current_face, &pen_new );
+                    FixGlyph( outline, &outline_bbox, &advance, &pen_new );
                 if( shadow )
-                    FixGlyph( shadow, &shadow_bbox, p_current_face, &pen_shadow_new );
+                    FixGlyph( shadow, &shadow_bbox, &advance, &pen_shadow_new );
 
                 /* FIXME and what about outline */
 
@@ -2327,8 +2711,8 @@ static int ProcessLines( filter_t *p_filter,
                     .i_line_thickness = i_line_thickness,
                 };
 
-                pen.x = pen_new.x + p_current_face->glyph->advance.x;
-                pen.y = pen_new.y + p_current_face->glyph->advance.y;
+                pen.x = pen_new.x + advance.x;
+                pen.y = pen_new.y + advance.y;
                 line_bbox = line_bbox_new;
             next:
                 i_glyph_last = i_glyph_index;
@@ -2392,7 +2776,7 @@ static int ProcessLines( filter_t *p_filter,
             break;
         }
     }
-    if( p_face )
+    if( p_face && !b_face_cached )
         FT_Done_Face( p_face );
 
     free( pp_fribidi_styles );
@@ -2403,6 +2787,178 @@ static int ProcessLines( filter_t *p_filter,
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * Text cache
+ *****************************************************************************/
+static bool TextStyleEquals( const text_style_t *p_style1,
+                             const text_style_t *p_style2 )
+{
+    if( !p_style1 || !p_style2 )
+        return p_style1 == p_style2;
+
+    if( p_style1->psz_fontname && p_style2->psz_fontname )
+    {
+        if( strcmp( p_style1->psz_fontname, p_style2->psz_fontname ) )
+            return false;
+    }
+    else if( p_style1->psz_fontname != p_style2->psz_fontname )
+        return false;
+
+    return p_style1->i_font_size == p_style2->i_font_size &&
+           p_style1->i_font_color == p_style2->i_font_color &&
+           p_style1->i_font_alpha == p_style2->i_font_alpha &&
+           p_style1->i_style_flags == p_style2->i_style_flags &&
+           p_style1->i_outline_color == p_style2->i_outline_color &&
+           p_style1->i_outline_alpha == p_style2->i_outline_alpha &&
+           p_style1->i_shadow_color == p_style2->i_shadow_color &&
+           p_style1->i_shadow_alpha == p_style2->i_shadow_alpha &&
+           p_style1->i_background_color == p_style2->i_background_color &&
+           p_style1->i_background_alpha == p_style2->i_background_alpha &&
+           p_style1->i_karaoke_background_color == p_style2->i_karaoke_background_color &&
+           p_style1->i_karaoke_background_alpha == p_style2->i_karaoke_background_alpha &&
+           p_style1->i_outline_width == p_style2->i_outline_width &&
+           p_style1->i_shadow_width == p_style2->i_shadow_width &&
+           p_style1->i_spacing == p_style2->i_spacing;
+}
+
+static void TextCacheEntryDelete( text_cache_entry_t *p_entry )
+{
+    picture_Release( p_entry->p_picture );
+    if( p_entry->p_style )
+        text_style_Delete( p_entry->p_style );
+    free( p_entry->psz_text );
+    free( p_entry );
+}
+
+static void TextCacheClean( text_cache_t *p_cache )
+{
+    for( text_cache_entry_t *p_entry = p_cache->p_first; p_entry != NULL; )
+    {
+        text_cache_entry_t *p_next = p_entry->p_next;
+        TextCacheEntryDelete( p_entry );
+        p_entry = p_next;
+    }
+    p_cache->p_first = NULL;
+    p_cache->i_count = 0;
+}
+
+/* It returns the chroma RenderCommon() will render to, or 0 if such a
+ * region cannot be cached */
+static vlc_fourcc_t TextCacheChroma( filter_t *p_filter,
+                                     const vlc_fourcc_t *p_chroma_list )
+{
+    if( p_filter->p_sys->text_cache.i_max == 0 ||
+        var_InheritBool( p_filter, "freetype-yuvp" ) )
+        return 0;
+    if( !p_chroma_list || *p_chroma_list == 0 )
+        return VLC_CODEC_RGBA;
+
+    for( ; *p_chroma_list != 0; p_chroma_list++ )
+    {
+        if( *p_chroma_list == VLC_CODEC_YUVA || *p_chroma_list == VLC_CODEC_RGBA )
+            return *p_chroma_list;
+        if( *p_chroma_list == VLC_CODEC_YUVP )
+            return 0;
+    }
+    return 0;
+}
+
+static bool TextCacheMatch( filter_t *p_filter, const text_cache_entry_t *p_entry,
+                            const subpicture_region_t *p_region_in, bool b_html,
+                            vlc_fourcc_t i_chroma )
+{
+    const char *psz_text = b_html ? p_region_in->psz_html : p_region_in->psz_text;
+
+    return p_entry->b_html == b_html &&
+           p_entry->fmt.i_chroma == i_chroma &&
+           p_entry->i_font_size == p_filter->p_sys->i_font_size &&
+           p_entry->i_align == p_region_in->i_align &&
+           p_entry->i_width  == p_filter->fmt_out.video.i_visible_width &&
+           p_entry->i_height == p_filter->fmt_out.video.i_visible_height &&
+           !strcmp( p_entry->psz_text, psz_text ) &&
+           TextStyleEquals( p_entry->p_style, p_region_in->p_style );
+}
+
+static int TextCacheGet( filter_t *p_filter, subpicture_region_t *p_region_out,
+                         const subpicture_region_t *p_region_in, bool b_html,
+                         vlc_fourcc_t i_chroma )
+{
+    text_cache_t *p_cache = &p_filter->p_sys->text_cache;
+
+    for( text_cache_entry_t **pp_entry = &p_cache->p_first;
+         *pp_entry != NULL; pp_entry = &(*pp_entry)->p_next )
+    {
+        text_cache_entry_t *p_entry = *pp_entry;
+        if( !TextCacheMatch( p_filter, p_entry, p_region_in, b_html, i_chroma ) )
+            continue;
+
+        picture_t *p_picture = picture_NewFromFormat( &p_entry->fmt );
+        if( !p_picture )
+            return VLC_ENOMEM;
+        picture_Copy( p_picture, p_entry->p_picture );
+        p_region_out->p_picture = p_picture;
+        p_region_out->fmt = p_entry->fmt;
+
+        /* Move it to the front */
+        *pp_entry = p_entry->p_next;
+        p_entry->p_next = p_cache->p_first;
+        p_cache->p_first = p_entry;
+
+        p_cache->i_hits++;
+        return VLC_SUCCESS;
+    }
+    p_cache->i_misses++;
+    return VLC_EGENERIC;
+}
+
+static void TextCachePut( filter_t *p_filter, const subpicture_region_t *p_region_out,
+                          const subpicture_region_t *p_region_in, bool b_html )
+{
+    text_cache_t *p_cache = &p_filter->p_sys->text_cache;
+
+    text_cache_entry_t *p_entry = malloc( sizeof(*p_entry) );
+    if( !p_entry )
+        return;
+
+    p_entry->b_html      = b_html;
+    p_entry->psz_text    = strdup( b_html ? p_region_in->psz_html : p_region_in->psz_text );
+    p_entry->p_style     = p_region_in->p_style ? text_style_Duplicate( p_region_in->p_style )
+                                                : NULL;
+    p_entry->i_font_size = p_filter->p_sys->i_font_size;
+    p_entry->i_align     = p_region_in->i_align;
+    p_entry->i_width     = p_filter->fmt_out.video.i_visible_width;
+    p_entry->i_height    = p_filter->fmt_out.video.i_visible_height;
+    p_entry->fmt         = p_region_out->fmt;
+    p_entry->p_picture   = picture_NewFromFormat( &p_entry->fmt );
+    if( !p_entry->psz_text || !p_entry->p_picture ||
+        ( p_region_in->p_style && !p_entry->p_style ) )
+    {
+        if( p_entry->p_picture )
+            picture_Release( p_entry->p_picture );
+        if( p_entry->p_style )
+            text_style_Delete( p_entry->p_style );
+        free( p_entry->psz_text );
+        free( p_entry );
+        return;
+    }
+    picture_Copy( p_entry->p_picture, p_region_out->p_picture );
+
+    if( p_cache->i_count >= p_cache->i_max )
+    {
+        /* Drop the least recently used text */
+        text_cache_entry_t **pp_last = &p_cache->p_first;
+        while( (*pp_last)->p_next )
+            pp_last = &(*pp_last)->p_next;
+        TextCacheEntryDelete( *pp_last );
+        *pp_last = NULL;
+        p_cache->i_count--;
+    }
+
+    p_entry->p_next = p_cache->p_first;
+    p_cache->p_first = p_entry;
+    p_cache->i_count++;
+}
+
 /**
  * This function renders a text subpicture region into another one.
  * It also calculates the size needed for this string, and renders the
@@ -2422,6 +2978,20 @@ static int RenderCommon( filter_t *p_filter, subpicture_region_t *p_region_out,
     if( !b_html && !p_region_in->psz_text )
         return VLC_EGENERIC;
 
+    /* Reset the default fontsize in case screen metrics have changed */
+    p_filter->p_sys->i_font_size = GetFontSize( p_filter );
+
+    /* Reuse the region if this text was rendered recently */
+    const vlc_fourcc_t i_cache_chroma = TextCacheChroma( p_filter, p_chroma_list );
+    if( i_cache_chroma &&
+        TextCacheGet( p_filter, p_region_out, p_region_in, b_html,
+                      i_cache_chroma ) == VLC_SUCCESS )
+    {
+        p_region_out->i_x = p_region_in->i_x;
+        p_region_out->i_y = p_region_in->i_y;
+        return VLC_SUCCESS;
+    }
+
     const size_t i_text_max = strlen( b_html ? p_region_in->psz_html
                                              : p_region_in->psz_text );
 
@@ -2434,9 +3004,6 @@ static int RenderCommon( filter_t *p_filter, subpicture_region_t *p_region_out,
         return VLC_EGENERIC;
     }
 
-    /* Reset the default fontsize in case screen metrics have changed */
-    p_filter->p_sys->i_font_size = GetFontSize( p_filter );
-
     /* */
     int rv = VLC_SUCCESS;
     int i_text_length = 0;
@@ -2581,6 +3148,8 @@ static int RenderCommon( filter_t *p_filter, subpicture_region_t *p_region_out,
          */
         if( pi_k_durations )
             var_SetBool( p_filter, "text-rerender", true );
+        else if( !rv && p_region_out->fmt.i_chroma == i_cache_chroma )
+            TextCachePut( p_filter, p_region_out, p_region_in, b_html );
     }
 
     FreeLines( p_lines );
@@ -2635,6 +3204,11 @@ static int Create( vlc_object_t *p_this )
     p_sys->p_library        = 0;
     p_sys->i_font_size      = 0;
     p_sys->i_display_height = 0;
+    p_sys->i_face_cache     = 0;
+    GlyphCacheInit( &p_sys->glyph_cache,
+                    var_InheritInteger( p_filter, "freetype-glyph-cache" ) );
+    memset( &p_sys->text_cache, 0, sizeof(p_sys->text_cache) );
+    p_sys->text_cache.i_max = var_InheritInteger( p_filter, "freetype-text-cache" );
 
     var_Create( p_filter, "freetype-rel-fontsize",
                 VLC_VAR_INTEGER | VLC_VAR_DOINHERIT );
@@ -2780,6 +3354,7 @@ static int Create( vlc_object_t *p_this )
     return VLC_SUCCESS;
 
 error:
+    GlyphCacheClean( &p_sys->glyph_cache );
     if( p_sys->p_face ) FT_Done_Face( p_sys->p_face );
     if( p_sys->p_library ) FT_Done_FreeType( p_sys->p_library );
 #ifdef HAVE_STYLES
@@ -2819,6 +3394,14 @@ static void Destroy( vlc_object_t *p_this )
      * even if no other library functions have been made since FcInit(),
      * so don't call it. */
 
+    msg_Dbg( p_filter, "glyph cache: %u hits, %u misses",
+             p_sys->glyph_cache.i_hits, p_sys->glyph_cache.i_misses );
+    msg_Dbg( p_filter, "text cache: %u hits, %u misses",
+             p_sys->text_cache.i_hits, p_sys->text_cache.i_misses );
+    TextCacheClean( &p_sys->text_cache );
+    GlyphCacheClean( &p_sys->glyph_cache );
+    FaceCacheClean( p_sys );
+
     if( p_sys->p_stroker )
         FT_Stroker_Done( p_sys->p_stroker );
     FT_Done_Face( p_sys->p_face );
@@ -0,0 +1,773 @@
+/*****************************************************************************
+ * yuv_rgb.c: 4:2:0 YUV to RGB conversions using AVX2
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+# define YUV_RGB_AVX2 __attribute__ ((__target__ ("avx2")))
+#endif
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open (vlc_object_t *);
+static void Close(vlc_object_t *);
+static int  OpenBench (vlc_object_t *);
+static void CloseBench(vlc_object_t *);
+
+#define BENCH_CFG_PREFIX "yuvrgbbench-"
+
+#define LOOPS_TEXT N_("Number of conversions")
+#define LOOPS_LONGTEXT N_("The number of times every conversion is run.")
+#define WIDTH_TEXT N_("Picture width")
+#define HEIGHT_TEXT N_("Picture height")
+#define SIZE_LONGTEXT N_("Size of the pictures converted by the benchmark.")
+
+vlc_module_begin()
+    set_description(N_("AVX2 conversions from 4:2:0 YUV to RGB"))
+    set_capability("video filter2", 160)
+    set_callbacks(Open, Close)
+
+    add_submodule()
+    set_description(N_("YUV to RGB conversions benchmark filter"))
+    set_shortname(N_("YUV to RGB benchmark"))
+    set_category(CAT_VIDEO)
+    set_subcategory(SUBCAT_VIDEO_VFILTER)
+    set_capability("video filter2", 0)
+    add_shortcut("yuvrgbbench")
+
+    set_section(N_("Benchmarking"), NULL)
+    add_integer(BENCH_CFG_PREFIX "loops", 100, LOOPS_TEXT,
+                LOOPS_LONGTEXT, false)
+    add_integer_with_range(BENCH_CFG_PREFIX "width", 1920, 2, 8192,
+                           WIDTH_TEXT, SIZE_LONGTEXT, false)
+    add_integer_with_range(BENCH_CFG_PREFIX "height", 1080, 2, 8192,
+                           HEIGHT_TEXT, SIZE_LONGTEXT, false)
+    set_callbacks(OpenBench, CloseBench)
+vlc_module_end()
+
+/*****************************************************************************
+ * Line kernels
+ *****************************************************************************
+ * A line of 8 bits Y is converted with the 8 bits U and V lines of its
+ * chroma row, u[i / 2] and v[i / 2] going with y[i]. NV12 and 10 bits
+ * chroma rows are first converted to such lines, once for two luma lines.
+ *
+ * The AVX2 kernels compute with 16 bits words. The ITU-R BT.601 limited
+ * range coefficients are in 14 (luma) and 13 (chroma) bits fixed point, and
+ * the centered samples are shifted left by 7 and 8 bits, so that every
+ * product rounded to its high half (_mm256_mulhrs_epi16) is the term of the
+ * sum in 6 bits fixed point. The sums fit in the words, except for blue
+ * which may saturate but only well above 255. The C kernels compute the
+ * very same values, and are used as the reference and for the last pixels
+ * of the lines.
+ *****************************************************************************/
+#define COEF_Y  19071 /* 1.164 */
+#define COEF_RV 13074 /* 1.596 */
+#define COEF_GU  3211 /* 0.392 */
+#define COEF_GV  6660 /* 0.813 */
+#define COEF_BU 16523 /* 2.017 */
+
+typedef struct {
+    unsigned bytes;     /* 2, 3 or 4 bytes per pixel */
+    unsigned offset[4]; /* R, G, B and padding byte offsets (RV24 and RV32) */
+    unsigned rshift[3]; /* R, G, B right then left shifts (RV15 and RV16) */
+    unsigned lshift[3];
+} yuv_rgb_format_t;
+
+typedef void (*yuv_rgb_line_t)(uint8_t *dst, const uint8_t *y,
+                               const uint8_t *u, const uint8_t *v,
+                               unsigned width, const yuv_rgb_format_t *);
+
+typedef struct {
+    const char *name;
+    yuv_rgb_line_t to_rgb32;
+    yuv_rgb_line_t to_rgb24;
+    yuv_rgb_line_t to_rgb16;
+    /* Interleaved UV pairs to U and V */
+    void (*split_uv)(uint8_t *u, uint8_t *v, const uint8_t *uv,
+                     unsigned count);
+    /* 10 bits to 8 bits samples */
+    void (*to_8bits)(uint8_t *dst, const uint16_t *src, unsigned count);
+} yuv_rgb_kernels_t;
+
+static inline uint8_t Clip8(int v)
+{
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+/* Rounded high half of a 16 bits product, as _mm256_mulhrs_epi16() */
+static inline int MulHrs(int a, int b)
+{
+    return (a * b + 0x4000) >> 15;
+}
+
+static inline void YuvToRgb(uint8_t rgb[3], int y, int u, int v)
+{
+    const int l = MulHrs((y - 16) * 128, COEF_Y) + 32;
+
+    u = (u - 128) * 256;
+    v = (v - 128) * 256;
+    rgb[0] = Clip8((l + MulHrs(v, COEF_RV)) >> 6);
+    rgb[1] = Clip8((l - MulHrs(u, COEF_GU) - MulHrs(v, COEF_GV)) >> 6);
+    rgb[2] = Clip8((l + MulHrs(u, COEF_BU)) >> 6);
+}
+
+static void ToRgb32C(uint8_t *dst, const uint8_t *y,
+                     const uint8_t *u, const uint8_t *v,
+                     unsigned width, const yuv_rgb_format_t *fmt)
+{
+    for (unsigned i = 0; i < width; i++, dst += 4) {
+        uint8_t rgb[3];
+        YuvToRgb(rgb, y[i], u[i / 2], v[i / 2]);
+        dst[fmt->offset[0]] = rgb[0];
+        dst[fmt->offset[1]] = rgb[1];
+        dst[fmt->offset[2]] = rgb[2];
+        dst[fmt->offset[3]] = 0xff;
+    }
+}
+
+static void ToRgb24C(uint8_t *dst, const uint8_t *y,
+                     const uint8_t *u, const uint8_t *v,
+                     unsigned width, const yuv_rgb_format_t *fmt)
+{
+    for (unsigned i = 0; i < width; i++, dst += 3) {
+        uint8_t rgb[3];
+        YuvToRgb(rgb, y[i], u[i / 2], v[i / 2]);
+        dst[fmt->offset[0]] = rgb[0];
+        dst[fmt->offset[1]] = rgb[1];
+        dst[fmt->offset[2]] = rgb[2];
+    }
+}
+
+static void ToRgb16C(uint8_t *dst, const uint8_t *y,
+                     const uint8_t *u, const uint8_t *v,
+                     unsigned width, const yuv_rgb_format_t *fmt)
+{
+    uint16_t *p = (uint16_t *)dst;
+
+    for (unsigned i = 0; i < width; i++) {
+        uint8_t rgb[3];
+        YuvToRgb(rgb, y[i], u[i / 2], v[i / 2]);
+        p[i] = ((rgb[0] >> fmt->rshift[0]) << fmt->lshift[0]) |
+               ((rgb[1] >> fmt->rshift[1]) << fmt->lshift[1]) |
+               ((rgb[2] >> fmt->rshift[2]) << fmt->lshift[2]);
+    }
+}
+
+static void SplitUvC(uint8_t *u, uint8_t *v, const uint8_t *uv,
+                     unsigned count)
+{
+    for (unsigned i = 0; i < count; i++) {
+        u[i] = uv[2 * i + 0];
+        v[i] = uv[2 * i + 1];
+    }
+}
+
+static void To8BitsC(uint8_t *dst, const uint16_t *src, unsigned count)
+{
+    /* Out of range samples saturate, as with the SIMD packing */
+    for (unsigned i = 0; i < count; i++)
+        dst[i] = __MIN(src[i] >> 2, 255);
+}
+
+static const yuv_rgb_kernels_t kernels_c = {
+    "C", ToRgb32C, ToRgb24C, ToRgb16C, SplitUvC, To8BitsC,
+};
+
+#if defined(HAVE_AVX2_INTRINSICS)
+/* It converts 16 pixels to R, G and B words, from 16 Y bytes and 16 U and
+ * V bytes where every chroma sample is repeated twice. */
+YUV_RGB_AVX2
+static inline void YuvToRgbWordsAVX2(__m256i rgb[3],
+                                     __m128i y, __m128i u, __m128i v)
+{
+    const __m256i l = _mm256_add_epi16(
+        _mm256_mulhrs_epi16(_mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(y),
+                                                               _mm256_set1_epi16(16)), 7),
+                            _mm256_set1_epi16(COEF_Y)),
+        _mm256_set1_epi16(32));
+    const __m256i cu = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(u),
+                                                          _mm256_set1_epi16(128)), 8);
+    const __m256i cv = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(v),
+                                                          _mm256_set1_epi16(128)), 8);
+
+    rgb[0] = _mm256_adds_epi16(l, _mm256_mulhrs_epi16(cv, _mm256_set1_epi16(COEF_RV)));
+    rgb[1] = _mm256_sub_epi16(_mm256_sub_epi16(l,
+                 _mm256_mulhrs_epi16(cu, _mm256_set1_epi16(COEF_GU))),
+                 _mm256_mulhrs_epi16(cv, _mm256_set1_epi16(COEF_GV)));
+    rgb[2] = _mm256_adds_epi16(l, _mm256_mulhrs_epi16(cu, _mm256_set1_epi16(COEF_BU)));
+    for (int c = 0; c < 3; c++)
+        rgb[c] = _mm256_srai_epi16(rgb[c], 6);
+}
+
+/* It converts 32 pixels to R, G and B bytes, in order. */
+YUV_RGB_AVX2
+static inline void YuvToRgbBytesAVX2(__m256i rgb[3], const uint8_t *y,
+                                     const uint8_t *u, const uint8_t *v)
+{
+    const __m128i u16 = _mm_loadu_si128((const __m128i *)u);
+    const __m128i v16 = _mm_loadu_si128((const __m128i *)v);
+    __m256i lo[3], hi[3];
+
+    YuvToRgbWordsAVX2(lo, _mm_loadu_si128((const __m128i *)&y[0]),
+                      _mm_unpacklo_epi8(u16, u16), _mm_unpacklo_epi8(v16, v16));
+    YuvToRgbWordsAVX2(hi, _mm_loadu_si128((const __m128i *)&y[16]),
+                      _mm_unpackhi_epi8(u16, u16), _mm_unpackhi_epi8(v16, v16));
+    /* The packing works within 128 bits lanes */
+    for (int c = 0; c < 3; c++)
+        rgb[c] = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo[c], hi[c]),
+                                          _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+/* It interleaves the 32 bytes of c[0..3] into 32 pixels of 4 bytes, px[k]
+ * holding the pixels 8k to 8k + 7. */
+YUV_RGB_AVX2
+static inline void InterleaveAVX2(__m256i px[4], const __m256i c[4])
+{
+    const __m256i t0 = _mm256_unpacklo_epi8(c[0], c[1]);
+    const __m256i t1 = _mm256_unpackhi_epi8(c[0], c[1]);
+    const __m256i t2 = _mm256_unpacklo_epi8(c[2], c[3]);
+    const __m256i t3 = _mm256_unpackhi_epi8(c[2], c[3]);
+    /* The low lanes hold the pixels 0-15, the high ones 16-31 */
+    const __m256i q0 = _mm256_unpacklo_epi16(t0, t2);
+    const __m256i q1 = _mm256_unpackhi_epi16(t0, t2);
+    const __m256i q2 = _mm256_unpacklo_epi16(t1, t3);
+    const __m256i q3 = _mm256_unpackhi_epi16(t1, t3);
+
+    px[0] = _mm256_permute2x128_si256(q0, q1, 0x20);
+    px[1] = _mm256_permute2x128_si256(q2, q3, 0x20);
+    px[2] = _mm256_permute2x128_si256(q0, q1, 0x31);
+    px[3] = _mm256_permute2x128_si256(q2, q3, 0x31);
+}
+
+YUV_RGB_AVX2
+static void ToRgb32AVX2(uint8_t *dst, const uint8_t *y,
+                        const uint8_t *u, const uint8_t *v,
+                        unsigned width, const yuv_rgb_format_t *fmt)
+{
+    unsigned i = 0;
+
+    for (; i + 32 <= width; i += 32) {
+        __m256i rgb[3], c[4], px[4];
+
+        YuvToRgbBytesAVX2(rgb, &y[i], &u[i / 2], &v[i / 2]);
+        c[fmt->offset[0]] = rgb[0];
+        c[fmt->offset[1]] = rgb[1];
+        c[fmt->offset[2]] = rgb[2];
+        c[fmt->offset[3]] = _mm256_set1_epi8(0xff);
+        InterleaveAVX2(px, c);
+        for (int k = 0; k < 4; k++)
+            _mm256_storeu_si256((__m256i *)&dst[4 * i + 32 * k], px[k]);
+    }
+    ToRgb32C(&dst[4 * i], &y[i], &u[i / 2], &v[i / 2], width - i, fmt);
+}
+
+YUV_RGB_AVX2
+static void ToRgb24AVX2(uint8_t *dst, const uint8_t *y,
+                        const uint8_t *u, const uint8_t *v,
+                        unsigned width, const yuv_rgb_format_t *fmt)
+{
+    /* It packs 4 pixels of 4 bytes into 12 bytes in every lane */
+    const __m256i pack = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    unsigned i = 0;
+
+    /* Every 16 bytes store overwrites the 4 last bytes of the previous one,
+     * and the last one writes 4 bytes past the 96 of the 32 pixels: there
+     * must be 2 more pixels in the line. */
+    for (; i + 32 + 2 <= width; i += 32) {
+        __m256i rgb[3], c[4], px[4];
+
+        YuvToRgbBytesAVX2(rgb, &y[i], &u[i / 2], &v[i / 2]);
+        c[fmt->offset[0]] = rgb[0];
+        c[fmt->offset[1]] = rgb[1];
+        c[fmt->offset[2]] = rgb[2];
+        c[3] = _mm256_setzero_si256();
+        InterleaveAVX2(px, c);
+        for (int k = 0; k < 4; k++) {
+            const __m256i p = _mm256_shuffle_epi8(px[k], pack);
+            uint8_t *d = &dst[3 * i + 24 * k];
+            _mm_storeu_si128((__m128i *)&d[0], _mm256_castsi256_si128(p));
+            _mm_storeu_si128((__m128i *)&d[12], _mm256_extracti128_si256(p, 1));
+        }
+    }
+    ToRgb24C(&dst[3 * i], &y[i], &u[i / 2], &v[i / 2], width - i, fmt);
+}
+
+YUV_RGB_AVX2
+static void ToRgb16AVX2(uint8_t *dst, const uint8_t *y,
+                        const uint8_t *u, const uint8_t *v,
+                        unsigned width, const yuv_rgb_format_t *fmt)
+{
+    __m128i rshift[3], lshift[3];
+    for (int c = 0; c < 3; c++) {
+        rshift[c] = _mm_cvtsi32_si128(fmt->rshift[c]);
+        lshift[c] = _mm_cvtsi32_si128(fmt->lshift[c]);
+    }
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max  = _mm256_set1_epi16(255);
+    unsigned i = 0;
+
+    for (; i + 16 <= width; i += 16) {
+        const __m128i u8 = _mm_loadl_epi64((const __m128i *)&u[i / 2]);
+        const __m128i v8 = _mm_loadl_epi64((const __m128i *)&v[i / 2]);
+        __m256i rgb[3];
+
+        YuvToRgbWordsAVX2(rgb, _mm_loadu_si128((const __m128i *)&y[i]),
+                          _mm_unpacklo_epi8(u8, u8), _mm_unpacklo_epi8(v8, v8));
+        __m256i p = zero;
+        for (int c = 0; c < 3; c++) {
+            const __m256i w = _mm256_min_epi16(_mm256_max_epi16(rgb[c], zero), max);
+            p = _mm256_or_si256(p, _mm256_sll_epi16(_mm256_srl_epi16(w, rshift[c]),
+                                                    lshift[c]));
+        }
+        _mm256_storeu_si256((__m256i *)&dst[2 * i], p);
+    }
+    ToRgb16C(&dst[2 * i], &y[i], &u[i / 2], &v[i / 2], width - i, fmt);
+}
+
+YUV_RGB_AVX2
+static void SplitUvAVX2(uint8_t *u, uint8_t *v, const uint8_t *uv,
+                        unsigned count)
+{
+    /* It gives the 8 U then the 8 V samples of every lane */
+    const __m256i split = _mm256_setr_epi8(
+        0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+        0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    unsigned i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        /* The low lanes get the U samples, the high ones the V samples */
+        const __m256i a = _mm256_permute4x64_epi64(
+            _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)&uv[2 * i]), split),
+            _MM_SHUFFLE(3, 1, 2, 0));
+        const __m256i b = _mm256_permute4x64_epi64(
+            _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)&uv[2 * i + 32]), split),
+            _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)&u[i], _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i *)&v[i], _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    SplitUvC(&u[i], &v[i], &uv[2 * i], count - i);
+}
+
+YUV_RGB_AVX2
+static void To8BitsAVX2(uint8_t *dst, const uint16_t *src, unsigned count)
+{
+    unsigned i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        const __m256i a = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)&src[i]), 2);
+        const __m256i b = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)&src[i + 16]), 2);
+        _mm256_storeu_si256((__m256i *)&dst[i],
+                            _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b),
+                                                     _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    To8BitsC(&dst[i], &src[i], count - i);
+}
+
+static const yuv_rgb_kernels_t kernels_avx2 = {
+    "AVX2", ToRgb32AVX2, ToRgb24AVX2, ToRgb16AVX2, SplitUvAVX2, To8BitsAVX2,
+};
+#endif
+
+/**
+ * It returns the SIMD kernels for the CPU, or NULL if there are none.
+ */
+static const yuv_rgb_kernels_t *GetKernels(void)
+{
+#if defined(HAVE_AVX2_INTRINSICS)
+    if (vlc_CPU_AVX2())
+        return &kernels_avx2;
+#endif
+    return NULL;
+}
+
+/*****************************************************************************
+ * Pictures conversion
+ *****************************************************************************/
+/* Scratch space for the U, V and 8 bits Y lines */
+#define YUV_RGB_SCRATCH(width) (2 * (((width) + 1) / 2) + (width))
+
+typedef struct {
+    const yuv_rgb_kernels_t *kernels;
+    yuv_rgb_line_t          to_rgb;
+    yuv_rgb_format_t        format;
+    vlc_fourcc_t            chroma; /* Input chroma */
+    unsigned                width;
+    unsigned                height;
+} yuv_rgb_t;
+
+static bool IsSupportedYuv(vlc_fourcc_t chroma)
+{
+#ifndef WORDS_BIGENDIAN
+    /* The little endian 10 bits samples are read as native words */
+    if (chroma == VLC_CODEC_I420_10L)
+        return true;
+#endif
+    return chroma == VLC_CODEC_I420 || chroma == VLC_CODEC_YV12 ||
+           chroma == VLC_CODEC_NV12;
+}
+
+/**
+ * It fills the RGB layout from a fixed up RGB format (see
+ * video_format_FixRgb()), and fails for the masks it cannot handle.
+ */
+static int SetupFormat(yuv_rgb_format_t *f, const video_format_t *fmt)
+{
+    const uint32_t mask[3]   = { fmt->i_rmask, fmt->i_gmask, fmt->i_bmask };
+    const unsigned lshift[3] = { fmt->i_lrshift, fmt->i_lgshift, fmt->i_lbshift };
+    const unsigned rshift[3] = { fmt->i_rrshift, fmt->i_rgshift, fmt->i_rbshift };
+
+    switch (fmt->i_chroma) {
+    case VLC_CODEC_RGB15:
+    case VLC_CODEC_RGB16:
+        f->bytes = 2;
+        for (int c = 0; c < 3; c++) {
+            if (mask[c] == 0 || mask[c] > 0xffff)
+                return VLC_EGENERIC;
+            f->lshift[c] = lshift[c];
+            f->rshift[c] = rshift[c];
+        }
+        return VLC_SUCCESS;
+
+    case VLC_CODEC_RGB24:
+    case VLC_CODEC_RGB32: {
+        f->bytes = fmt->i_chroma == VLC_CODEC_RGB24 ? 3 : 4;
+        unsigned used = 0;
+        for (int c = 0; c < 3; c++) {
+            if (rshift[c] != 0 || (lshift[c] % 8) != 0 ||
+                lshift[c] / 8 >= f->bytes ||
+                mask[c] != (0xffu << lshift[c]))
+                return VLC_EGENERIC;
+#ifdef WORDS_BIGENDIAN
+            f->offset[c] = f->bytes - 1 - lshift[c] / 8;
+#else
+            f->offset[c] = lshift[c] / 8;
+#endif
+            used |= 1 << f->offset[c];
+        }
+        if (used != 0x7 && used != 0xb && used != 0xd && used != 0xe)
+            return VLC_EGENERIC;
+        /* The padding byte of RV32 is the remaining one */
+        f->offset[3] = 0;
+        while (used & (1 << f->offset[3]))
+            f->offset[3]++;
+        return VLC_SUCCESS;
+    }
+    default:
+        return VLC_EGENERIC;
+    }
+}
+
+static yuv_rgb_line_t GetLineKernel(const yuv_rgb_kernels_t *k,
+                                    const yuv_rgb_format_t *f)
+{
+    switch (f->bytes) {
+    case 2:  return k->to_rgb16;
+    case 3:  return k->to_rgb24;
+    default: return k->to_rgb32;
+    }
+}
+
+/**
+ * It converts the lines [first, end) of src to dst, first being even.
+ */
+static void ConvertLines(const yuv_rgb_t *c, uint8_t *scratch,
+                         picture_t *dst, const picture_t *src,
+                         int first, int end)
+{
+    const yuv_rgb_kernels_t *k = c->kernels;
+    const unsigned cwidth = (c->width + 1) / 2;
+    uint8_t *u_line = &scratch[0];
+    uint8_t *v_line = &scratch[cwidth];
+    uint8_t *y_line = &scratch[2 * cwidth];
+
+    const plane_t *y_plane = &src->p[Y_PLANE];
+    const plane_t *u_plane = &src->p[c->chroma == VLC_CODEC_YV12 ? V_PLANE : U_PLANE];
+    const plane_t *v_plane = &src->p[c->chroma == VLC_CODEC_YV12 ? U_PLANE : V_PLANE];
+
+    for (int cy = first / 2; 2 * cy < end; cy++) {
+        const uint8_t *u, *v;
+
+        switch (c->chroma) {
+        case VLC_CODEC_NV12:
+            k->split_uv(u_line, v_line,
+                        &src->p[1].p_pixels[cy * src->p[1].i_pitch], cwidth);
+            u = u_line;
+            v = v_line;
+            break;
+        case VLC_CODEC_I420_10L:
+            k->to_8bits(u_line, (const uint16_t *)&u_plane->p_pixels[cy * u_plane->i_pitch],
+                        cwidth);
+            k->to_8bits(v_line, (const uint16_t *)&v_plane->p_pixels[cy * v_plane->i_pitch],
+                        cwidth);
+            u = u_line;
+            v = v_line;
+            break;
+        default:
+            u = &u_plane->p_pixels[cy * u_plane->i_pitch];
+            v = &v_plane->p_pixels[cy * v_plane->i_pitch];
+            break;
+        }
+
+        for (int y = 2 * cy; y < __MIN(2 * cy + 2, end); y++) {
+            const uint8_t *l = &y_plane->p_pixels[y * y_plane->i_pitch];
+            if (c->chroma == VLC_CODEC_I420_10L) {
+                k->to_8bits(y_line, (const uint16_t *)l, c->width);
+                l = y_line;
+            }
+            c->to_rgb(&dst->p[0].p_pixels[y * dst->p[0].i_pitch],
+                      l, u, v, c->width, &c->format);
+        }
+    }
+}
+
+/*****************************************************************************
+ * Converter
+ *****************************************************************************/
+/* Under this number of lines per slice, threads are not worth it */
+#define MINIMUM_SLICE_HEIGHT 32
+
+struct filter_sys_t {
+    yuv_rgb_t conv;
+    unsigned  slices;
+    size_t    scratch_size; /* Per slice */
+    uint8_t   *scratch;
+
+    bool      bench_done;
+};
+
+typedef struct {
+    picture_t       *dst;
+    const picture_t *src;
+} yuv_rgb_job_t;
+
+static void ConvertSlice(filter_t *filter, void *data,
+                         unsigned slice, unsigned slices)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const yuv_rgb_job_t *job = data;
+    int first, end;
+
+    filter_GetSliceLines(sys->conv.height, slice, slices, 2, &first, &end);
+    ConvertLines(&sys->conv, &sys->scratch[slice * sys->scratch_size],
+                 job->dst, job->src, first, end);
+}
+
+static void Convert(filter_t *filter, picture_t *src, picture_t *dst)
+{
+    filter_sys_t *sys = filter->p_sys;
+    yuv_rgb_job_t job = { .dst = dst, .src = src };
+
+    filter_RunSlices(filter, sys->slices, ConvertSlice, &job);
+}
+
+VIDEO_FILTER_WRAPPER(Convert)
+
+static int Open(vlc_object_t *object)
+{
+    filter_t *filter = (filter_t *)object;
+    const video_format_t *in = &filter->fmt_in.video;
+
+    const yuv_rgb_kernels_t *kernels = GetKernels();
+    if (!kernels)
+        return VLC_EGENERIC;
+
+    /* It does not scale */
+    if (!IsSupportedYuv(in->i_chroma) ||
+        in->i_width  != filter->fmt_out.video.i_width ||
+        in->i_height != filter->fmt_out.video.i_height ||
+        in->i_width == 0 || in->i_height == 0)
+        return VLC_EGENERIC;
+
+    video_format_t out = filter->fmt_out.video;
+    video_format_FixRgb(&out);
+
+    yuv_rgb_format_t format;
+    if (SetupFormat(&format, &out))
+        return VLC_EGENERIC;
+
+    filter_sys_t *sys = malloc(sizeof(*sys));
+    if (!sys)
+        return VLC_ENOMEM;
+
+    sys->conv.kernels = kernels;
+    sys->conv.format  = format;
+    sys->conv.to_rgb  = GetLineKernel(kernels, &format);
+    sys->conv.chroma  = in->i_chroma;
+    sys->conv.width   = in->i_width;
+    sys->conv.height  = in->i_height;
+
+    unsigned slices = filter_GetSlices(filter);
+    slices = __MIN(slices, in->i_height / MINIMUM_SLICE_HEIGHT);
+    sys->slices = __MAX(slices, 1);
+
+    sys->scratch_size = YUV_RGB_SCRATCH(in->i_width);
+    sys->scratch = malloc(sys->slices * sys->scratch_size);
+    if (!sys->scratch) {
+        free(sys);
+        return VLC_ENOMEM;
+    }
+
+    msg_Dbg(filter, "%4.4s to %4.4s using %s kernels in %u slice(s)",
+            (const char *)&in->i_chroma, (const char *)&out.i_chroma,
+            kernels->name, sys->slices);
+
+    filter->p_sys = sys;
+    filter->pf_video_filter = Convert_Filter;
+    return VLC_SUCCESS;
+}
+
+static void Close(vlc_object_t *object)
+{
+    filter_t *filter = (filter_t *)object;
+    filter_sys_t *sys = filter->p_sys;
+
+    free(sys->scratch);
+    free(sys);
+}
+
+/*****************************************************************************
+ * Benchmark
+ *****************************************************************************
+ * On the first picture, every kernels set converts random pictures of every
+ * supported YUV chroma to every RGB depth, and the speed is reported in
+ * megapixels per second. The pictures then go through untouched.
+ *****************************************************************************/
+static void BenchRandomize(picture_t *picture)
+{
+    for (int i = 0; i < picture->i_planes; i++) {
+        const plane_t *p = &picture->p[i];
+        for (int j = 0; j < p->i_lines * p->i_pitch; j++)
+            p->p_pixels[j] = rand() & 0xff;
+    }
+}
+
+static void BenchRun(filter_t *filter, const yuv_rgb_kernels_t *k,
+                     vlc_fourcc_t in_chroma, vlc_fourcc_t out_chroma,
+                     unsigned width, unsigned height, int loops)
+{
+    video_format_t in, out;
+    video_format_Setup(&in,  in_chroma,  width, height, 1, 1);
+    video_format_Setup(&out, out_chroma, width, height, 1, 1);
+    video_format_FixRgb(&out);
+
+    yuv_rgb_t conv = {
+        .kernels = k,
+        .chroma  = in_chroma,
+        .width   = width,
+        .height  = height,
+    };
+    if (SetupFormat(&conv.format, &out))
+        return;
+    conv.to_rgb = GetLineKernel(k, &conv.format);
+
+    picture_t *src = picture_NewFromFormat(&in);
+    picture_t *dst = picture_NewFromFormat(&out);
+    uint8_t *scratch = malloc(YUV_RGB_SCRATCH(width));
+    if (src && dst && scratch) {
+        BenchRandomize(src);
+        if (in_chroma == VLC_CODEC_I420_10L) {
+            /* Keep the samples within 10 bits */
+            for (int i = 0; i < src->i_planes; i++) {
+                plane_t *p = &src->p[i];
+                for (int j = 1; j < p->i_lines * p->i_pitch; j += 2)
+                    p->p_pixels[j] &= 0x03;
+            }
+        }
+
+        const mtime_t start = mdate();
+        for (int i = 0; i < loops; i++)
+            ConvertLines(&conv, scratch, dst, src, 0, height);
+        const mtime_t duration = __MAX(mdate() - start, 1);
+
+        msg_Info(filter, "%4.4s to %4.4s (%s): %.1f Mpixels/s",
+                 (const char *)&in_chroma, (const char *)&out_chroma, k->name,
+                 (double)width * height * loops / duration);
+    }
+    free(scratch);
+    if (dst)
+        picture_Release(dst);
+    if (src)
+        picture_Release(src);
+}
+
+static picture_t *BenchFilter(filter_t *filter, picture_t *picture)
+{
+    filter_sys_t *sys = filter->p_sys;
+
+    if (sys->bench_done)
+        return picture;
+    sys->bench_done = true;
+
+    static const vlc_fourcc_t yuv[] = {
+        VLC_CODEC_I420, VLC_CODEC_NV12, VLC_CODEC_I420_10L,
+    };
+    static const vlc_fourcc_t rgb[] = {
+        VLC_CODEC_RGB32, VLC_CODEC_RGB24, VLC_CODEC_RGB16,
+    };
+    const yuv_rgb_kernels_t *kernels[] = { &kernels_c, GetKernels() };
+
+    const int loops = __MAX(var_InheritInteger(filter, BENCH_CFG_PREFIX "loops"), 1);
+    const unsigned width  = var_InheritInteger(filter, BENCH_CFG_PREFIX "width");
+    const unsigned height = var_InheritInteger(filter, BENCH_CFG_PREFIX "height");
+
+    msg_Info(filter, "converting %ux%u pictures %d times", width, height, loops);
+    for (size_t i = 0; i < sizeof(yuv) / sizeof(*yuv); i++)
+        for (size_t o = 0; o < sizeof(rgb) / sizeof(*rgb); o++)
+            for (size_t k = 0; k < sizeof(kernels) / sizeof(*kernels); k++)
+                if (kernels[k])
+                    BenchRun(filter, kernels[k], yuv[i], rgb[o],
+                             width, height, loops);
+    return picture;
+}
+
+static int OpenBench(vlc_object_t *object)
+{
+    filter_t *filter = (filter_t *)object;
+
+    filter_sys_t *sys = calloc(1, sizeof(*sys));
+    if (!sys)
+        return VLC_ENOMEM;
+
+    filter->p_sys = sys;
+    filter->pf_video_filter = BenchFilter;
+    return VLC_SUCCESS;
+}
+
+static void CloseBench(vlc_object_t *object)
+{
+    filter_t *filter = (filter_t *)object;
+
+    free(filter->p_sys);
+}
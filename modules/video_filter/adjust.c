@@ -220,6 +220,160 @@ static void Destroy( vlc_object_t *p_this )
     free( p_sys );
 }
 
+/*****************************************************************************
+ * Slices
+ *****************************************************************************/
+typedef struct
+{
+    picture_t  *p_pic;
+    picture_t  *p_outpic;
+    const int  *pi_luma;
+    int        (* pf_process_sat_hue)( picture_t *, picture_t *, int, int, int,
+                                       int, int );
+    int        i_sin, i_cos, i_sat, i_x, i_y;
+    int        i_y_offset;
+    bool       b_error;
+} adjust_slices_t;
+
+/* It makes p_slice a view of the lines of a slice of p_pic, so that the
+ * whole picture functions only process that slice */
+static void SlicePicture( picture_t *p_slice, const picture_t *p_pic,
+                          unsigned i_slice, unsigned i_slices )
+{
+    *p_slice = *p_pic;
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_slice->p[i];
+        int i_first, i_end;
+
+        filter_GetSliceLines( p->i_visible_lines, i_slice, i_slices, 1,
+                              &i_first, &i_end );
+        p->p_pixels += i_first * p->i_pitch;
+        p->i_lines = p->i_visible_lines = i_end - i_first;
+    }
+}
+
+static void FilterPlanarSlice( filter_t *p_filter, void *p_data,
+                               unsigned i_slice, unsigned i_slices )
+{
+    adjust_slices_t *p_slices = p_data;
+    const int *pi_luma = p_slices->pi_luma;
+    picture_t pic, outpic;
+    uint8_t *p_in, *p_in_end, *p_line_end;
+    uint8_t *p_out;
+
+    VLC_UNUSED(p_filter);
+    SlicePicture( &pic, p_slices->p_pic, i_slice, i_slices );
+    SlicePicture( &outpic, p_slices->p_outpic, i_slice, i_slices );
+
+    /*
+     * Do the Y plane
+     */
+
+    p_in = pic.p[Y_PLANE].p_pixels;
+    p_in_end = p_in + pic.p[Y_PLANE].i_visible_lines
+                      * pic.p[Y_PLANE].i_pitch - 8;
+
+    p_out = outpic.p[Y_PLANE].p_pixels;
+
+    for( ; p_in < p_in_end ; )
+    {
+        p_line_end = p_in + pic.p[Y_PLANE].i_visible_pitch - 8;
+
+        for( ; p_in < p_line_end ; )
+        {
+            /* Do 8 pixels at a time */
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+        }
+
+        p_line_end += 8;
+
+        for( ; p_in < p_line_end ; )
+        {
+            *p_out++ = pi_luma[ *p_in++ ];
+        }
+
+        p_in += pic.p[Y_PLANE].i_pitch
+              - pic.p[Y_PLANE].i_visible_pitch;
+        p_out += outpic.p[Y_PLANE].i_pitch
+               - outpic.p[Y_PLANE].i_visible_pitch;
+    }
+
+    /*
+     * Do the U and V planes
+     */
+
+    /* Currently no errors are implemented in the function, if any are added
+     * check them here */
+    p_slices->pf_process_sat_hue( &pic, &outpic, p_slices->i_sin,
+                                  p_slices->i_cos, p_slices->i_sat,
+                                  p_slices->i_x, p_slices->i_y );
+}
+
+static void FilterPackedSlice( filter_t *p_filter, void *p_data,
+                               unsigned i_slice, unsigned i_slices )
+{
+    adjust_slices_t *p_slices = p_data;
+    const int *pi_luma = p_slices->pi_luma;
+    picture_t pic, outpic;
+    uint8_t *p_in, *p_in_end, *p_line_end;
+    uint8_t *p_out;
+
+    VLC_UNUSED(p_filter);
+    SlicePicture( &pic, p_slices->p_pic, i_slice, i_slices );
+    SlicePicture( &outpic, p_slices->p_outpic, i_slice, i_slices );
+
+    /*
+     * Do the Y plane
+     */
+
+    p_in = pic.p->p_pixels + p_slices->i_y_offset;
+    p_in_end = p_in + pic.p->i_visible_lines * pic.p->i_pitch - 8 * 4;
+
+    p_out = outpic.p->p_pixels + p_slices->i_y_offset;
+
+    for( ; p_in < p_in_end ; )
+    {
+        p_line_end = p_in + pic.p->i_visible_pitch - 8 * 4;
+
+        for( ; p_in < p_line_end ; )
+        {
+            /* Do 8 pixels at a time */
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+        }
+
+        p_line_end += 8 * 4;
+
+        for( ; p_in < p_line_end ; )
+        {
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+        }
+
+        p_in += pic.p->i_pitch - pic.p->i_visible_pitch;
+        p_out += outpic.p->i_pitch - outpic.p->i_visible_pitch;
+    }
+
+    /*
+     * Do the U and V planes
+     */
+
+    if( p_slices->pf_process_sat_hue( &pic, &outpic, p_slices->i_sin,
+                                      p_slices->i_cos, p_slices->i_sat,
+                                      p_slices->i_x, p_slices->i_y )
+        != VLC_SUCCESS )
+        p_slices->b_error = true;
+}
+
 /*****************************************************************************
  * Run the filter on a Planar YUV picture
  *****************************************************************************/
@@ -229,8 +383,6 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
     int pi_gamma[256];
 
     picture_t *p_outpic;
-    uint8_t *p_in, *p_in_end, *p_line_end;
-    uint8_t *p_out;
 
     bool b_thres;
     double  f_hue;
@@ -299,66 +451,23 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
         i_sat = 0;
     }
 
-    /*
-     * Do the Y plane
-     */
-
-    p_in = p_pic->p[Y_PLANE].p_pixels;
-    p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
-                      * p_pic->p[Y_PLANE].i_pitch - 8;
-
-    p_out = p_outpic->p[Y_PLANE].p_pixels;
-
-    for( ; p_in < p_in_end ; )
-    {
-        p_line_end = p_in + p_pic->p[Y_PLANE].i_visible_pitch - 8;
-
-        for( ; p_in < p_line_end ; )
-        {
-            /* Do 8 pixels at a time */
-            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-        }
-
-        p_line_end += 8;
-
-        for( ; p_in < p_line_end ; )
-        {
-            *p_out++ = pi_luma[ *p_in++ ];
-        }
-
-        p_in += p_pic->p[Y_PLANE].i_pitch
-              - p_pic->p[Y_PLANE].i_visible_pitch;
-        p_out += p_outpic->p[Y_PLANE].i_pitch
-               - p_outpic->p[Y_PLANE].i_visible_pitch;
-    }
-
-    /*
-     * Do the U and V planes
-     */
-
     i_sin = sin(f_hue) * 256;
     i_cos = cos(f_hue) * 256;
 
     i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
     i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
 
-    if ( i_sat > 256 )
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
-    else
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
+    adjust_slices_t slices = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .pi_luma = pi_luma,
+        .pf_process_sat_hue = i_sat > 256 ? p_sys->pf_process_sat_hue_clip
+                                          : p_sys->pf_process_sat_hue,
+        .i_sin = i_sin, .i_cos = i_cos, .i_sat = i_sat, .i_x = i_x, .i_y = i_y,
+        .b_error = false,
+    };
+    filter_RunSlices( p_filter, filter_GetSlices( p_filter ),
+                      FilterPlanarSlice, &slices );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
@@ -372,12 +481,8 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
     int pi_gamma[256];
 
     picture_t *p_outpic;
-    uint8_t *p_in, *p_in_v, *p_in_end, *p_line_end;
-    uint8_t *p_out, *p_out_v;
     int i_y_offset, i_u_offset, i_v_offset;
 
-    int i_visible_lines, i_pitch, i_visible_pitch;
-
     bool b_thres;
     double  f_hue;
     double  f_gamma;
@@ -389,10 +494,6 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
 
     if( !p_pic ) return NULL;
 
-    i_visible_lines = p_pic->p->i_visible_lines;
-    i_pitch = p_pic->p->i_pitch;
-    i_visible_pitch = p_pic->p->i_visible_pitch;
-
     if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
                              &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
     {
@@ -461,85 +562,34 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
         i_sat = 0;
     }
 
-    /*
-     * Do the Y plane
-     */
-
-    p_in = p_pic->p->p_pixels + i_y_offset;
-    p_in_end = p_in + p_pic->p->i_visible_lines * p_pic->p->i_pitch - 8 * 4;
-
-    p_out = p_outpic->p->p_pixels + i_y_offset;
-
-    for( ; p_in < p_in_end ; )
-    {
-        p_line_end = p_in + i_visible_pitch - 8 * 4;
-
-        for( ; p_in < p_line_end ; )
-        {
-            /* Do 8 pixels at a time */
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-        }
-
-        p_line_end += 8 * 4;
-
-        for( ; p_in < p_line_end ; )
-        {
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-        }
-
-        p_in += i_pitch - p_pic->p->i_visible_pitch;
-        p_out += i_pitch - p_outpic->p->i_visible_pitch;
-    }
-
-    /*
-     * Do the U and V planes
-     */
-
-    p_in = p_pic->p->p_pixels + i_u_offset;
-    p_in_v = p_pic->p->p_pixels + i_v_offset;
-    p_in_end = p_in + i_visible_lines * i_pitch - 8 * 4;
-
-    p_out = p_outpic->p->p_pixels + i_u_offset;
-    p_out_v = p_outpic->p->p_pixels + i_v_offset;
-
     i_sin = sin(f_hue) * 256;
     i_cos = cos(f_hue) * 256;
 
     i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
     i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
 
-    if ( i_sat > 256 )
+    adjust_slices_t slices = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .pi_luma = pi_luma,
+        .pf_process_sat_hue = i_sat > 256 ? p_sys->pf_process_sat_hue_clip
+                                          : p_sys->pf_process_sat_hue,
+        .i_sin = i_sin, .i_cos = i_cos, .i_sat = i_sat, .i_x = i_x, .i_y = i_y,
+        .i_y_offset = i_y_offset,
+        .b_error = false,
+    };
+    filter_RunSlices( p_filter, filter_GetSlices( p_filter ),
+                      FilterPackedSlice, &slices );
+
+    if( slices.b_error )
     {
-        if ( p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                             i_x, i_y ) != VLC_SUCCESS )
-        {
-            /* Currently only one error can happen in the function, but if there
-             * will be more of them, this message must go away */
-            msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
-                      (char*)&(p_pic->format.i_chroma) );
-            picture_Release( p_pic );
-            return NULL;
-        }
-    }
-    else
-    {
-        if ( p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y ) != VLC_SUCCESS )
-        {
-            /* Currently only one error can happen in the function, but if there
-             * will be more of them, this message must go away */
-            msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
-                      (char*)&(p_pic->format.i_chroma) );
-            picture_Release( p_pic );
-            return NULL;
-        }
+        /* Currently only one error can happen in the function, but if there
+         * will be more of them, this message must go away */
+        msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
+                  (char*)&(p_pic->format.i_chroma) );
+        picture_Release( p_outpic );
+        picture_Release( p_pic );
+        return NULL;
     }
 
     return CopyInfoAndRelease( p_outpic, p_pic );
@@ -32,8 +32,21 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+# define BLEND_SSE2 __attribute__ ((__target__ ("sse2")))
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+# define BLEND_AVX2 __attribute__ ((__target__ ("avx2")))
+#endif
+#if defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -262,6 +275,16 @@ private:
     uint8_t *data;
 };
 
+static inline unsigned getRgbOffset(unsigned lshift, unsigned bytes)
+{
+#ifdef WORDS_BIGENDIAN
+    return (8 * bytes - lshift) / 8;
+#else
+    (void)bytes;
+    return lshift / 8;
+#endif
+}
+
 template <unsigned bytes, bool has_alpha>
 class CPictureRGBX : public CPicture {
 public:
@@ -273,15 +296,9 @@ public:
             offset_b = 2;
             offset_a = 3;
         } else {
-#ifdef WORDS_BIGENDIAN
-            offset_r = (8 * bytes - fmt->i_lrshift) / 8;
-            offset_g = (8 * bytes - fmt->i_lgshift) / 8;
-            offset_b = (8 * bytes - fmt->i_lbshift) / 8;
-#else
-            offset_r = fmt->i_lrshift / 8;
-            offset_g = fmt->i_lgshift / 8;
-            offset_b = fmt->i_lbshift / 8;
-#endif
+            offset_r = getRgbOffset(fmt->i_lrshift, bytes);
+            offset_g = getRgbOffset(fmt->i_lgshift, bytes);
+            offset_b = getRgbOffset(fmt->i_lbshift, bytes);
         }
         data = CPicture::getLine<1>(0);
     }
@@ -591,11 +608,587 @@ static const struct {
 #undef YUV
 };
 
+/*****************************************************************************
+ * Line based blenders
+ *****************************************************************************
+ * For the most common overlays (YUVA or RGBA subpictures on 4:2:0 or RV32
+ * video), the pixels are blended a whole line at a time by the kernels
+ * below. The C kernels compute exactly what the templates above do, and
+ * the SIMD ones must match them bit for bit.
+ *****************************************************************************/
+struct blend_kernels_t {
+    /* a[i] = div255(alpha * src[i]) */
+    void (*scale_alpha)(uint8_t *a, const uint8_t *src, unsigned count,
+                        unsigned alpha);
+    /* merge(&dst[i], src[i], a[i]) */
+    void (*merge)(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                  unsigned count);
+    /* RGBA to planar YUVA using rgb_to_yuv() */
+    void (*rgba_to_yuva)(uint8_t *y, uint8_t *u, uint8_t *v, uint8_t *a,
+                         const uint8_t *rgba, unsigned count);
+    /* RGBA merged onto 32 bits RGB whose components are at offset[] */
+    void (*merge_rgbx)(uint8_t *dst, const uint8_t *rgba, unsigned count,
+                       unsigned alpha, const unsigned offset[3]);
+};
+
+static void ScaleAlphaC(uint8_t *a, const uint8_t *src, unsigned count,
+                        unsigned alpha)
+{
+    for (unsigned i = 0; i < count; i++)
+        a[i] = div255(alpha * src[i]);
+}
+
+static void MergeC(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                   unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+        ::merge(&dst[i], src[i], a[i]);
+}
+
+static void RgbaToYuvaC(uint8_t *y, uint8_t *u, uint8_t *v, uint8_t *a,
+                        const uint8_t *rgba, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++, rgba += 4) {
+        rgb_to_yuv(&y[i], &u[i], &v[i], rgba[0], rgba[1], rgba[2]);
+        a[i] = rgba[3];
+    }
+}
+
+static void MergeRgbxC(uint8_t *dst, const uint8_t *rgba, unsigned count,
+                       unsigned alpha, const unsigned offset[3])
+{
+    for (unsigned i = 0; i < count; i++, dst += 4, rgba += 4) {
+        const unsigned a = div255(alpha * rgba[3]);
+        ::merge(&dst[offset[0]], rgba[0], a);
+        ::merge(&dst[offset[1]], rgba[1], a);
+        ::merge(&dst[offset[2]], rgba[2], a);
+    }
+}
+
+static const blend_kernels_t kernels_c = {
+    ScaleAlphaC, MergeC, RgbaToYuvaC, MergeRgbxC,
+};
+
+#if defined(HAVE_SSE2_INTRINSICS)
+/* All the intermediate values fit in 16 bits words:
+ * (255 - f) * d + s * f <= 255 * 255 and so does div255() input. */
+BLEND_SSE2
+static inline __m128i Div255SSE2(__m128i v)
+{
+    v = _mm_add_epi16(v, _mm_srli_epi16(v, 8));
+    v = _mm_add_epi16(v, _mm_set1_epi16(1));
+    return _mm_srli_epi16(v, 8);
+}
+
+BLEND_SSE2
+static inline __m128i MergeWordsSSE2(__m128i d, __m128i s, __m128i f)
+{
+    const __m128i nf = _mm_sub_epi16(_mm_set1_epi16(255), f);
+    return Div255SSE2(_mm_add_epi16(_mm_mullo_epi16(nf, d),
+                                    _mm_mullo_epi16(s, f)));
+}
+
+BLEND_SSE2
+static void ScaleAlphaSSE2(uint8_t *a, const uint8_t *src, unsigned count,
+                           unsigned alpha)
+{
+    const __m128i zero   = _mm_setzero_si128();
+    const __m128i factor = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        const __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+        const __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), factor);
+        const __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), factor);
+        _mm_storeu_si128((__m128i *)&a[i],
+                         _mm_packus_epi16(Div255SSE2(lo), Div255SSE2(hi)));
+    }
+    ScaleAlphaC(&a[i], &src[i], count - i, alpha);
+}
+
+BLEND_SSE2
+static void MergeSSE2(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                      unsigned count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+        const __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+        const __m128i f = _mm_loadu_si128((const __m128i *)&a[i]);
+        const __m128i lo = MergeWordsSSE2(_mm_unpacklo_epi8(d, zero),
+                                          _mm_unpacklo_epi8(s, zero),
+                                          _mm_unpacklo_epi8(f, zero));
+        const __m128i hi = MergeWordsSSE2(_mm_unpackhi_epi8(d, zero),
+                                          _mm_unpackhi_epi8(s, zero),
+                                          _mm_unpackhi_epi8(f, zero));
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+    }
+    MergeC(&dst[i], &src[i], &a[i], count - i);
+}
+
+/* The U and V sums stay within [-28560, 28688], so they are computed on
+ * signed words; the Y one (at most 56228) on unsigned words. */
+BLEND_SSE2
+static void RgbaToYuvaSSE2(uint8_t *y, uint8_t *u, uint8_t *v, uint8_t *a,
+                           const uint8_t *rgba, unsigned count)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i c128 = _mm_set1_epi16(128);
+    unsigned i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const __m128i p0 = _mm_loadu_si128((const __m128i *)&rgba[4 * i]);
+        const __m128i p1 = _mm_loadu_si128((const __m128i *)&rgba[4 * i + 16]);
+
+        const __m128i r = _mm_packs_epi32(_mm_and_si128(p0, mask),
+                                          _mm_and_si128(p1, mask));
+        const __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask),
+                                          _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+        const __m128i b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask),
+                                          _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+        const __m128i al = _mm_packs_epi32(_mm_srli_epi32(p0, 24),
+                                           _mm_srli_epi32(p1, 24));
+
+        __m128i vy = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)),
+                                   _mm_mullo_epi16(g, _mm_set1_epi16(129)));
+        vy = _mm_add_epi16(vy, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)), c128));
+        vy = _mm_add_epi16(_mm_srli_epi16(vy, 8), _mm_set1_epi16(16));
+
+        __m128i vu = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(-38)),
+                                   _mm_mullo_epi16(g, _mm_set1_epi16(-74)));
+        vu = _mm_add_epi16(vu, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(112)), c128));
+        vu = _mm_add_epi16(_mm_srai_epi16(vu, 8), c128);
+
+        __m128i vv = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(112)),
+                                   _mm_mullo_epi16(g, _mm_set1_epi16(-94)));
+        vv = _mm_add_epi16(vv, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(-18)), c128));
+        vv = _mm_add_epi16(_mm_srai_epi16(vv, 8), c128);
+
+        _mm_storel_epi64((__m128i *)&y[i], _mm_packus_epi16(vy, vy));
+        _mm_storel_epi64((__m128i *)&u[i], _mm_packus_epi16(vu, vu));
+        _mm_storel_epi64((__m128i *)&v[i], _mm_packus_epi16(vv, vv));
+        _mm_storel_epi64((__m128i *)&a[i], _mm_packus_epi16(al, al));
+    }
+    RgbaToYuvaC(&y[i], &u[i], &v[i], &a[i], &rgba[4 * i], count - i);
+}
+
+/* Two pixels per register, as words: the scaled alpha is spread over the
+ * color components and zeroed on the padding byte, which merge() then
+ * leaves untouched. */
+template <bool swap_rb>
+BLEND_SSE2
+static void MergeRgbxLayoutSSE2(uint8_t *dst, const uint8_t *rgba,
+                                unsigned count, unsigned alpha)
+{
+    const __m128i zero   = _mm_setzero_si128();
+    const __m128i factor = _mm_set1_epi16(alpha);
+    const __m128i color  = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    unsigned i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        const __m128i s = _mm_loadu_si128((const __m128i *)&rgba[4 * i]);
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst[4 * i]);
+        __m128i sw[2] = { _mm_unpacklo_epi8(s, zero), _mm_unpackhi_epi8(s, zero) };
+        __m128i dw[2] = { _mm_unpacklo_epi8(d, zero), _mm_unpackhi_epi8(d, zero) };
+
+        for (int j = 0; j < 2; j++) {
+            __m128i f = Div255SSE2(_mm_mullo_epi16(sw[j], factor));
+            f = _mm_shufflelo_epi16(f, _MM_SHUFFLE(3, 3, 3, 3));
+            f = _mm_shufflehi_epi16(f, _MM_SHUFFLE(3, 3, 3, 3));
+            f = _mm_and_si128(f, color);
+            if (swap_rb) {
+                sw[j] = _mm_shufflelo_epi16(sw[j], _MM_SHUFFLE(3, 0, 1, 2));
+                sw[j] = _mm_shufflehi_epi16(sw[j], _MM_SHUFFLE(3, 0, 1, 2));
+            }
+            dw[j] = MergeWordsSSE2(dw[j], sw[j], f);
+        }
+        _mm_storeu_si128((__m128i *)&dst[4 * i], _mm_packus_epi16(dw[0], dw[1]));
+    }
+
+    static const unsigned offset[3] = { swap_rb ? 2u : 0u, 1u, swap_rb ? 0u : 2u };
+    MergeRgbxC(&dst[4 * i], &rgba[4 * i], count - i, alpha, offset);
+}
+
+BLEND_SSE2
+static void MergeRgbxSSE2(uint8_t *dst, const uint8_t *rgba, unsigned count,
+                          unsigned alpha, const unsigned offset[3])
+{
+    if (offset[1] == 1 && offset[0] == 0 && offset[2] == 2)
+        MergeRgbxLayoutSSE2<false>(dst, rgba, count, alpha);
+    else if (offset[1] == 1 && offset[0] == 2 && offset[2] == 0)
+        MergeRgbxLayoutSSE2<true>(dst, rgba, count, alpha);
+    else
+        MergeRgbxC(dst, rgba, count, alpha, offset);
+}
+
+static const blend_kernels_t kernels_sse2 = {
+    ScaleAlphaSSE2, MergeSSE2, RgbaToYuvaSSE2, MergeRgbxSSE2,
+};
+#endif
+
+#if defined(HAVE_AVX2_INTRINSICS) && defined(HAVE_SSE2_INTRINSICS)
+BLEND_AVX2
+static inline __m256i Div255AVX2(__m256i v)
+{
+    v = _mm256_add_epi16(v, _mm256_srli_epi16(v, 8));
+    v = _mm256_add_epi16(v, _mm256_set1_epi16(1));
+    return _mm256_srli_epi16(v, 8);
+}
+
+BLEND_AVX2
+static inline __m256i MergeWordsAVX2(__m256i d, __m256i s, __m256i f)
+{
+    const __m256i nf = _mm256_sub_epi16(_mm256_set1_epi16(255), f);
+    return Div255AVX2(_mm256_add_epi16(_mm256_mullo_epi16(nf, d),
+                                       _mm256_mullo_epi16(s, f)));
+}
+
+/* The unpack and pack instructions work within 128 bits lanes, and
+ * undo each other, so the byte order is preserved. */
+BLEND_AVX2
+static void ScaleAlphaAVX2(uint8_t *a, const uint8_t *src, unsigned count,
+                           unsigned alpha)
+{
+    const __m256i zero   = _mm256_setzero_si256();
+    const __m256i factor = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        const __m256i s = _mm256_loadu_si256((const __m256i *)&src[i]);
+        const __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), factor);
+        const __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), factor);
+        _mm256_storeu_si256((__m256i *)&a[i],
+                            _mm256_packus_epi16(Div255AVX2(lo), Div255AVX2(hi)));
+    }
+    ScaleAlphaSSE2(&a[i], &src[i], count - i, alpha);
+}
+
+BLEND_AVX2
+static void MergeAVX2(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                      unsigned count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    unsigned i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        const __m256i d = _mm256_loadu_si256((const __m256i *)&dst[i]);
+        const __m256i s = _mm256_loadu_si256((const __m256i *)&src[i]);
+        const __m256i f = _mm256_loadu_si256((const __m256i *)&a[i]);
+        const __m256i lo = MergeWordsAVX2(_mm256_unpacklo_epi8(d, zero),
+                                          _mm256_unpacklo_epi8(s, zero),
+                                          _mm256_unpacklo_epi8(f, zero));
+        const __m256i hi = MergeWordsAVX2(_mm256_unpackhi_epi8(d, zero),
+                                          _mm256_unpackhi_epi8(s, zero),
+                                          _mm256_unpackhi_epi8(f, zero));
+        _mm256_storeu_si256((__m256i *)&dst[i], _mm256_packus_epi16(lo, hi));
+    }
+    MergeSSE2(&dst[i], &src[i], &a[i], count - i);
+}
+
+static const blend_kernels_t kernels_avx2 = {
+    ScaleAlphaAVX2, MergeAVX2, RgbaToYuvaSSE2, MergeRgbxSSE2,
+};
+#endif
+
+#if defined(__ARM_NEON__)
+static inline uint8x8_t Div255NEON(uint16x8_t v)
+{
+    v = vaddq_u16(v, vshrq_n_u16(v, 8));
+    return vshrn_n_u16(vaddq_u16(v, vdupq_n_u16(1)), 8);
+}
+
+static inline uint8x16_t MergeBytesNEON(uint8x16_t d, uint8x16_t s, uint8x16_t f)
+{
+    const uint8x16_t nf = vmvnq_u8(f); /* 255 - f */
+    uint16x8_t lo = vmull_u8(vget_low_u8(nf), vget_low_u8(d));
+    uint16x8_t hi = vmull_u8(vget_high_u8(nf), vget_high_u8(d));
+    lo = vmlal_u8(lo, vget_low_u8(s), vget_low_u8(f));
+    hi = vmlal_u8(hi, vget_high_u8(s), vget_high_u8(f));
+    return vcombine_u8(Div255NEON(lo), Div255NEON(hi));
+}
+
+static inline uint8x16_t ScaleBytesNEON(uint8x16_t s, uint8x8_t factor)
+{
+    return vcombine_u8(Div255NEON(vmull_u8(vget_low_u8(s), factor)),
+                       Div255NEON(vmull_u8(vget_high_u8(s), factor)));
+}
+
+static void ScaleAlphaNEON(uint8_t *a, const uint8_t *src, unsigned count,
+                           unsigned alpha)
+{
+    const uint8x8_t factor = vdup_n_u8(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16)
+        vst1q_u8(&a[i], ScaleBytesNEON(vld1q_u8(&src[i]), factor));
+    ScaleAlphaC(&a[i], &src[i], count - i, alpha);
+}
+
+static void MergeNEON(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                      unsigned count)
+{
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16)
+        vst1q_u8(&dst[i], MergeBytesNEON(vld1q_u8(&dst[i]), vld1q_u8(&src[i]),
+                                         vld1q_u8(&a[i])));
+    MergeC(&dst[i], &src[i], &a[i], count - i);
+}
+
+static inline void RgbToYuv8NEON(uint8x8_t *y, uint8x8_t *u, uint8x8_t *v,
+                                 uint8x8_t r8, uint8x8_t g8, uint8x8_t b8)
+{
+    const uint16x8_t r = vmovl_u8(r8);
+    const uint16x8_t g = vmovl_u8(g8);
+    const uint16x8_t b = vmovl_u8(b8);
+
+    uint16x8_t vy = vmulq_n_u16(r, 66);
+    vy = vmlaq_n_u16(vy, g, 129);
+    vy = vmlaq_n_u16(vy, b, 25);
+    vy = vaddq_u16(vy, vdupq_n_u16(128));
+    *y = vadd_u8(vshrn_n_u16(vy, 8), vdup_n_u8(16));
+
+    int16x8_t vu = vmulq_n_s16(vreinterpretq_s16_u16(r), -38);
+    vu = vmlaq_n_s16(vu, vreinterpretq_s16_u16(g), -74);
+    vu = vmlaq_n_s16(vu, vreinterpretq_s16_u16(b), 112);
+    vu = vshrq_n_s16(vaddq_s16(vu, vdupq_n_s16(128)), 8);
+    *u = vmovn_u16(vreinterpretq_u16_s16(vaddq_s16(vu, vdupq_n_s16(128))));
+
+    int16x8_t vv = vmulq_n_s16(vreinterpretq_s16_u16(r), 112);
+    vv = vmlaq_n_s16(vv, vreinterpretq_s16_u16(g), -94);
+    vv = vmlaq_n_s16(vv, vreinterpretq_s16_u16(b), -18);
+    vv = vshrq_n_s16(vaddq_s16(vv, vdupq_n_s16(128)), 8);
+    *v = vmovn_u16(vreinterpretq_u16_s16(vaddq_s16(vv, vdupq_n_s16(128))));
+}
+
+static void RgbaToYuvaNEON(uint8_t *y, uint8_t *u, uint8_t *v, uint8_t *a,
+                           const uint8_t *rgba, unsigned count)
+{
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16x4_t p = vld4q_u8(&rgba[4 * i]);
+        uint8x8_t y0, u0, v0, y1, u1, v1;
+
+        RgbToYuv8NEON(&y0, &u0, &v0, vget_low_u8(p.val[0]),
+                      vget_low_u8(p.val[1]), vget_low_u8(p.val[2]));
+        RgbToYuv8NEON(&y1, &u1, &v1, vget_high_u8(p.val[0]),
+                      vget_high_u8(p.val[1]), vget_high_u8(p.val[2]));
+        vst1q_u8(&y[i], vcombine_u8(y0, y1));
+        vst1q_u8(&u[i], vcombine_u8(u0, u1));
+        vst1q_u8(&v[i], vcombine_u8(v0, v1));
+        vst1q_u8(&a[i], p.val[3]);
+    }
+    RgbaToYuvaC(&y[i], &u[i], &v[i], &a[i], &rgba[4 * i], count - i);
+}
+
+static void MergeRgbxNEON(uint8_t *dst, const uint8_t *rgba, unsigned count,
+                          unsigned alpha, const unsigned offset[3])
+{
+    const uint8x8_t factor = vdup_n_u8(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16x4_t s = vld4q_u8(&rgba[4 * i]);
+        uint8x16x4_t d = vld4q_u8(&dst[4 * i]);
+        const uint8x16_t f = ScaleBytesNEON(s.val[3], factor);
+
+        for (unsigned j = 0; j < 3; j++)
+            d.val[offset[j]] = MergeBytesNEON(d.val[offset[j]], s.val[j], f);
+        vst4q_u8(&dst[4 * i], d);
+    }
+    MergeRgbxC(&dst[4 * i], &rgba[4 * i], count - i, alpha, offset);
+}
+
+static const blend_kernels_t kernels_neon = {
+    ScaleAlphaNEON, MergeNEON, RgbaToYuvaNEON, MergeRgbxNEON,
+};
+#endif
+
+/**
+ * It returns the best kernels for the CPU, or NULL to use the templates.
+ */
+static const blend_kernels_t *GetKernels(void)
+{
+#if defined(HAVE_AVX2_INTRINSICS) && defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_AVX2())
+        return &kernels_avx2;
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_SSE2())
+        return &kernels_sse2;
+#endif
+#if defined(__ARM_NEON__)
+    if (vlc_CPU_ARM_NEON())
+        return &kernels_neon;
+#endif
+    return NULL;
+}
+
+class CPictureLines : public CPicture {
+public:
+    CPictureLines(const CPicture &cfg) : CPicture(cfg)
+    {
+    }
+    uint8_t *getRow(unsigned plane, unsigned ry) const
+    {
+        return &picture->p[plane].p_pixels[(y / ry) * picture->p[plane].i_pitch];
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
+    void nextLine()
+    {
+        y++;
+    }
+};
+
+/**
+ * It blends a YUVA (or RGBA when rgba is true) picture on a 8 bits 4:2:0
+ * picture, planar or semi-planar (NV12/NV21).
+ *
+ * Like with the templates, a chroma sample is merged with the source pixel
+ * landing on it, so every other pixel of the even lines.
+ */
+template <bool rgba, bool semiplanar, bool swap_uv>
+void BlendLines420(const blend_kernels_t &k, uint8_t *scratch,
+                   const CPicture &dst_data, const CPicture &src_data,
+                   unsigned width, unsigned height, unsigned alpha)
+{
+    CPictureLines src(src_data);
+    CPictureLines dst(dst_data);
+
+    uint8_t *line_y = &scratch[0 * width];
+    uint8_t *line_u = &scratch[1 * width];
+    uint8_t *line_v = &scratch[2 * width];
+    uint8_t *line_a = &scratch[3 * width];
+    uint8_t *chroma   = &scratch[4 * width];     /* U then V, or UV */
+    uint8_t *chroma_a = &scratch[6 * width + 2]; /* alpha for chroma[] */
+
+    const unsigned phase = dst.getX() % 2;
+    const unsigned count = (width + 1 - phase) / 2;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *src_y, *src_u, *src_v;
+
+        if (rgba) {
+            k.rgba_to_yuva(line_y, line_u, line_v, line_a,
+                           &src.getRow(0, 1)[4 * src.getX()], width);
+            k.scale_alpha(line_a, line_a, width, alpha);
+            src_y = line_y;
+            src_u = line_u;
+            src_v = line_v;
+        } else {
+            src_y = &src.getRow(0, 1)[src.getX()];
+            src_u = &src.getRow(1, 1)[src.getX()];
+            src_v = &src.getRow(2, 1)[src.getX()];
+            k.scale_alpha(line_a, &src.getRow(3, 1)[src.getX()], width, alpha);
+        }
+
+        k.merge(&dst.getRow(0, 1)[dst.getX()], src_y, line_a, width);
+
+        if ((dst.getY() % 2) == 0 && count > 0) {
+            const unsigned offset = (dst.getX() + phase) / 2;
+
+            if (semiplanar) {
+                for (unsigned i = 0; i < count; i++) {
+                    const unsigned dx = phase + 2 * i;
+                    chroma[2 * i +  swap_uv] = src_u[dx];
+                    chroma[2 * i + !swap_uv] = src_v[dx];
+                    chroma_a[2 * i + 0] =
+                    chroma_a[2 * i + 1] = line_a[dx];
+                }
+                k.merge(&dst.getRow(1, 2)[2 * offset], chroma, chroma_a,
+                        2 * count);
+            } else {
+                for (unsigned i = 0; i < count; i++) {
+                    const unsigned dx = phase + 2 * i;
+                    chroma[i]         = src_u[dx];
+                    chroma[count + i] = src_v[dx];
+                    chroma_a[i]       = line_a[dx];
+                }
+                k.merge(&dst.getRow(swap_uv ? 2 : 1, 2)[offset],
+                        &chroma[0], chroma_a, count);
+                k.merge(&dst.getRow(swap_uv ? 1 : 2, 2)[offset],
+                        &chroma[count], chroma_a, count);
+            }
+        }
+        src.nextLine();
+        dst.nextLine();
+    }
+}
+
+/**
+ * It blends a RGBA picture on a 32 bits RGB picture.
+ */
+static void BlendLinesRGB32(const blend_kernels_t &k, uint8_t *,
+                            const CPicture &dst_data, const CPicture &src_data,
+                            unsigned width, unsigned height, unsigned alpha)
+{
+    CPictureLines src(src_data);
+    CPictureLines dst(dst_data);
+
+    const video_format_t *fmt = dst.getFormat();
+    const unsigned offset[3] = {
+        getRgbOffset(fmt->i_lrshift, 4),
+        getRgbOffset(fmt->i_lgshift, 4),
+        getRgbOffset(fmt->i_lbshift, 4),
+    };
+
+    for (unsigned y = 0; y < height; y++) {
+        k.merge_rgbx(&dst.getRow(0, 1)[4 * dst.getX()],
+                     &src.getRow(0, 1)[4 * src.getX()], width, alpha, offset);
+        src.nextLine();
+        dst.nextLine();
+    }
+}
+
+/* Size of the scratch memory needed by the line blenders */
+#define BLEND_LINES_SCRATCH(width) (8 * (size_t)(width) + 16)
+
+typedef void (*blend_lines_function_t)(const blend_kernels_t &k, uint8_t *scratch,
+                                       const CPicture &dst_data, const CPicture &src_data,
+                                       unsigned width, unsigned height, unsigned alpha);
+
+static const struct {
+    vlc_fourcc_t           dst;
+    vlc_fourcc_t           src;
+    blend_lines_function_t blend;
+} blends_lines[] = {
+    { VLC_CODEC_I420,  VLC_CODEC_YUVA, BlendLines420<false, false, false> },
+    { VLC_CODEC_J420,  VLC_CODEC_YUVA, BlendLines420<false, false, false> },
+    { VLC_CODEC_YV12,  VLC_CODEC_YUVA, BlendLines420<false, false, true>  },
+    { VLC_CODEC_NV12,  VLC_CODEC_YUVA, BlendLines420<false, true,  false> },
+    { VLC_CODEC_NV21,  VLC_CODEC_YUVA, BlendLines420<false, true,  true>  },
+    { VLC_CODEC_I420,  VLC_CODEC_RGBA, BlendLines420<true,  false, false> },
+    { VLC_CODEC_J420,  VLC_CODEC_RGBA, BlendLines420<true,  false, false> },
+    { VLC_CODEC_YV12,  VLC_CODEC_RGBA, BlendLines420<true,  false, true>  },
+    { VLC_CODEC_NV12,  VLC_CODEC_RGBA, BlendLines420<true,  true,  false> },
+    { VLC_CODEC_NV21,  VLC_CODEC_RGBA, BlendLines420<true,  true,  true>  },
+    { VLC_CODEC_RGB32, VLC_CODEC_RGBA, BlendLinesRGB32 },
+};
+
 struct filter_sys_t {
-    filter_sys_t() : blend(NULL)
+    filter_sys_t() : blend(NULL), blend_lines(NULL), kernels(NULL),
+                     scratch(NULL), scratch_size(0)
     {
     }
-    blend_function_t blend;
+    ~filter_sys_t()
+    {
+        free(scratch);
+    }
+    blend_function_t       blend;
+    blend_lines_function_t blend_lines;
+    const blend_kernels_t  *kernels;
+    uint8_t                *scratch;
+    size_t                 scratch_size;
 };
 
 /**
@@ -623,13 +1216,30 @@ static void Blend(filter_t *filter,
     video_format_FixRgb(&filter->fmt_out.video);
     video_format_FixRgb(&filter->fmt_in.video);
 
-    sys->blend(CPicture(dst, &filter->fmt_out.video,
-                        filter->fmt_out.video.i_x_offset + x_offset,
-                        filter->fmt_out.video.i_y_offset + y_offset),
-               CPicture(src, &filter->fmt_in.video,
-                        filter->fmt_in.video.i_x_offset,
-                        filter->fmt_in.video.i_y_offset),
-               width, height, alpha);
+    const CPicture dst_data(dst, &filter->fmt_out.video,
+                            filter->fmt_out.video.i_x_offset + x_offset,
+                            filter->fmt_out.video.i_y_offset + y_offset);
+    const CPicture src_data(src, &filter->fmt_in.video,
+                            filter->fmt_in.video.i_x_offset,
+                            filter->fmt_in.video.i_y_offset);
+
+    /* The kernels work on 8 bits values */
+    if (sys->blend_lines && alpha <= 255) {
+        const size_t size = BLEND_LINES_SCRATCH(width);
+        if (sys->scratch_size < size) {
+            uint8_t *scratch = (uint8_t *)realloc(sys->scratch, size);
+            if (scratch) {
+                sys->scratch      = scratch;
+                sys->scratch_size = size;
+            }
+        }
+        if (sys->scratch_size >= size) {
+            sys->blend_lines(*sys->kernels, sys->scratch, dst_data, src_data,
+                             width, height, alpha);
+            return;
+        }
+    }
+    sys->blend(dst_data, src_data, width, height, alpha);
 }
 
 static int Open(vlc_object_t *object)
@@ -651,6 +1261,14 @@ static int Open(vlc_object_t *object)
         return VLC_EGENERIC;
     }
 
+    sys->kernels = GetKernels();
+    if (sys->kernels) {
+        for (size_t i = 0; i < sizeof(blends_lines) / sizeof(*blends_lines); i++) {
+            if (blends_lines[i].src == src && blends_lines[i].dst == dst)
+                sys->blend_lines = blends_lines[i].blend;
+        }
+    }
+
     filter->pf_video_blend = Blend;
     filter->p_sys          = sys;
     return VLC_SUCCESS;
@@ -0,0 +1,194 @@
+/*****************************************************************************
+ * benchmark.c : Deinterlacer algorithms benchmark
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+#include <vlc_filter.h>
+
+#include "deinterlace.h"
+#include "benchmark.h"
+
+/* Number of distinct synthetic frames, given in a loop */
+#define BENCHMARK_PICTURES (8)
+
+/*****************************************************************************
+ * Synthetic frames
+ *****************************************************************************/
+
+/**
+ * Fills a frame with diagonal bars moving horizontally, the bottom field
+ * being captured half a frame later than the top one, and some noise.
+ */
+static void FillInterlaced( picture_t *p_pic, int i_frame, int i_pixel_size )
+{
+    for( int i_plane = 0; i_plane < p_pic->i_planes; i_plane++ )
+    {
+        const plane_t *p = &p_pic->p[i_plane];
+        const int i_width = p->i_visible_pitch / i_pixel_size;
+
+        for( int y = 0; y < p->i_visible_lines; y++ )
+        {
+            const int i_time = 2 * i_frame + (y & 1);
+            uint8_t *p_line = &p->p_pixels[y * p->i_pitch];
+
+            for( int x = 0; x < i_width; x++ )
+            {
+                const int i_bar = ( ( x + y + 6 * i_time ) / 16 ) & 1;
+                const unsigned v = ( i_bar ? 180 : 60 ) + ( rand() & 15 );
+
+                if( i_pixel_size == 1 )
+                    p_line[x] = v;
+                else
+                    ((uint16_t *)p_line)[x] = v << 2;
+            }
+        }
+    }
+}
+
+static picture_t *BufferNew( filter_t *p_filter )
+{
+    return picture_NewFromFormat( &p_filter->fmt_out.video );
+}
+
+static void BufferDel( filter_t *p_filter, picture_t *p_pic )
+{
+    VLC_UNUSED(p_filter);
+    picture_Release( p_pic );
+}
+
+/*****************************************************************************
+ * Benchmark
+ *****************************************************************************/
+
+static void Benchmark( filter_t *p_filter, const char *psz_method,
+                       picture_t *const *pp_pictures, int i_frames )
+{
+    filter_t *p_deint = vlc_object_create( p_filter, sizeof(*p_deint) );
+    if( !p_deint )
+        return;
+
+    es_format_Copy( &p_deint->fmt_in, &p_filter->fmt_in );
+    es_format_Copy( &p_deint->fmt_out, &p_filter->fmt_in );
+    p_deint->b_allow_fmt_out_change = true;
+    p_deint->pf_video_buffer_new = BufferNew;
+    p_deint->pf_video_buffer_del = BufferDel;
+
+    config_chain_t cfg = {
+        .p_next    = NULL,
+        .psz_name  = (char *)"mode",
+        .psz_value = (char *)psz_method,
+    };
+    p_deint->p_cfg = &cfg;
+
+    if( Open( VLC_OBJECT(p_deint) ) )
+    {
+        msg_Warn( p_filter, "%s: cannot deinterlace this format", psz_method );
+        goto end;
+    }
+    /* Unsupported methods fall back to blending */
+    if( p_deint->p_sys->i_mode == DEINTERLACE_BLEND && strcmp( psz_method, "blend" ) )
+    {
+        msg_Warn( p_filter, "%s: not supported for this format", psz_method );
+        Close( VLC_OBJECT(p_deint) );
+        goto end;
+    }
+
+    unsigned i_outputs = 0;
+    const mtime_t i_start = mdate();
+    for( int i = 0; i < i_frames; i++ )
+    {
+        picture_t *p_pic = picture_Hold( pp_pictures[i % BENCHMARK_PICTURES] );
+        p_pic->date = VLC_TS_0 + i * INT64_C(40000);
+
+        picture_t *p_out = Deinterlace( p_deint, p_pic );
+        while( p_out )
+        {
+            picture_t *p_next = p_out->p_next;
+            p_out->p_next = NULL;
+            picture_Release( p_out );
+            p_out = p_next;
+            i_outputs++;
+        }
+    }
+    const mtime_t i_duration = __MAX( mdate() - i_start, 1 );
+
+    msg_Info( p_filter, "%s: %.1f fps (%u pictures out of %d)", psz_method,
+              (double)i_frames * CLOCK_FREQ / i_duration, i_outputs, i_frames );
+
+    Close( VLC_OBJECT(p_deint) );
+end:
+    es_format_Clean( &p_deint->fmt_out );
+    es_format_Clean( &p_deint->fmt_in );
+    vlc_object_release( p_deint );
+}
+
+static picture_t *Pass( filter_t *p_filter, picture_t *p_pic )
+{
+    VLC_UNUSED(p_filter);
+    return p_pic;
+}
+
+int OpenBenchmark( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    const vlc_chroma_description_t *chroma =
+        vlc_fourcc_GetChromaDescription( p_filter->fmt_in.video.i_chroma );
+    if( !chroma )
+        return VLC_EGENERIC;
+
+    picture_t *pp_pictures[BENCHMARK_PICTURES];
+    for( int i = 0; i < BENCHMARK_PICTURES; i++ )
+    {
+        pp_pictures[i] = picture_NewFromFormat( &p_filter->fmt_in.video );
+        if( !pp_pictures[i] )
+        {
+            while( i-- > 0 )
+                picture_Release( pp_pictures[i] );
+            return VLC_ENOMEM;
+        }
+        FillInterlaced( pp_pictures[i], i, chroma->pixel_size );
+        pp_pictures[i]->b_progressive = false;
+        pp_pictures[i]->b_top_field_first = true;
+        pp_pictures[i]->i_nb_fields = 2;
+    }
+
+    const int i_frames = __MAX( var_InheritInteger( p_filter,
+                                    BENCHMARK_CFG_PREFIX "frames" ), 1 );
+    msg_Info( p_filter, "deinterlacing %d frames of %ux%u %4.4s",
+              i_frames, p_filter->fmt_in.video.i_width,
+              p_filter->fmt_in.video.i_height,
+              (const char *)&p_filter->fmt_in.video.i_chroma );
+
+    for( size_t i = 0; i < sizeof(mode_list) / sizeof(*mode_list); i++ )
+        Benchmark( p_filter, mode_list[i], pp_pictures, i_frames );
+
+    for( int i = 0; i < BENCHMARK_PICTURES; i++ )
+        picture_Release( pp_pictures[i] );
+
+    p_filter->fmt_out.video = p_filter->fmt_in.video;
+    p_filter->fmt_out.i_codec = p_filter->fmt_in.i_codec;
+    p_filter->pf_video_filter = Pass;
+    return VLC_SUCCESS;
+}
@@ -0,0 +1,54 @@
+/*****************************************************************************
+ * benchmark.h : Deinterlacer algorithms benchmark
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_DEINTERLACE_BENCHMARK_H
+#define VLC_DEINTERLACE_BENCHMARK_H 1
+
+/**
+ * \file
+ * Benchmark of the deinterlace algorithms on synthetic interlaced frames.
+ */
+
+/* Forward declarations */
+struct vlc_object_t;
+
+#define BENCHMARK_CFG_PREFIX "deinterlacebench-"
+
+/*****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+/**
+ * Open function of the benchmark filter.
+ *
+ * It runs every method known to SetFilterMethod() over synthetic interlaced
+ * frames of the input format, and reports the frame rate each of them
+ * sustains. The benchmark filter then passes the pictures through.
+ *
+ * The number of frames given to each method is read from the
+ * "deinterlacebench-frames" option.
+ *
+ * @param p_this The filter instance as vlc_object_t.
+ * @return VLC error code
+ * @see SetFilterMethod()
+ */
+int OpenBenchmark( vlc_object_t *p_this );
+
+#endif
@@ -45,6 +45,7 @@
 #include "deinterlace.h"
 #include "helpers.h"
 #include "merge.h"
+#include "benchmark.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -86,6 +87,10 @@
                                     "Best simulation, but requires more CPU "\
                                     "and memory bandwidth.")
 
+#define BENCHMARK_FRAMES_TEXT N_("Number of frames")
+#define BENCHMARK_FRAMES_LONGTEXT N_("Number of synthetic interlaced frames " \
+                                     "given to each deinterlace method.")
+
 #define PHOSPHOR_DIMMER_TEXT N_("Phosphor old field dimmer strength")
 #define PHOSPHOR_DIMMER_LONGTEXT N_("This controls the strength of the "\
                                     "darkening filter that simulates CRT TV "\
@@ -114,6 +119,15 @@ vlc_module_begin ()
         change_safe ()
     add_shortcut( "deinterlace" )
     set_callbacks( Open, Close )
+
+    add_submodule ()
+    set_description( N_("Deinterlacing benchmark filter") )
+    set_shortname( N_("Deinterlace benchmark") )
+    set_capability( "video filter2", 0 )
+    add_integer( BENCHMARK_CFG_PREFIX "frames", 250, BENCHMARK_FRAMES_TEXT,
+                 BENCHMARK_FRAMES_LONGTEXT, true )
+    add_shortcut( "deinterlacebench" )
+    set_callbacks( OpenBenchmark, NULL )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -632,6 +646,14 @@ int Open( vlc_object_t *p_this )
         p_sys->pf_merge = MergeAltivec;
     else
 #endif
+#if defined(HAVE_AVX2_INTRINSICS)
+    if( vlc_CPU_AVX2() )
+    {
+        p_sys->pf_merge = chroma->pixel_size == 1 ? Merge8BitAVX2 : Merge16BitAVX2;
+        p_sys->pf_end_merge = NULL;
+    }
+    else
+#endif
 #if defined(CAN_COMPILE_SSE2)
     if( vlc_CPU_SSE2() )
     {
@@ -145,3 +145,102 @@ static void yadif_filter_line_c_16bit(uint16_t *dst, uint16_t *prev, uint16_t *c
     prefs /= 2;
     FILTER
 }
+
+#if defined(HAVE_AVX2_INTRINSICS)
+// ================ AVX2 =================
+/* It computes 16 pixels at once on 16 bits words, the same way as the C
+ * version, which does the last pixels of the line. */
+#define HAVE_YADIF_AVX2
+#include <immintrin.h>
+
+#define YADIF_AVX2 __attribute__ ((__target__ ("avx2")))
+
+YADIF_AVX2
+static inline __m256i yadif_load_avx2(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+/* ABS(cur[mrefs-1+j] - cur[prefs-1-j]) + ABS(cur[mrefs+j] - cur[prefs-j])
+ * + ABS(cur[mrefs+1+j] - cur[prefs+1-j]) */
+YADIF_AVX2
+static inline __m256i yadif_score_avx2(const uint8_t *cur, int prefs, int mrefs, int j)
+{
+    __m256i score = _mm256_setzero_si256();
+    for (int k = -1; k <= 1; k++)
+        score = _mm256_add_epi16(score,
+                    _mm256_abs_epi16(_mm256_sub_epi16(yadif_load_avx2(&cur[mrefs+k+j]),
+                                                      yadif_load_avx2(&cur[prefs+k-j]))));
+    return score;
+}
+
+YADIF_AVX2
+static void yadif_filter_line_avx2(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    uint8_t *prev2= parity ? prev : cur ;
+    uint8_t *next2= parity ? cur  : next;
+    int x;
+
+    for (x = 0; x + 16 <= w; x += 16) {
+        const __m256i c  = yadif_load_avx2(&cur[x+mrefs]);
+        const __m256i e  = yadif_load_avx2(&cur[x+prefs]);
+        const __m256i p2 = yadif_load_avx2(&prev2[x]);
+        const __m256i n2 = yadif_load_avx2(&next2[x]);
+        const __m256i d  = _mm256_srli_epi16(_mm256_add_epi16(p2, n2), 1);
+
+        const __m256i temporal_diff0 = _mm256_abs_epi16(_mm256_sub_epi16(p2, n2));
+        const __m256i temporal_diff1 = _mm256_srli_epi16(_mm256_add_epi16(
+            _mm256_abs_epi16(_mm256_sub_epi16(yadif_load_avx2(&prev[x+mrefs]), c)),
+            _mm256_abs_epi16(_mm256_sub_epi16(yadif_load_avx2(&prev[x+prefs]), e))), 1);
+        const __m256i temporal_diff2 = _mm256_srli_epi16(_mm256_add_epi16(
+            _mm256_abs_epi16(_mm256_sub_epi16(yadif_load_avx2(&next[x+mrefs]), c)),
+            _mm256_abs_epi16(_mm256_sub_epi16(yadif_load_avx2(&next[x+prefs]), e))), 1);
+        __m256i diff = _mm256_max_epi16(_mm256_max_epi16(_mm256_srli_epi16(temporal_diff0, 1),
+                                                         temporal_diff1), temporal_diff2);
+
+        __m256i spatial_pred  = _mm256_srli_epi16(_mm256_add_epi16(c, e), 1);
+        __m256i spatial_score = _mm256_sub_epi16(yadif_score_avx2(&cur[x], prefs, mrefs, 0),
+                                                 _mm256_set1_epi16(1));
+
+        /* The directions 2 and -2 are only checked when 1 and -1 were better,
+         * as the nested CHECK() of the C version do. */
+        for (int j = -1; j <= 1; j += 2) {
+            __m256i better = _mm256_set1_epi16(-1);
+            for (int n = 1; n <= 2; n++) {
+                const int k = n * j;
+                const __m256i score = yadif_score_avx2(&cur[x], prefs, mrefs, k);
+                const __m256i pred  = _mm256_srli_epi16(_mm256_add_epi16(
+                    yadif_load_avx2(&cur[x+mrefs+k]), yadif_load_avx2(&cur[x+prefs-k])), 1);
+
+                better = _mm256_and_si256(better, _mm256_cmpgt_epi16(spatial_score, score));
+                spatial_score = _mm256_blendv_epi8(spatial_score, score, better);
+                spatial_pred  = _mm256_blendv_epi8(spatial_pred, pred, better);
+            }
+        }
+
+        if (mode < 2) {
+            const __m256i b = _mm256_srli_epi16(_mm256_add_epi16(
+                yadif_load_avx2(&prev2[x+2*mrefs]), yadif_load_avx2(&next2[x+2*mrefs])), 1);
+            const __m256i f = _mm256_srli_epi16(_mm256_add_epi16(
+                yadif_load_avx2(&prev2[x+2*prefs]), yadif_load_avx2(&next2[x+2*prefs])), 1);
+            const __m256i de = _mm256_sub_epi16(d, e);
+            const __m256i dc = _mm256_sub_epi16(d, c);
+            const __m256i bc = _mm256_sub_epi16(b, c);
+            const __m256i fe = _mm256_sub_epi16(f, e);
+            const __m256i max = _mm256_max_epi16(_mm256_max_epi16(de, dc), _mm256_min_epi16(bc, fe));
+            const __m256i min = _mm256_min_epi16(_mm256_min_epi16(de, dc), _mm256_max_epi16(bc, fe));
+
+            diff = _mm256_max_epi16(_mm256_max_epi16(diff, min),
+                                    _mm256_sub_epi16(_mm256_setzero_si256(), max));
+        }
+
+        spatial_pred = _mm256_min_epi16(_mm256_max_epi16(spatial_pred, _mm256_sub_epi16(d, diff)),
+                                        _mm256_add_epi16(d, diff));
+        spatial_pred = _mm256_packus_epi16(spatial_pred, spatial_pred);
+        _mm_storeu_si128((__m128i *)&dst[x],
+                         _mm256_castsi256_si128(_mm256_permute4x64_epi64(spatial_pred,
+                                                                         _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+
+    yadif_filter_line_c(&dst[x], &prev[x], &cur[x], &next[x], w - x, prefs, mrefs, parity, mode);
+}
+#endif
@@ -73,6 +73,7 @@ vlc_module_end()
  * Local prototypes
  *****************************************************************************/
 #define FFMAX(a,b) __MAX(a,b)
+#define FFMIN(a,b) __MIN(a,b)
 #ifdef CAN_COMPILE_MMXEXT
 #   define HAVE_MMX2 1
 #else
@@ -106,6 +107,8 @@ struct filter_sys_t {
     int              radius;
     const vlc_chroma_description_t *chroma;
     struct vf_priv_s cfg;
+    unsigned         slices;
+    size_t           buf_size; /* Per slice, in elements of cfg.buf */
 };
 
 static int Open(vlc_object_t *object)
@@ -130,6 +133,7 @@ static int Open(vlc_object_t *object)
     var_AddCallback(filter, CFG_PREFIX "strength", Callback, NULL);
     var_AddCallback(filter, CFG_PREFIX "radius",   Callback, NULL);
     sys->cfg.buf = NULL;
+    sys->slices  = 0;
 
     struct vf_priv_s *cfg = &sys->cfg;
     cfg->thresh      = 0.0;
@@ -171,6 +175,43 @@ static void Close(vlc_object_t *object)
     free(sys);
 }
 
+typedef struct {
+    picture_t *src;
+    picture_t *dst;
+} gradfun_slices_t;
+
+static void FilterSlice(filter_t *filter, void *data,
+                        unsigned slice, unsigned slices)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const gradfun_slices_t *s = data;
+    const video_format_t *fmt = &filter->fmt_in.video;
+    struct vf_priv_s *cfg = &sys->cfg;
+
+    for (int i = 0; i < s->dst->i_planes; i++) {
+        const plane_t *srcp = &s->src->p[i];
+        plane_t       *dstp = &s->dst->p[i];
+
+        const vlc_chroma_description_t *chroma = sys->chroma;
+        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
+        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
+        int r = (cfg->radius  * chroma->p[i].w.num / chroma->p[i].w.den +
+                 cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
+        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
+        if (__MIN(w, h) > 2 * r && cfg->buf) {
+            int first, end;
+            filter_GetSliceLines(h, slice, slices, 2, &first, &end);
+            if (first < end)
+                filter_plane(cfg, cfg->buf + slice * sys->buf_size,
+                             dstp->p_pixels, srcp->p_pixels,
+                             w, h, dstp->i_pitch, srcp->i_pitch, r,
+                             first, end);
+        } else if (slice == 0) {
+            plane_CopyPixels(dstp, srcp);
+        }
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     filter_sys_t *sys = filter->p_sys;
@@ -188,31 +229,21 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
 
     const video_format_t *fmt = &filter->fmt_in.video;
     struct vf_priv_s *cfg = &sys->cfg;
+    const unsigned slices = filter_GetSlices(filter);
 
     cfg->thresh = (1 << 15) / strength;
-    if (cfg->radius != radius) {
-        cfg->radius = radius;
-        cfg->buf    = vlc_memalign(16,
-                                   (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) * sizeof(*cfg->buf));
+    if (cfg->radius != radius || sys->slices != slices) {
+        cfg->radius   = radius;
+        sys->slices   = slices;
+        /* Each slice has its own 16 bytes aligned buffer */
+        sys->buf_size = ((((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) + 7) & ~7;
+        vlc_free(cfg->buf);
+        cfg->buf      = vlc_memalign(16,
+                                     slices * sys->buf_size * sizeof(*cfg->buf));
     }
 
-    for (int i = 0; i < dst->i_planes; i++) {
-        const plane_t *srcp = &src->p[i];
-        plane_t       *dstp = &dst->p[i];
-
-        const vlc_chroma_description_t *chroma = sys->chroma;
-        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
-        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
-        int r = (cfg->radius  * chroma->p[i].w.num / chroma->p[i].w.den +
-                 cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
-        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
-        if (__MIN(w, h) > 2 * r && cfg->buf) {
-            filter_plane(cfg, dstp->p_pixels, srcp->p_pixels,
-                         w, h, dstp->i_pitch, srcp->i_pitch, r);
-        } else {
-            plane_CopyPixels(dstp, srcp);
-        }
-    }
+    gradfun_slices_t s = { .src = src, .dst = dst };
+    filter_RunSlices(filter, slices, FilterSlice, &s);
 
     picture_CopyProperties(dst, src);
     picture_Release(src);
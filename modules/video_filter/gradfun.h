@@ -223,26 +223,39 @@ static void blur_line_sse2(uint16_t *dc, uint16_t *buf, uint16_t *buf1,
 }
 #endif // HAVE_6REGS && HAVE_SSE2
 
-static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
-                         int width, int height, int dstride, int sstride, int r)
+/* It filters the lines [y_first, y_end) of a plane. buffer is private to
+ * the caller and must hold ((width+15)&~15)*(r+1)/2+32 elements.
+ * The box blur window is rebuilt from the r row pairs before the first line,
+ * so that the lines of a plane can be filtered independently. */
+static void filter_plane(struct vf_priv_s *ctx, uint16_t *buffer,
+                         uint8_t *dst, uint8_t *src,
+                         int width, int height, int dstride, int sstride, int r,
+                         int y_first, int y_end)
 {
     int bstride = ((width+15)&~15)/2;
-    int y;
+    int y, k;
     uint32_t dc_factor = (1<<21)/(r*r);
-    uint16_t *dc = ctx->buf+16;
-    uint16_t *buf = ctx->buf+bstride+32;
+    uint16_t *dc = buffer+16;
+    uint16_t *buf = buffer+bstride+32;
     int thresh = ctx->thresh;
+    /* Last line whose window still fits in the picture */
+    int last = r + ((height-2*r-1)&~1);
+    int step = -1;
 
     memset(dc, 0, (bstride+16)*sizeof(*buf));
-    for (y=0; y<r; y++)
-        ctx->blur_line(dc, buf+y*bstride, buf+(y-1)*bstride, src+2*y*sstride, sstride, width/2);
-    for (;;) {
-        if (y < height-r) {
-            int mod = ((y+r)/2)%r;
-            uint16_t *buf0 = buf+mod*bstride;
-            uint16_t *buf1 = buf+(mod?mod-1:r-1)*bstride;
+    for (y=y_first; y<y_end; y++) {
+        int s = FFMIN(FFMAX(y&~1, r), last);
+        if (s != step) {
+            int p = (s+r)/2;
             int x, v;
-            ctx->blur_line(dc, buf0, buf1, src+(y+r)*sstride, sstride, width/2);
+            if (step < 0)
+                k = p-r;
+            for (; k<=p; k++) {
+                uint16_t *buf0 = buf+(k%r)*bstride;
+                uint16_t *buf1 = k==p-r && step < 0 ? buf-bstride
+                                                    : buf+((k+r-1)%r)*bstride;
+                ctx->blur_line(dc, buf0, buf1, src+2*k*sstride, sstride, width/2);
+            }
             for (x=v=0; x<r; x++)
                 v += dc[x];
             for (; x<width/2; x++) {
@@ -253,15 +266,9 @@ static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
                 dc[x-r] = v * dc_factor >> 16;
             for (x=-r/2; x<0; x++)
                 dc[x] = dc[0];
+            step = s;
         }
-        if (y == r) {
-            for (y=0; y<r; y++)
-                ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
-        }
-        ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
-        if (++y >= height) break;
         ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
-        if (++y >= height) break;
     }
 }
 
@@ -140,10 +140,15 @@ static int Open(vlc_object_t *this)
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
     }
-    cfg->Line = malloc(wmax*sizeof(int));
-    if (!cfg->Line) {
-        free(sys);
-        return VLC_ENOMEM;
+    /* Each plane is denoised by its own slice, so they need their own line */
+    for (int i = 0; i < 3; ++i) {
+        cfg->Line[i] = malloc(wmax*sizeof(int));
+        if (!cfg->Line[i]) {
+            for (int j = 0; j < i; ++j)
+                free(cfg->Line[j]);
+            free(sys);
+            return VLC_ENOMEM;
+        }
     }
 
     filter->p_sys = sys;
@@ -180,19 +185,43 @@ static void Close(vlc_object_t *this)
 
     for (int i = 0; i < 3; ++i) {
         free(cfg->Frame[i]);
+        free(cfg->Line[i]);
     }
-    free(cfg->Line);
     free(sys);
 }
 
 /*****************************************************************************
  * Filter
  *****************************************************************************/
-static picture_t *Filter(filter_t *filter, picture_t *src)
-{
+typedef struct {
+    picture_t *src;
     picture_t *dst;
+} hqdn3d_slices_t;
+
+/* The spatial low pass is recursive both horizontally and vertically, so
+ * a plane cannot be split without changing the output: one slice is one
+ * plane. */
+static void FilterSlice(filter_t *filter, void *data,
+                        unsigned slice, unsigned slices)
+{
+    const hqdn3d_slices_t *s = data;
     filter_sys_t *sys = filter->p_sys;
     struct vf_priv_s *cfg = &sys->cfg;
+    int *spat = slice == 0 ? cfg->Coefs[0] : cfg->Coefs[2];
+    int *temp = slice == 0 ? cfg->Coefs[1] : cfg->Coefs[3];
+
+    VLC_UNUSED(slices);
+    deNoise(s->src->p[slice].p_pixels, s->dst->p[slice].p_pixels,
+            cfg->Line[slice], &cfg->Frame[slice], sys->w[slice], sys->h[slice],
+            s->src->p[slice].i_pitch, s->dst->p[slice].i_pitch,
+            spat,
+            spat,
+            temp);
+}
+
+static picture_t *Filter(filter_t *filter, picture_t *src)
+{
+    picture_t *dst;
 
     if (!src) return NULL;
 
@@ -202,24 +231,8 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
         return NULL;
     }
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
+    hqdn3d_slices_t slices = { .src = src, .dst = dst };
+    filter_RunSlices(filter, 3, FilterSlice, &slices);
 
     return CopyInfoAndRelease(dst, src);
 }
@@ -31,6 +31,7 @@
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
+#include <vlc_modules.h>
 
 #include <math.h>
 #include <limits.h> /* INT_MAX */
@@ -52,6 +53,24 @@ static subpicture_t *Filter ( filter_t *, mtime_t );
 static int MosaicCallback   ( vlc_object_t *, char const *, vlc_value_t,
                               vlc_value_t, void * );
 
+/*****************************************************************************
+ * mosaic_tile_t : state of a bridged picture in the composite picture
+ *****************************************************************************/
+typedef struct
+{
+    filter_t  *p_scaler;      /* Scaler of the bridged pictures */
+    picture_t *p_source;      /* Last bridged picture */
+    picture_t *p_scaled;      /* Last bridged picture, scaled */
+
+    bool b_used;              /* Part of the composite picture */
+    bool b_dirty;             /* Needs to be scaled again */
+    int i_x, i_y;             /* Position in the mosaic */
+    unsigned i_width, i_height;
+    int i_alpha;
+} mosaic_tile_t;
+
+static void TileDelete( mosaic_tile_t * );
+
 /*****************************************************************************
  * filter_sys_t : filter descriptor
  *****************************************************************************/
@@ -79,6 +98,12 @@ struct filter_sys_t
     int i_offsets_length;
 
     mtime_t i_delay;
+
+    bool b_composite;         /* Do we build a single picture ourselves ? */
+    mosaic_tile_t **pp_tiles; /* One per bridged ES */
+    int i_tiles;
+    picture_t *p_composite;   /* Last composite picture */
+    int i_composite_x, i_composite_y;
 };
 
 /*****************************************************************************
@@ -151,6 +176,13 @@ struct filter_sys_t
         "(only used if positioning method is set to \"offsets\"). You " \
         "must give a comma-separated list of coordinates (eg: 10,10,150,10)." )
 
+#define COMPOSITE_TEXT N_("Composite picture")
+#define COMPOSITE_LONGTEXT N_( \
+        "Scale the mosaic elements concurrently into a single picture, " \
+        "only when they receive a new picture, and display it as one " \
+        "subpicture. Overlapping elements are not blended together, and " \
+        "the alignment applies to the whole mosaic." )
+
 #define DELAY_TEXT N_("Delay")
 #define DELAY_LONGTEXT N_( \
         "Pictures coming from the mosaic elements will be delayed " \
@@ -223,13 +255,16 @@ vlc_module_begin ()
 
     add_integer( CFG_PREFIX "delay", 0, DELAY_TEXT, DELAY_LONGTEXT,
                  false )
+
+    add_bool( CFG_PREFIX "composite", false,
+              COMPOSITE_TEXT, COMPOSITE_LONGTEXT, true )
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
     "alpha", "height", "width", "align", "xoffset", "yoffset",
     "borderw", "borderh", "position", "rows", "cols",
     "keep-aspect-ratio", "keep-picture", "order", "offsets",
-    "delay", NULL
+    "delay", "composite", NULL
 };
 
 /*****************************************************************************
@@ -333,6 +368,11 @@ static int CreateFilter( vlc_object_t *p_this )
         p_sys->p_image = image_HandlerCreate( p_filter );
     }
 
+    p_sys->b_composite = var_CreateGetBool( p_filter, CFG_PREFIX "composite" );
+    p_sys->pp_tiles = NULL;
+    p_sys->i_tiles = 0;
+    p_sys->p_composite = NULL;
+
     p_sys->i_order_length = 0;
     p_sys->ppsz_order = NULL;
     psz_order = var_CreateGetStringCommand( p_filter, CFG_PREFIX "order" );
@@ -406,6 +446,12 @@ static void DestroyFilter( vlc_object_t *p_this )
         image_HandlerDelete( p_sys->p_image );
     }
 
+    for( int i = 0; i < p_sys->i_tiles; i++ )
+        TileDelete( p_sys->pp_tiles[i] );
+    free( p_sys->pp_tiles );
+    if( p_sys->p_composite )
+        picture_Release( p_sys->p_composite );
+
     if( p_sys->i_order_length )
     {
         for( int i_index = 0; i_index < p_sys->i_order_length; i_index++ )
@@ -425,6 +471,495 @@ static void DestroyFilter( vlc_object_t *p_this )
     free( p_sys );
 }
 
+/*****************************************************************************
+ * Mosaic elements
+ *****************************************************************************/
+
+/* It drops the pictures of an element that are too old, and returns the one
+ * to display, if any */
+static picture_t *GetPicture( filter_t *p_filter, bridged_es_t *p_es,
+                              mtime_t date )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    while ( p_es->p_picture != NULL
+             && p_es->p_picture->date + p_sys->i_delay < date )
+    {
+        if ( p_es->p_picture->p_next != NULL )
+        {
+            picture_t *p_next = p_es->p_picture->p_next;
+            picture_Release( p_es->p_picture );
+            p_es->p_picture = p_next;
+        }
+        else if ( p_es->p_picture->date + p_sys->i_delay + BLANK_DELAY <
+                    date )
+        {
+            /* Display blank */
+            picture_Release( p_es->p_picture );
+            p_es->p_picture = NULL;
+            p_es->pp_last = &p_es->p_picture;
+            break;
+        }
+        else
+        {
+            msg_Dbg( p_filter, "too late picture for %s (%"PRId64 ")",
+                     p_es->psz_id,
+                     date - p_es->p_picture->date - p_sys->i_delay );
+            break;
+        }
+    }
+    return p_es->p_picture;
+}
+
+/* It returns the slot of an element in the mosaic */
+static int GetRealIndex( filter_sys_t *p_sys, const bridged_es_t *p_es,
+                         int *pi_real_index, int *pi_greatest_real_index_used )
+{
+    if ( p_sys->i_order_length == 0 )
+        return ++*pi_real_index;
+
+    for ( int i = 0; i < p_sys->i_order_length; i++ )
+    {
+        if ( strcmp( p_es->psz_id, p_sys->ppsz_order[i] ) == 0 )
+            return *pi_real_index = i;
+    }
+    return *pi_real_index = ++*pi_greatest_real_index_used;
+}
+
+/* It computes the size of an element in the mosaic */
+static void GetSize( filter_sys_t *p_sys, const video_format_t *p_fmt_in,
+                     unsigned col_inner_width, unsigned row_inner_height,
+                     unsigned *pi_width, unsigned *pi_height )
+{
+    if( p_sys->b_keep )
+    {
+        *pi_width  = p_fmt_in->i_width;
+        *pi_height = p_fmt_in->i_height;
+        return;
+    }
+
+    *pi_width  = col_inner_width;
+    *pi_height = row_inner_height;
+
+    if( p_sys->b_ar ) /* keep aspect ratio */
+    {
+        if( (float)*pi_width / (float)*pi_height
+              > (float)p_fmt_in->i_width / (float)p_fmt_in->i_height )
+        {
+            *pi_width = ( *pi_height * p_fmt_in->i_width )
+                          / p_fmt_in->i_height;
+        }
+        else
+        {
+            *pi_height = ( *pi_width * p_fmt_in->i_height )
+                           / p_fmt_in->i_width;
+        }
+    }
+}
+
+/* It computes the position of an element in the mosaic */
+static void GetPosition( filter_sys_t *p_sys, const bridged_es_t *p_es,
+                         int i_real_index,
+                         unsigned col_inner_width, unsigned row_inner_height,
+                         unsigned i_width, unsigned i_height,
+                         int *pi_x, int *pi_y )
+{
+    if( p_es->i_x >= 0 && p_es->i_y >= 0 )
+    {
+        *pi_x = p_es->i_x;
+        *pi_y = p_es->i_y;
+        return;
+    }
+    if( p_sys->i_position == position_offsets )
+    {
+        *pi_x = p_sys->pi_x_offsets[i_real_index];
+        *pi_y = p_sys->pi_y_offsets[i_real_index];
+        return;
+    }
+
+    const int i_row = ( i_real_index / p_sys->i_cols ) % p_sys->i_rows;
+    const int i_col = i_real_index % p_sys->i_cols ;
+
+    *pi_x = p_sys->i_xoffset
+          + i_col * ( p_sys->i_width / p_sys->i_cols )
+          + ( i_col * p_sys->i_borderw ) / p_sys->i_cols;
+    /* we don't have to center the video if it takes the whole rectangle
+     * area or if it's larger than the rectangle */
+    if( i_width <= col_inner_width && !p_sys->b_ar && !p_sys->b_keep )
+        *pi_x += ( col_inner_width - i_width ) / 2;
+
+    *pi_y = p_sys->i_yoffset
+          + i_row * ( p_sys->i_height / p_sys->i_rows )
+          + ( i_row * p_sys->i_borderh ) / p_sys->i_rows;
+    if( i_height <= row_inner_height && !p_sys->b_ar && !p_sys->b_keep )
+        *pi_y += ( row_inner_height - i_height ) / 2;
+}
+
+/*****************************************************************************
+ * Composite picture
+ *****************************************************************************
+ * All the elements are scaled concurrently, each one in its own slice, and
+ * copied into a single YUVA picture. An element is only scaled again when it
+ * received a new picture. The scalers do not write into the composite picture
+ * directly because they may write past the right edge of their element.
+ *****************************************************************************/
+static picture_t *TileBufferNew( filter_t *p_scaler )
+{
+    mosaic_tile_t *p_tile = (mosaic_tile_t *)p_scaler->p_owner;
+
+    return picture_Hold( p_tile->p_scaled );
+}
+
+static void TileBufferDel( filter_t *p_scaler, picture_t *p_picture )
+{
+    VLC_UNUSED(p_scaler);
+    picture_Release( p_picture );
+}
+
+static void TileDeleteScaler( mosaic_tile_t *p_tile )
+{
+    filter_t *p_scaler = p_tile->p_scaler;
+
+    if( !p_scaler )
+        return;
+    if( p_scaler->p_module )
+        module_unneed( p_scaler, p_scaler->p_module );
+    es_format_Clean( &p_scaler->fmt_in );
+    es_format_Clean( &p_scaler->fmt_out );
+    vlc_object_release( p_scaler );
+    p_tile->p_scaler = NULL;
+}
+
+static void TileDelete( mosaic_tile_t *p_tile )
+{
+    TileDeleteScaler( p_tile );
+    if( p_tile->p_source )
+        picture_Release( p_tile->p_source );
+    if( p_tile->p_scaled )
+        picture_Release( p_tile->p_scaled );
+    free( p_tile );
+}
+
+/* It (re)creates the scaler and the scaled picture of an element when its
+ * formats changed */
+static void TileSetup( filter_t *p_filter, mosaic_tile_t *p_tile )
+{
+    const video_format_t *p_src = &p_tile->p_source->format;
+
+    if( p_tile->p_scaled &&
+        ( p_tile->p_scaled->format.i_width  != p_tile->i_width ||
+          p_tile->p_scaled->format.i_height != p_tile->i_height ) )
+    {
+        picture_Release( p_tile->p_scaled );
+        p_tile->p_scaled = NULL;
+    }
+    if( !p_tile->p_scaled )
+    {
+        p_tile->p_scaled = picture_New( VLC_CODEC_YUVA, p_tile->i_width,
+                                        p_tile->i_height, 1, 1 );
+        if( !p_tile->p_scaled )
+            return;
+    }
+
+    if( p_tile->p_scaler &&
+        p_tile->p_scaler->fmt_in.video.i_chroma == p_src->i_chroma &&
+        p_tile->p_scaler->fmt_in.video.i_width  == p_src->i_width &&
+        p_tile->p_scaler->fmt_in.video.i_height == p_src->i_height &&
+        p_tile->p_scaler->fmt_out.video.i_width  == p_tile->i_width &&
+        p_tile->p_scaler->fmt_out.video.i_height == p_tile->i_height )
+        return;
+    TileDeleteScaler( p_tile );
+
+    /* Same format: the picture will simply be copied */
+    if( p_src->i_chroma == VLC_CODEC_YUVA &&
+        p_src->i_width  == p_tile->i_width &&
+        p_src->i_height == p_tile->i_height )
+        return;
+
+    filter_t *p_scaler = vlc_object_create( p_filter, sizeof(*p_scaler) );
+    if( !p_scaler )
+        return;
+
+    es_format_Init( &p_scaler->fmt_in, VIDEO_ES, p_src->i_chroma );
+    video_format_Setup( &p_scaler->fmt_in.video, p_src->i_chroma,
+                        p_src->i_width, p_src->i_height, 1, 1 );
+    es_format_Init( &p_scaler->fmt_out, VIDEO_ES, VLC_CODEC_YUVA );
+    video_format_Setup( &p_scaler->fmt_out.video, VLC_CODEC_YUVA,
+                        p_tile->i_width, p_tile->i_height, 1, 1 );
+
+    p_scaler->pf_video_buffer_new = TileBufferNew;
+    p_scaler->pf_video_buffer_del = TileBufferDel;
+    p_scaler->p_owner = (filter_owner_sys_t *)p_tile;
+
+    p_scaler->p_module = module_need( p_scaler, "video filter2", NULL, false );
+    p_tile->p_scaler = p_scaler;
+    if( !p_scaler->p_module )
+    {
+        msg_Warn( p_filter, "cannot scale %4.4s %ux%u to YUVA %ux%u",
+                  (const char *)&p_src->i_chroma,
+                  p_src->i_width, p_src->i_height,
+                  p_tile->i_width, p_tile->i_height );
+        TileDeleteScaler( p_tile );
+    }
+}
+
+/* It scales the picture of an element, with its alpha applied */
+static bool TileScale( mosaic_tile_t *p_tile )
+{
+    picture_t *p_scaled = p_tile->p_scaled;
+
+    if( p_tile->p_scaler )
+    {
+        picture_t *p_out = p_tile->p_scaler->pf_video_filter(
+                               p_tile->p_scaler,
+                               picture_Hold( p_tile->p_source ) );
+        if( !p_out )
+            return false;
+        /* The scaler did not use our buffer */
+        if( p_out != p_scaled )
+            picture_CopyPixels( p_scaled, p_out );
+        picture_Release( p_out );
+    }
+    else if( p_tile->p_source->format.i_chroma == VLC_CODEC_YUVA )
+        picture_CopyPixels( p_scaled, p_tile->p_source );
+    else
+        return false;
+
+    /* The alpha of the element applies to all its pixels */
+    if( p_tile->i_alpha != 255 )
+    {
+        plane_t *p_a = &p_scaled->p[A_PLANE];
+
+        for( int y = 0; y < p_a->i_visible_lines; y++ )
+        {
+            uint8_t *p_line = &p_a->p_pixels[y * p_a->i_pitch];
+
+            for( int x = 0; x < p_a->i_visible_pitch; x++ )
+                p_line[x] = p_line[x] * p_tile->i_alpha / 255;
+        }
+    }
+    return true;
+}
+
+typedef struct
+{
+    mosaic_tile_t **pp_tiles; /* Elements of the composite picture */
+    picture_t *p_composite;
+    int i_x, i_y;             /* Position of the composite picture */
+} mosaic_composite_t;
+
+static void CompositeSlice( filter_t *p_filter, void *p_data,
+                            unsigned i_slice, unsigned i_slices )
+{
+    mosaic_composite_t *p_ctx = p_data;
+    mosaic_tile_t *p_tile = p_ctx->pp_tiles[i_slice];
+    VLC_UNUSED(p_filter); VLC_UNUSED(i_slices);
+
+    if( p_tile->b_dirty && !TileScale( p_tile ) )
+    {
+        /* Leave it transparent */
+        picture_Release( p_tile->p_scaled );
+        p_tile->p_scaled = NULL;
+    }
+    if( !p_tile->p_scaled )
+        return;
+
+    for( int i = 0; i < p_ctx->p_composite->i_planes; i++ )
+    {
+        const plane_t *p_src = &p_tile->p_scaled->p[i];
+        plane_t *p_dst = &p_ctx->p_composite->p[i];
+        uint8_t *p_out = &p_dst->p_pixels[
+                            ( p_tile->i_y - p_ctx->i_y ) * p_dst->i_pitch +
+                            ( p_tile->i_x - p_ctx->i_x ) * p_dst->i_pixel_pitch];
+
+        for( unsigned y = 0; y < p_tile->i_height; y++ )
+            memcpy( &p_out[y * p_dst->i_pitch],
+                    &p_src->p_pixels[y * p_src->i_pitch],
+                    p_tile->i_width * p_src->i_pixel_pitch );
+    }
+}
+
+/* It builds the composite picture and returns its region. The mosaic lock
+ * is released as soon as the bridged pictures are held. */
+static subpicture_region_t *Composite( filter_t *p_filter, bridge_t *p_bridge,
+                                       mtime_t date,
+                                       unsigned col_inner_width,
+                                       unsigned row_inner_height )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    int i_real_index = 0;
+    int i_greatest_real_index_used = p_sys->i_order_length - 1;
+
+    /* One state per bridged ES */
+    if( p_sys->i_tiles < p_bridge->i_es_num )
+    {
+        mosaic_tile_t **pp_tiles = realloc( p_sys->pp_tiles,
+                            p_bridge->i_es_num * sizeof(*pp_tiles) );
+        if( !pp_tiles )
+        {
+            vlc_global_unlock( VLC_MOSAIC_MUTEX );
+            return NULL;
+        }
+        p_sys->pp_tiles = pp_tiles;
+        while( p_sys->i_tiles < p_bridge->i_es_num )
+        {
+            mosaic_tile_t *p_tile = calloc( 1, sizeof(*p_tile) );
+            if( !p_tile )
+                break;
+            p_sys->pp_tiles[p_sys->i_tiles++] = p_tile;
+        }
+    }
+
+    bool b_changed = false;
+    unsigned i_used = 0;
+    int i_x_min = INT_MAX, i_y_min = INT_MAX;
+    int i_x_max = INT_MIN, i_y_max = INT_MIN;
+
+    for( int i_index = 0; i_index < p_sys->i_tiles; i_index++ )
+    {
+        mosaic_tile_t *p_tile = p_sys->pp_tiles[i_index];
+        bridged_es_t *p_es = i_index < p_bridge->i_es_num ?
+                             p_bridge->pp_es[i_index] : NULL;
+        picture_t *p_picture = NULL;
+
+        if( p_es && !p_es->b_empty )
+            p_picture = GetPicture( p_filter, p_es, date );
+
+        const bool b_shown = p_tile->b_used;
+        p_tile->b_used = p_picture != NULL;
+        if( !p_tile->b_used )
+        {
+            if( p_tile->p_source )
+            {
+                picture_Release( p_tile->p_source );
+                p_tile->p_source = NULL;
+            }
+            b_changed |= b_shown;
+            continue;
+        }
+
+        const int i_slot = GetRealIndex( p_sys, p_es, &i_real_index,
+                                         &i_greatest_real_index_used );
+        unsigned i_width, i_height;
+        int i_x, i_y;
+        GetSize( p_sys, &p_picture->format, col_inner_width, row_inner_height,
+                 &i_width, &i_height );
+        GetPosition( p_sys, p_es, i_slot, col_inner_width, row_inner_height,
+                     i_width, i_height, &i_x, &i_y );
+        if( i_width == 0 || i_height == 0 )
+        {
+            p_tile->b_used = false;
+            b_changed |= b_shown;
+            continue;
+        }
+
+        p_tile->b_dirty = !b_shown ||
+                          p_tile->p_source != p_picture ||
+                          p_tile->i_width  != i_width ||
+                          p_tile->i_height != i_height ||
+                          p_tile->i_alpha  != p_es->i_alpha;
+        b_changed |= p_tile->b_dirty ||
+                     p_tile->i_x != i_x || p_tile->i_y != i_y;
+
+        if( p_tile->p_source != p_picture )
+        {
+            if( p_tile->p_source )
+                picture_Release( p_tile->p_source );
+            p_tile->p_source = picture_Hold( p_picture );
+        }
+        p_tile->i_x      = i_x;
+        p_tile->i_y      = i_y;
+        p_tile->i_width  = i_width;
+        p_tile->i_height = i_height;
+        p_tile->i_alpha  = p_es->i_alpha;
+
+        i_x_min = __MIN( i_x_min, i_x );
+        i_y_min = __MIN( i_y_min, i_y );
+        i_x_max = __MAX( i_x_max, i_x + (int)i_width );
+        i_y_max = __MAX( i_y_max, i_y + (int)i_height );
+        i_used++;
+    }
+
+    /* The bridged pictures are held, let the bridges go on */
+    vlc_global_unlock( VLC_MOSAIC_MUTEX );
+
+    if( i_used == 0 )
+    {
+        if( p_sys->p_composite )
+            picture_Release( p_sys->p_composite );
+        p_sys->p_composite = NULL;
+        return NULL;
+    }
+
+    video_format_t fmt;
+    video_format_Setup( &fmt, VLC_CODEC_YUVA,
+                        i_x_max - i_x_min, i_y_max - i_y_min, 1, 1 );
+
+    subpicture_region_t *p_region = subpicture_region_New( &fmt );
+    if( !p_region )
+        return NULL;
+
+    if( p_sys->p_composite && !b_changed &&
+        p_sys->p_composite->format.i_width  == fmt.i_width &&
+        p_sys->p_composite->format.i_height == fmt.i_height )
+    {
+        /* Nothing to do, the last composite picture is still valid */
+        picture_Release( p_region->p_picture );
+        p_region->p_picture = picture_Hold( p_sys->p_composite );
+    }
+    else
+    {
+        mosaic_composite_t ctx = {
+            .pp_tiles    = malloc( i_used * sizeof(*ctx.pp_tiles) ),
+            .p_composite = p_region->p_picture,
+            .i_x         = i_x_min,
+            .i_y         = i_y_min,
+        };
+        if( !ctx.pp_tiles )
+        {
+            subpicture_region_Delete( p_region );
+            return NULL;
+        }
+
+        /* Pixels not covered by any element are transparent */
+        for( int i = 0; i < ctx.p_composite->i_planes; i++ )
+        {
+            plane_t *p = &ctx.p_composite->p[i];
+            memset( p->p_pixels, i == U_PLANE || i == V_PLANE ? 0x80 : 0x00,
+                    p->i_pitch * p->i_lines );
+        }
+
+        unsigned i_tiles = 0;
+        for( int i = 0; i < p_sys->i_tiles; i++ )
+        {
+            mosaic_tile_t *p_tile = p_sys->pp_tiles[i];
+
+            if( !p_tile->b_used )
+                continue;
+            if( !p_tile->p_scaled )
+                p_tile->b_dirty = true;
+            if( p_tile->b_dirty )
+                TileSetup( p_filter, p_tile );
+            /* Without its scaled picture, the element is left transparent */
+            if( !p_tile->p_scaled )
+                continue;
+            ctx.pp_tiles[i_tiles++] = p_tile;
+        }
+
+        filter_RunSlices( p_filter, i_tiles, CompositeSlice, &ctx );
+        free( ctx.pp_tiles );
+
+        if( p_sys->p_composite )
+            picture_Release( p_sys->p_composite );
+        p_sys->p_composite = picture_Hold( p_region->p_picture );
+    }
+
+    p_region->i_x = i_x_min;
+    p_region->i_y = i_y_min;
+    p_region->i_align = p_sys->i_align;
+    return p_region;
+}
+
 /*****************************************************************************
  * Filter
  *****************************************************************************/
@@ -435,7 +970,7 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
 
     subpicture_t *p_spu;
 
-    int i_index, i_real_index, i_row, i_col;
+    int i_index, i_real_index;
     int i_greatest_real_index_used = p_sys->i_order_length - 1;
 
     unsigned int col_inner_width, row_inner_height;
@@ -519,6 +1054,15 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
     row_inner_height = ( ( p_sys->i_height - ( p_sys->i_rows - 1 )
                        * p_sys->i_borderh ) / p_sys->i_rows );
 
+    if( p_sys->b_composite )
+    {
+        /* The mosaic lock is released by Composite() */
+        p_spu->p_region = Composite( p_filter, p_bridge, date,
+                                     col_inner_width, row_inner_height );
+        vlc_mutex_unlock( &p_sys->lock );
+        return p_spu;
+    }
+
     i_real_index = 0;
 
     for ( i_index = 0; i_index < p_bridge->i_es_num; i_index++ )
@@ -533,57 +1077,11 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
         if ( p_es->b_empty )
             continue;
 
-        while ( p_es->p_picture != NULL
-                 && p_es->p_picture->date + p_sys->i_delay < date )
-        {
-            if ( p_es->p_picture->p_next != NULL )
-            {
-                picture_t *p_next = p_es->p_picture->p_next;
-                picture_Release( p_es->p_picture );
-                p_es->p_picture = p_next;
-            }
-            else if ( p_es->p_picture->date + p_sys->i_delay + BLANK_DELAY <
-                        date )
-            {
-                /* Display blank */
-                picture_Release( p_es->p_picture );
-                p_es->p_picture = NULL;
-                p_es->pp_last = &p_es->p_picture;
-                break;
-            }
-            else
-            {
-                msg_Dbg( p_filter, "too late picture for %s (%"PRId64 ")",
-                         p_es->psz_id,
-                         date - p_es->p_picture->date - p_sys->i_delay );
-                break;
-            }
-        }
-
-        if ( p_es->p_picture == NULL )
+        if ( GetPicture( p_filter, p_es, date ) == NULL )
             continue;
 
-        if ( p_sys->i_order_length == 0 )
-        {
-            i_real_index++;
-        }
-        else
-        {
-            int i;
-            for ( i = 0; i <= p_sys->i_order_length; i++ )
-            {
-                if ( i == p_sys->i_order_length ) break;
-                if ( strcmp( p_es->psz_id, p_sys->ppsz_order[i] ) == 0 )
-                {
-                    i_real_index = i;
-                    break;
-                }
-            }
-            if ( i == p_sys->i_order_length )
-                i_real_index = ++i_greatest_real_index_used;
-        }
-        i_row = ( i_real_index / p_sys->i_cols ) % p_sys->i_rows;
-        i_col = i_real_index % p_sys->i_cols ;
+        GetRealIndex( p_sys, p_es, &i_real_index,
+                      &i_greatest_real_index_used );
 
         if ( !p_sys->b_keep )
         {
@@ -597,23 +1095,8 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
                 fmt_out.i_chroma = VLC_CODEC_YUVA;
             else
                 fmt_out.i_chroma = VLC_CODEC_I420;
-            fmt_out.i_width = col_inner_width;
-            fmt_out.i_height = row_inner_height;
-
-            if( p_sys->b_ar ) /* keep aspect ratio */
-            {
-                if( (float)fmt_out.i_width / (float)fmt_out.i_height
-                      > (float)fmt_in.i_width / (float)fmt_in.i_height )
-                {
-                    fmt_out.i_width = ( fmt_out.i_height * fmt_in.i_width )
-                                         / fmt_in.i_height;
-                }
-                else
-                {
-                    fmt_out.i_height = ( fmt_out.i_width * fmt_in.i_height )
-                                        / fmt_in.i_width;
-                }
-             }
+            GetSize( p_sys, &fmt_in, col_inner_width, row_inner_height,
+                     &fmt_out.i_width, &fmt_out.i_height );
 
             fmt_out.i_visible_width = fmt_out.i_width;
             fmt_out.i_visible_height = fmt_out.i_height;
@@ -653,54 +1136,10 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
             return p_spu;
         }
 
-        if( p_es->i_x >= 0 && p_es->i_y >= 0 )
-        {
-            p_region->i_x = p_es->i_x;
-            p_region->i_y = p_es->i_y;
-        }
-        else if( p_sys->i_position == position_offsets )
-        {
-            p_region->i_x = p_sys->pi_x_offsets[i_real_index];
-            p_region->i_y = p_sys->pi_y_offsets[i_real_index];
-        }
-        else
-        {
-            if( fmt_out.i_width > col_inner_width ||
-                p_sys->b_ar || p_sys->b_keep )
-            {
-                /* we don't have to center the video since it takes the
-                whole rectangle area or it's larger than the rectangle */
-                p_region->i_x = p_sys->i_xoffset
-                            + i_col * ( p_sys->i_width / p_sys->i_cols )
-                            + ( i_col * p_sys->i_borderw ) / p_sys->i_cols;
-            }
-            else
-            {
-                /* center the video in the dedicated rectangle */
-                p_region->i_x = p_sys->i_xoffset
-                        + i_col * ( p_sys->i_width / p_sys->i_cols )
-                        + ( i_col * p_sys->i_borderw ) / p_sys->i_cols
-                        + ( col_inner_width - fmt_out.i_width ) / 2;
-            }
-
-            if( fmt_out.i_height > row_inner_height
-                || p_sys->b_ar || p_sys->b_keep )
-            {
-                /* we don't have to center the video since it takes the
-                whole rectangle area or it's taller than the rectangle */
-                p_region->i_y = p_sys->i_yoffset
-                        + i_row * ( p_sys->i_height / p_sys->i_rows )
-                        + ( i_row * p_sys->i_borderh ) / p_sys->i_rows;
-            }
-            else
-            {
-                /* center the video in the dedicated rectangle */
-                p_region->i_y = p_sys->i_yoffset
-                        + i_row * ( p_sys->i_height / p_sys->i_rows )
-                        + ( i_row * p_sys->i_borderh ) / p_sys->i_rows
-                        + ( row_inner_height - fmt_out.i_height ) / 2;
-            }
-        }
+        GetPosition( p_sys, p_es, i_real_index,
+                     col_inner_width, row_inner_height,
+                     fmt_out.i_width, fmt_out.i_height,
+                     &p_region->i_x, &p_region->i_y );
         p_region->i_align = p_sys->i_align;
         p_region->i_alpha = p_es->i_alpha;
 
@@ -161,42 +161,35 @@ static void Destroy( vlc_object_t *p_this )
 }
 
 /*****************************************************************************
- * Render: displays previously rendered output
- *****************************************************************************
- * This function send the currently rendered image to Invert image, waits
- * until it is displayed and switch the two rendering buffers, preparing next
- * frame.
+ * FilterSlice: sharpens a band of lines of the Y plane
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+typedef struct
 {
-    picture_t *p_outpic;
-    int i, j;
-    uint8_t *p_src = NULL;
-    uint8_t *p_out = NULL;
-    int i_src_pitch;
-    int i_out_pitch;
+    const picture_t *p_pic;
+    picture_t       *p_outpic;
+} sharpen_slices_t;
+
+static void FilterSlice( filter_t *p_filter, void *p_data,
+                         unsigned i_slice, unsigned i_slices )
+{
+    const sharpen_slices_t *p_slices = p_data;
+    const picture_t *p_pic = p_slices->p_pic;
+    int i, j, i_first, i_end;
     int pix;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
 
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-
     /* process the Y plane */
-    p_src = p_pic->p[Y_PLANE].p_pixels;
-    p_out = p_outpic->p[Y_PLANE].p_pixels;
-    i_src_pitch = p_pic->p[Y_PLANE].i_pitch;
-    i_out_pitch = p_outpic->p[Y_PLANE].i_pitch;
+    const uint8_t *p_src = p_pic->p[Y_PLANE].p_pixels;
+    uint8_t *p_out = p_slices->p_outpic->p[Y_PLANE].p_pixels;
+    const int i_src_pitch = p_pic->p[Y_PLANE].i_pitch;
+    const int i_out_pitch = p_slices->p_outpic->p[Y_PLANE].i_pitch;
+
+    filter_GetSliceLines( p_pic->p[Y_PLANE].i_visible_lines, i_slice, i_slices,
+                          1, &i_first, &i_end );
 
     /* perform convolution only on Y plane. Avoid border line. */
-    vlc_mutex_lock( &p_filter->p_sys->lock );
-    for( i = 0; i < p_pic->p[Y_PLANE].i_visible_lines; i++ )
+    for( i = i_first; i < i_end; i++ )
     {
         if( (i == 0) || (i == p_pic->p[Y_PLANE].i_visible_lines - 1) )
         {
@@ -227,6 +220,34 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                p_filter->p_sys->tab_precalc[pix + 256] );
         }
     }
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************
+ * This function send the currently rendered image to Invert image, waits
+ * until it is displayed and switch the two rendering buffers, preparing next
+ * frame.
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+
+    if( !p_pic ) return NULL;
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    sharpen_slices_t slices = { .p_pic = p_pic, .p_outpic = p_outpic };
+
+    /* The lock keeps tab_precalc stable while the slices run */
+    vlc_mutex_lock( &p_filter->p_sys->lock );
+    filter_RunSlices( p_filter, filter_GetSlices( p_filter ),
+                      FilterSlice, &slices );
     vlc_mutex_unlock( &p_filter->p_sys->lock );
 
     plane_CopyPixels( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE] );
@@ -55,6 +55,11 @@ static void CloseScaler( vlc_object_t * );
 
 #define SCALEMODE_TEXT N_("Scaling mode")
 #define SCALEMODE_LONGTEXT N_("Scaling mode to use.")
+#define SLICES_TEXT N_("Slices")
+#define SLICES_LONGTEXT N_("Number of horizontal bands of the pictures " \
+    "converted concurrently, each with its own scaler (0 for one per video " \
+    "filter thread, 1 to disable). The pixels next to the band boundaries " \
+    "may slightly differ from a conversion in one pass.")
 
 static const int pi_mode_values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
 const char *const ppsz_mode_descriptions[] =
@@ -72,6 +77,8 @@ vlc_module_begin ()
     set_callbacks( OpenScaler, CloseScaler )
     add_integer( "swscale-mode", 2, SCALEMODE_TEXT, SCALEMODE_LONGTEXT, true )
         change_integer_list( pi_mode_values, ppsz_mode_descriptions )
+    add_integer( "swscale-slices", 1, SLICES_TEXT, SLICES_LONGTEXT, true )
+        change_integer_range( 0, 64 )
 vlc_module_end ()
 
 /* Version checking */
@@ -80,6 +87,18 @@ vlc_module_end ()
  * Local prototypes
  ****************************************************************************/
 
+/**
+ * A horizontal band converted by its own context
+ */
+typedef struct
+{
+    struct SwsContext *ctx;
+    int i_src_y;
+    int i_src_height;
+    int i_dst_y;
+    int i_dst_height;
+} scaler_slice_t;
+
 /**
  * Internal swscale filter structure.
  */
@@ -103,6 +122,12 @@ struct filter_sys_t
     bool b_copy;
     bool b_swap_uvi;
     bool b_swap_uvo;
+
+    int i_slices_max;
+    unsigned i_slices;
+    scaler_slice_t *p_slices;
+    const vlc_chroma_description_t *p_chroma_in;
+    const vlc_chroma_description_t *p_chroma_out;
 };
 
 static picture_t *Filter( filter_t *, picture_t * );
@@ -133,6 +158,8 @@ static int GetSwsCpuMask(void);
 #define ALLOW_YUVP (false)
 /* SwScaler does not like too small picture */
 #define MINIMUM_WIDTH (32)
+/* Smallest band worth its own context */
+#define MINIMUM_SLICE_HEIGHT (32)
 
 /* XXX is it always 3 even for BIG_ENDIAN (blend.c seems to think so) ? */
 #define OFFSET_A (3)
@@ -189,6 +216,9 @@ static int OpenScaler( vlc_object_t *p_this )
     p_sys->p_dst_a = NULL;
     p_sys->p_src_e = NULL;
     p_sys->p_dst_e = NULL;
+    p_sys->i_slices_max = var_InheritInteger( p_filter, "swscale-slices" );
+    p_sys->i_slices = 0;
+    p_sys->p_slices = NULL;
     memset( &p_sys->fmt_in,  0, sizeof(p_sys->fmt_in) );
     memset( &p_sys->fmt_out, 0, sizeof(p_sys->fmt_out) );
 
@@ -341,6 +371,92 @@ static int GetParameters( ScalerConfiguration *p_cfg,
     return VLC_SUCCESS;
 }
 
+static void CleanSlices( filter_sys_t *p_sys )
+{
+    for( unsigned i = 0; i < p_sys->i_slices; i++ )
+    {
+        if( p_sys->p_slices[i].ctx )
+            sws_freeContext( p_sys->p_slices[i].ctx );
+    }
+    free( p_sys->p_slices );
+    p_sys->p_slices = NULL;
+    p_sys->i_slices = 0;
+}
+
+static void InitSlices( filter_t *p_filter, const ScalerConfiguration *p_cfg,
+                        unsigned i_fmti_width, unsigned i_fmto_width )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const video_format_t *p_fmti = &p_filter->fmt_in.video;
+    const video_format_t *p_fmto = &p_filter->fmt_out.video;
+
+    unsigned i_slices = p_sys->i_slices_max > 0 ? (unsigned)p_sys->i_slices_max
+                                                : filter_GetSlices( p_filter );
+    if( i_slices <= 1 )
+        return;
+
+    p_sys->p_chroma_in  = vlc_fourcc_GetChromaDescription( p_fmti->i_chroma );
+    p_sys->p_chroma_out = vlc_fourcc_GetChromaDescription( p_fmto->i_chroma );
+    if( !p_sys->p_chroma_in || !p_sys->p_chroma_out )
+        return;
+
+    /* Every band keeps the scaling ratio, so that the vertical filters keep
+     * their phases: the bands are made of units of h_in/gcd input lines and
+     * h_out/gcd output lines, large enough to start on a chroma line. */
+    const unsigned i_gcd = GCD( p_fmti->i_height, p_fmto->i_height );
+    unsigned i_align_in = 1, i_align_out = 1;
+    for( unsigned n = 0; n < p_sys->p_chroma_in->plane_count; n++ )
+        i_align_in = __MAX( i_align_in, p_sys->p_chroma_in->p[n].h.den /
+                                        p_sys->p_chroma_in->p[n].h.num );
+    for( unsigned n = 0; n < p_sys->p_chroma_out->plane_count; n++ )
+        i_align_out = __MAX( i_align_out, p_sys->p_chroma_out->p[n].h.den /
+                                          p_sys->p_chroma_out->p[n].h.num );
+    unsigned i_merge = 1;
+    while( ( i_merge * p_fmti->i_height / i_gcd ) % i_align_in ||
+           ( i_merge * p_fmto->i_height / i_gcd ) % i_align_out )
+        i_merge++;
+    const unsigned i_unit_in  = i_merge * p_fmti->i_height / i_gcd;
+    const unsigned i_unit_out = i_merge * p_fmto->i_height / i_gcd;
+    const unsigned i_units    = i_gcd / i_merge;
+
+    i_slices = __MIN( i_slices, i_units );
+    i_slices = __MIN( i_slices, p_fmto->i_height / MINIMUM_SLICE_HEIGHT );
+    if( i_slices <= 1 )
+        return;
+
+    p_sys->p_slices = calloc( i_slices, sizeof(*p_sys->p_slices) );
+    if( !p_sys->p_slices )
+        return;
+    p_sys->i_slices = i_slices;
+
+    for( unsigned i = 0; i < i_slices; i++ )
+    {
+        scaler_slice_t *p_slice = &p_sys->p_slices[i];
+        const unsigned i_first = i * i_units / i_slices;
+        const unsigned i_end   = (i + 1) * i_units / i_slices;
+
+        /* The last band also gets the lines left by the units */
+        p_slice->i_src_y      = i_first * i_unit_in;
+        p_slice->i_src_height = ( i + 1 < i_slices ? i_end * i_unit_in
+                                                   : p_fmti->i_height ) - p_slice->i_src_y;
+        p_slice->i_dst_y      = i_first * i_unit_out;
+        p_slice->i_dst_height = ( i + 1 < i_slices ? i_end * i_unit_out
+                                                   : p_fmto->i_height ) - p_slice->i_dst_y;
+
+        p_slice->ctx = sws_getContext( i_fmti_width, p_slice->i_src_height, p_cfg->i_fmti,
+                                       i_fmto_width, p_slice->i_dst_height, p_cfg->i_fmto,
+                                       p_cfg->i_sws_flags | p_sys->i_cpu_mask,
+                                       p_sys->p_src_filter, p_sys->p_dst_filter, 0 );
+        if( !p_slice->ctx )
+        {
+            msg_Warn( p_filter, "could not init SwScaler slices" );
+            CleanSlices( p_sys );
+            return;
+        }
+    }
+    msg_Dbg( p_filter, "converting in %u slices", i_slices );
+}
+
 static int Init( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -422,6 +538,9 @@ static int Init( filter_t *p_filter )
     p_sys->b_swap_uvi = cfg.b_swap_uvi;
     p_sys->b_swap_uvo = cfg.b_swap_uvo;
 
+    if( !cfg.b_copy )
+        InitSlices( p_filter, &cfg, i_fmti_width, i_fmto_width );
+
     video_format_ScaleCropAr( p_fmto, p_fmti );
 #if 0
     msg_Dbg( p_filter, "%ix%i chroma: %4.4s -> %ix%i chroma: %4.4s extend by %d",
@@ -435,6 +554,8 @@ static void Clean( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    CleanSlices( p_sys );
+
     if( p_sys->p_src_e )
         picture_Release( p_sys->p_src_e );
     if( p_sys->p_dst_e )
@@ -560,6 +681,68 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
 #endif
 }
 
+typedef struct
+{
+    picture_t *p_dst;
+    picture_t *p_src;
+} scaler_slices_t;
+
+/* It moves the planes of a picture down by i_y lines of its first plane */
+static void OffsetPicture( picture_t *p_dst, const picture_t *p_src,
+                           const vlc_chroma_description_t *p_chroma, int i_y )
+{
+    *p_dst = *p_src;
+    for( int n = 0; n < p_dst->i_planes; n++ )
+    {
+        plane_t *p = &p_dst->p[n];
+        p->p_pixels += i_y * p_chroma->p[n].h.num / p_chroma->p[n].h.den * p->i_pitch;
+    }
+}
+
+static void ConvertSlice( filter_t *p_filter, void *p_data,
+                          unsigned i_slice, unsigned i_slices )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const scaler_slices_t *p_pictures = p_data;
+    const scaler_slice_t *p_slice = &p_sys->p_slices[i_slice];
+    picture_t src, dst;
+
+    VLC_UNUSED(i_slices);
+    OffsetPicture( &src, p_pictures->p_src, p_sys->p_chroma_in, p_slice->i_src_y );
+    OffsetPicture( &dst, p_pictures->p_dst, p_sys->p_chroma_out, p_slice->i_dst_y );
+    Convert( p_filter, p_slice->ctx, &dst, &src, p_slice->i_src_height, 0, 3,
+             p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+}
+
+/* libswscale SIMD code wants aligned lines */
+static bool IsPlaneAligned( const plane_t *p )
+{
+    return ((uintptr_t)p->p_pixels % 16) == 0 && (p->i_pitch % 16) == 0;
+}
+
+/* It tells if p_pic can hold the lines of the width extended picture p_ext */
+static bool CanHoldExtended( const picture_t *p_pic, const picture_t *p_ext )
+{
+    if( p_pic->i_planes != p_ext->i_planes )
+        return false;
+    for( int n = 0; n < p_pic->i_planes; n++ )
+    {
+        if( !IsPlaneAligned( &p_pic->p[n] ) ||
+            p_pic->p[n].i_pitch < p_ext->p[n].i_pitch ||
+            p_pic->p[n].i_lines < p_ext->p[n].i_visible_lines )
+            return false;
+    }
+    return true;
+}
+
+/* It gives a single plane picture made of the A plane of p_pic */
+static void GetPlaneA( picture_t *p_a, const picture_t *p_pic )
+{
+    *p_a = *p_pic;
+    p_a->p[0] = p_pic->p[A_PLANE];
+    p_a->i_planes = 1;
+}
+
 /****************************************************************************
  * Filter: the whole thing
  ****************************************************************************
@@ -593,30 +776,56 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     if( p_sys->i_extend_factor != 1 )
     {
         p_src = p_sys->p_src_e;
-        p_dst = p_sys->p_dst_e;
-
         CopyPad( p_src, p_pic );
+
+        /* The extended lines can be written in the output picture directly
+         * when its pitches are large enough */
+        if( !CanHoldExtended( p_pic_dst, p_sys->p_dst_e ) )
+            p_dst = p_sys->p_dst_e;
     }
 
     if( p_sys->b_copy && p_sys->b_swap_uvi == p_sys->b_swap_uvo )
         picture_CopyPixels( p_dst, p_src );
     else if( p_sys->b_copy )
         SwapUV( p_dst, p_src );
+    else if( p_sys->i_slices > 1 )
+    {
+        scaler_slices_t pictures = { .p_dst = p_dst, .p_src = p_src };
+        filter_RunSlices( p_filter, p_sys->i_slices, ConvertSlice, &pictures );
+    }
     else
         Convert( p_filter, p_sys->ctx, p_dst, p_src, p_fmti->i_height, 0, 3,
                  p_sys->b_swap_uvi, p_sys->b_swap_uvo );
     if( p_sys->ctxA )
     {
-        /* We extract the A plane to rescale it, and then we reinject it. */
+        /* We extract the A plane to rescale it, and then we reinject it.
+         * A planes are used in place when they suit libswscale. */
+        picture_t *p_src_a = p_sys->p_src_a;
+        picture_t *p_dst_a = p_sys->p_dst_a;
+        picture_t src_a, dst_a;
+
         if( p_fmti->i_chroma == VLC_CODEC_RGBA )
-            ExtractA( p_sys->p_src_a, p_src, p_fmti->i_width * p_sys->i_extend_factor, p_fmti->i_height );
+            ExtractA( p_src_a, p_src, p_fmti->i_width * p_sys->i_extend_factor, p_fmti->i_height );
+        else if( IsPlaneAligned( &p_src->p[A_PLANE] ) )
+        {
+            GetPlaneA( &src_a, p_src );
+            p_src_a = &src_a;
+        }
         else
-            plane_CopyPixels( p_sys->p_src_a->p, p_src->p+A_PLANE );
+            plane_CopyPixels( p_src_a->p, p_src->p+A_PLANE );
 
-        Convert( p_filter, p_sys->ctxA, p_sys->p_dst_a, p_sys->p_src_a, p_fmti->i_height, 0, 1, false, false );
+        const bool b_dst_a = p_fmto->i_chroma != VLC_CODEC_RGBA &&
+                             IsPlaneAligned( &p_dst->p[A_PLANE] );
+        if( b_dst_a )
+        {
+            GetPlaneA( &dst_a, p_dst );
+            p_dst_a = &dst_a;
+        }
+
+        Convert( p_filter, p_sys->ctxA, p_dst_a, p_src_a, p_fmti->i_height, 0, 1, false, false );
         if( p_fmto->i_chroma == VLC_CODEC_RGBA )
             InjectA( p_dst, p_sys->p_dst_a, p_fmto->i_width * p_sys->i_extend_factor, p_fmto->i_height );
-        else
+        else if( !b_dst_a )
             plane_CopyPixels( p_dst->p+A_PLANE, p_sys->p_dst_a->p );
     }
     else if( p_sys->b_add_a )
@@ -628,7 +837,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             FillA( &p_dst->p[A_PLANE], 0 );
     }
 
-    if( p_sys->i_extend_factor != 1 )
+    if( p_dst != p_pic_dst )
     {
         picture_CopyPixels( p_pic_dst, p_dst );
     }
@@ -485,6 +485,19 @@ int input_vaControl( input_thread_t *p_input, int i_query, va_list args )
             return es_out_ControlModifyPcrSystem( p_input->p->p_es_out_display, b_absolute, i_system );
         }
 
+        case INPUT_ADD_LOST_PACKETS:
+        {
+            unsigned i_lost = va_arg( args, unsigned );
+
+            if( libvlc_stats( p_input ) )
+            {
+                vlc_mutex_lock( &p_input->p->counters.counters_lock );
+                stats_Update( p_input->p->counters.p_lost_packets, i_lost, NULL );
+                vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+            }
+            return VLC_SUCCESS;
+        }
+
         default:
             msg_Err( p_input, "unknown query in input_vaControl" );
             return VLC_EGENERIC;
@@ -785,8 +785,8 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->p_packetizer = NULL;
     p_owner->b_packetizer = b_packetizer;
 
-    /* decoder fifo */
-    p_owner->p_fifo = block_FifoNew();
+    /* decoder fifo: fed by the input thread, drained by DecoderThread() */
+    p_owner->p_fifo = block_FifoNewSPSC( 1024 );
     if( unlikely(p_owner->p_fifo == NULL) )
     {
         free( p_owner );
@@ -1350,7 +1350,8 @@ static void DecoderGetCc( decoder_t *p_dec, decoder_t *p_dec_cc )
 }
 
 static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
-                              int *pi_played_sum, int *pi_lost_sum )
+                              int *pi_played_sum, int *pi_lost_sum,
+                              vout_timing_t *p_timing_sum )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
     vout_thread_t  *p_vout = p_owner->p_vout;
@@ -1460,6 +1461,10 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
         *pi_played_sum += i_tmp_display;
         *pi_lost_sum += i_tmp_lost;
 
+        vout_timing_t timing;
+        vout_GetResetTiming( p_vout, &timing );
+        vout_timing_Merge( p_timing_sum, &timing );
+
         if( !b_has_more || b_buffering_first )
             break;
 
@@ -1479,7 +1484,9 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
     int i_lost = 0;
     int i_decoded = 0;
     int i_displayed = 0;
+    vout_timing_t timing;
 
+    memset( &timing, 0, sizeof( timing ) );
     while( (p_pic = p_dec->pf_decode_video( p_dec, &p_block )) )
     {
         vout_thread_t  *p_vout = p_owner->p_vout;
@@ -1513,7 +1520,7 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
             ( !p_owner->p_packetizer || !p_owner->p_packetizer->pf_get_cc ) )
             DecoderGetCc( p_dec, p_dec );
 
-        DecoderPlayVideo( p_dec, p_pic, &i_displayed, &i_lost );
+        DecoderPlayVideo( p_dec, p_pic, &i_displayed, &i_lost, &timing );
     }
 
     /* Update ugly stat */
@@ -1526,6 +1533,7 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
         stats_Update( p_input->p->counters.p_lost_pictures, i_lost , NULL);
         stats_Update( p_input->p->counters.p_displayed_pictures,
                       i_displayed, NULL);
+        vout_timing_Merge( &p_input->p->counters.vout_timing, &timing );
         vlc_mutex_unlock( &p_input->p->counters.counters_lock );
     }
 }
@@ -863,6 +863,7 @@ static void InitStatistics( input_thread_t * p_input )
         INIT_COUNTER( read_packets, COUNTER );
         INIT_COUNTER( demux_read, COUNTER );
         INIT_COUNTER( input_bitrate, DERIVATIVE );
+        INIT_COUNTER( lost_packets, COUNTER );
         INIT_COUNTER( demux_bitrate, DERIVATIVE );
         INIT_COUNTER( demux_corrupted, COUNTER );
         INIT_COUNTER( demux_discontinuity, COUNTER );
@@ -1342,6 +1343,7 @@ error:
         EXIT_COUNTER( read_packets );
         EXIT_COUNTER( demux_read );
         EXIT_COUNTER( input_bitrate );
+        EXIT_COUNTER( lost_packets );
         EXIT_COUNTER( demux_bitrate );
         EXIT_COUNTER( demux_corrupted );
         EXIT_COUNTER( demux_discontinuity );
@@ -1415,6 +1417,7 @@ static void End( input_thread_t * p_input )
             CL_CO( read_packets );
             CL_CO( demux_read );
             CL_CO( input_bitrate );
+            CL_CO( lost_packets );
             CL_CO( demux_bitrate );
             CL_CO( demux_corrupted );
             CL_CO( demux_discontinuity );
@@ -140,6 +140,7 @@ struct input_thread_private_t
         counter_t *p_read_packets;
         counter_t *p_read_bytes;
         counter_t *p_input_bitrate;
+        counter_t *p_lost_packets;
         counter_t *p_demux_read;
         counter_t *p_demux_bitrate;
         counter_t *p_demux_corrupted;
@@ -154,6 +155,7 @@ struct input_thread_private_t
         counter_t *p_lost_abuffers;
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
+        vout_timing_t vout_timing;
         vlc_mutex_t counters_lock;
     } counters;
 
@@ -91,10 +91,21 @@
  *          we have to support seekable/non-seekable switch on the fly.
  *        - compute a good value for i_read_size
  *        - ?
+ *
+ *  Each track has its own read-ahead: it doubles every time the reader
+ *  drains the track (sequential access) and a track started by a hard
+ *  seek (random access) only gets half of the read-ahead of the track
+ *  it was seeked from.
  */
 #define STREAM_READ_ATONCE 1024
 #define STREAM_CACHE_TRACK_SIZE (STREAM_CACHE_SIZE/STREAM_CACHE_TRACK)
 
+/* Bounds of the per track read-ahead. A refill blocks until it is complete,
+ * so slow (non fast seekable) accesses get a lower maximum */
+#define STREAM_READ_AHEAD_MIN (STREAM_READ_ATONCE/2)
+#define STREAM_READ_AHEAD_MAX (STREAM_CACHE_TRACK_SIZE/16)
+#define STREAM_READ_AHEAD_MAX_SLOW __MIN(32*STREAM_READ_ATONCE, STREAM_READ_AHEAD_MAX)
+
 typedef struct
 {
     int64_t i_date;
@@ -104,6 +115,8 @@ typedef struct
 
     uint8_t *p_buffer;
 
+    unsigned i_read_ahead;  /* Adaptive read-ahead size */
+
 } stream_track_t;
 
 typedef struct
@@ -138,6 +151,8 @@ struct stream_sys_t
         block_t *p_first;
         block_t **pp_last;
 
+        uint64_t i_shared_end;   /* End offset of data handed out in place */
+
     } block;
 
     /* Method 2: for pf_read */
@@ -153,6 +168,7 @@ struct stream_sys_t
         /* */
         unsigned i_used; /* Used since last read */
         unsigned i_read_size;
+        unsigned i_read_ahead_max;
 
     } stream;
 
@@ -170,6 +186,12 @@ struct stream_sys_t
         uint64_t i_bytes;
         uint64_t i_read_time;
 
+        /* Stat about the stream user */
+        uint64_t i_consumed;
+        uint64_t i_request;
+        uint64_t i_miss;
+        uint64_t i_miss_request; /* Last request accounted as a miss */
+
         /* Stat about seek */
         unsigned i_seek_count;
         uint64_t i_seek_time;
@@ -203,6 +225,16 @@ static void AStreamDestroy( stream_t *s );
 static void UStreamDestroy( stream_t *s );
 static int  ASeek( stream_t *s, uint64_t i_pos );
 
+/* Accounts the current request as a cache miss */
+static void AStreamMiss( stream_sys_t *p_sys )
+{
+    if( p_sys->stat.i_miss_request != p_sys->stat.i_request )
+    {
+        p_sys->stat.i_miss_request = p_sys->stat.i_request;
+        p_sys->stat.i_miss++;
+    }
+}
+
 /****************************************************************************
  * stream_CommonNew: create an empty stream structure
  ****************************************************************************/
@@ -315,6 +347,10 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
     p_sys->stat.i_read_count = 0;
     p_sys->stat.i_seek_count = 0;
     p_sys->stat.i_seek_time = 0;
+    p_sys->stat.i_consumed = 0;
+    p_sys->stat.i_request = 0;
+    p_sys->stat.i_miss = 0;
+    p_sys->stat.i_miss_request = 0;
 
     TAB_INIT( p_sys->i_list, p_sys->list );
     p_sys->i_list_index = 0;
@@ -382,6 +418,7 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
         p_sys->block.i_size = 0;
         p_sys->block.p_first = NULL;
         p_sys->block.pp_last = &p_sys->block.p_first;
+        p_sys->block.i_shared_end = 0;
 
         /* Do the prebuffering */
         AStreamPrebufferBlock( s );
@@ -411,6 +448,8 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
             goto error;
         p_sys->stream.i_used   = 0;
         p_sys->stream.i_read_size = STREAM_READ_ATONCE;
+        p_sys->stream.i_read_ahead_max = p_sys->stat.b_fastseek ?
+            STREAM_READ_AHEAD_MAX : STREAM_READ_AHEAD_MAX_SLOW;
 #if STREAM_READ_ATONCE < 256
 #   error "Invalid STREAM_READ_ATONCE value"
 #endif
@@ -422,6 +461,7 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
             p_sys->stream.tk[i].i_end   = p_sys->i_pos;
             p_sys->stream.tk[i].p_buffer=
                 &p_sys->stream.p_buffer[i * STREAM_CACHE_TRACK_SIZE];
+            p_sys->stream.tk[i].i_read_ahead = STREAM_READ_ATONCE;
         }
 
         /* Do the prebuffering */
@@ -460,6 +500,12 @@ static void AStreamDestroy( stream_t *s )
 {
     stream_sys_t *p_sys = s->p_sys;
 
+    msg_Dbg( s, "cache: %"PRIu64"/%"PRIu64" hits, %"PRIu64" bytes read, "
+             "%"PRIu64" bytes consumed, %u seeks",
+             p_sys->stat.i_request - p_sys->stat.i_miss, p_sys->stat.i_request,
+             p_sys->stat.i_bytes, p_sys->stat.i_consumed,
+             p_sys->stat.i_seek_count );
+
     if( p_sys->method == STREAM_METHOD_BLOCK )
         block_ChainRelease( p_sys->block.p_first );
     else
@@ -509,6 +555,7 @@ static void AStreamControlReset( stream_t *s )
         p_sys->block.i_size = 0;
         p_sys->block.p_first = NULL;
         p_sys->block.pp_last = &p_sys->block.p_first;
+        p_sys->block.i_shared_end = 0;
 
         /* Do the prebuffering */
         AStreamPrebufferBlock( s );
@@ -529,6 +576,7 @@ static void AStreamControlReset( stream_t *s )
             p_sys->stream.tk[i].i_date  = 0;
             p_sys->stream.tk[i].i_start = p_sys->i_pos;
             p_sys->stream.tk[i].i_end   = p_sys->i_pos;
+            p_sys->stream.tk[i].i_read_ahead = STREAM_READ_ATONCE;
         }
 
         /* Do the prebuffering */
@@ -599,6 +647,7 @@ static int AStreamControl( stream_t *s, int i_query, va_list args )
 
         case STREAM_SET_POSITION:
             i_64 = va_arg( args, uint64_t );
+            p_sys->stat.i_request++;
             switch( p_sys->method )
             {
             case STREAM_METHOD_BLOCK:
@@ -636,6 +685,23 @@ static int AStreamControl( stream_t *s, int i_query, va_list args )
         case STREAM_GET_CONTENT_TYPE:
             return access_Control( p_access, ACCESS_GET_CONTENT_TYPE,
                                     va_arg( args, char ** ) );
+        case STREAM_GET_STATS:
+        {
+            stream_stats_t *p_stats = va_arg( args, stream_stats_t * );
+
+            p_stats->i_hits = p_sys->stat.i_request - p_sys->stat.i_miss;
+            p_stats->i_misses = p_sys->stat.i_miss;
+            p_stats->i_read = p_sys->stat.i_bytes;
+            p_stats->i_consumed = p_sys->stat.i_consumed;
+            p_stats->i_seek = p_sys->stat.i_seek_count;
+            if( p_sys->method == STREAM_METHOD_STREAM )
+                p_stats->i_read_ahead =
+                    p_sys->stream.tk[p_sys->stream.i_tk].i_read_ahead;
+            else
+                p_stats->i_read_ahead = 0;
+            break;
+        }
+
         case STREAM_SET_RECORD_STATE:
         default:
             msg_Err( s, "invalid stream_vaControl query=0x%x", i_query );
@@ -723,6 +789,8 @@ static int AStreamReadBlock( stream_t *s, void *p_read, unsigned int i_read )
     if( p_sys->block.p_current == NULL )
         return 0;
 
+    p_sys->stat.i_request++;
+
     if( p_data == NULL )
     {
         /* seek within this stream if possible, else use plain old read and discard */
@@ -731,7 +799,12 @@ static int AStreamReadBlock( stream_t *s, void *p_read, unsigned int i_read )
         bool   b_aseek;
         access_Control( p_access, ACCESS_CAN_SEEK, &b_aseek );
         if( b_aseek )
-            return AStreamSeekBlock( s, p_sys->i_pos + i_read ) ? 0 : i_read;
+        {
+            if( AStreamSeekBlock( s, p_sys->i_pos + i_read ) )
+                return 0;
+            p_sys->stat.i_consumed += i_read;
+            return i_read;
+        }
     }
 
     while( i_data < i_read )
@@ -768,6 +841,7 @@ static int AStreamReadBlock( stream_t *s, void *p_read, unsigned int i_read )
     }
 
     p_sys->i_pos += i_data;
+    p_sys->stat.i_consumed += i_data;
     return i_data;
 }
 
@@ -781,6 +855,8 @@ static int AStreamPeekBlock( stream_t *s, const uint8_t **pp_peek, unsigned int
 
     if( p_sys->block.p_current == NULL ) return 0; /* EOF */
 
+    p_sys->stat.i_request++;
+
     /* We can directly give a pointer over our buffer */
     if( i_read <= p_sys->block.p_current->i_buffer - p_sys->block.i_offset )
     {
@@ -845,8 +921,10 @@ static int AStreamSeekBlock( stream_t *s, uint64_t i_pos )
     int64_t    i_offset = i_pos - p_sys->block.i_start;
     bool b_seek;
 
-    /* We already have thoses data, just update p_current/i_offset */
-    if( i_offset >= 0 && (uint64_t)i_offset < p_sys->block.i_size )
+    /* We already have thoses data, just update p_current/i_offset, unless
+     * they were handed out by AStreamSliceBlock() (and may be modified) */
+    if( i_offset >= 0 && (uint64_t)i_offset < p_sys->block.i_size
+     && i_pos >= p_sys->block.i_shared_end )
     {
         block_t *b = p_sys->block.p_first;
         int i_current = 0;
@@ -866,7 +944,7 @@ static int AStreamSeekBlock( stream_t *s, uint64_t i_pos )
     }
 
     /* We may need to seek or to read data */
-    if( i_offset < 0 )
+    if( i_offset < 0 || i_pos < p_sys->block.i_shared_end )
     {
         bool b_aseek;
         access_Control( p_access, ACCESS_CAN_SEEK, &b_aseek );
@@ -931,6 +1009,7 @@ static int AStreamSeekBlock( stream_t *s, uint64_t i_pos )
         p_sys->block.i_size = 0;
         p_sys->block.p_first = NULL;
         p_sys->block.pp_last = &p_sys->block.p_first;
+        p_sys->block.i_shared_end = 0;
 
         /* Refill a block */
         if( AStreamRefillBlock( s ) )
@@ -969,6 +1048,43 @@ static int AStreamSeekBlock( stream_t *s, uint64_t i_pos )
     return VLC_EGENERIC;
 }
 
+/* Smallest slice worth a block allocation instead of a copy */
+#define STREAM_SLICE_MIN_SIZE 4096
+
+/**
+ * Reads data as a slice of the current access block, without copying it.
+ * This only works with shareable blocks from the access, and if the
+ * requested data is fully contained within the current block.
+ */
+static block_t *AStreamSliceBlock( stream_t *s, unsigned int i_size )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    block_t *b = p_sys->block.p_current;
+
+    if( b == NULL || i_size < STREAM_SLICE_MIN_SIZE
+     || b->i_buffer - p_sys->block.i_offset < i_size )
+        return NULL;
+
+    block_t *p_slice = block_shared_Slice( b, p_sys->block.i_offset, i_size );
+    if( p_slice == NULL )
+        return NULL;
+
+    p_sys->stat.i_request++;
+    p_sys->stat.i_consumed += i_size;
+
+    p_sys->i_pos += i_size;
+    p_sys->block.i_shared_end = p_sys->i_pos;
+    p_sys->block.i_offset += i_size;
+    if( p_sys->block.i_offset >= b->i_buffer )
+    {
+        p_sys->block.i_offset = 0;
+        p_sys->block.p_current = b->p_next;
+        if( p_sys->block.p_current == NULL )
+            AStreamRefillBlock( s );
+    }
+    return p_slice;
+}
+
 static int AStreamRefillBlock( stream_t *s )
 {
     stream_sys_t *p_sys = s->p_sys;
@@ -995,6 +1111,7 @@ static int AStreamRefillBlock( stream_t *s )
     }
 
     /* Now read a new block */
+    AStreamMiss( p_sys );
     const int64_t i_start = mdate();
     for( ;; )
     {
@@ -1042,6 +1159,8 @@ static int AStreamReadStream( stream_t *s, void *p_read, unsigned int i_read )
 {
     stream_sys_t *p_sys = s->p_sys;
 
+    p_sys->stat.i_request++;
+
     if( !p_read )
     {
         const uint64_t i_pos_wanted = p_sys->i_pos + i_read;
@@ -1051,9 +1170,13 @@ static int AStreamReadStream( stream_t *s, void *p_read, unsigned int i_read )
             if( p_sys->i_pos != i_pos_wanted )
                 return 0;
         }
+        p_sys->stat.i_consumed += i_read;
         return i_read;
     }
-    return AStreamReadNoSeekStream( s, p_read, i_read );
+
+    int i_data = AStreamReadNoSeekStream( s, p_read, i_read );
+    p_sys->stat.i_consumed += i_data;
+    return i_data;
 }
 
 static int AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned int i_read )
@@ -1064,6 +1187,8 @@ static int AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned int
 
     if( tk->i_start >= tk->i_end ) return 0; /* EOF */
 
+    p_sys->stat.i_request++;
+
 #ifdef STREAM_DEBUG
     msg_Dbg( s, "AStreamPeekStream: %d pos=%"PRId64" tk=%d "
              "start=%"PRId64" offset=%d end=%"PRId64,
@@ -1152,7 +1277,8 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
     /* FIXME compute seek cost (instead of static 'stupid' value) */
     uint64_t i_skip_threshold;
     if( b_aseek )
-        i_skip_threshold = b_afastseek ? 128 : 3*p_sys->stream.i_read_size;
+        i_skip_threshold = b_afastseek ? 128 :
+            __MAX( 3*p_sys->stream.i_read_size, p_current->i_read_ahead );
     else
         i_skip_threshold = INT64_MAX;
 
@@ -1221,6 +1347,7 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
              */
             if( ASeek( s, tk->i_end ) )
                 return VLC_EGENERIC;
+            p_sys->stat.i_seek_count++;
         }
         else if( i_pos > tk->i_end )
         {
@@ -1242,7 +1369,11 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
         /* Nothing good, seek and choose oldest segment */
         if( ASeek( s, i_pos ) )
             return VLC_EGENERIC;
+        p_sys->stat.i_seek_count++;
 
+        /* Random access, shrink the read-ahead */
+        tk->i_read_ahead = __MAX( p_current->i_read_ahead / 2,
+                                  STREAM_READ_AHEAD_MIN );
         tk->i_start = i_pos;
         tk->i_end   = i_pos;
     }
@@ -1257,8 +1388,8 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
      */
     if( tk->i_end < tk->i_start + p_sys->stream.i_offset + p_sys->stream.i_read_size )
     {
-        if( p_sys->stream.i_used < STREAM_READ_ATONCE / 2 )
-            p_sys->stream.i_used = STREAM_READ_ATONCE / 2;
+        if( p_sys->stream.i_used < tk->i_read_ahead )
+            p_sys->stream.i_used = tk->i_read_ahead;
 
         if( AStreamRefillStream( s ) && i_pos == tk->i_end )
             return VLC_EGENERIC;
@@ -1312,9 +1443,14 @@ static int AStreamReadNoSeekStream( stream_t *s, void *p_read, unsigned int i_re
 
         if( tk->i_end + i_data <= tk->i_start + p_sys->stream.i_offset + i_read )
         {
-            const unsigned i_read_requested = VLC_CLIP( i_read - i_data,
-                                                    STREAM_READ_ATONCE / 2,
-                                                    STREAM_READ_ATONCE * 10 );
+            /* The track is drained by a sequential reader, read further */
+            tk->i_read_ahead = __MIN( 2 * tk->i_read_ahead,
+                                      p_sys->stream.i_read_ahead_max );
+
+            const unsigned i_read_requested =
+                __MAX( VLC_CLIP( i_read - i_data, STREAM_READ_ATONCE / 2,
+                                 STREAM_READ_ATONCE * 10 ),
+                       tk->i_read_ahead );
 
             if( p_sys->stream.i_used < i_read_requested )
                 p_sys->stream.i_used = i_read_requested;
@@ -1345,6 +1481,8 @@ static int AStreamRefillStream( stream_t *s )
 
     if( i_toread <= 0 ) return VLC_EGENERIC; /* EOF */
 
+    AStreamMiss( p_sys );
+
 #ifdef STREAM_DEBUG
     msg_Dbg( s, "AStreamRefillStream: used=%d toread=%d",
                  p_sys->stream.i_used, i_toread );
@@ -1724,13 +1862,17 @@ static block_t *AReadBlock( stream_t *s, bool *pb_eof )
         if( p_input && p_block && libvlc_stats (p_access) )
         {
             uint64_t total;
+            size_t i_size;
+            int i_count;
 
+            /* The access may return a chain of blocks */
+            block_ChainProperties( p_block, &i_count, &i_size, NULL );
             vlc_mutex_lock( &p_input->p->counters.counters_lock );
             stats_Update( p_input->p->counters.p_read_bytes,
-                          p_block->i_buffer, &total );
+                          i_size, &total );
             stats_Update( p_input->p->counters.p_input_bitrate,
                           total, NULL );
-            stats_Update( p_input->p->counters.p_read_packets, 1, NULL );
+            stats_Update( p_input->p->counters.p_read_packets, i_count, NULL );
             vlc_mutex_unlock( &p_input->p->counters.counters_lock );
         }
         return p_block;
@@ -1765,12 +1907,15 @@ static block_t *AReadBlock( stream_t *s, bool *pb_eof )
         if( p_input )
         {
             uint64_t total;
+            size_t i_size;
+            int i_count;
 
+            block_ChainProperties( p_block, &i_count, &i_size, NULL );
             vlc_mutex_lock( &p_input->p->counters.counters_lock );
             stats_Update( p_input->p->counters.p_read_bytes,
-                          p_block->i_buffer, &total );
+                          i_size, &total );
             stats_Update( p_input->p->counters.p_input_bitrate, total, NULL );
-            stats_Update( p_input->p->counters.p_read_packets, 1 , NULL);
+            stats_Update( p_input->p->counters.p_read_packets, i_count, NULL );
             vlc_mutex_unlock( &p_input->p->counters.counters_lock );
         }
     }
@@ -1899,6 +2044,13 @@ block_t *stream_Block( stream_t *s, int i_size )
 {
     if( i_size <= 0 ) return NULL;
 
+    if( s->pf_read == AStreamReadBlock )
+    {
+        block_t *p_bk = AStreamSliceBlock( s, i_size );
+        if( p_bk )
+            return p_bk;
+    }
+
     /* emulate block read */
     block_t *p_bk = block_Alloc( i_size );
     if( p_bk )
@@ -0,0 +1,513 @@
+/*****************************************************************************
+ * thumbnail.c: keyframe thumbnails extraction without an input thread
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * The media is opened with a bare demuxer and an es_out of our own: only the
+ * first video ES gets a decoder, every other ES is discarded as soon as the
+ * demuxer sends it. For each requested time, the demuxer does a non precise
+ * seek (MP4, MKV and AVI then land on the keyframe found in their index) and
+ * only the first picture decoded after it is kept, so that no frame is
+ * decoded up to the exact time.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_input.h>
+#include <vlc_es_out.h>
+#include <vlc_codec.h>
+#include <vlc_image.h>
+#include <vlc_meta.h>
+#include <vlc_modules.h>
+
+#include "demux.h"
+#include "stream.h"
+#include "input_internal.h"
+
+/* Maximum number of video blocks sent to the decoder to get one picture */
+#define THUMBNAIL_MAX_BLOCKS (100)
+
+struct es_out_id_t
+{
+    int i_cat;
+};
+
+struct es_out_sys_t
+{
+    vlc_object_t *p_parent;
+
+    es_out_id_t  *p_video;      /* The only decoded ES */
+    decoder_t    *p_packetizer;
+    decoder_t    *p_decoder;
+
+    bool         b_discontinuity;
+    unsigned     i_blocks;
+    mtime_t      i_first_date;  /* Date of the first block since the seek */
+    picture_t    *p_picture;    /* First picture decoded since the seek */
+};
+
+/*****************************************************************************
+ * Decoder
+ *****************************************************************************/
+static picture_t *video_new_buffer( decoder_t *p_dec )
+{
+    p_dec->fmt_out.video.i_chroma = p_dec->fmt_out.i_codec;
+    return picture_NewFromFormat( &p_dec->fmt_out.video );
+}
+
+static void video_del_buffer( decoder_t *p_dec, picture_t *p_pic )
+{
+    (void)p_dec;
+    picture_Release( p_pic );
+}
+
+static void video_link_picture( decoder_t *p_dec, picture_t *p_pic )
+{
+    (void)p_dec;
+    picture_Hold( p_pic );
+}
+
+static void video_unlink_picture( decoder_t *p_dec, picture_t *p_pic )
+{
+    (void)p_dec;
+    picture_Release( p_pic );
+}
+
+static void DeleteDecoder( decoder_t *p_dec )
+{
+    if( p_dec->p_module )
+        module_unneed( p_dec, p_dec->p_module );
+
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+
+    if( p_dec->p_description )
+        vlc_meta_Delete( p_dec->p_description );
+
+    vlc_object_release( p_dec );
+}
+
+static decoder_t *CreateDecoder( vlc_object_t *p_this, const es_format_t *p_fmt,
+                                 bool b_packetizer )
+{
+    decoder_t *p_dec = vlc_custom_create( p_this, sizeof( *p_dec ),
+                                          b_packetizer ? "thumbnail packetizer"
+                                                       : "thumbnail decoder" );
+    if( p_dec == NULL )
+        return NULL;
+
+    p_dec->p_module = NULL;
+    es_format_Copy( &p_dec->fmt_in, p_fmt );
+    es_format_Init( &p_dec->fmt_out, VIDEO_ES, 0 );
+    p_dec->b_pace_control = true;
+
+    p_dec->pf_vout_buffer_new = video_new_buffer;
+    p_dec->pf_vout_buffer_del = video_del_buffer;
+    p_dec->pf_picture_link    = video_link_picture;
+    p_dec->pf_picture_unlink  = video_unlink_picture;
+
+    if( b_packetizer )
+    {
+        p_dec->fmt_in.b_packetized = false;
+        p_dec->p_module = module_need( p_dec, "packetizer", NULL, false );
+    }
+    else
+    {
+        /* Only the keyframes are needed: let avcodec skip the other ones */
+        var_Create( p_dec, "avcodec-skip-frame", VLC_VAR_INTEGER );
+        var_SetInteger( p_dec, "avcodec-skip-frame", 3 );
+
+        p_dec->p_module = module_need( p_dec, "decoder", "$codec", false );
+    }
+    if( !p_dec->p_module )
+    {
+        msg_Err( p_dec, "no suitable %s module for fourcc `%4.4s'",
+                 b_packetizer ? "packetizer" : "decoder",
+                 (char *)&p_dec->fmt_in.i_codec );
+        DeleteDecoder( p_dec );
+        return NULL;
+    }
+    return p_dec;
+}
+
+static void Decode( es_out_sys_t *p_sys, block_t *p_block )
+{
+    picture_t *p_pic;
+
+    while( (p_pic = p_sys->p_decoder->pf_decode_video( p_sys->p_decoder,
+                                                       &p_block )) != NULL )
+    {
+        if( p_sys->p_picture == NULL )
+            p_sys->p_picture = p_pic;
+        else
+            picture_Release( p_pic );
+    }
+}
+
+/*****************************************************************************
+ * ES out
+ *****************************************************************************/
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *p_fmt )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    es_out_id_t *p_es = malloc( sizeof( *p_es ) );
+    if( !p_es )
+        return NULL;
+    p_es->i_cat = p_fmt->i_cat;
+
+    if( p_fmt->i_cat != VIDEO_ES || p_sys->p_video != NULL )
+        return p_es;
+
+    if( !p_fmt->b_packetized )
+    {
+        p_sys->p_packetizer = CreateDecoder( p_sys->p_parent, p_fmt, true );
+        if( !p_sys->p_packetizer )
+            return p_es;
+        p_sys->p_decoder = CreateDecoder( p_sys->p_parent,
+                                          &p_sys->p_packetizer->fmt_out, false );
+    }
+    else
+        p_sys->p_decoder = CreateDecoder( p_sys->p_parent, p_fmt, false );
+
+    if( p_sys->p_decoder )
+        p_sys->p_video = p_es;
+    else if( p_sys->p_packetizer )
+    {
+        DeleteDecoder( p_sys->p_packetizer );
+        p_sys->p_packetizer = NULL;
+    }
+    return p_es;
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *p_es, block_t *p_block )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    /* Audio and subtitles are never decoded */
+    if( p_es != p_sys->p_video || p_sys->p_picture != NULL )
+    {
+        block_Release( p_block );
+        return VLC_SUCCESS;
+    }
+
+    if( p_sys->b_discontinuity )
+    {
+        p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+        p_sys->b_discontinuity = false;
+    }
+    if( p_sys->i_first_date <= VLC_TS_INVALID )
+        p_sys->i_first_date = p_block->i_dts > VLC_TS_INVALID ? p_block->i_dts
+                                                              : p_block->i_pts;
+    p_sys->i_blocks++;
+
+    if( p_sys->p_packetizer )
+    {
+        decoder_t *p_pack = p_sys->p_packetizer;
+        block_t *p_out;
+
+        while( (p_out = p_pack->pf_packetize( p_pack, &p_block )) != NULL )
+        {
+            if( p_pack->fmt_out.i_extra > 0 &&
+                p_sys->p_decoder->fmt_in.i_extra == 0 )
+            {
+                void *p_extra = malloc( p_pack->fmt_out.i_extra );
+                if( p_extra )
+                {
+                    memcpy( p_extra, p_pack->fmt_out.p_extra,
+                            p_pack->fmt_out.i_extra );
+                    p_sys->p_decoder->fmt_in.p_extra = p_extra;
+                    p_sys->p_decoder->fmt_in.i_extra = p_pack->fmt_out.i_extra;
+                }
+            }
+
+            while( p_out )
+            {
+                block_t *p_next = p_out->p_next;
+                p_out->p_next = NULL;
+                Decode( p_sys, p_out );
+                p_out = p_next;
+            }
+        }
+    }
+    else
+        Decode( p_sys, p_block );
+    return VLC_SUCCESS;
+}
+
+static void DeleteVideo( es_out_sys_t *p_sys )
+{
+    DeleteDecoder( p_sys->p_decoder );
+    if( p_sys->p_packetizer )
+        DeleteDecoder( p_sys->p_packetizer );
+    p_sys->p_decoder = NULL;
+    p_sys->p_packetizer = NULL;
+    p_sys->p_video = NULL;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *p_es )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( p_es == p_sys->p_video )
+        DeleteVideo( p_sys );
+    free( p_es );
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    switch( i_query )
+    {
+    case ES_OUT_GET_ES_STATE:
+    {
+        es_out_id_t *p_es = va_arg( args, es_out_id_t * );
+        bool *pb_selected = va_arg( args, bool * );
+
+        /* Let the demuxers which can skip unselected tracks do so */
+        *pb_selected = p_es == p_sys->p_video;
+        return VLC_SUCCESS;
+    }
+
+    case ES_OUT_SET_ES:
+    case ES_OUT_RESTART_ES:
+    case ES_OUT_SET_ES_DEFAULT:
+    case ES_OUT_SET_ES_STATE:
+    case ES_OUT_SET_GROUP:
+    case ES_OUT_SET_PCR:
+    case ES_OUT_SET_GROUP_PCR:
+    case ES_OUT_RESET_PCR:
+    case ES_OUT_SET_NEXT_DISPLAY_TIME:
+    case ES_OUT_SET_GROUP_META:
+    case ES_OUT_SET_GROUP_EPG:
+    case ES_OUT_DEL_GROUP:
+    case ES_OUT_SET_ES_SCRAMBLED_STATE:
+    case ES_OUT_SET_META:
+        return VLC_SUCCESS;
+
+    default:
+        return VLC_EGENERIC;
+    }
+}
+
+/*****************************************************************************
+ * Extraction
+ *****************************************************************************/
+static int Seek( demux_t *p_demux, mtime_t i_time )
+{
+    if( !demux_Control( p_demux, DEMUX_SET_TIME, i_time, false ) )
+        return VLC_SUCCESS;
+
+    /* Fall back to the position for the demuxers that only know about it */
+    int64_t i_length;
+    if( demux_Control( p_demux, DEMUX_GET_LENGTH, &i_length ) || i_length <= 0 )
+        return VLC_EGENERIC;
+
+    double f_position = (double)i_time / i_length;
+    if( f_position > 1.0 )
+        f_position = 1.0;
+    return demux_Control( p_demux, DEMUX_SET_POSITION, f_position, false );
+}
+
+/* It returns the first picture decoded from the current position, which the
+ * caller must release */
+static picture_t *GetPicture( demux_t *p_demux, es_out_sys_t *p_sys )
+{
+    /* A picture decoded before the seek */
+    if( p_sys->p_picture != NULL )
+        picture_Release( p_sys->p_picture );
+    p_sys->p_picture = NULL;
+    p_sys->i_blocks = 0;
+
+    while( p_sys->p_picture == NULL &&
+           p_sys->i_blocks < THUMBNAIL_MAX_BLOCKS )
+    {
+        if( demux_Demux( p_demux ) <= 0 )
+            break;
+    }
+
+    picture_t *p_pic = p_sys->p_picture;
+    p_sys->p_picture = NULL;
+    return p_pic;
+}
+
+/* It computes the largest size fitting in the requested box which keeps the
+ * display aspect ratio of the decoded video */
+static void FitSize( video_format_t *p_fmt, const video_format_t *p_src,
+                     const video_format_t *p_box )
+{
+    unsigned i_src_width = p_src->i_visible_width;
+    unsigned i_src_height = p_src->i_visible_height;
+    if( p_src->i_sar_num > 0 && p_src->i_sar_den > 0 )
+        i_src_width = (uint64_t)i_src_width * p_src->i_sar_num /
+                      p_src->i_sar_den;
+
+    unsigned i_width = p_box->i_width;
+    unsigned i_height = p_box->i_height;
+    if( i_width == 0 && i_height == 0 )
+    {
+        i_width = i_src_width;
+        i_height = i_src_height;
+    }
+    else if( i_height == 0 || (i_width != 0 &&
+             (uint64_t)i_width * i_src_height <=
+             (uint64_t)i_height * i_src_width) )
+        i_height = (uint64_t)i_width * i_src_height / i_src_width;
+    else
+        i_width = (uint64_t)i_height * i_src_width / i_src_height;
+
+    video_format_Setup( p_fmt, p_box->i_chroma, __MAX(i_width, 1),
+                        __MAX(i_height, 1), 1, 1 );
+    p_fmt->i_rmask = p_box->i_rmask;
+    p_fmt->i_gmask = p_box->i_gmask;
+    p_fmt->i_bmask = p_box->i_bmask;
+    video_format_FixRgb( p_fmt );
+}
+
+#undef input_GetThumbnails
+/**
+ * Extracts the video keyframes the nearest to the given times.
+ *
+ * The pictures are converted to the chroma of p_fmt and scaled to fit in
+ * its size, keeping the aspect ratio (a null dimension is computed from the
+ * other one, both null keep the video size). The date of each picture is the
+ * time of its keyframe in the media.
+ *
+ * \param pp_pictures array of i_count pictures, set to NULL for the times
+ * no picture could be extracted at
+ * \return VLC_SUCCESS if the media has a video track it could decode
+ */
+int input_GetThumbnails( vlc_object_t *p_parent, input_item_t *p_item,
+                         const mtime_t *pi_times, unsigned i_count,
+                         const video_format_t *p_fmt, picture_t **pp_pictures )
+{
+    for( unsigned i = 0; i < i_count; i++ )
+        pp_pictures[i] = NULL;
+
+    char *psz_uri = input_item_GetURI( p_item );
+    if( psz_uri == NULL )
+        return VLC_ENOMEM;
+
+    const char *psz_access, *psz_demux, *psz_path, *psz_anchor;
+    char *psz_dup = strdup( psz_uri );
+    if( psz_dup == NULL )
+    {
+        free( psz_uri );
+        return VLC_ENOMEM;
+    }
+    input_SplitMRL( &psz_access, &psz_demux, &psz_path, &psz_anchor, psz_dup );
+
+    int i_ret = VLC_EGENERIC;
+    stream_t *p_stream = stream_UrlNew( p_parent, psz_uri );
+    free( psz_uri );
+    if( p_stream == NULL )
+        goto error;
+
+    es_out_sys_t sys = {
+        .p_parent = p_parent,
+        .p_video = NULL,
+        .p_packetizer = NULL,
+        .p_decoder = NULL,
+        .b_discontinuity = false,
+        .i_blocks = 0,
+        .i_first_date = VLC_TS_INVALID,
+        .p_picture = NULL,
+    };
+    es_out_t out = {
+        .pf_add = EsOutAdd,
+        .pf_send = EsOutSend,
+        .pf_del = EsOutDel,
+        .pf_control = EsOutControl,
+        .pf_destroy = NULL,
+        .p_sys = &sys,
+    };
+
+    demux_t *p_demux = demux_New( p_parent, NULL, psz_access, psz_demux,
+                                  psz_path, p_stream, &out, false );
+    if( p_demux == NULL )
+    {
+        stream_Delete( p_stream );
+        goto error;
+    }
+    image_handler_t *p_image = image_HandlerCreate( p_parent );
+
+    /* Some demuxers only add their ES once they start demuxing */
+    if( sys.p_video == NULL )
+        demux_Demux( p_demux );
+
+    if( sys.p_video != NULL && p_image != NULL )
+    {
+        i_ret = VLC_SUCCESS;
+        for( unsigned i = 0; i < i_count; i++ )
+        {
+            if( sys.p_video == NULL || Seek( p_demux, pi_times[i] ) )
+                continue;
+            sys.b_discontinuity = true;
+            sys.i_first_date = VLC_TS_INVALID;
+
+            /* The dates of the blocks are in the time base of the demuxer
+             * (e.g. the PCR of TS and PS), not in media time */
+            int64_t i_time;
+            if( demux_Control( p_demux, DEMUX_GET_TIME, &i_time ) )
+                i_time = -1;
+
+            picture_t *p_pic = GetPicture( p_demux, &sys );
+            if( p_pic == NULL )
+            {
+                msg_Warn( p_parent, "no keyframe decoded near %"PRId64" ms",
+                          pi_times[i] / 1000 );
+                continue;
+            }
+
+            video_format_t fmt_in = sys.p_decoder->fmt_out.video;
+            video_format_t fmt_out;
+            FitSize( &fmt_out, &fmt_in, p_fmt );
+
+            pp_pictures[i] = image_Convert( p_image, p_pic, &fmt_in, &fmt_out );
+            if( pp_pictures[i] )
+            {
+                if( i_time >= 0 && p_pic->date > VLC_TS_INVALID &&
+                    sys.i_first_date > VLC_TS_INVALID )
+                    pp_pictures[i]->date = __MAX( i_time + p_pic->date
+                                                  - sys.i_first_date, 0 );
+                else
+                    pp_pictures[i]->date = pi_times[i];
+            }
+            picture_Release( p_pic );
+        }
+    }
+    else
+        msg_Err( p_parent, "no decodable video track" );
+
+    if( sys.p_picture != NULL )
+        picture_Release( sys.p_picture );
+    if( p_image )
+        image_HandlerDelete( p_image );
+    demux_Delete( p_demux );
+    stream_Delete( p_stream );
+    if( sys.p_video != NULL )
+        DeleteVideo( &sys );
+error:
+    free( psz_dup );
+    return i_ret;
+}
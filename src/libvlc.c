@@ -116,6 +116,7 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv->p_ml = NULL;
     priv->p_dialog_provider = NULL;
     priv->p_vlm = NULL;
+    priv->p_filter_slices = NULL;
     priv->i_verbose = 3; /* initial value until config is loaded */
 #if defined( HAVE_ISATTY ) && !defined( WIN32 )
     priv->b_color = isatty( STDERR_FILENO ); /* 2 is for stderr */
@@ -125,6 +126,7 @@ libvlc_int_t * libvlc_InternalCreate( void )
 
     /* Initialize mutexes */
     vlc_mutex_init( &priv->ml_lock );
+    vlc_mutex_init( &priv->filter_slices_lock );
     vlc_ExitInit( &priv->exit );
 
     return p_libvlc;
@@ -606,6 +608,9 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if( p_playlist != NULL )
         playlist_Destroy( p_playlist );
 
+    /* Stop the video filter threads, no filter can be running anymore */
+    filter_DeleteSlices( p_libvlc );
+
     msg_Dbg( p_libvlc, "removing stats" );
 
 #if !defined( WIN32 ) && !defined( __OS2__ )
@@ -654,6 +659,7 @@ void libvlc_InternalDestroy( libvlc_int_t *p_libvlc )
     /* Destroy mutexes */
     vlc_ExitDestroy( &priv->exit );
     vlc_mutex_destroy( &priv->ml_lock );
+    vlc_mutex_destroy( &priv->filter_slices_lock );
 
     assert( atomic_load(&(vlc_internals(p_libvlc)->refs)) == 1 );
     vlc_object_release( p_libvlc );
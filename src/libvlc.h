@@ -160,6 +160,10 @@ typedef struct libvlc_priv_t
     /* Interfaces */
     struct intf_thread_t *p_intf; ///< Interfaces linked-list
 
+    /* Video filters */
+    struct filter_slices_t *p_filter_slices; ///< slice threads (or NULL)
+    vlc_mutex_t        filter_slices_lock; ///< Mutex for slice threads creation
+
     /* Objects tree */
     vlc_mutex_t        structure_lock;
 
@@ -174,6 +178,7 @@ static inline libvlc_priv_t *libvlc_priv (libvlc_int_t *libvlc)
 
 void playlist_ServicesDiscoveryKillAll( playlist_t *p_playlist );
 void intf_DestroyAll( libvlc_int_t * );
+void filter_DeleteSlices( libvlc_int_t * );
 
 #define libvlc_stats( o ) (libvlc_priv((VLC_OBJECT(o))->p_libvlc)->b_stats)
 
@@ -39,6 +39,7 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include <vlc_atomic.h>
 
 /**
  * @section Block handling functions.
@@ -124,15 +125,297 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /* Maximum size of reserved footer before we release with realloc() */
 #define BLOCK_WASTE_SIZE   2048
 
+/**
+ * @section Block pool
+ *
+ * Small and medium blocks are carved out of power-of-two size classes and
+ * recycled instead of being handed back to the heap. Each thread keeps a
+ * small magazine of free blocks per size class, so that allocation and
+ * release usually do not need any lock. Magazines are refilled from, and
+ * drained to, a global depot, with a bounded amount of memory per class.
+ *
+ * Since a block may be released by another thread than the one that
+ * allocated it (e.g. input thread to decoder thread), blocks freely migrate
+ * through the depot. The depot is never torn down, as blocks may still be
+ * in use by other threads at exit: its bounded memory is left to the system.
+ */
+
+/* Smallest and largest pooled allocation (header and padding included) */
+#define BLOCK_POOL_MIN_SHIFT 9
+#define BLOCK_POOL_MAX_SHIFT 17
+#define BLOCK_POOL_CLASSES (BLOCK_POOL_MAX_SHIFT - BLOCK_POOL_MIN_SHIFT + 1)
+/* Maximum number of free blocks in a per-thread magazine */
+#define BLOCK_MAGAZINE_ROUNDS 32
+/* Maximum number of bytes cached per class by a magazine, and by the depot */
+#define BLOCK_MAGAZINE_BYTES (256 << 10)
+#define BLOCK_DEPOT_BYTES    (4 << 20)
+
+typedef struct
+{
+    unsigned count;
+    block_t *rounds[BLOCK_MAGAZINE_ROUNDS];
+} block_magazine_t;
+
+typedef struct
+{
+    block_magazine_t magazines[BLOCK_POOL_CLASSES];
+    /* Counters not yet published to the depot */
+    uint64_t hits;
+    uint64_t misses;
+} block_cache_t;
+
+static struct
+{
+    vlc_mutex_t lock;
+    block_t *list[BLOCK_POOL_CLASSES];
+    size_t count[BLOCK_POOL_CLASSES];
+    uint64_t hits;
+    uint64_t misses;
+    vlc_threadvar_t key;
+} depot = { .lock = VLC_STATIC_MUTEX, };
+
+static atomic_bool depot_ready = ATOMIC_VAR_INIT(false);
+
+static unsigned block_pool_Rounds (unsigned cls)
+{
+    unsigned rounds = BLOCK_MAGAZINE_BYTES >> (cls + BLOCK_POOL_MIN_SHIFT);
+
+    if (rounds > BLOCK_MAGAZINE_ROUNDS)
+        rounds = BLOCK_MAGAZINE_ROUNDS;
+    if (rounds < 2)
+        rounds = 2;
+    return rounds;
+}
+
+static size_t block_depot_Max (unsigned cls)
+{
+    return BLOCK_DEPOT_BYTES >> (cls + BLOCK_POOL_MIN_SHIFT);
+}
+
+/**
+ * Returns the size class for an allocation of the given size,
+ * or BLOCK_POOL_CLASSES if the allocation is too large to be pooled.
+ */
+static unsigned block_pool_Class (size_t alloc)
+{
+    if (alloc <= (1 << BLOCK_POOL_MIN_SHIFT))
+        return 0;
+    if (alloc > (1 << BLOCK_POOL_MAX_SHIFT))
+        return BLOCK_POOL_CLASSES;
+
+    unsigned shift = (sizeof (unsigned) * 8) - clz (alloc - 1);
+    return shift - BLOCK_POOL_MIN_SHIFT;
+}
+
+/* Must be called with the depot lock held */
+static void block_depot_Push (unsigned cls, block_t *block)
+{
+    if (depot.count[cls] >= block_depot_Max (cls))
+    {
+        free (block);
+        return;
+    }
+    block->p_next = depot.list[cls];
+    depot.list[cls] = block;
+    depot.count[cls]++;
+}
+
+/* Must be called with the depot lock held */
+static void block_cache_Publish (block_cache_t *cache)
+{
+    depot.hits += cache->hits;
+    depot.misses += cache->misses;
+    cache->hits = cache->misses = 0;
+}
+
+static void block_cache_Destroy (void *data)
+{
+    block_cache_t *cache = data;
+
+    vlc_mutex_lock (&depot.lock);
+    for (unsigned cls = 0; cls < BLOCK_POOL_CLASSES; cls++)
+    {
+        block_magazine_t *mag = &cache->magazines[cls];
+
+        while (mag->count > 0)
+            block_depot_Push (cls, mag->rounds[--mag->count]);
+    }
+    block_cache_Publish (cache);
+    vlc_mutex_unlock (&depot.lock);
+    free (cache);
+}
+
+/**
+ * Gets the block cache of the calling thread, creating it if needed.
+ * @return the cache, or NULL on error (the depot is then used directly).
+ */
+static block_cache_t *block_cache_Get (void)
+{
+    if (unlikely(!atomic_load_explicit (&depot_ready, memory_order_acquire)))
+    {
+        bool ok;
+
+        vlc_mutex_lock (&depot.lock);
+        ok = atomic_load_explicit (&depot_ready, memory_order_relaxed);
+        if (!ok
+         && vlc_threadvar_create (&depot.key, block_cache_Destroy) == 0)
+        {
+            atomic_store_explicit (&depot_ready, true, memory_order_release);
+            ok = true;
+        }
+        vlc_mutex_unlock (&depot.lock);
+        if (!ok)
+            return NULL;
+    }
+
+    block_cache_t *cache = vlc_threadvar_get (depot.key);
+    if (likely(cache != NULL))
+        return cache;
+
+    cache = calloc (1, sizeof (*cache));
+    if (unlikely(cache == NULL))
+        return NULL;
+    if (vlc_threadvar_set (depot.key, cache))
+    {
+        free (cache);
+        return NULL;
+    }
+    return cache;
+}
+
+static block_t *block_pool_Get (unsigned cls)
+{
+    block_cache_t *cache = block_cache_Get ();
+    block_t *block = NULL;
+
+    if (likely(cache != NULL))
+    {
+        block_magazine_t *mag = &cache->magazines[cls];
+
+        if (likely(mag->count > 0))
+        {
+            cache->hits++;
+            return mag->rounds[--mag->count];
+        }
+
+        /* Empty magazine: refill half of it from the depot */
+        unsigned want = block_pool_Rounds (cls) / 2;
+
+        vlc_mutex_lock (&depot.lock);
+        while (mag->count < want && depot.list[cls] != NULL)
+        {
+            block_t *b = depot.list[cls];
+
+            depot.list[cls] = b->p_next;
+            depot.count[cls]--;
+            mag->rounds[mag->count++] = b;
+        }
+        block_cache_Publish (cache);
+        vlc_mutex_unlock (&depot.lock);
+
+        if (mag->count > 0)
+        {
+            cache->hits++;
+            return mag->rounds[--mag->count];
+        }
+        cache->misses++;
+    }
+    else
+    {
+        vlc_mutex_lock (&depot.lock);
+        block = depot.list[cls];
+        if (block != NULL)
+        {
+            depot.list[cls] = block->p_next;
+            depot.count[cls]--;
+            depot.hits++;
+        }
+        else
+            depot.misses++;
+        vlc_mutex_unlock (&depot.lock);
+    }
+
+    if (block == NULL)
+        block = malloc (1 << (cls + BLOCK_POOL_MIN_SHIFT));
+    return block;
+}
+
+static void block_pool_Release (block_t *block)
+{
+    /* That is always true for blocks allocated with block_Alloc(). */
+    assert (block->p_start == (unsigned char *)(block + 1));
+    block_Invalidate (block);
+
+    unsigned cls = block_pool_Class (sizeof (*block) + block->i_size);
+    assert (cls < BLOCK_POOL_CLASSES);
+
+    block_cache_t *cache = block_cache_Get ();
+    if (likely(cache != NULL))
+    {
+        block_magazine_t *mag = &cache->magazines[cls];
+        unsigned rounds = block_pool_Rounds (cls);
+
+        if (likely(mag->count < rounds))
+        {
+            mag->rounds[mag->count++] = block;
+            return;
+        }
+
+        /* Full magazine: drain half of it to the depot */
+        vlc_mutex_lock (&depot.lock);
+        while (mag->count > rounds / 2)
+            block_depot_Push (cls, mag->rounds[--mag->count]);
+        block_cache_Publish (cache);
+        vlc_mutex_unlock (&depot.lock);
+        mag->rounds[mag->count++] = block;
+    }
+    else
+    {
+        vlc_mutex_lock (&depot.lock);
+        block_depot_Push (cls, block);
+        vlc_mutex_unlock (&depot.lock);
+    }
+}
+
+/**
+ * Reads the block pool usage counters.
+ * A hit is an allocation served from recycled memory, a miss one that had to
+ * go to the heap. Allocations too large to be pooled are not counted.
+ * Counters of each thread are published in batches, so the values lag
+ * slightly behind.
+ */
+void block_PoolStats (uint64_t *restrict hits, uint64_t *restrict misses)
+{
+    vlc_mutex_lock (&depot.lock);
+    *hits = depot.hits;
+    *misses = depot.misses;
+    vlc_mutex_unlock (&depot.lock);
+}
+
 block_t *block_Alloc (size_t size)
 {
     /* 2 * BLOCK_PADDING: pre + post padding */
-    const size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
+    size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
                        + size;
     if (unlikely(alloc <= size))
         return NULL;
 
-    block_t *b = malloc (alloc);
+    block_t *b;
+    block_free_t release;
+    unsigned cls = block_pool_Class (alloc);
+
+    if (likely(cls < BLOCK_POOL_CLASSES))
+    {
+        b = block_pool_Get (cls);
+        /* Leave any extra room of the size class as footer */
+        alloc = 1 << (cls + BLOCK_POOL_MIN_SHIFT);
+        release = block_pool_Release;
+    }
+    else
+    {
+        b = malloc (alloc);
+        release = block_generic_Release;
+    }
     if (unlikely(b == NULL))
         return NULL;
 
@@ -142,10 +425,26 @@ block_t *block_Alloc (size_t size)
     b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
     b->p_buffer = (void *)(((uintptr_t)b->p_buffer) & ~(BLOCK_ALIGN - 1));
     b->i_buffer = size;
-    b->pf_release = block_generic_Release;
+    b->pf_release = release;
     return b;
 }
 
+/**
+ * Tells whether a pooled block would be reallocated from its own size class
+ * for the given size. The slack of the class is then not worth releasing.
+ */
+static bool block_pool_SameClass (const block_t *block, size_t size)
+{
+    if (block->pf_release != block_pool_Release)
+        return false;
+
+    size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
+                       + size;
+    return alloc > size
+        && block_pool_Class (alloc)
+               == block_pool_Class (sizeof (*block) + block->i_size);
+}
+
 block_t *block_Realloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
 {
     size_t requested = i_prebody + i_body;
@@ -225,7 +524,8 @@ block_t *block_Realloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
     else
     /* We have a very large reserved footer now? Release some of it.
      * XXX it might not preserve the alignment of p_buffer */
-    if( p_end - (p_block->p_buffer + i_body) > BLOCK_WASTE_SIZE )
+    if( p_end - (p_block->p_buffer + i_body) > BLOCK_WASTE_SIZE
+     && !block_pool_SameClass( p_block, requested ) )
     {
         block_t *p_rea = block_Alloc( requested );
         if( p_rea )
@@ -292,6 +592,106 @@ block_t *block_heap_Alloc (void *addr, size_t length)
     return block;
 }
 
+typedef struct
+{
+    block_t     self;
+    block_t    *original;
+    atomic_uint refs;
+} block_shared_t;
+
+typedef struct
+{
+    block_t         self;
+    block_shared_t *shared;
+} block_slice_t;
+
+static void block_shared_Unref (block_shared_t *sh)
+{
+    if (atomic_fetch_sub (&sh->refs, 1) == 1)
+    {
+        block_Release (sh->original);
+        free (sh);
+    }
+}
+
+static void block_shared_Release (block_t *block)
+{
+    block_Invalidate (block);
+    block_shared_Unref ((block_shared_t *)block);
+}
+
+/**
+ * Makes a block shareable with block_shared_Slice().
+ *
+ * The returned block has the same payload and properties as the original.
+ * The original block is only released when the returned block and all the
+ * slices taken from it have been released.
+ *
+ * @param block block to make shareable (will be released on error)
+ * @return NULL on error, or a new block.
+ */
+block_t *block_shared_Alloc (block_t *block)
+{
+    block_shared_t *sh = malloc (sizeof (*sh));
+    if (unlikely(sh == NULL))
+    {
+        block_Release (block);
+        return NULL;
+    }
+
+    block_Init (&sh->self, block->p_start, block->i_size);
+    BlockMetaCopy (&sh->self, block);
+    sh->self.p_next = NULL;
+    sh->self.p_buffer = block->p_buffer;
+    sh->self.i_buffer = block->i_buffer;
+    sh->self.pf_release = block_shared_Release;
+    sh->original = block;
+    block->p_next = NULL;
+    atomic_init (&sh->refs, 1);
+    return &sh->self;
+}
+
+static void block_slice_Release (block_t *block)
+{
+    block_slice_t *slice = (block_slice_t *)block;
+
+    block_Invalidate (block);
+    block_shared_Unref (slice->shared);
+    free (slice);
+}
+
+/**
+ * Creates a block referring to part of the payload of a shareable block
+ * (see block_shared_Alloc()), without copying the data.
+ *
+ * @note The payload memory is common to the block and all its slices. The
+ * caller must make sure that nothing will read a range of the payload that
+ * the slice owner might modify.
+ *
+ * @param block shareable block (it is not modified)
+ * @param offset offset of the slice from the start of the payload
+ * @param length slice length in bytes
+ * @return NULL if the block is not shareable or on error, or a new block.
+ */
+block_t *block_shared_Slice (block_t *block, size_t offset, size_t length)
+{
+    if (block->pf_release != block_shared_Release)
+        return NULL;
+    assert (offset <= block->i_buffer && length <= block->i_buffer - offset);
+
+    block_slice_t *slice = malloc (sizeof (*slice));
+    if (unlikely(slice == NULL))
+        return NULL;
+
+    block_shared_t *sh = (block_shared_t *)block;
+
+    block_Init (&slice->self, block->p_buffer + offset, length);
+    slice->self.pf_release = block_slice_Release;
+    slice->shared = sh;
+    atomic_fetch_add (&sh->refs, 1);
+    return &slice->self;
+}
+
 #ifdef HAVE_MMAP
 # include <sys/mman.h>
 
@@ -455,6 +855,31 @@ block_t *block_FilePath (const char *path)
  * @section Thread-safe block queue functions
  */
 
+/**
+ * Lock-free ring for single producer, single consumer queues.
+ *
+ * The producer owns the tail index and the consumer owns the head index.
+ * When the ring is full, blocks are queued on the locked list of the FIFO
+ * instead, and the producer keeps using that list until the consumer has
+ * drained it, so that ordering is preserved.
+ *
+ * The FIFO lock and condition variables are only used when one side needs
+ * to sleep (empty queue for the consumer, block_FifoPace() for the producer).
+ */
+typedef struct
+{
+    vlc_mutex_t   consumer; /**< Serializes dequeuing with block_FifoEmpty() */
+    atomic_size_t head; /**< Next slot to read (written by the consumer) */
+    atomic_size_t tail; /**< Next slot to write (written by the producer) */
+    atomic_size_t depth;
+    atomic_size_t size;
+    atomic_size_t overflow; /**< Blocks on the locked list */
+    atomic_bool   reader_waiting;
+    atomic_bool   writer_waiting;
+    size_t        mask;
+    block_t      *slots[];
+} block_ring_t;
+
 /**
  * Internal state for block queues
  */
@@ -469,6 +894,8 @@ struct block_fifo_t
     size_t              i_depth;
     size_t              i_size;
     bool          b_force_wake;
+
+    block_ring_t        *p_ring; /**< Lock-free ring (SPSC mode only) */
 };
 
 block_fifo_t *block_FifoNew( void )
@@ -484,13 +911,194 @@ block_fifo_t *block_FifoNew( void )
     p_fifo->pp_last = &p_fifo->p_first;
     p_fifo->i_depth = p_fifo->i_size = 0;
     p_fifo->b_force_wake = false;
+    p_fifo->p_ring = NULL;
+
+    return p_fifo;
+}
+
+/**
+ * Creates a FIFO for exactly one producer and one consumer thread.
+ *
+ * Blocks are handed over through a lock-free ring, so that block_FifoPut()
+ * and block_FifoGet() only need a few atomic operations unless the consumer
+ * has to sleep. The API is the same as for block_FifoNew(), with the
+ * following restrictions:
+ *  - only one thread may call block_FifoPut() and block_FifoPace(),
+ *  - only one thread may call block_FifoGet() and block_FifoShow().
+ * block_FifoEmpty(), block_FifoWake(), block_FifoCount() and block_FifoSize()
+ * can be called from either of those threads.
+ *
+ * @param slots ring size in blocks (rounded up to a power of two);
+ * the FIFO is not bounded, if the ring is full, blocks are queued on a
+ * slower locked list.
+ */
+block_fifo_t *block_FifoNewSPSC( size_t slots )
+{
+    if( slots < 2 )
+        slots = 2;
+    if( slots > (SIZE_MAX >> 1) / sizeof( block_t * ) )
+        return NULL;
+    while( slots & (slots - 1) )
+        slots = (slots | (slots - 1)) + 1;
 
+    block_ring_t *ring = malloc( sizeof( *ring )
+                                 + slots * sizeof( ring->slots[0] ) );
+    if( unlikely(ring == NULL) )
+        return NULL;
+
+    block_fifo_t *p_fifo = block_FifoNew();
+    if( unlikely(p_fifo == NULL) )
+    {
+        free( ring );
+        return NULL;
+    }
+
+    vlc_mutex_init( &ring->consumer );
+    atomic_init( &ring->head, 0 );
+    atomic_init( &ring->tail, 0 );
+    atomic_init( &ring->depth, 0 );
+    atomic_init( &ring->size, 0 );
+    atomic_init( &ring->overflow, 0 );
+    atomic_init( &ring->reader_waiting, false );
+    atomic_init( &ring->writer_waiting, false );
+    ring->mask = slots - 1;
+    p_fifo->p_ring = ring;
     return p_fifo;
 }
 
+static bool block_RingIsEmpty( block_ring_t *ring )
+{
+    return atomic_load( &ring->head ) == atomic_load( &ring->tail )
+        && atomic_load( &ring->overflow ) == 0;
+}
+
+/* Producer side */
+static void block_RingPush( block_fifo_t *p_fifo, block_t *p_block )
+{
+    block_ring_t *ring = p_fifo->p_ring;
+    size_t tail = atomic_load_explicit( &ring->tail, memory_order_relaxed );
+    size_t head = atomic_load_explicit( &ring->head, memory_order_acquire );
+
+    if( likely(atomic_load( &ring->overflow ) == 0)
+     && tail - head <= ring->mask )
+    {
+        ring->slots[tail & ring->mask] = p_block;
+        atomic_store_explicit( &ring->tail, tail + 1, memory_order_release );
+        return;
+    }
+
+    /* Ring full (or not drained yet): use the locked list */
+    vlc_mutex_lock( &p_fifo->lock );
+    *p_fifo->pp_last = p_block;
+    p_fifo->pp_last = &p_block->p_next;
+    atomic_fetch_add( &ring->overflow, 1 );
+    vlc_mutex_unlock( &p_fifo->lock );
+}
+
+/* Consumer side, with the consumer lock held */
+static block_t *block_RingPop( block_fifo_t *p_fifo, bool remove )
+{
+    block_ring_t *ring = p_fifo->p_ring;
+    size_t head = atomic_load_explicit( &ring->head, memory_order_relaxed );
+    size_t tail = atomic_load_explicit( &ring->tail, memory_order_acquire );
+    block_t *b = NULL;
+
+    if( head == tail && atomic_load( &ring->overflow ) != 0 )
+    {
+        vlc_mutex_lock( &p_fifo->lock );
+        /* Blocks in the ring are older than those on the list. They might
+         * not have been visible without the lock. */
+        tail = atomic_load_explicit( &ring->tail, memory_order_acquire );
+        if( head == tail )
+        {
+            b = p_fifo->p_first;
+            assert( b != NULL );
+            if( remove )
+            {
+                p_fifo->p_first = b->p_next;
+                if( p_fifo->p_first == NULL )
+                    p_fifo->pp_last = &p_fifo->p_first;
+                atomic_fetch_sub( &ring->overflow, 1 );
+            }
+        }
+        vlc_mutex_unlock( &p_fifo->lock );
+    }
+
+    if( b == NULL )
+    {
+        if( head == tail )
+            return NULL;
+
+        b = ring->slots[head & ring->mask];
+        if( remove )
+            atomic_store_explicit( &ring->head, head + 1,
+                                   memory_order_release );
+    }
+
+    if( remove )
+    {
+        atomic_fetch_sub( &ring->depth, 1 );
+        atomic_fetch_sub( &ring->size, b->i_buffer );
+        b->p_next = NULL;
+
+        /* Wake up block_FifoPace() if needed */
+        atomic_thread_fence( memory_order_seq_cst );
+        if( atomic_load( &ring->writer_waiting ) )
+        {
+            vlc_mutex_lock( &p_fifo->lock );
+            vlc_cond_broadcast( &p_fifo->wait_room );
+            vlc_mutex_unlock( &p_fifo->lock );
+        }
+    }
+    return b;
+}
+
+/* Consumer side: sleeps until the queue is not empty, or is woken up */
+static bool block_RingWait( block_fifo_t *p_fifo, bool remove )
+{
+    block_ring_t *ring = p_fifo->p_ring;
+
+    vlc_mutex_lock( &p_fifo->lock );
+    mutex_cleanup_push( &p_fifo->lock );
+    atomic_store( &ring->reader_waiting, true );
+    while( block_RingIsEmpty( ring ) && !p_fifo->b_force_wake )
+        vlc_cond_wait( &p_fifo->wait, &p_fifo->lock );
+    atomic_store( &ring->reader_waiting, false );
+    vlc_cleanup_pop();
+
+    bool woken = remove && p_fifo->b_force_wake;
+    if( woken )
+        p_fifo->b_force_wake = false;
+    vlc_mutex_unlock( &p_fifo->lock );
+    return woken;
+}
+
+static block_t *block_RingGet( block_fifo_t *p_fifo, bool remove )
+{
+    block_ring_t *ring = p_fifo->p_ring;
+    block_t *b;
+    bool woken = false;
+
+    for( ;; )
+    {
+        vlc_mutex_lock( &ring->consumer );
+        b = block_RingPop( p_fifo, remove );
+        vlc_mutex_unlock( &ring->consumer );
+
+        if( b != NULL || woken )
+            return b;
+        woken = block_RingWait( p_fifo, remove );
+    }
+}
+
 void block_FifoRelease( block_fifo_t *p_fifo )
 {
     block_FifoEmpty( p_fifo );
+    if( p_fifo->p_ring != NULL )
+    {
+        vlc_mutex_destroy( &p_fifo->p_ring->consumer );
+        free( p_fifo->p_ring );
+    }
     vlc_cond_destroy( &p_fifo->wait_room );
     vlc_cond_destroy( &p_fifo->wait );
     vlc_mutex_destroy( &p_fifo->lock );
@@ -501,6 +1109,18 @@ void block_FifoEmpty( block_fifo_t *p_fifo )
 {
     block_t *block;
 
+    if( p_fifo->p_ring != NULL )
+    {
+        block_ring_t *ring = p_fifo->p_ring;
+        block_t **pp_last = &block;
+
+        vlc_mutex_lock( &ring->consumer );
+        while( (*pp_last = block_RingPop( p_fifo, true )) != NULL )
+            pp_last = &(*pp_last)->p_next;
+        vlc_mutex_unlock( &ring->consumer );
+        goto release;
+    }
+
     vlc_mutex_lock( &p_fifo->lock );
     block = p_fifo->p_first;
     if (block != NULL)
@@ -512,6 +1132,7 @@ void block_FifoEmpty( block_fifo_t *p_fifo )
     vlc_cond_broadcast( &p_fifo->wait_room );
     vlc_mutex_unlock( &p_fifo->lock );
 
+release:
     while (block != NULL)
     {
         block_t *buf;
@@ -543,6 +1164,21 @@ void block_FifoPace (block_fifo_t *fifo, size_t max_depth, size_t max_size)
 {
     vlc_testcancel ();
 
+    if (fifo->p_ring != NULL)
+    {
+        block_ring_t *ring = fifo->p_ring;
+
+        vlc_mutex_lock (&fifo->lock);
+        mutex_cleanup_push (&fifo->lock);
+        atomic_store (&ring->writer_waiting, true);
+        while ((atomic_load (&ring->depth) > max_depth)
+            || (atomic_load (&ring->size) > max_size))
+            vlc_cond_wait (&fifo->wait_room, &fifo->lock);
+        atomic_store (&ring->writer_waiting, false);
+        vlc_cleanup_run ();
+        return;
+    }
+
     vlc_mutex_lock (&fifo->lock);
     while ((fifo->i_depth > max_depth) || (fifo->i_size > max_size))
     {
@@ -574,6 +1210,32 @@ size_t block_FifoPut( block_fifo_t *p_fifo, block_t *p_block )
             break;
     }
 
+    if (p_fifo->p_ring != NULL)
+    {
+        block_ring_t *ring = p_fifo->p_ring;
+
+        /* Account before publishing, so the consumer never underflows */
+        atomic_fetch_add (&ring->depth, i_depth);
+        atomic_fetch_add (&ring->size, i_size);
+        while (p_block != NULL)
+        {
+            block_t *p_next = p_block->p_next;
+
+            p_block->p_next = NULL;
+            block_RingPush (p_fifo, p_block);
+            p_block = p_next;
+        }
+
+        atomic_thread_fence (memory_order_seq_cst);
+        if (atomic_load (&ring->reader_waiting))
+        {
+            vlc_mutex_lock (&p_fifo->lock);
+            vlc_cond_signal (&p_fifo->wait);
+            vlc_mutex_unlock (&p_fifo->lock);
+        }
+        return i_size;
+    }
+
     vlc_mutex_lock (&p_fifo->lock);
     *p_fifo->pp_last = p_block;
     p_fifo->pp_last = &p_last->p_next;
@@ -589,7 +1251,8 @@ size_t block_FifoPut( block_fifo_t *p_fifo, block_t *p_block )
 void block_FifoWake( block_fifo_t *p_fifo )
 {
     vlc_mutex_lock( &p_fifo->lock );
-    if( p_fifo->p_first == NULL )
+    if( p_fifo->p_ring != NULL ? block_RingIsEmpty( p_fifo->p_ring )
+                               : p_fifo->p_first == NULL )
         p_fifo->b_force_wake = true;
     vlc_cond_broadcast( &p_fifo->wait );
     vlc_mutex_unlock( &p_fifo->lock );
@@ -607,6 +1270,9 @@ block_t *block_FifoGet( block_fifo_t *p_fifo )
 
     vlc_testcancel( );
 
+    if( p_fifo->p_ring != NULL )
+        return block_RingGet( p_fifo, true );
+
     vlc_mutex_lock( &p_fifo->lock );
     mutex_cleanup_push( &p_fifo->lock );
 
@@ -660,6 +1326,9 @@ block_t *block_FifoShow( block_fifo_t *p_fifo )
 
     vlc_testcancel( );
 
+    if( p_fifo->p_ring != NULL )
+        return block_RingGet( p_fifo, false );
+
     vlc_mutex_lock( &p_fifo->lock );
     mutex_cleanup_push( &p_fifo->lock );
 
@@ -675,11 +1344,15 @@ block_t *block_FifoShow( block_fifo_t *p_fifo )
 /* FIXME: not thread-safe */
 size_t block_FifoSize( const block_fifo_t *p_fifo )
 {
+    if( p_fifo->p_ring != NULL )
+        return atomic_load( &p_fifo->p_ring->size );
     return p_fifo->i_size;
 }
 
 /* FIXME: not thread-safe */
 size_t block_FifoCount( const block_fifo_t *p_fifo )
 {
+    if( p_fifo->p_ring != NULL )
+        return atomic_load( &p_fifo->p_ring->depth );
     return p_fifo->i_depth;
 }
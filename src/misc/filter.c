@@ -111,6 +111,193 @@ void filter_DeleteBlend( filter_t *p_blend )
     vlc_object_release( p_blend );
 }
 
+/*****************************************************************************
+ * Slice threads
+ *****************************************************************************
+ * They are shared by all the filters of a libvlc instance. The thread
+ * calling filter_RunSlices() processes slices too, so a job always
+ * completes even when all the other threads are busy with another one.
+ *****************************************************************************/
+typedef struct filter_slices_job_t filter_slices_job_t;
+struct filter_slices_job_t
+{
+    filter_slices_job_t *p_next;
+
+    filter_t        *p_filter;
+    filter_slice_cb pf_slice;
+    void            *p_data;
+
+    unsigned        i_slices;
+    unsigned        i_next;    /* Next slice to start */
+    unsigned        i_pending; /* Slices not done yet */
+};
+
+typedef struct filter_slices_t
+{
+    vlc_mutex_t         lock;
+    vlc_cond_t          wait; /* A job was queued or we are closing */
+    vlc_cond_t          done; /* A job was completed */
+    filter_slices_job_t *p_first;
+    bool                b_closing;
+
+    unsigned            i_threads;
+    vlc_thread_t        threads[];
+} filter_slices_t;
+
+/* It runs the next slice of the given job, with the lock held */
+static void SlicesRunNext( filter_slices_t *p_slices, filter_slices_job_t *p_job )
+{
+    const unsigned i_slice = p_job->i_next++;
+
+    if( p_job->i_next >= p_job->i_slices )
+    {
+        /* Every slice is started: unqueue the job */
+        filter_slices_job_t **pp_job = &p_slices->p_first;
+        while( *pp_job != p_job )
+            pp_job = &(*pp_job)->p_next;
+        *pp_job = p_job->p_next;
+    }
+    vlc_mutex_unlock( &p_slices->lock );
+
+    p_job->pf_slice( p_job->p_filter, p_job->p_data, i_slice, p_job->i_slices );
+
+    vlc_mutex_lock( &p_slices->lock );
+    if( --p_job->i_pending == 0 )
+        vlc_cond_broadcast( &p_slices->done );
+}
+
+static void *SlicesThread( void *p_data )
+{
+    filter_slices_t *p_slices = p_data;
+
+    vlc_mutex_lock( &p_slices->lock );
+    for( ;; )
+    {
+        while( !p_slices->p_first && !p_slices->b_closing )
+            vlc_cond_wait( &p_slices->wait, &p_slices->lock );
+        if( !p_slices->p_first )
+            break;
+        SlicesRunNext( p_slices, p_slices->p_first );
+    }
+    vlc_mutex_unlock( &p_slices->lock );
+    return NULL;
+}
+
+static filter_slices_t *SlicesNew( vlc_object_t *p_obj )
+{
+    int i_threads = var_InheritInteger( p_obj, "filter-threads" );
+    if( i_threads <= 0 )
+        i_threads = vlc_GetCPUCount();
+
+    /* The calling thread does its share of the work */
+    const unsigned i_workers = i_threads > 1 ? i_threads - 1 : 0;
+
+    filter_slices_t *p_slices = malloc( sizeof(*p_slices) +
+                                        i_workers * sizeof(vlc_thread_t) );
+    if( !p_slices )
+        return NULL;
+
+    vlc_mutex_init( &p_slices->lock );
+    vlc_cond_init( &p_slices->wait );
+    vlc_cond_init( &p_slices->done );
+    p_slices->p_first   = NULL;
+    p_slices->b_closing = false;
+    p_slices->i_threads = 0;
+
+    while( p_slices->i_threads < i_workers )
+    {
+        if( vlc_clone( &p_slices->threads[p_slices->i_threads], SlicesThread,
+                       p_slices, VLC_THREAD_PRIORITY_VIDEO ) )
+            break;
+        p_slices->i_threads++;
+    }
+    msg_Dbg( p_obj, "using %u video filter thread(s)", p_slices->i_threads + 1 );
+    return p_slices;
+}
+
+static filter_slices_t *SlicesGet( filter_t *p_filter )
+{
+    libvlc_priv_t *p_priv = libvlc_priv( p_filter->p_libvlc );
+
+    vlc_mutex_lock( &p_priv->filter_slices_lock );
+    if( !p_priv->p_filter_slices )
+        p_priv->p_filter_slices = SlicesNew( VLC_OBJECT(p_filter->p_libvlc) );
+    filter_slices_t *p_slices = p_priv->p_filter_slices;
+    vlc_mutex_unlock( &p_priv->filter_slices_lock );
+
+    return p_slices;
+}
+
+void filter_DeleteSlices( libvlc_int_t *p_libvlc )
+{
+    filter_slices_t *p_slices = libvlc_priv( p_libvlc )->p_filter_slices;
+    if( !p_slices )
+        return;
+
+    vlc_mutex_lock( &p_slices->lock );
+    p_slices->b_closing = true;
+    vlc_cond_broadcast( &p_slices->wait );
+    vlc_mutex_unlock( &p_slices->lock );
+
+    for( unsigned i = 0; i < p_slices->i_threads; i++ )
+        vlc_join( p_slices->threads[i], NULL );
+
+    vlc_cond_destroy( &p_slices->done );
+    vlc_cond_destroy( &p_slices->wait );
+    vlc_mutex_destroy( &p_slices->lock );
+    free( p_slices );
+    libvlc_priv( p_libvlc )->p_filter_slices = NULL;
+}
+
+unsigned filter_GetSlices( filter_t *p_filter )
+{
+    filter_slices_t *p_slices = SlicesGet( p_filter );
+
+    return p_slices ? p_slices->i_threads + 1 : 1;
+}
+
+void filter_RunSlices( filter_t *p_filter, unsigned i_slices,
+                       filter_slice_cb pf_slice, void *p_data )
+{
+    filter_slices_t *p_slices = i_slices > 1 ? SlicesGet( p_filter ) : NULL;
+
+    if( !p_slices || p_slices->i_threads == 0 )
+    {
+        for( unsigned i = 0; i < i_slices; i++ )
+            pf_slice( p_filter, p_data, i, i_slices );
+        return;
+    }
+
+    filter_slices_job_t job = {
+        .p_next    = NULL,
+        .p_filter  = p_filter,
+        .pf_slice  = pf_slice,
+        .p_data    = p_data,
+        .i_slices  = i_slices,
+        .i_next    = 0,
+        .i_pending = i_slices,
+    };
+
+    /* The filters run from threads that may be cancelled, but the job lives
+     * on our stack: we must wait for it whatever happens. */
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock( &p_slices->lock );
+    filter_slices_job_t **pp_last = &p_slices->p_first;
+    while( *pp_last )
+        pp_last = &(*pp_last)->p_next;
+    *pp_last = &job;
+    vlc_cond_broadcast( &p_slices->wait );
+
+    while( job.i_next < job.i_slices )
+        SlicesRunNext( p_slices, &job );
+    while( job.i_pending > 0 )
+        vlc_cond_wait( &p_slices->done, &p_slices->lock );
+    vlc_mutex_unlock( &p_slices->lock );
+
+    vlc_restorecancel( canc );
+}
+
 /* */
 #include <vlc_video_splitter.h>
 
@@ -92,6 +92,17 @@ picture_t *picture_fifo_Pop(picture_fifo_t *fifo)
 
     return picture;
 }
+unsigned picture_fifo_Count(picture_fifo_t *fifo)
+{
+    unsigned count = 0;
+
+    vlc_mutex_lock(&fifo->lock);
+    for (picture_t *picture = fifo->first; picture; picture = picture->p_next)
+        count++;
+    vlc_mutex_unlock(&fifo->lock);
+
+    return count;
+}
 picture_t *picture_fifo_Peek(picture_fifo_t *fifo)
 {
     vlc_mutex_lock(&fifo->lock);
@@ -38,6 +38,12 @@
 /*****************************************************************************
  *
  *****************************************************************************/
+typedef struct pool_node_t pool_node_t;
+struct pool_node_t {
+    pool_node_t *prev;
+    pool_node_t *next;
+};
+
 struct picture_gc_sys_t {
     /* Saved release */
     void (*destroy)(picture_t *);
@@ -49,6 +55,12 @@ struct picture_gc_sys_t {
 
     /* */
     int64_t tick;
+
+    /* Current owner, and link in its free or used list */
+    picture_pool_t *pool;
+    picture_t      *picture;
+    pool_node_t    node;
+    bool           used;
 };
 
 struct picture_pool_t {
@@ -59,12 +71,96 @@ struct picture_pool_t {
     int            picture_count;
     picture_t      **picture;
     bool           *picture_reserved;
+
+    /* Pictures are released from any thread, so the lists are locked */
+    vlc_mutex_t    lock;
+    pool_node_t    free; /* most recently released first */
+    pool_node_t    used; /* least recently obtained first */
+    unsigned       used_count;
+    unsigned       used_peak;
+    unsigned       starved;
 };
 
 static void Destroy(picture_t *);
 static int  Lock(picture_t *);
 static void Unlock(picture_t *);
 
+static void ListInit(pool_node_t *head)
+{
+    head->prev = head->next = head;
+}
+
+static void ListRemove(pool_node_t *node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+}
+
+static void ListInsertAfter(pool_node_t *where, pool_node_t *node)
+{
+    node->prev = where;
+    node->next = where->next;
+    where->next->prev = node;
+    where->next = node;
+}
+
+static picture_gc_sys_t *NodeToGc(pool_node_t *node)
+{
+    return (picture_gc_sys_t *)((char *)node - offsetof(picture_gc_sys_t, node));
+}
+
+/* Must be called with the pool lock held */
+static void MarkFree(picture_pool_t *pool, picture_gc_sys_t *gc_sys)
+{
+    if (!gc_sys->used)
+        return;
+    ListRemove(&gc_sys->node);
+    ListInsertAfter(&pool->free, &gc_sys->node);
+    gc_sys->used = false;
+    pool->used_count--;
+}
+
+/* Must be called with the pool lock held */
+static void MarkUsed(picture_pool_t *pool, picture_gc_sys_t *gc_sys)
+{
+    assert(!gc_sys->used);
+    ListRemove(&gc_sys->node);
+    ListInsertAfter(pool->used.prev, &gc_sys->node);
+    gc_sys->used = true;
+    if (++pool->used_count > pool->used_peak)
+        pool->used_peak = pool->used_count;
+}
+
+/* Attaches a picture to a pool, in its free list or in its used list */
+static void Attach(picture_pool_t *pool, picture_t *picture)
+{
+    picture_gc_sys_t *gc_sys = picture->gc.p_sys;
+    bool used = vlc_atomic_get(&picture->gc.refcount) > 0;
+
+    vlc_mutex_lock(&pool->lock);
+    gc_sys->pool = pool;
+    gc_sys->used = used;
+    if (used) {
+        ListInsertAfter(pool->used.prev, &gc_sys->node);
+        if (++pool->used_count > pool->used_peak)
+            pool->used_peak = pool->used_count;
+    } else
+        ListInsertAfter(pool->free.prev, &gc_sys->node);
+    vlc_mutex_unlock(&pool->lock);
+}
+
+static void Detach(picture_pool_t *pool, picture_t *picture)
+{
+    picture_gc_sys_t *gc_sys = picture->gc.p_sys;
+
+    vlc_mutex_lock(&pool->lock);
+    assert(gc_sys->pool == pool);
+    ListRemove(&gc_sys->node);
+    if (gc_sys->used)
+        pool->used_count--;
+    vlc_mutex_unlock(&pool->lock);
+}
+
 static picture_pool_t *Create(picture_pool_t *master, int picture_count)
 {
     picture_pool_t *pool = calloc(1, sizeof(*pool));
@@ -82,6 +178,9 @@ static picture_pool_t *Create(picture_pool_t *master, int picture_count)
         free(pool);
         return NULL;
     }
+    vlc_mutex_init(&pool->lock);
+    ListInit(&pool->free);
+    ListInit(&pool->used);
     return pool;
 }
 
@@ -106,6 +205,7 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
         gc_sys->lock        = cfg->lock;
         gc_sys->unlock      = cfg->unlock;
         gc_sys->tick        = 0;
+        gc_sys->picture     = picture;
 
         /* */
         vlc_atomic_set(&picture->gc.refcount, 0);
@@ -115,6 +215,7 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
         /* */
         pool->picture[i] = picture;
         pool->picture_reserved[i] = false;
+        Attach(pool, picture);
     }
     return pool;
 
@@ -166,10 +267,14 @@ picture_pool_t *picture_pool_Reserve(picture_pool_t *master, int count)
         if (master->picture_reserved[i])
             continue;
 
-        assert(vlc_atomic_get(&master->picture[i]->gc.refcount) == 0);
+        picture_t *picture = master->picture[i];
+
+        assert(vlc_atomic_get(&picture->gc.refcount) == 0);
         master->picture_reserved[i] = true;
+        Detach(master, picture);
+        Attach(pool, picture);
 
-        pool->picture[found]          = master->picture[i];
+        pool->picture[found]          = picture;
         pool->picture_reserved[found] = false;
         found++;
     }
@@ -185,6 +290,10 @@ void picture_pool_Delete(picture_pool_t *pool)
     for (int i = 0; i < pool->picture_count; i++) {
         picture_t *picture = pool->picture[i];
         if (pool->master) {
+            if (!picture)
+                continue;
+            Detach(pool, picture);
+            Attach(pool->master, picture);
             for (int j = 0; j < pool->master->picture_count; j++) {
                 if (pool->master->picture[j] == picture)
                     pool->master->picture_reserved[j] = false;
@@ -205,6 +314,7 @@ void picture_pool_Delete(picture_pool_t *pool)
             free(gc_sys);
         }
     }
+    vlc_mutex_destroy(&pool->lock);
     free(pool->picture_reserved);
     free(pool->picture);
     free(pool);
@@ -212,59 +322,80 @@ void picture_pool_Delete(picture_pool_t *pool)
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    for (int i = 0; i < pool->picture_count; i++) {
-        if (pool->picture_reserved[i])
-            continue;
-
-        picture_t *picture = pool->picture[i];
-        if (vlc_atomic_get(&picture->gc.refcount) > 0)
-            continue;
+    vlc_mutex_lock(&pool->lock);
+    for (pool_node_t *node = pool->free.next; node != &pool->free;
+         node = node->next) {
+        picture_gc_sys_t *gc_sys = NodeToGc(node);
+        picture_t *picture = gc_sys->picture;
 
+        assert(vlc_atomic_get(&picture->gc.refcount) == 0);
         if (Lock(picture))
             continue;
 
+        MarkUsed(pool, gc_sys);
+        gc_sys->tick = pool->tick++;
+        vlc_mutex_unlock(&pool->lock);
+
         /* */
         picture->p_next = NULL;
-        picture->gc.p_sys->tick = pool->tick++;
         picture_Hold(picture);
         return picture;
     }
+    pool->starved++;
+    vlc_mutex_unlock(&pool->lock);
     return NULL;
 }
 
 void picture_pool_NonEmpty(picture_pool_t *pool, bool reset)
 {
-    picture_t *old = NULL;
+    vlc_mutex_lock(&pool->lock);
+    /* The used list is sorted by tick, the oldest picture comes first */
+    while (pool->used.next != &pool->used) {
+        if (!reset && pool->free.next != &pool->free)
+            break;
 
-    for (int i = 0; i < pool->picture_count; i++) {
-        if (pool->picture_reserved[i])
-            continue;
+        picture_gc_sys_t *gc_sys = NodeToGc(pool->used.next);
+        picture_t *picture = gc_sys->picture;
 
-        picture_t *picture = pool->picture[i];
-        if (reset) {
-            if (vlc_atomic_get(&picture->gc.refcount) > 0)
-                Unlock(picture);
-            vlc_atomic_set(&picture->gc.refcount, 0);
-        } else if (vlc_atomic_get(&picture->gc.refcount) == 0) {
-            return;
-        } else if (!old || picture->gc.p_sys->tick < old->gc.p_sys->tick) {
-            old = picture;
-        }
-    }
-    if (!reset && old) {
-        if (vlc_atomic_get(&old->gc.refcount) > 0)
-            Unlock(old);
-        vlc_atomic_set(&old->gc.refcount, 0);
+        if (vlc_atomic_get(&picture->gc.refcount) > 0)
+            Unlock(picture);
+        vlc_atomic_set(&picture->gc.refcount, 0);
+        MarkFree(pool, gc_sys);
     }
+    vlc_mutex_unlock(&pool->lock);
 }
+
 int picture_pool_GetSize(picture_pool_t *pool)
 {
     return pool->picture_count;
 }
 
+void picture_pool_GetStats(picture_pool_t *pool, unsigned *used,
+                           unsigned *peak, unsigned *starved)
+{
+    vlc_mutex_lock(&pool->lock);
+    if (used)
+        *used = pool->used_count;
+    if (peak)
+        *peak = pool->used_peak;
+    if (starved)
+        *starved = pool->starved;
+    vlc_mutex_unlock(&pool->lock);
+}
+
 static void Destroy(picture_t *picture)
 {
-    Unlock(picture);
+    picture_gc_sys_t *gc_sys = picture->gc.p_sys;
+    picture_pool_t *pool = gc_sys->pool;
+
+    vlc_mutex_lock(&pool->lock);
+    /* Once the reference count dropped to zero, picture_pool_NonEmpty() may
+     * have reclaimed the picture, and picture_pool_Get() handed it out again */
+    if (gc_sys->used && vlc_atomic_get(&picture->gc.refcount) == 0) {
+        Unlock(picture);
+        MarkFree(pool, gc_sys);
+    }
+    vlc_mutex_unlock(&pool->lock);
 }
 
 static int Lock(picture_t *picture)
@@ -280,4 +411,3 @@ static void Unlock(picture_t *picture)
     if (gc_sys->unlock)
         gc_sys->unlock(picture);
 }
-
@@ -187,19 +187,27 @@ subpicture_region_private_t *subpicture_region_private_New( video_format_t *p_fm
             *p_private->fmt.p_palette = *p_fmt->p_palette;
     }
     p_private->p_picture = NULL;
+    p_private->p_next = NULL;
 
     return p_private;
 }
 
 void subpicture_region_private_Delete( subpicture_region_private_t *p_private )
 {
-    if( p_private->p_picture )
-        picture_Release( p_private->p_picture );
-    free( p_private->fmt.p_palette );
-    free( p_private );
+    while( p_private )
+    {
+        subpicture_region_private_t *p_next = p_private->p_next;
+
+        if( p_private->p_picture )
+            picture_Release( p_private->p_picture );
+        free( p_private->fmt.p_palette );
+        free( p_private );
+
+        p_private = p_next;
+    }
 }
 
-subpicture_region_t *subpicture_region_New( const video_format_t *p_fmt )
+static subpicture_region_t *RegionNew( const video_format_t *p_fmt )
 {
     subpicture_region_t *p_region = calloc( 1, sizeof(*p_region ) );
     if( !p_region )
@@ -220,6 +228,15 @@ subpicture_region_t *subpicture_region_New( const video_format_t *p_fmt )
     p_region->p_style = NULL;
     p_region->p_picture = NULL;
 
+    return p_region;
+}
+
+subpicture_region_t *subpicture_region_New( const video_format_t *p_fmt )
+{
+    subpicture_region_t *p_region = RegionNew( p_fmt );
+    if( !p_region )
+        return NULL;
+
     if( p_fmt->i_chroma == VLC_CODEC_TEXT )
         return p_region;
 
@@ -234,6 +251,17 @@ subpicture_region_t *subpicture_region_New( const video_format_t *p_fmt )
     return p_region;
 }
 
+subpicture_region_t *subpicture_region_NewFromPicture( const video_format_t *p_fmt,
+                                                       picture_t *p_picture )
+{
+    subpicture_region_t *p_region = RegionNew( p_fmt );
+    if( !p_region )
+        return NULL;
+
+    p_region->p_picture = picture_Hold( p_picture );
+    return p_region;
+}
+
 void subpicture_region_Delete( subpicture_region_t *p_region )
 {
     if( !p_region )
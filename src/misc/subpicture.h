@@ -24,8 +24,15 @@
 struct subpicture_region_private_t {
     video_format_t fmt;
     picture_t      *p_picture;
+
+    /* The same region rendered for another output size or chroma */
+    subpicture_region_private_t *p_next;
 };
 
 subpicture_region_private_t *subpicture_region_private_New(video_format_t *);
 void subpicture_region_private_Delete(subpicture_region_private_t *);
 
+/* It creates a region sharing the given picture instead of allocating one */
+subpicture_region_t *subpicture_region_NewFromPicture(const video_format_t *,
+                                                      picture_t *);
+
@@ -146,6 +146,12 @@ void httpd_StreamDelete (httpd_stream_t *stream)
     assert (0);
 }
 
+int httpd_StreamGetLag (httpd_stream_t *stream, int64_t **lag)
+{
+    (void) stream; (void) lag;
+    assert (0);
+}
+
 int httpd_StreamHeader (httpd_stream_t *stream, uint8_t *data, int count)
 {
     (void) stream; (void) data; (void) count;
@@ -167,6 +173,12 @@ int httpd_StreamSend (httpd_stream_t *stream, uint8_t *data, int count)
     assert (0);
 }
 
+int httpd_StreamSendBlock (httpd_stream_t *stream, block_t *block)
+{
+    (void) stream; (void) block;
+    assert (0);
+}
+
 int httpd_UrlCatch (httpd_url_t *url, int request, httpd_callback_t cb,
                     httpd_callback_sys_t *data)
 {
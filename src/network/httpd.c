@@ -39,6 +39,8 @@
 #include <vlc_charset.h>
 #include <vlc_url.h>
 #include <vlc_mime.h>
+#include <vlc_block.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
 #include <string.h>
@@ -51,6 +53,9 @@
 #ifdef HAVE_POLL
 # include <poll.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+#endif
 
 #if defined( WIN32 )
 #   include <winsock2.h>
@@ -67,7 +72,35 @@
 
 static void httpd_ClientClean( httpd_client_t *cl );
 
-/* each host run in his own thread */
+/* Maximum number of events handled per wake up of a worker */
+#define HTTPD_WORKER_EVENTS 64
+/* Stream data gathered per send to a client, in bytes and in segments */
+#define HTTPD_STREAM_GATHER (64 << 10)
+#define HTTPD_STREAM_IOV    512
+
+/* each worker thread serves its own share of the clients of a host */
+typedef struct
+{
+    httpd_host_t *host;
+
+    vlc_thread_t thread;
+    vlc_mutex_t  lock;
+
+    int            i_client;
+    httpd_client_t **client;
+
+#ifdef HAVE_SYS_EPOLL_H
+    int          epfd;
+#endif
+} httpd_worker_t;
+
+/* each host run its own pool of worker threads
+ *
+ * The host lock protects the list of urls and serializes the url callbacks.
+ * A worker lock protects the clients of that worker. A worker may take the
+ * host lock while holding its own lock, but not the other way around. The
+ * first worker, which accepts the connections, may also lock the worker it
+ * hands a new client to. */
 struct httpd_host_t
 {
     VLC_COMMON_MEMBERS
@@ -80,9 +113,11 @@ struct httpd_host_t
     unsigned     nfd;
     unsigned     port;
 
-    vlc_thread_t thread;
     vlc_mutex_t lock;
-    vlc_cond_t  wait;
+
+    httpd_worker_t *worker;
+    unsigned        i_worker;
+    unsigned        i_worker_next; /* worker getting the next client */
 
     /* all registered url (becarefull that 2 httpd_url_t could point at the same url)
      * This will slow down the url research but make my live easier
@@ -91,9 +126,6 @@ struct httpd_host_t
     int         i_url;
     httpd_url_t **url;
 
-    int            i_client;
-    httpd_client_t **client;
-
     /* TLS data */
     vlc_tls_creds_t *p_tls;
 };
@@ -126,6 +158,7 @@ enum
     HTTPD_CLIENT_SEND_DONE,
 
     HTTPD_CLIENT_WAITING,
+    HTTPD_CLIENT_STREAMING, /* sending from the ring of a httpd_stream_t */
 
     HTTPD_CLIENT_DEAD,
 
@@ -140,6 +173,8 @@ enum
     HTTPD_CLIENT_STREAM,    /* regulary get data from cb */
 };
 
+typedef struct httpd_segment_t httpd_segment_t;
+
 struct httpd_client_t
 {
     httpd_url_t *url;
@@ -151,6 +186,10 @@ struct httpd_client_t
     bool    b_stream_mode;
     uint8_t i_state;
 
+    /* socket readiness, cleared once an operation would block */
+    bool    b_readable;
+    bool    b_writable;
+
     mtime_t i_activity_date;
     mtime_t i_activity_timeout;
 
@@ -165,6 +204,12 @@ struct httpd_client_t
 
     /* TLS data */
     vlc_tls_t *p_tls;
+
+    /* stream data cursor */
+    httpd_stream_t  *stream;
+    httpd_segment_t *p_segment;         /* segment being sent, or NULL */
+    size_t          i_segment_offset;   /* bytes of it already sent */
+    int64_t         i_stream_lag;       /* bytes of the stream not sent yet */
 };
 
 
@@ -615,6 +660,34 @@ void httpd_RedirectDelete( httpd_redirect_t *rdir )
 /*****************************************************************************
  * High Level Funtions: httpd_stream_t
  *****************************************************************************/
+/* A segment of stream data. The segments are chained from the oldest to the
+ * newest, and each segment holds a reference to the next one, so that a
+ * client keeps the data it has yet to send even once the ring dropped it. */
+struct httpd_segment_t
+{
+    httpd_segment_t *p_next;    /* next segment, set once under stream lock */
+    block_t         *p_block;   /* data, never modified */
+    int64_t         i_pos;      /* absolute position of the data */
+    atomic_uint     refs;
+};
+
+static void httpd_SegmentHold( httpd_segment_t *seg )
+{
+    atomic_fetch_add( &seg->refs, 1 );
+}
+
+static void httpd_SegmentRelease( httpd_segment_t *seg )
+{
+    while( seg != NULL && atomic_fetch_sub( &seg->refs, 1 ) == 1 )
+    {
+        httpd_segment_t *next = seg->p_next;
+
+        block_Release( seg->p_block );
+        free( seg );
+        seg = next;
+    }
+}
+
 struct httpd_stream_t
 {
     vlc_mutex_t lock;
@@ -626,11 +699,17 @@ struct httpd_stream_t
     uint8_t *p_header;
     int     i_header;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* ring of segments, shared by the clients */
+    httpd_segment_t *p_head;        /* oldest segment (holds a reference) */
+    httpd_segment_t *p_tail;        /* newest segment */
+    httpd_segment_t *p_join;        /* a new connection will start with that */
+    bool        b_keyframes;        /* whether the data has keyframe flags */
+    int64_t     i_buffer_size;      /* data kept in the ring, in bytes */
     int64_t     i_buffer_pos;       /* absolute position from begining */
-    int64_t     i_buffer_last_pos;  /* a new connection will start with that */
+
+    /* clients sending from the ring */
+    int             i_client;
+    httpd_client_t  **client;
 };
 
 static int httpd_StreamCallBack( httpd_callback_sys_t *p_sys,
@@ -646,56 +725,8 @@ static int httpd_StreamCallBack( httpd_callback_sys_t *p_sys,
 
     if( answer->i_body_offset > 0 )
     {
-        int64_t i_write;
-        int     i_pos;
-
-#if 0
-        fprintf( stderr, "httpd_StreamCallBack i_body_offset=%lld\n",
-                 answer->i_body_offset );
-#endif
-
-        if( answer->i_body_offset >= stream->i_buffer_pos )
-        {
-            /* fprintf( stderr, "httpd_StreamCallBack: no data\n" ); */
-            return VLC_EGENERIC;    /* wait, no data available */
-        }
-        if( answer->i_body_offset + stream->i_buffer_size <
-            stream->i_buffer_pos )
-        {
-            /* this client isn't fast enough */
-#if 0
-            fprintf( stderr, "fixing i_body_offset (old=%lld new=%lld)\n",
-                     answer->i_body_offset, stream->i_buffer_last_pos );
-#endif
-            answer->i_body_offset = stream->i_buffer_last_pos;
-        }
-
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        i_write = stream->i_buffer_pos - answer->i_body_offset;
-        if( i_write > HTTPD_CL_BUFSIZE )
-        {
-            i_write = HTTPD_CL_BUFSIZE;
-        }
-        else if( i_write <= 0 )
-        {
-            return VLC_EGENERIC;    /* wait, no data available */
-        }
-
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN( i_write, stream->i_buffer_size - i_pos );
-
-        /* using HTTPD_MSG_ANSWER -> data available */
-        answer->i_proto  = HTTPD_PROTO_HTTP;
-        answer->i_version= 0;
-        answer->i_type   = HTTPD_MSG_ANSWER;
-
-        answer->i_body = i_write;
-        answer->p_body = xmalloc( i_write );
-        memcpy( answer->p_body, &stream->p_buffer[i_pos], i_write );
-
-        answer->i_body_offset += i_write;
-
-        return VLC_SUCCESS;
+        /* the data is sent from the ring by httpd_ClientStreamSend() */
+        return VLC_EGENERIC;
     }
     else
     {
@@ -716,7 +747,7 @@ static int httpd_StreamCallBack( httpd_callback_sys_t *p_sys,
                 answer->p_body = xmalloc( stream->i_header );
                 memcpy( answer->p_body, stream->p_header, stream->i_header );
             }
-            answer->i_body_offset = stream->i_buffer_last_pos;
+            answer->i_body_offset = stream->i_buffer_pos;
             vlc_mutex_unlock( &stream->lock );
         }
         else
@@ -758,6 +789,21 @@ static int httpd_StreamCallBack( httpd_callback_sys_t *p_sys,
             httpd_MsgAdd( answer, "Content-type",  "%s", stream->psz_mime );
         }
         httpd_MsgAdd( answer, "Cache-Control", "%s", "no-cache" );
+
+        if( answer->i_body_offset > 0 && cl->stream == NULL )
+        {
+            /* start sending from the join point of the ring */
+            vlc_mutex_lock( &stream->lock );
+            cl->stream = stream;
+            cl->p_segment = stream->p_join;
+            if( cl->p_segment != NULL )
+                httpd_SegmentHold( cl->p_segment );
+            cl->i_segment_offset = 0;
+            cl->i_stream_lag = cl->p_segment != NULL
+                             ? stream->i_buffer_pos - cl->p_segment->i_pos : 0;
+            TAB_APPEND( stream->i_client, stream->client, cl );
+            vlc_mutex_unlock( &stream->lock );
+        }
         return VLC_SUCCESS;
     }
 }
@@ -785,12 +831,15 @@ httpd_stream_t *httpd_StreamNew( httpd_host_t *host,
     }
     stream->i_header = 0;
     stream->p_header = NULL;
+    stream->p_head = NULL;
+    stream->p_tail = NULL;
+    stream->p_join = NULL;
+    stream->b_keyframes = false;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
-    stream->p_buffer = xmalloc( stream->i_buffer_size );
+    TAB_INIT( stream->i_client, stream->client );
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
     stream->i_buffer_pos = 1;
-    stream->i_buffer_last_pos = 1;
 
     httpd_UrlCatch( stream->url, HTTPD_MSG_HEAD, httpd_StreamCallBack,
                     (httpd_callback_sys_t*)stream );
@@ -819,56 +868,136 @@ int httpd_StreamHeader( httpd_stream_t *stream, uint8_t *p_data, int i_data )
     return VLC_SUCCESS;
 }
 
-int httpd_StreamSend( httpd_stream_t *stream, uint8_t *p_data, int i_data )
+/**
+ * Appends a block to the stream. The block is shared with the clients, not
+ * copied. Clients connecting later, or lagging behind the data kept by the
+ * stream, start at the last block flagged with BLOCK_FLAG_TYPE_I, or at the
+ * last block if the stream never had such flags.
+ */
+int httpd_StreamSendBlock( httpd_stream_t *stream, block_t *p_block )
 {
-    int i_count;
-    int i_pos;
-
-    if( i_data < 0 || p_data == NULL )
+    if( p_block->i_buffer == 0 )
     {
+        block_Release( p_block );
         return VLC_SUCCESS;
     }
+
+    httpd_segment_t *seg = malloc( sizeof( *seg ) );
+    if( unlikely(seg == NULL) )
+    {
+        block_Release( p_block );
+        return VLC_ENOMEM;
+    }
+    seg->p_next = NULL;
+    seg->p_block = p_block;
+    atomic_init( &seg->refs, 1 );
+
     vlc_mutex_lock( &stream->lock );
+    seg->i_pos = stream->i_buffer_pos;
+    stream->i_buffer_pos += p_block->i_buffer;
 
-    /* save this pointer (to be used by new connection) */
-    stream->i_buffer_last_pos = stream->i_buffer_pos;
+    /* the previous segment, or else the ring, owns the reference */
+    if( stream->p_tail != NULL )
+        stream->p_tail->p_next = seg;
+    else
+        stream->p_head = seg;
+    stream->p_tail = seg;
 
-    i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    i_count = i_data;
-    while( i_count > 0)
+    if( p_block->i_flags & BLOCK_FLAG_TYPE_I )
     {
-        int i_copy;
-
-        i_copy = __MIN( i_count, stream->i_buffer_size - i_pos );
+        stream->b_keyframes = true;
+        stream->p_join = seg;
+    }
+    else if( !stream->b_keyframes )
+        stream->p_join = seg;
+
+    /* drop the oldest data, moving the join point along if it gets dropped
+     * (clients joining then start in the middle of a group of pictures) */
+    while( stream->p_head != stream->p_tail
+        && stream->i_buffer_pos - stream->p_head->p_next->i_pos
+               >= stream->i_buffer_size )
+    {
+        httpd_segment_t *head = stream->p_head;
 
-        /* Ok, we can't go past the end of our buffer */
-        memcpy( &stream->p_buffer[i_pos], p_data, i_copy );
+        if( stream->p_join == head )
+            stream->p_join = head->p_next;
+        stream->p_head = head->p_next;
+        httpd_SegmentHold( stream->p_head );
+        httpd_SegmentRelease( head );
+    }
+    vlc_mutex_unlock( &stream->lock );
+    return VLC_SUCCESS;
+}
 
-        i_pos = ( i_pos + i_copy ) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
+int httpd_StreamSend( httpd_stream_t *stream, uint8_t *p_data, int i_data )
+{
+    if( i_data <= 0 || p_data == NULL )
+    {
+        return VLC_SUCCESS;
     }
 
-    stream->i_buffer_pos += i_data;
+    block_t *p_block = block_Alloc( i_data );
+    if( unlikely(p_block == NULL) )
+        return VLC_ENOMEM;
+    memcpy( p_block->p_buffer, p_data, i_data );
+    return httpd_StreamSendBlock( stream, p_block );
+}
+
+/**
+ * Gets how far behind the stream each of its clients is, in bytes not sent
+ * yet, as of the last data the client sent.
+ * \param ppi_lag address to store an allocated array of the lags,
+ * or NULL if there are no clients (must be freed by the caller)
+ * \return the number of clients, or -1 on error
+ */
+int httpd_StreamGetLag( httpd_stream_t *stream, int64_t **ppi_lag )
+{
+    int64_t *pi_lag = NULL;
+    int i_client;
 
+    vlc_mutex_lock( &stream->lock );
+    i_client = stream->i_client;
+    if( i_client > 0 )
+    {
+        pi_lag = malloc( i_client * sizeof( *pi_lag ) );
+        if( pi_lag != NULL )
+            for( int i = 0; i < i_client; i++ )
+                pi_lag[i] = stream->client[i]->i_stream_lag;
+        else
+            i_client = -1;
+    }
     vlc_mutex_unlock( &stream->lock );
-    return VLC_SUCCESS;
+
+    *ppi_lag = pi_lag;
+    return i_client;
 }
 
 void httpd_StreamDelete( httpd_stream_t *stream )
 {
     httpd_UrlDelete( stream->url );
+    TAB_CLEAN( stream->i_client, stream->client );
     vlc_mutex_destroy( &stream->lock );
     free( stream->psz_mime );
     free( stream->p_header );
-    free( stream->p_buffer );
+    httpd_SegmentRelease( stream->p_head );
     free( stream );
 }
 
+/* Removes a client from the clients of its stream */
+static void httpd_ClientStreamDetach( httpd_client_t *cl )
+{
+    httpd_stream_t *stream = cl->stream;
+
+    vlc_mutex_lock( &stream->lock );
+    TAB_REMOVE( stream->i_client, stream->client, cl );
+    vlc_mutex_unlock( &stream->lock );
+    cl->stream = NULL;
+}
+
 /*****************************************************************************
  * Low level
  *****************************************************************************/
-static void* httpd_HostThread( void * );
+static void* httpd_WorkerThread( void * );
 static httpd_host_t *httpd_HostCreate( vlc_object_t *, const char *,
                                        const char *, vlc_tls_creds_t * );
 
@@ -945,6 +1074,49 @@ static struct httpd
     int          i_host;
 } httpd = { VLC_STATIC_MUTEX, NULL, 0 };
 
+static int httpd_WorkerInit( httpd_host_t *host, httpd_worker_t *worker )
+{
+    worker->host = host;
+    worker->i_client = 0;
+    worker->client = NULL;
+#ifdef HAVE_SYS_EPOLL_H
+    worker->epfd = epoll_create1( EPOLL_CLOEXEC );
+    if( worker->epfd == -1 )
+        return VLC_EGENERIC;
+#endif
+    vlc_mutex_init( &worker->lock );
+    return VLC_SUCCESS;
+}
+
+static void httpd_WorkerClean( httpd_worker_t *worker )
+{
+    for( int i = 0; i < worker->i_client; i++ )
+    {
+        msg_Warn( worker->host, "client still connected" );
+        httpd_ClientClean( worker->client[i] );
+        free( worker->client[i] );
+    }
+    free( worker->client );
+#ifdef HAVE_SYS_EPOLL_H
+    close( worker->epfd );
+#endif
+    vlc_mutex_destroy( &worker->lock );
+}
+
+/* Stops the first count workers of a host, and releases all of them */
+static void httpd_HostStopWorkers( httpd_host_t *host, unsigned count )
+{
+    for( unsigned i = 0; i < count; i++ )
+        vlc_cancel( host->worker[i].thread );
+    for( unsigned i = 0; i < count; i++ )
+        vlc_join( host->worker[i].thread, NULL );
+    for( unsigned i = 0; i < host->i_worker; i++ )
+        httpd_WorkerClean( &host->worker[i] );
+    free( host->worker );
+    host->worker = NULL;
+    host->i_worker = 0;
+}
+
 static httpd_host_t *httpd_HostCreate( vlc_object_t *p_this,
                                        const char *hostvar,
                                        const char *portvar,
@@ -998,8 +1170,9 @@ static httpd_host_t *httpd_HostCreate( vlc_object_t *p_this,
         goto error;
 
     vlc_mutex_init( &host->lock );
-    vlc_cond_init( &host->wait );
     host->i_ref = 1;
+    host->worker = NULL;
+    host->i_worker = 0;
 
     host->fds = net_ListenTCP( p_this, url.psz_host, port );
     if( host->fds == NULL )
@@ -1018,17 +1191,51 @@ static httpd_host_t *httpd_HostCreate( vlc_object_t *p_this,
     host->port     = port;
     host->i_url    = 0;
     host->url      = NULL;
-    host->i_client = 0;
-    host->client   = NULL;
     host->p_tls    = p_tls;
 
-    /* create the thread */
-    if( vlc_clone( &host->thread, httpd_HostThread, host,
-                   VLC_THREAD_PRIORITY_LOW ) )
-    {
-        msg_Err( p_this, "cannot spawn http host thread" );
+    /* create the workers */
+    unsigned i_worker = var_InheritInteger( p_this, "http-threads" );
+#ifndef HAVE_SYS_EPOLL_H
+    i_worker = 1; /* poll() sets cannot be shared across threads */
+#endif
+    if( i_worker < 1 )
+        i_worker = 1;
+
+    host->worker = malloc( i_worker * sizeof( *host->worker ) );
+    if( host->worker == NULL )
         goto error;
+    for( ; host->i_worker < i_worker; host->i_worker++ )
+        if( httpd_WorkerInit( host, &host->worker[host->i_worker] ) )
+            goto error;
+    host->i_worker_next = 0;
+
+#ifdef HAVE_SYS_EPOLL_H
+    /* the first worker accepts the new connections */
+    for( unsigned i = 0; i < host->nfd; i++ )
+    {
+        struct epoll_event ev = {
+            .events = EPOLLIN,
+            .data.ptr = &host->fds[i],
+        };
+
+        if( epoll_ctl( host->worker[0].epfd, EPOLL_CTL_ADD,
+                       host->fds[i], &ev ) )
+        {
+            msg_Err( p_this, "cannot poll HTTP host socket: %m" );
+            goto error;
+        }
     }
+#endif
+
+    for( unsigned i = 0; i < host->i_worker; i++ )
+        if( vlc_clone( &host->worker[i].thread, httpd_WorkerThread,
+                       &host->worker[i], VLC_THREAD_PRIORITY_LOW ) )
+        {
+            msg_Err( p_this, "cannot spawn http host thread" );
+            httpd_HostStopWorkers( host, i );
+            goto error;
+        }
+    msg_Dbg( host, "using %u thread(s)", host->i_worker );
 
     /* now add it to httpd */
     TAB_APPEND( httpd.i_host, httpd.host, host );
@@ -1043,8 +1250,9 @@ error:
 
     if( host != NULL )
     {
+        if( host->worker != NULL )
+            httpd_HostStopWorkers( host, 0 );
         net_ListenClose( host->fds );
-        vlc_cond_destroy( &host->wait );
         vlc_mutex_destroy( &host->lock );
         vlc_object_release( host );
     }
@@ -1076,8 +1284,7 @@ void httpd_HostDelete( httpd_host_t *host )
     }
     TAB_REMOVE( httpd.i_host, httpd.host, host );
 
-    vlc_cancel( host->thread );
-    vlc_join( host->thread, NULL );
+    httpd_HostStopWorkers( host, host->i_worker );
 
     msg_Dbg( host, "HTTP host removed" );
 
@@ -1085,20 +1292,9 @@ void httpd_HostDelete( httpd_host_t *host )
     {
         msg_Err( host, "url still registered: %s", host->url[i]->psz_url );
     }
-    for( i = 0; i < host->i_client; i++ )
-    {
-        httpd_client_t *cl = host->client[i];
-        msg_Warn( host, "client still connected" );
-        httpd_ClientClean( cl );
-        TAB_REMOVE( host->i_client, host->client, cl );
-        free( cl );
-        i--;
-        /* TODO */
-    }
 
     vlc_tls_Delete( host->p_tls );
     net_ListenClose( host->fds );
-    vlc_cond_destroy( &host->wait );
     vlc_mutex_destroy( &host->lock );
     vlc_object_release( host );
     vlc_mutex_unlock( &httpd.mutex );
@@ -1138,7 +1334,6 @@ httpd_url_t *httpd_UrlNew( httpd_host_t *host, const char *psz_url,
     }
 
     TAB_APPEND( host->i_url, host->url, url );
-    vlc_cond_signal( &host->wait );
     vlc_mutex_unlock( &host->lock );
 
     return url;
@@ -1160,32 +1355,42 @@ int httpd_UrlCatch( httpd_url_t *url, int i_msg, httpd_callback_t cb,
 void httpd_UrlDelete( httpd_url_t *url )
 {
     httpd_host_t *host = url->host;
-    int          i;
 
     vlc_mutex_lock( &host->lock );
     TAB_REMOVE( host->i_url, host->url, url );
+    vlc_mutex_unlock( &host->lock );
 
-    vlc_mutex_destroy( &url->lock );
-    free( url->psz_url );
-    free( url->psz_user );
-    free( url->psz_password );
-
-    for( i = 0; i < host->i_client; i++ )
+    /* The workers may still be handling events for the clients: they close
+     * them. Holding the worker lock ensures that no callback is running. */
+    for( unsigned i = 0; i < host->i_worker; i++ )
     {
-        httpd_client_t *client = host->client[i];
+        httpd_worker_t *worker = &host->worker[i];
 
-        if( client->url == url )
+        vlc_mutex_lock( &worker->lock );
+        for( int j = 0; j < worker->i_client; j++ )
         {
-            /* TODO complete it */
-            msg_Warn( host, "force closing connections" );
-            httpd_ClientClean( client );
-            TAB_REMOVE( host->i_client, host->client, client );
-            free( client );
-            i--;
+            httpd_client_t *client = worker->client[j];
+
+            if( client->url == url )
+            {
+                /* TODO complete it */
+                msg_Warn( host, "force closing connections" );
+                client->url = NULL;
+                if( client->stream != NULL )
+                    httpd_ClientStreamDetach( client );
+                client->i_state = HTTPD_CLIENT_DEAD;
+                /* wake the worker up */
+                shutdown( client->fd, SHUT_RDWR );
+            }
         }
+        vlc_mutex_unlock( &worker->lock );
     }
+
+    vlc_mutex_destroy( &url->lock );
+    free( url->psz_url );
+    free( url->psz_user );
+    free( url->psz_password );
     free( url );
-    vlc_mutex_unlock( &host->lock );
 }
 
 static void httpd_MsgInit( httpd_message_t *msg )
@@ -1274,6 +1479,12 @@ static void httpd_ClientInit( httpd_client_t *cl, mtime_t now )
     cl->i_buffer = 0;
     cl->p_buffer = xmalloc( cl->i_buffer_size );
     cl->b_stream_mode = false;
+    cl->b_readable = false;
+    cl->b_writable = false;
+    cl->stream = NULL;
+    cl->p_segment = NULL;
+    cl->i_segment_offset = 0;
+    cl->i_stream_lag = 0;
 
     httpd_MsgInit( &cl->query );
     httpd_MsgInit( &cl->answer );
@@ -1304,6 +1515,11 @@ static void httpd_ClientClean( httpd_client_t *cl )
 
     free( cl->p_buffer );
     cl->p_buffer = NULL;
+
+    httpd_SegmentRelease( cl->p_segment );
+    cl->p_segment = NULL;
+    if( cl->stream != NULL )
+        httpd_ClientStreamDetach( cl );
 }
 
 static httpd_client_t *httpd_ClientNew( int fd, vlc_tls_t *p_tls, mtime_t now )
@@ -1375,7 +1591,8 @@ msg_type[] =
 };
 
 
-static void httpd_ClientRecv( httpd_client_t *cl )
+/* Receives from the client, returns -1 if the socket would block */
+static int httpd_ClientRecv( httpd_client_t *cl )
 {
     int i_len;
 
@@ -1728,10 +1945,11 @@ static void httpd_ClientRecv( httpd_client_t *cl )
 
     /* check if the client is to be set to dead */
 #if defined( WIN32 )
-    if( ( i_len < 0 && WSAGetLastError() != WSAEWOULDBLOCK ) || ( i_len == 0 ) )
+    const bool b_block = i_len < 0 && WSAGetLastError() == WSAEWOULDBLOCK;
 #else
-    if( ( i_len < 0 && errno != EAGAIN ) || ( i_len == 0 ) )
+    const bool b_block = i_len < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK );
 #endif
+    if( ( i_len < 0 && !b_block ) || ( i_len == 0 ) )
     {
         if( cl->query.i_proto != HTTPD_PROTO_NONE && cl->query.i_type != HTTPD_MSG_NONE )
         {
@@ -1778,9 +1996,11 @@ static void httpd_ClientRecv( httpd_client_t *cl )
         }
     }
 #endif
+    return b_block ? -1 : 0;
 }
 
-static void httpd_ClientSend( httpd_client_t *cl )
+/* Sends to the client, returns -1 if the socket would block */
+static int httpd_ClientSend( httpd_client_t *cl )
 {
     int i;
     int i_len;
@@ -1833,17 +2053,31 @@ static void httpd_ClientSend( httpd_client_t *cl )
 
         if( cl->i_buffer >= cl->i_buffer_size )
         {
+            if( cl->answer.i_body == 0 && cl->stream != NULL )
+            {
+                /* send the body data straight from the stream ring */
+                free( cl->p_buffer );
+                cl->p_buffer = NULL;
+                cl->i_buffer = 0;
+                cl->i_buffer_size = 0;
+                cl->i_state = HTTPD_CLIENT_STREAMING;
+                return 0;
+            }
+
             if( cl->answer.i_body == 0  && cl->answer.i_body_offset > 0 )
             {
                 /* catch more body data */
+                httpd_host_t *host = cl->url->host;
                 int     i_msg = cl->query.i_type;
                 int64_t i_offset = cl->answer.i_body_offset;
 
                 httpd_MsgClean( &cl->answer );
                 cl->answer.i_body_offset = i_offset;
 
+                vlc_mutex_lock( &host->lock );
                 cl->url->catch[i_msg].cb( cl->url->catch[i_msg].p_sys, cl,
                                           &cl->answer, &cl->query );
+                vlc_mutex_unlock( &host->lock );
             }
 
             if( cl->answer.i_body > 0 )
@@ -1867,15 +2101,169 @@ static void httpd_ClientSend( httpd_client_t *cl )
     else
     {
 #if defined( WIN32 )
-        if( ( i_len < 0 && WSAGetLastError() != WSAEWOULDBLOCK ) || ( i_len == 0 ) )
+        if( WSAGetLastError() == WSAEWOULDBLOCK )
 #else
-        if( ( i_len < 0 && errno != EAGAIN ) || ( i_len == 0 ) )
+        if( errno == EAGAIN || errno == EWOULDBLOCK )
 #endif
-        {
-            /* error */
-            cl->i_state = HTTPD_CLIENT_DEAD;
-        }
+            return -1;
+
+        /* error */
+        cl->i_state = HTTPD_CLIENT_DEAD;
+    }
+    return 0;
+}
+
+/* Moves a stream client that fell behind the data kept in the ring to the
+ * join point, so that it no longer keeps the dropped data alive.
+ * The stream lock must be held. */
+static void httpd_ClientStreamResync( httpd_client_t *cl )
+{
+    httpd_stream_t  *stream = cl->stream;
+    httpd_segment_t *seg = cl->p_segment;
+
+    if( seg == NULL || seg->i_pos >= stream->p_head->i_pos )
+        return;
+
+    const int64_t i_pos = seg->i_pos + cl->i_segment_offset;
+    msg_Dbg( cl->url->host, "client lagging %"PRId64" bytes behind, "
+             "skipping %"PRId64" bytes", stream->i_buffer_pos - i_pos,
+             stream->p_join->i_pos - i_pos );
+    httpd_SegmentHold( stream->p_join );
+    httpd_SegmentRelease( seg );
+    cl->p_segment = stream->p_join;
+    cl->i_segment_offset = 0;
+}
+
+/* Moves the cursor of a stream client past the data it has sent. A client
+ * that fell behind the data kept in the ring skips to the join point.
+ * Returns the size of the data left to send in the current segment.
+ * The stream lock must be held. */
+static size_t httpd_ClientStreamSeek( httpd_client_t *cl )
+{
+    httpd_stream_t  *stream = cl->stream;
+    httpd_segment_t *seg = cl->p_segment;
+
+    if( seg == NULL )
+    {
+        /* the stream had no data when the client connected */
+        seg = stream->p_join;
+        if( seg == NULL )
+            return 0;
+        httpd_SegmentHold( seg );
+        cl->i_segment_offset = 0;
+        cl->p_segment = seg;
+    }
+    httpd_ClientStreamResync( cl );
+    seg = cl->p_segment;
+
+    while( cl->i_segment_offset >= seg->p_block->i_buffer
+        && seg->p_next != NULL )
+    {
+        httpd_segment_t *next = seg->p_next;
+
+        httpd_SegmentHold( next );
+        httpd_SegmentRelease( seg );
+        cl->p_segment = next;
+        cl->i_segment_offset = 0;
+        /* this client isn't fast enough if the next one was dropped too */
+        httpd_ClientStreamResync( cl );
+        seg = cl->p_segment;
     }
+
+    cl->i_stream_lag = stream->i_buffer_pos - seg->i_pos
+                     - cl->i_segment_offset;
+    return seg->p_block->i_buffer - cl->i_segment_offset;
+}
+
+/* Sends stream data from the ring without copying it, gathering the
+ * segments up to HTTPD_STREAM_GATHER bytes where possible.
+ * Returns -1 if the socket would block */
+static int httpd_ClientStreamSend( httpd_client_t *cl )
+{
+    httpd_stream_t *stream = cl->stream;
+    struct iovec iov[HTTPD_STREAM_IOV];
+    unsigned i_iov = 0;
+    ssize_t i_len;
+
+    vlc_mutex_lock( &stream->lock );
+    size_t i_left = httpd_ClientStreamSeek( cl );
+    if( i_left > 0 )
+    {
+        const httpd_segment_t *seg = cl->p_segment;
+
+        iov[0].iov_base = seg->p_block->p_buffer + cl->i_segment_offset;
+        iov[0].iov_len = i_left;
+        i_iov++;
+#ifndef WIN32
+        /* The following segments are kept by the current one */
+        if( cl->p_tls == NULL )
+            for( seg = seg->p_next;
+                 seg != NULL && i_iov < HTTPD_STREAM_IOV
+                             && i_left < HTTPD_STREAM_GATHER;
+                 seg = seg->p_next )
+            {
+                iov[i_iov].iov_base = seg->p_block->p_buffer;
+                iov[i_iov].iov_len = seg->p_block->i_buffer;
+                i_left += seg->p_block->i_buffer;
+                i_iov++;
+            }
+#endif
+    }
+    vlc_mutex_unlock( &stream->lock );
+
+    if( i_iov == 0 )
+    {
+        /* wait for more data */
+        cl->i_state = HTTPD_CLIENT_WAITING;
+        return 0;
+    }
+
+#ifndef WIN32
+    if( i_iov > 1 )
+    {
+        struct msghdr hdr = {
+            .msg_iov = iov,
+            .msg_iovlen = i_iov,
+        };
+
+        do
+            i_len = sendmsg( cl->fd, &hdr, 0 );
+        while( i_len == -1 && errno == EINTR );
+    }
+    else
+#endif
+        i_len = httpd_NetSend( cl, iov[0].iov_base, iov[0].iov_len );
+
+    if( i_len < 0 )
+    {
+#if defined( WIN32 )
+        if( WSAGetLastError() == WSAEWOULDBLOCK )
+#else
+        if( errno == EAGAIN || errno == EWOULDBLOCK )
+#endif
+            return -1;
+
+        /* error */
+        cl->i_state = HTTPD_CLIENT_DEAD;
+        return 0;
+    }
+
+    /* the last segment sent from stays current until the next seek */
+    vlc_mutex_lock( &stream->lock );
+    cl->i_segment_offset += i_len;
+    while( cl->i_segment_offset > cl->p_segment->p_block->i_buffer )
+    {
+        httpd_segment_t *seg = cl->p_segment;
+
+        cl->i_segment_offset -= seg->p_block->i_buffer;
+        cl->p_segment = seg->p_next;
+        httpd_SegmentHold( cl->p_segment );
+        httpd_SegmentRelease( seg );
+    }
+    cl->i_stream_lag = stream->i_buffer_pos - cl->p_segment->i_pos
+                     - cl->i_segment_offset;
+    vlc_mutex_unlock( &stream->lock );
+    return 0;
 }
 
 static void httpd_ClientTlsHandshake( httpd_client_t *cl )
@@ -1892,358 +2280,546 @@ static void httpd_ClientTlsHandshake( httpd_client_t *cl )
 
         case 1:
             cl->i_state = HTTPD_CLIENT_TLS_HS_IN;
+            cl->b_readable = false;
             break;
 
         case 2:
             cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
+            cl->b_writable = false;
             break;
     }
 }
 
-static void* httpd_HostThread( void *data )
+/* Does the I/O the client is waiting for, until its socket would block */
+static void httpd_ClientIO( httpd_client_t *cl, mtime_t now )
 {
-    httpd_host_t *host = data;
-    int canc = vlc_savecancel();
-
-    vlc_mutex_lock( &host->lock );
-    while( host->i_ref > 0 )
+    for( ;; )
     {
-        struct pollfd ufd[host->nfd + host->i_client];
-        unsigned nfd;
-        for( nfd = 0; nfd < host->nfd; nfd++ )
+        switch( cl->i_state )
         {
-            ufd[nfd].fd = host->fds[nfd];
-            ufd[nfd].events = POLLIN;
-            ufd[nfd].revents = 0;
+            case HTTPD_CLIENT_RECEIVING:
+                if( !cl->b_readable )
+                    return;
+                if( httpd_ClientRecv( cl ) )
+                    cl->b_readable = false;
+                break;
+
+            case HTTPD_CLIENT_SENDING:
+                if( !cl->b_writable )
+                    return;
+                if( httpd_ClientSend( cl ) )
+                    cl->b_writable = false;
+                break;
+
+            case HTTPD_CLIENT_STREAMING:
+                if( !cl->b_writable )
+                    return;
+                if( httpd_ClientStreamSend( cl ) )
+                    cl->b_writable = false;
+                break;
+
+            case HTTPD_CLIENT_TLS_HS_IN:
+                if( !cl->b_readable )
+                    return;
+                httpd_ClientTlsHandshake( cl );
+                break;
+
+            case HTTPD_CLIENT_TLS_HS_OUT:
+                if( !cl->b_writable )
+                    return;
+                httpd_ClientTlsHandshake( cl );
+                break;
+
+            default:
+                return;
         }
+        cl->i_activity_date = now;
+    }
+}
 
-        /* add all socket that should be read/write and close dead connection */
-        while( host->i_url <= 0 )
+/* Whether the client can make progress without waiting for its socket */
+static bool httpd_ClientReady( const httpd_client_t *cl )
+{
+    switch( cl->i_state )
+    {
+        case HTTPD_CLIENT_RECEIVING:
+        case HTTPD_CLIENT_TLS_HS_IN:
+            return cl->b_readable;
+        case HTTPD_CLIENT_SENDING:
+        case HTTPD_CLIENT_STREAMING:
+        case HTTPD_CLIENT_TLS_HS_OUT:
+            return cl->b_writable;
+        case HTTPD_CLIENT_WAITING:
+            return false;
+        default:
+            return true;
+    }
+}
+
+/* Handles the client requests and answers once received or sent */
+static void httpd_ClientProcess( httpd_host_t *host, httpd_client_t *cl )
+{
+    if( cl->i_state == HTTPD_CLIENT_RECEIVE_DONE )
+    {
+        httpd_message_t *answer = &cl->answer;
+        httpd_message_t *query  = &cl->query;
+        int i_msg = query->i_type;
+
+        httpd_MsgInit( answer );
+
+        /* Handle what we received */
+        if( i_msg == HTTPD_MSG_ANSWER )
         {
-            mutex_cleanup_push( &host->lock );
-            vlc_restorecancel( canc );
-            vlc_cond_wait( &host->wait, &host->lock );
-            canc = vlc_savecancel();
-            vlc_cleanup_pop();
+            cl->url     = NULL;
+            cl->i_state = HTTPD_CLIENT_DEAD;
         }
+        else if( i_msg == HTTPD_MSG_OPTIONS )
+        {
 
-        mtime_t now = mdate();
-        bool b_low_delay = false;
+            answer->i_type   = HTTPD_MSG_ANSWER;
+            answer->i_proto  = query->i_proto;
+            answer->i_status = 200;
+            answer->i_body = 0;
+            answer->p_body = NULL;
 
-        for(int i_client = 0; i_client < host->i_client; i_client++ )
-        {
-            httpd_client_t *cl = host->client[i_client];
-            if( cl->i_ref < 0 || ( cl->i_ref == 0 &&
-                ( cl->i_state == HTTPD_CLIENT_DEAD ||
-                  ( cl->i_activity_timeout > 0 &&
-                    cl->i_activity_date+cl->i_activity_timeout < now) ) ) )
+            httpd_MsgAdd( answer, "Server", "VLC/%s", VERSION );
+            httpd_MsgAdd( answer, "Content-Length", "0" );
+
+            switch( query->i_proto )
             {
-                httpd_ClientClean( cl );
-                TAB_REMOVE( host->i_client, host->client, cl );
-                free( cl );
-                i_client--;
-                continue;
-            }
+                case HTTPD_PROTO_HTTP:
+                    answer->i_version = 1;
+                    httpd_MsgAdd( answer, "Allow",
+                                  "GET,HEAD,POST,OPTIONS" );
+                    break;
 
-            struct pollfd *pufd = ufd + nfd;
-            assert (pufd < ufd + (sizeof (ufd) / sizeof (ufd[0])));
+                case HTTPD_PROTO_RTSP:
+                {
+                    const char *p;
+                    answer->i_version = 0;
+
+                    p = httpd_MsgGet( query, "Cseq" );
+                    if( p != NULL )
+                        httpd_MsgAdd( answer, "Cseq", "%s", p );
+                    p = httpd_MsgGet( query, "Timestamp" );
+                    if( p != NULL )
+                        httpd_MsgAdd( answer, "Timestamp", "%s", p );
+
+                    p = httpd_MsgGet( query, "Require" );
+                    if( p != NULL )
+                    {
+                        answer->i_status = 551;
+                        httpd_MsgAdd( query, "Unsupported", "%s", p );
+                    }
 
-            pufd->fd = cl->fd;
-            pufd->events = pufd->revents = 0;
+                    httpd_MsgAdd( answer, "Public", "DESCRIBE,SETUP,"
+                                  "TEARDOWN,PLAY,PAUSE,GET_PARAMETER" );
+                    break;
+                }
+            }
 
-            if( ( cl->i_state == HTTPD_CLIENT_RECEIVING )
-                  || ( cl->i_state == HTTPD_CLIENT_TLS_HS_IN ) )
+            cl->i_buffer = -1;  /* Force the creation of the answer in
+                                 * httpd_ClientSend */
+            cl->i_state = HTTPD_CLIENT_SENDING;
+        }
+        else if( i_msg == HTTPD_MSG_NONE )
+        {
+            if( query->i_proto == HTTPD_PROTO_NONE )
             {
-                pufd->events = POLLIN;
+                cl->url = NULL;
+                cl->i_state = HTTPD_CLIENT_DEAD;
             }
-            else if( ( cl->i_state == HTTPD_CLIENT_SENDING )
-                  || ( cl->i_state == HTTPD_CLIENT_TLS_HS_OUT ) )
+            else
             {
-                pufd->events = POLLOUT;
+                char *p;
+
+                /* unimplemented */
+                answer->i_proto  = query->i_proto ;
+                answer->i_type   = HTTPD_MSG_ANSWER;
+                answer->i_version= 0;
+                answer->i_status = 501;
+
+                answer->i_body = httpd_HtmlError (&p, 501, NULL);
+                answer->p_body = (uint8_t *)p;
+                httpd_MsgAdd( answer, "Content-Length", "%d", answer->i_body );
+
+                cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
+                cl->i_state = HTTPD_CLIENT_SENDING;
             }
-            else if( cl->i_state == HTTPD_CLIENT_RECEIVE_DONE )
-            {
-                httpd_message_t *answer = &cl->answer;
-                httpd_message_t *query  = &cl->query;
-                int i_msg = query->i_type;
+        }
+        else
+        {
+            bool b_auth_failed = false;
 
-                httpd_MsgInit( answer );
+            /* Search the url and trigger callbacks */
+            vlc_mutex_lock( &host->lock );
+            for(int i = 0; i < host->i_url; i++ )
+            {
+                httpd_url_t *url = host->url[i];
 
-                /* Handle what we received */
-                if( i_msg == HTTPD_MSG_ANSWER )
-                {
-                    cl->url     = NULL;
-                    cl->i_state = HTTPD_CLIENT_DEAD;
-                }
-                else if( i_msg == HTTPD_MSG_OPTIONS )
+                if( !strcmp( url->psz_url, query->psz_url ) )
                 {
+                    if( url->catch[i_msg].cb )
+                    {
+                        if( answer && ( *url->psz_user || *url->psz_password ) )
+                        {
+                            /* create the headers */
+                            const char *b64 = httpd_MsgGet( query, "Authorization" ); /* BASIC id */
+                            char *user = NULL, *pass = NULL;
 
-                    answer->i_type   = HTTPD_MSG_ANSWER;
-                    answer->i_proto  = query->i_proto;
-                    answer->i_status = 200;
-                    answer->i_body = 0;
-                    answer->p_body = NULL;
+                            if( b64 != NULL
+                             && !strncasecmp( b64, "BASIC", 5 ) )
+                            {
+                                b64 += 5;
+                                while( *b64 == ' ' )
+                                    b64++;
 
-                    httpd_MsgAdd( answer, "Server", "VLC/%s", VERSION );
-                    httpd_MsgAdd( answer, "Content-Length", "0" );
+                                user = vlc_b64_decode( b64 );
+                                if (user != NULL)
+                                {
+                                    pass = strchr (user, ':');
+                                    if (pass != NULL)
+                                        *pass++ = '\0';
+                                }
+                            }
 
-                    switch( query->i_proto )
-                    {
-                        case HTTPD_PROTO_HTTP:
-                            answer->i_version = 1;
-                            httpd_MsgAdd( answer, "Allow",
-                                          "GET,HEAD,POST,OPTIONS" );
-                            break;
+                            if ((user == NULL) || (pass == NULL)
+                             || strcmp (user, url->psz_user)
+                             || strcmp (pass, url->psz_password))
+                            {
+                                httpd_MsgAdd( answer,
+                                              "WWW-Authenticate",
+                                              "Basic realm=\"VLC stream\"" );
+                                /* We fail for all url */
+                                b_auth_failed = true;
+                                free( user );
+                                break;
+                            }
+
+                            free( user );
+                        }
 
-                        case HTTPD_PROTO_RTSP:
+                        if( !url->catch[i_msg].cb( url->catch[i_msg].p_sys, cl, answer, query ) )
                         {
-                            const char *p;
-                            answer->i_version = 0;
-
-                            p = httpd_MsgGet( query, "Cseq" );
-                            if( p != NULL )
-                                httpd_MsgAdd( answer, "Cseq", "%s", p );
-                            p = httpd_MsgGet( query, "Timestamp" );
-                            if( p != NULL )
-                                httpd_MsgAdd( answer, "Timestamp", "%s", p );
-
-                            p = httpd_MsgGet( query, "Require" );
-                            if( p != NULL )
+                            if( answer->i_proto == HTTPD_PROTO_NONE )
                             {
-                                answer->i_status = 551;
-                                httpd_MsgAdd( query, "Unsupported", "%s", p );
+                                /* Raw answer from a CGI */
+                                cl->i_buffer = cl->i_buffer_size;
                             }
+                            else
+                                cl->i_buffer = -1;
 
-                            httpd_MsgAdd( answer, "Public", "DESCRIBE,SETUP,"
-                                          "TEARDOWN,PLAY,PAUSE,GET_PARAMETER" );
-                            break;
+                            /* only one url can answer */
+                            answer = NULL;
+                            if( cl->url == NULL )
+                            {
+                                cl->url = url;
+                            }
                         }
                     }
-
-                    cl->i_buffer = -1;  /* Force the creation of the answer in
-                                         * httpd_ClientSend */
-                    cl->i_state = HTTPD_CLIENT_SENDING;
                 }
-                else if( i_msg == HTTPD_MSG_NONE )
-                {
-                    if( query->i_proto == HTTPD_PROTO_NONE )
-                    {
-                        cl->url = NULL;
-                        cl->i_state = HTTPD_CLIENT_DEAD;
-                    }
-                    else
-                    {
-                        char *p;
+            }
+            vlc_mutex_unlock( &host->lock );
 
-                        /* unimplemented */
-                        answer->i_proto  = query->i_proto ;
-                        answer->i_type   = HTTPD_MSG_ANSWER;
-                        answer->i_version= 0;
-                        answer->i_status = 501;
+            if( answer )
+            {
+                char *p;
 
-                        answer->i_body = httpd_HtmlError (&p, 501, NULL);
-                        answer->p_body = (uint8_t *)p;
-                        httpd_MsgAdd( answer, "Content-Length", "%d", answer->i_body );
+                answer->i_proto  = query->i_proto;
+                answer->i_type   = HTTPD_MSG_ANSWER;
+                answer->i_version= 0;
 
-                        cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
-                        cl->i_state = HTTPD_CLIENT_SENDING;
-                    }
+                if( b_auth_failed )
+                {
+                    answer->i_status = 401;
                 }
                 else
                 {
-                    bool b_auth_failed = false;
+                    /* no url registered */
+                    answer->i_status = 404;
+                }
 
-                    /* Search the url and trigger callbacks */
-                    for(int i = 0; i < host->i_url; i++ )
-                    {
-                        httpd_url_t *url = host->url[i];
+                answer->i_body = httpd_HtmlError (&p,
+                                                  answer->i_status,
+                                                  query->psz_url);
+                answer->p_body = (uint8_t *)p;
 
-                        if( !strcmp( url->psz_url, query->psz_url ) )
-                        {
-                            if( url->catch[i_msg].cb )
-                            {
-                                if( answer && ( *url->psz_user || *url->psz_password ) )
-                                {
-                                    /* create the headers */
-                                    const char *b64 = httpd_MsgGet( query, "Authorization" ); /* BASIC id */
-                                    char *user = NULL, *pass = NULL;
-
-                                    if( b64 != NULL
-                                     && !strncasecmp( b64, "BASIC", 5 ) )
-                                    {
-                                        b64 += 5;
-                                        while( *b64 == ' ' )
-                                            b64++;
-
-                                        user = vlc_b64_decode( b64 );
-                                        if (user != NULL)
-                                        {
-                                            pass = strchr (user, ':');
-                                            if (pass != NULL)
-                                                *pass++ = '\0';
-                                        }
-                                    }
-
-                                    if ((user == NULL) || (pass == NULL)
-                                     || strcmp (user, url->psz_user)
-                                     || strcmp (pass, url->psz_password))
-                                    {
-                                        httpd_MsgAdd( answer,
-                                                      "WWW-Authenticate",
-                                                      "Basic realm=\"VLC stream\"" );
-                                        /* We fail for all url */
-                                        b_auth_failed = true;
-                                        free( user );
-                                        break;
-                                    }
-
-                                    free( user );
-                                }
+                cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
+                httpd_MsgAdd( answer, "Content-Length", "%d", answer->i_body );
+                httpd_MsgAdd( answer, "Content-Type", "%s", "text/html" );
+            }
 
-                                if( !url->catch[i_msg].cb( url->catch[i_msg].p_sys, cl, answer, query ) )
-                                {
-                                    if( answer->i_proto == HTTPD_PROTO_NONE )
-                                    {
-                                        /* Raw answer from a CGI */
-                                        cl->i_buffer = cl->i_buffer_size;
-                                    }
-                                    else
-                                        cl->i_buffer = -1;
-
-                                    /* only one url can answer */
-                                    answer = NULL;
-                                    if( cl->url == NULL )
-                                    {
-                                        cl->url = url;
-                                    }
-                                }
-                            }
-                        }
-                    }
+            cl->i_state = HTTPD_CLIENT_SENDING;
+        }
+    }
+    else if( cl->i_state == HTTPD_CLIENT_SEND_DONE )
+    {
+        if( !cl->b_stream_mode || cl->answer.i_body_offset == 0 )
+        {
+            const char *psz_connection = httpd_MsgGet( &cl->answer, "Connection" );
+            const char *psz_query = httpd_MsgGet( &cl->query, "Connection" );
+            bool b_connection = false;
+            bool b_keepalive = false;
+            bool b_query = false;
+
+            cl->url = NULL;
+            if( psz_connection )
+            {
+                b_connection = ( strcasecmp( psz_connection, "Close" ) == 0 );
+                b_keepalive = ( strcasecmp( psz_connection, "Keep-Alive" ) == 0 );
+            }
 
-                    if( answer )
-                    {
-                        char *p;
+            if( psz_query )
+            {
+                b_query = ( strcasecmp( psz_query, "Close" ) == 0 );
+            }
 
-                        answer->i_proto  = query->i_proto;
-                        answer->i_type   = HTTPD_MSG_ANSWER;
-                        answer->i_version= 0;
+            if( ( ( cl->query.i_proto == HTTPD_PROTO_HTTP ) &&
+                  ( ( cl->query.i_version == 0 && b_keepalive ) ||
+                    ( cl->query.i_version == 1 && !b_connection ) ) ) ||
+                ( ( cl->query.i_proto == HTTPD_PROTO_RTSP ) &&
+                  !b_query && !b_connection ) )
+            {
+                httpd_MsgClean( &cl->query );
+                httpd_MsgInit( &cl->query );
 
-                        if( b_auth_failed )
-                        {
-                            answer->i_status = 401;
-                        }
-                        else
-                        {
-                            /* no url registered */
-                            answer->i_status = 404;
-                        }
+                cl->i_buffer = 0;
+                cl->i_buffer_size = 1000;
+                free( cl->p_buffer );
+                cl->p_buffer = xmalloc( cl->i_buffer_size );
+                cl->i_state = HTTPD_CLIENT_RECEIVING;
+            }
+            else
+            {
+                cl->i_state = HTTPD_CLIENT_DEAD;
+            }
+            httpd_MsgClean( &cl->answer );
+        }
+        else
+        {
+            int64_t i_offset = cl->answer.i_body_offset;
+            httpd_MsgClean( &cl->answer );
 
-                        answer->i_body = httpd_HtmlError (&p,
-                                                          answer->i_status,
-                                                          query->psz_url);
-                        answer->p_body = (uint8_t *)p;
+            cl->answer.i_body_offset = i_offset;
+            free( cl->p_buffer );
+            cl->p_buffer = NULL;
+            cl->i_buffer = 0;
+            cl->i_buffer_size = 0;
 
-                        cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
-                        httpd_MsgAdd( answer, "Content-Length", "%d", answer->i_body );
-                        httpd_MsgAdd( answer, "Content-Type", "%s", "text/html" );
-                    }
+            cl->i_state = HTTPD_CLIENT_WAITING;
+        }
+    }
+    else if( cl->i_state == HTTPD_CLIENT_WAITING && cl->stream != NULL )
+    {
+        vlc_mutex_lock( &cl->stream->lock );
+        if( httpd_ClientStreamSeek( cl ) > 0 )
+            cl->i_state = HTTPD_CLIENT_STREAMING;
+        vlc_mutex_unlock( &cl->stream->lock );
+    }
+    else if( cl->i_state == HTTPD_CLIENT_WAITING )
+    {
+        int64_t i_offset = cl->answer.i_body_offset;
+        int     i_msg = cl->query.i_type;
 
-                    cl->i_state = HTTPD_CLIENT_SENDING;
-                }
-            }
-            else if( cl->i_state == HTTPD_CLIENT_SEND_DONE )
-            {
-                if( !cl->b_stream_mode || cl->answer.i_body_offset == 0 )
-                {
-                    const char *psz_connection = httpd_MsgGet( &cl->answer, "Connection" );
-                    const char *psz_query = httpd_MsgGet( &cl->query, "Connection" );
-                    bool b_connection = false;
-                    bool b_keepalive = false;
-                    bool b_query = false;
-
-                    cl->url = NULL;
-                    if( psz_connection )
-                    {
-                        b_connection = ( strcasecmp( psz_connection, "Close" ) == 0 );
-                        b_keepalive = ( strcasecmp( psz_connection, "Keep-Alive" ) == 0 );
-                    }
+        httpd_MsgInit( &cl->answer );
+        cl->answer.i_body_offset = i_offset;
 
-                    if( psz_query )
-                    {
-                        b_query = ( strcasecmp( psz_query, "Close" ) == 0 );
-                    }
+        vlc_mutex_lock( &host->lock );
+        cl->url->catch[i_msg].cb( cl->url->catch[i_msg].p_sys, cl,
+                                  &cl->answer, &cl->query );
+        vlc_mutex_unlock( &host->lock );
+        if( cl->answer.i_type != HTTPD_MSG_NONE )
+        {
+            /* we have new data, so re-enter send mode */
+            cl->i_buffer      = 0;
+            cl->p_buffer      = cl->answer.p_body;
+            cl->i_buffer_size = cl->answer.i_body;
+            cl->answer.p_body = NULL;
+            cl->answer.i_body = 0;
+            cl->i_state = HTTPD_CLIENT_SENDING;
+        }
+    }
+}
 
-                    if( ( ( cl->query.i_proto == HTTPD_PROTO_HTTP ) &&
-                          ( ( cl->query.i_version == 0 && b_keepalive ) ||
-                            ( cl->query.i_version == 1 && !b_connection ) ) ) ||
-                        ( ( cl->query.i_proto == HTTPD_PROTO_RTSP ) &&
-                          !b_query && !b_connection ) )
-                    {
-                        httpd_MsgClean( &cl->query );
-                        httpd_MsgInit( &cl->query );
-
-                        cl->i_buffer = 0;
-                        cl->i_buffer_size = 1000;
-                        free( cl->p_buffer );
-                        cl->p_buffer = xmalloc( cl->i_buffer_size );
-                        cl->i_state = HTTPD_CLIENT_RECEIVING;
-                    }
-                    else
-                    {
-                        cl->i_state = HTTPD_CLIENT_DEAD;
-                    }
-                    httpd_MsgClean( &cl->answer );
-                }
-                else
-                {
-                    int64_t i_offset = cl->answer.i_body_offset;
-                    httpd_MsgClean( &cl->answer );
+static void httpd_WorkerAdd( httpd_worker_t *worker, httpd_client_t *cl )
+{
+    TAB_APPEND( worker->i_client, worker->client, cl );
+#ifdef HAVE_SYS_EPOLL_H
+    /* Edge-triggered: the socket readiness is kept in the client until an
+     * operation would block */
+    struct epoll_event ev = {
+        .events = EPOLLIN | EPOLLOUT | EPOLLET,
+        .data.ptr = cl,
+    };
+
+    if( epoll_ctl( worker->epfd, EPOLL_CTL_ADD, cl->fd, &ev ) )
+        cl->i_state = HTTPD_CLIENT_DEAD;
+#endif
+}
 
-                    cl->answer.i_body_offset = i_offset;
-                    free( cl->p_buffer );
-                    cl->p_buffer = NULL;
-                    cl->i_buffer = 0;
-                    cl->i_buffer_size = 0;
+static void httpd_WorkerRemove( httpd_worker_t *worker, httpd_client_t *cl )
+{
+#ifdef HAVE_SYS_EPOLL_H
+    epoll_ctl( worker->epfd, EPOLL_CTL_DEL, cl->fd, NULL );
+#endif
+    httpd_ClientClean( cl );
+    TAB_REMOVE( worker->i_client, worker->client, cl );
+    free( cl );
+}
 
-                    cl->i_state = HTTPD_CLIENT_WAITING;
-                }
+/* Accepts a new connection and hands it over to the next worker */
+static void httpd_HostAccept( httpd_worker_t *worker, int fd, mtime_t now )
+{
+    httpd_host_t *host = worker->host;
+    httpd_client_t *cl;
+
+    /* */
+    fd = vlc_accept (fd, NULL, NULL, true);
+    if (fd == -1)
+        return;
+    setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
+                &(int){ 1 }, sizeof(int));
+
+    vlc_tls_t *p_tls;
+
+    if( host->p_tls != NULL )
+        p_tls = vlc_tls_SessionCreate( host->p_tls, fd, NULL );
+    else
+        p_tls = NULL;
+
+    cl = httpd_ClientNew( fd, p_tls, now );
+
+    httpd_worker_t *target = &host->worker[host->i_worker_next];
+    host->i_worker_next = (host->i_worker_next + 1) % host->i_worker;
+
+    if( target != worker )
+        vlc_mutex_lock( &target->lock );
+    httpd_WorkerAdd( target, cl );
+    if( target != worker )
+        vlc_mutex_unlock( &target->lock );
+}
+
+static void* httpd_WorkerThread( void *data )
+{
+    httpd_worker_t *worker = data;
+    httpd_host_t *host = worker->host;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock( &worker->lock );
+    for( ;; )
+    {
+        mtime_t now = mdate();
+        int timeout = -1;
+
+        /* close dead connection and handle the others */
+        for(int i_client = 0; i_client < worker->i_client; i_client++ )
+        {
+            httpd_client_t *cl = worker->client[i_client];
+            if( cl->i_ref < 0 || ( cl->i_ref == 0 &&
+                ( cl->i_state == HTTPD_CLIENT_DEAD ||
+                  ( cl->i_activity_timeout > 0 &&
+                    cl->i_activity_date+cl->i_activity_timeout < now) ) ) )
+            {
+                httpd_WorkerRemove( worker, cl );
+                i_client--;
+                continue;
             }
-            else if( cl->i_state == HTTPD_CLIENT_WAITING )
+
+            httpd_ClientIO( cl, now );
+            httpd_ClientProcess( host, cl );
+            httpd_ClientIO( cl, now );
+
+            if( cl->i_state == HTTPD_CLIENT_STREAMING )
             {
-                int64_t i_offset = cl->answer.i_body_offset;
-                int     i_msg = cl->query.i_type;
+                /* a blocked client must not keep the data dropped from the
+                 * ring alive */
+                vlc_mutex_lock( &cl->stream->lock );
+                httpd_ClientStreamResync( cl );
+                vlc_mutex_unlock( &cl->stream->lock );
+            }
 
-                httpd_MsgInit( &cl->answer );
-                cl->answer.i_body_offset = i_offset;
+            if( httpd_ClientReady( cl ) )
+                timeout = 0;
+            else if( ( cl->i_state == HTTPD_CLIENT_WAITING
+                    || cl->i_state == HTTPD_CLIENT_STREAMING ) && timeout != 0 )
+                timeout = 20; /* we will wait 20ms (not too big) */
+        }
 
-                cl->url->catch[i_msg].cb( cl->url->catch[i_msg].p_sys, cl,
-                                          &cl->answer, &cl->query );
-                if( cl->answer.i_type != HTTPD_MSG_NONE )
-                {
-                    /* we have new data, so re-enter send mode */
-                    cl->i_buffer      = 0;
-                    cl->p_buffer      = cl->answer.p_body;
-                    cl->i_buffer_size = cl->answer.i_body;
-                    cl->answer.p_body = NULL;
-                    cl->answer.i_body = 0;
-                    cl->i_state = HTTPD_CLIENT_SENDING;
-                }
+#ifdef HAVE_SYS_EPOLL_H
+        vlc_mutex_unlock( &worker->lock );
+        vlc_restorecancel( canc );
+
+        struct epoll_event ev[HTTPD_WORKER_EVENTS];
+        int ret = epoll_wait( worker->epfd, ev, HTTPD_WORKER_EVENTS, timeout );
+
+        canc = vlc_savecancel();
+        vlc_mutex_lock( &worker->lock );
+        if( ret == -1 && errno != EINTR )
+        {
+            /* Kernel on low memory or a bug: pace */
+            msg_Err( host, "polling error: %m" );
+            msleep( 100000 );
+        }
+
+        now = mdate();
+        for( int i = 0; i < ret; i++ )
+        {
+            const int *fd = ev[i].data.ptr;
+
+            if( fd >= host->fds && fd < host->fds + host->nfd )
+            {   /* Handle server sockets (accept new connections) */
+                httpd_HostAccept( worker, *fd, now );
+                continue;
             }
 
-            if (pufd->events != 0)
+            httpd_client_t *cl = ev[i].data.ptr;
+            if( ev[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP) )
+                cl->b_readable = true;
+            if( ev[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP) )
+                cl->b_writable = true;
+        }
+#else
+        struct pollfd ufd[host->nfd + worker->i_client];
+        httpd_client_t *ucl[sizeof (ufd) / sizeof (ufd[0])];
+        unsigned nfd;
+        for( nfd = 0; nfd < host->nfd; nfd++ )
+        {
+            ufd[nfd].fd = host->fds[nfd];
+            ufd[nfd].events = POLLIN;
+            ufd[nfd].revents = 0;
+        }
+
+        /* add all socket that should be read/write */
+        unsigned ncl = 0;
+        for( int i_client = 0; i_client < worker->i_client; i_client++ )
+        {
+            httpd_client_t *cl = worker->client[i_client];
+            struct pollfd *pufd = &ufd[nfd];
+
+            pufd->fd = cl->fd;
+            pufd->events = pufd->revents = 0;
+
+            if( ( cl->i_state == HTTPD_CLIENT_RECEIVING )
+                  || ( cl->i_state == HTTPD_CLIENT_TLS_HS_IN ) )
+                pufd->events = POLLIN;
+            else if( ( cl->i_state == HTTPD_CLIENT_SENDING )
+                  || ( cl->i_state == HTTPD_CLIENT_STREAMING )
+                  || ( cl->i_state == HTTPD_CLIENT_TLS_HS_OUT ) )
+                pufd->events = POLLOUT;
+
+            if( pufd->events != 0 )
+            {
+                ucl[ncl++] = cl;
                 nfd++;
-            else
-                b_low_delay = true;
+            }
         }
-        vlc_mutex_unlock( &host->lock );
+        vlc_mutex_unlock( &worker->lock );
         vlc_restorecancel( canc );
 
-        /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
-        int ret = poll( ufd, nfd, b_low_delay ? 20 : -1 );
+        int ret = poll( ufd, nfd, timeout );
 
         canc = vlc_savecancel();
-        vlc_mutex_lock( &host->lock );
+        vlc_mutex_lock( &worker->lock );
         switch( ret )
         {
             case -1:
@@ -2259,68 +2835,22 @@ static void* httpd_HostThread( void *data )
 
         /* Handle client sockets */
         now = mdate();
-        nfd = host->nfd;
-
-        for( int i_client = 0; i_client < host->i_client; i_client++ )
+        for( unsigned i = 0; i < ncl; i++ )
         {
-            httpd_client_t *cl = host->client[i_client];
-            const struct pollfd *pufd = &ufd[nfd];
-
-            assert( pufd < &ufd[sizeof(ufd) / sizeof(ufd[0])] );
-
-            if( cl->fd != pufd->fd )
-                continue; // we were not waiting for this client
-            ++nfd;
-            if( pufd->revents == 0 )
-                continue; // no event received
-
-            cl->i_activity_date = now;
+            const struct pollfd *pufd = &ufd[host->nfd + i];
+            httpd_client_t *cl = ucl[i];
 
-            if( cl->i_state == HTTPD_CLIENT_RECEIVING )
-            {
-                httpd_ClientRecv( cl );
-            }
-            else if( cl->i_state == HTTPD_CLIENT_SENDING )
-            {
-                httpd_ClientSend( cl );
-            }
-            else if( cl->i_state == HTTPD_CLIENT_TLS_HS_IN
-                  || cl->i_state == HTTPD_CLIENT_TLS_HS_OUT )
-            {
-                httpd_ClientTlsHandshake( cl );
-            }
+            if( pufd->revents & (POLLIN | POLLERR | POLLHUP) )
+                cl->b_readable = true;
+            if( pufd->revents & (POLLOUT | POLLERR | POLLHUP) )
+                cl->b_writable = true;
         }
 
         /* Handle server sockets (accept new connections) */
         for( nfd = 0; nfd < host->nfd; nfd++ )
-        {
-            httpd_client_t *cl;
-            int fd = ufd[nfd].fd;
-
-            assert (fd == host->fds[nfd]);
-
-            if( ufd[nfd].revents == 0 )
-                continue;
-
-            /* */
-            fd = vlc_accept (fd, NULL, NULL, true);
-            if (fd == -1)
-                continue;
-            setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
-                        &(int){ 1 }, sizeof(int));
-
-            vlc_tls_t *p_tls;
-
-            if( host->p_tls != NULL )
-                p_tls = vlc_tls_SessionCreate( host->p_tls, fd, NULL );
-            else
-                p_tls = NULL;
-
-            cl = httpd_ClientNew( fd, p_tls, now );
-
-            TAB_APPEND( host->i_client, host->client, cl );
-        }
+            if( ufd[nfd].revents != 0 )
+                httpd_HostAccept( worker, ufd[nfd].fd, now );
+#endif
     }
-    vlc_mutex_unlock( &host->lock );
     return NULL;
 }
@@ -84,10 +84,125 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void test_block_Pool (void)
+{
+    uint64_t hits, misses, hits2, misses2;
+    block_t *blocks[64];
+
+    for (size_t size = 1; size <= 100000; size *= 3)
+    {
+        for (unsigned i = 0; i < 64; i++)
+        {
+            blocks[i] = block_Alloc (size);
+            assert (blocks[i] != NULL);
+            assert (blocks[i]->i_buffer == size);
+            assert (((uintptr_t)blocks[i]->p_buffer % 16) == 0);
+            assert (blocks[i]->p_buffer - blocks[i]->p_start >= 32);
+            assert (blocks[i]->p_start + blocks[i]->i_size
+                    >= blocks[i]->p_buffer + size + 32);
+            memset (blocks[i]->p_buffer, i, size);
+        }
+        for (unsigned i = 0; i < 64; i++)
+            block_Release (blocks[i]);
+    }
+
+    /* Freshly released blocks must be recycled */
+    block_Release (block_Alloc (188));
+    block_PoolStats (&hits, &misses);
+    for (unsigned i = 0; i < 1000; i++)
+        block_Release (block_Alloc (188));
+    block_Release (block_Alloc (1 << 20));
+    /* Force the thread cache to publish its counters */
+    for (unsigned i = 0; i < 64; i++)
+        blocks[i] = block_Alloc (188);
+    for (unsigned i = 0; i < 64; i++)
+        block_Release (blocks[i]);
+    block_PoolStats (&hits2, &misses2);
+    assert (hits2 - hits >= 1000);
+}
+
+static void test_block_Shared (void)
+{
+    block_t *block = block_Alloc (sizeof (text));
+    assert (block != NULL);
+    memcpy (block->p_buffer, text, sizeof (text));
+    assert (block_shared_Slice (block, 0, 1) == NULL);
+
+    block = block_shared_Alloc (block);
+    assert (block != NULL);
+    assert (block->i_buffer == sizeof (text));
+
+    block_t *slice = block_shared_Slice (block, 5, 2);
+    assert (slice != NULL);
+    assert (slice->i_buffer == 2);
+    assert (!memcmp (slice->p_buffer, "is", 2));
+
+    /* The slice must outlive its parent */
+    block_Release (block);
+    assert (!memcmp (slice->p_buffer, "is", 2));
+    block_Release (slice);
+}
+
+#define FIFO_COUNT 100000
+
+static void *test_fifo_Producer (void *data)
+{
+    block_fifo_t *fifo = data;
+
+    for (unsigned i = 0; i < FIFO_COUNT; i++)
+    {
+        block_t *block = block_Alloc (sizeof (i));
+        assert (block != NULL);
+        memcpy (block->p_buffer, &i, sizeof (i));
+        block_FifoPut (fifo, block);
+        if ((i % 1000) == 0)
+            block_FifoPace (fifo, 100, SIZE_MAX);
+    }
+    return NULL;
+}
+
+static void test_block_FifoSPSC (void)
+{
+    /* Small ring, so that the overflow list is exercised too */
+    block_fifo_t *fifo = block_FifoNewSPSC (16);
+    vlc_thread_t th;
+
+    assert (fifo != NULL);
+    assert (block_FifoCount (fifo) == 0);
+
+    int val = vlc_clone (&th, test_fifo_Producer, fifo,
+                         VLC_THREAD_PRIORITY_LOW);
+    assert (val == 0);
+
+    for (unsigned i = 0; i < FIFO_COUNT; i++)
+    {
+        unsigned n;
+        block_t *block = block_FifoShow (fifo);
+
+        assert (block != NULL);
+        assert (block == block_FifoGet (fifo));
+        memcpy (&n, block->p_buffer, sizeof (n));
+        assert (n == i);
+        block_Release (block);
+    }
+    vlc_join (th, NULL);
+    assert (block_FifoCount (fifo) == 0);
+
+    block_FifoPut (fifo, block_Alloc (10));
+    block_FifoPut (fifo, block_Alloc (20));
+    assert (block_FifoCount (fifo) == 2);
+    block_FifoEmpty (fifo);
+    assert (block_FifoCount (fifo) == 0);
+    block_FifoRelease (fifo);
+}
+
 int main (void)
 {
     test_block_File ();
     test_block ();
+    test_block_Pool ();
+    test_block_Shared ();
+    test_block_FifoSPSC ();
     return 0;
 }
 
@@ -24,19 +24,40 @@
 #ifndef LIBVLC_VOUT_STATISTIC_H
 # define LIBVLC_VOUT_STATISTIC_H
 # include <vlc_atomic.h>
+# include <vlc_input_item.h>
 
 /* NOTE: Both statistics are atomic on their own, so one might be older than
  * the other one. Currently, only one of them is updated at a time, so this
- * is a non-issue. */
+ * is a non-issue. The same goes for the timing ones, which are only updated
+ * by the vout thread. */
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+
+    /* Timing, see vout_timing_t */
+    atomic_uint_fast64_t late[VOUT_TIMING_LATE_BUCKETS];
+    struct {
+        atomic_uint_fast64_t count;
+        atomic_uint_fast64_t total;
+        atomic_uint_fast64_t max;
+    } stage[VOUT_TIMING_STAGES];
+    atomic_uint_fast64_t queue_total;
+    atomic_uint          queue_max;
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    for (unsigned i = 0; i < VOUT_TIMING_LATE_BUCKETS; i++)
+        atomic_init(&stat->late[i], 0);
+    for (unsigned i = 0; i < VOUT_TIMING_STAGES; i++) {
+        atomic_init(&stat->stage[i].count, 0);
+        atomic_init(&stat->stage[i].total, 0);
+        atomic_init(&stat->stage[i].max, 0);
+    }
+    atomic_init(&stat->queue_total, 0);
+    atomic_init(&stat->queue_max, 0);
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -61,4 +82,46 @@ static inline void vout_statistic_AddLost(vout_statistic_t *stat, int lost)
     atomic_fetch_add(&stat->lost, lost);
 }
 
+static inline void vout_statistic_AddStage(vout_statistic_t *stat,
+                                           enum vout_timing_stage_e stage,
+                                           mtime_t duration)
+{
+    atomic_fetch_add(&stat->stage[stage].count, 1);
+    atomic_fetch_add(&stat->stage[stage].total, duration);
+
+    /* Only the vout thread updates it */
+    if ((uint_fast64_t)duration > atomic_load(&stat->stage[stage].max))
+        atomic_store(&stat->stage[stage].max, duration);
+}
+
+/* It accounts for a picture displayed late by the given duration (negative
+ * when it is early) while queue pictures were waiting */
+static inline void vout_statistic_AddTiming(vout_statistic_t *stat,
+                                            mtime_t late, unsigned queue)
+{
+    unsigned bucket = 0;
+    while (bucket < VOUT_TIMING_LATE_BUCKETS - 1 &&
+           late >= (CLOCK_FREQ / 1000) << bucket)
+        bucket++;
+    atomic_fetch_add(&stat->late[bucket], 1);
+
+    atomic_fetch_add(&stat->queue_total, queue);
+    if (queue > atomic_load(&stat->queue_max))
+        atomic_store(&stat->queue_max, queue);
+}
+
+static inline void vout_statistic_GetResetTiming(vout_statistic_t *stat,
+                                                 vout_timing_t *timing)
+{
+    for (unsigned i = 0; i < VOUT_TIMING_LATE_BUCKETS; i++)
+        timing->late[i] = atomic_exchange(&stat->late[i], 0);
+    for (unsigned i = 0; i < VOUT_TIMING_STAGES; i++) {
+        timing->stage[i].count = atomic_exchange(&stat->stage[i].count, 0);
+        timing->stage[i].total = atomic_exchange(&stat->stage[i].total, 0);
+        timing->stage[i].max   = atomic_exchange(&stat->stage[i].max, 0);
+    }
+    timing->queue_total = atomic_exchange(&stat->queue_total, 0);
+    timing->queue_max   = atomic_exchange(&stat->queue_max, 0);
+}
+
 #endif
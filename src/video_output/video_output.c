@@ -291,6 +291,11 @@ void vout_GetResetStatistic(vout_thread_t *vout, int *displayed, int *lost)
     vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
 }
 
+void vout_GetResetTiming(vout_thread_t *vout, vout_timing_t *timing)
+{
+    vout_statistic_GetResetTiming(&vout->p->statistic, timing);
+}
+
 void vout_Flush(vout_thread_t *vout, mtime_t date)
 {
     vout_control_PushTime(&vout->p->control, VOUT_CONTROL_FLUSH, date);
@@ -857,7 +862,10 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool is_
         vout->p->displayed.is_interlaced = !decoded->b_progressive;
         vout->p->displayed.qtype         = decoded->i_qtype;
 
+        const mtime_t filter_start = mdate();
         picture = filter_chain_VideoFilter(vout->p->filter.chain_static, decoded);
+        vout_statistic_AddStage(&vout->p->statistic, VOUT_TIMING_FILTER,
+                                mdate() - filter_start);
     }
 
     vlc_mutex_unlock(&vout->p->filter.lock);
@@ -883,9 +891,12 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     vout_chrono_Start(&vout->p->render);
 
+    const mtime_t filter_start = mdate();
     vlc_mutex_lock(&vout->p->filter.lock);
     picture_t *filtered = filter_chain_VideoFilter(vout->p->filter.chain_interactive, torender);
     vlc_mutex_unlock(&vout->p->filter.lock);
+    vout_statistic_AddStage(&vout->p->statistic, VOUT_TIMING_FILTER,
+                            mdate() - filter_start);
 
     if (!filtered)
         return VLC_EGENERIC;
@@ -957,11 +968,16 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         }
     }
 
+    const mtime_t spu_start = mdate();
     subpicture_t *subpic = spu_Render(vout->p->spu,
                                       subpicture_chromas, &fmt_spu,
                                       &vd->source,
                                       render_subtitle_date, render_osd_date,
                                       do_snapshot);
+    const mtime_t prepare_start = mdate();
+    if (subpic)
+        vout_statistic_AddStage(&vout->p->statistic, VOUT_TIMING_SPU,
+                                prepare_start - spu_start);
     /*
      * Perform rendering
      *
@@ -1029,6 +1045,8 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
             return VLC_EGENERIC;
     }
 
+    vout_statistic_AddStage(&vout->p->statistic, VOUT_TIMING_PREPARE,
+                            mdate() - prepare_start);
     vout_chrono_Stop(&vout->p->render);
 #if 0
         {
@@ -1050,11 +1068,17 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     /* Display the direct buffer returned by vout_RenderPicture */
     vout->p->displayed.date = mdate();
+    if (!is_forced)
+        vout_statistic_AddTiming(&vout->p->statistic,
+                                 vout->p->displayed.date - direct->date,
+                                 picture_fifo_Count(vout->p->decoder_fifo));
     vout_display_Display(vd,
                          sys->display.filtered ? sys->display.filtered
                                                 : direct,
                          subpic);
     sys->display.filtered = NULL;
+    vout_statistic_AddStage(&vout->p->statistic, VOUT_TIMING_DISPLAY,
+                            mdate() - vout->p->displayed.date);
 
     vout_statistic_AddDisplayed(&vout->p->statistic, 1);
 
@@ -25,6 +25,8 @@
 #ifndef LIBVLC_VOUT_CONTROL_H
 #define LIBVLC_VOUT_CONTROL_H 1
 
+#include <vlc_input_item.h>
+
 /**
  * This function will (un)pause the display of pictures.
  * It is thread safe
@@ -41,6 +43,11 @@ void spu_OffsetSubtitleDate( spu_t *p_spu, mtime_t i_duration );
  */
 void vout_GetResetStatistic( vout_thread_t *p_vout, int *pi_displayed, int *pi_lost );
 
+/**
+ * This function will return and reset the rendering timing statistics.
+ */
+void vout_GetResetTiming( vout_thread_t *p_vout, vout_timing_t *p_timing );
+
 /**
  * This function will ensure that all ready/displayed pciture have at most
  * the provided dat
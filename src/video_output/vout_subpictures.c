@@ -51,6 +51,11 @@
 /* Number of simultaneous subpictures */
 #define VOUT_MAX_SUBPICTURES (__MAX(VOUT_MAX_PICTURES, SPU_MAX_PREPARE_TIME/5000))
 
+/* Number of converted/scaled pictures kept per region, so that rendering
+ * alternately at several sizes (snapshots, display/early blending) does not
+ * scale the region again on every frame */
+#define SPU_REGION_CACHE_MAX (3)
+
 /* */
 typedef struct {
     subpicture_t *subpicture;
@@ -661,6 +666,58 @@ static void SpuSelectSubpictures(spu_t *spu,
 
 
 
+/**
+ * It returns the picture of the region already converted and scaled to the
+ * given size and chroma, if any, and makes it the most recently used one.
+ */
+static subpicture_region_private_t *SpuRegionCacheGet(subpicture_region_t *region,
+                                                      unsigned width,
+                                                      unsigned height,
+                                                      vlc_fourcc_t chroma)
+{
+    for (subpicture_region_private_t **ptr = &region->p_private;
+         *ptr != NULL; ptr = &(*ptr)->p_next) {
+        subpicture_region_private_t *private = *ptr;
+
+        if (private->fmt.i_width  != width ||
+            private->fmt.i_height != height ||
+            private->fmt.i_chroma != chroma)
+            continue;
+
+        *ptr = private->p_next;
+        private->p_next   = region->p_private;
+        region->p_private = private;
+        return private;
+    }
+    return NULL;
+}
+
+/**
+ * It stores a converted/scaled picture of the region, dropping the least
+ * recently used ones when needed. It takes ownership of the picture.
+ */
+static subpicture_region_private_t *SpuRegionCachePut(subpicture_region_t *region,
+                                                      picture_t *picture)
+{
+    subpicture_region_private_t *private =
+        subpicture_region_private_New(&picture->format);
+    if (!private) {
+        picture_Release(picture);
+        return NULL;
+    }
+    private->p_picture = picture;
+
+    subpicture_region_private_t **ptr = &region->p_private;
+    for (unsigned i = 0; *ptr != NULL && i < SPU_REGION_CACHE_MAX - 1; i++)
+        ptr = &(*ptr)->p_next;
+    subpicture_region_private_Delete(*ptr);
+    *ptr = NULL;
+
+    private->p_next   = region->p_private;
+    region->p_private = private;
+    return private;
+}
+
 /**
  * It will transform the provided region into another region suitable for rendering.
  */
@@ -785,31 +842,19 @@ static void SpuRenderRegion(spu_t *spu,
         const unsigned dst_width  = spu_scale_w(region->fmt.i_width,  scale_size);
         const unsigned dst_height = spu_scale_h(region->fmt.i_height, scale_size);
 
-        /* Destroy the cache if unusable */
-        if (region->p_private) {
-            subpicture_region_private_t *private = region->p_private;
-            bool is_changed = false;
-
-            /* Check resize changes */
-            if (dst_width  != private->fmt.i_width ||
-                dst_height != private->fmt.i_height)
-                is_changed = true;
-
-            /* Check forced palette changes */
-            if (changed_palette)
-                is_changed = true;
-
-            if (convert_chroma && private->fmt.i_chroma != chroma_list[0])
-                is_changed = true;
+        const vlc_fourcc_t dst_chroma = convert_chroma || using_palette ?
+                                        chroma_list[0] : region->fmt.i_chroma;
 
-            if (is_changed) {
-                subpicture_region_private_Delete(private);
-                region->p_private = NULL;
-            }
+        /* Destroy the cache if unusable */
+        if (changed_palette && region->p_private) {
+            subpicture_region_private_Delete(region->p_private);
+            region->p_private = NULL;
         }
 
         /* Scale if needed into cache */
-        if (!region->p_private && dst_width > 0 && dst_height > 0) {
+        subpicture_region_private_t *private =
+            SpuRegionCacheGet(region, dst_width, dst_height, dst_chroma);
+        if (!private && dst_width > 0 && dst_height > 0) {
             filter_t *scale = sys->scale;
 
             picture_t *picture = region->p_picture;
@@ -859,24 +904,14 @@ static void SpuRenderRegion(spu_t *spu,
             }
 
             /* */
-            if (picture) {
-                region->p_private = subpicture_region_private_New(&picture->format);
-                if (region->p_private) {
-                    region->p_private->p_picture = picture;
-                    if (!region->p_private->p_picture) {
-                        subpicture_region_private_Delete(region->p_private);
-                        region->p_private = NULL;
-                    }
-                } else {
-                    picture_Release(picture);
-                }
-            }
+            if (picture)
+                private = SpuRegionCachePut(region, picture);
         }
 
         /* And use the scaled picture */
-        if (region->p_private) {
-            region_fmt     = region->p_private->fmt;
-            region_picture = region->p_private->p_picture;
+        if (private) {
+            region_fmt     = private->fmt;
+            region_picture = private->p_picture;
         }
     }
 
@@ -914,14 +949,13 @@ static void SpuRenderRegion(spu_t *spu,
         }
     }
 
-    subpicture_region_t *dst = *dst_ptr = subpicture_region_New(&region_fmt);
+    /* The output region only references the (cached) picture */
+    subpicture_region_t *dst = *dst_ptr =
+        subpicture_region_NewFromPicture(&region_fmt, region_picture);
     if (dst) {
         dst->i_x       = x_offset;
         dst->i_y       = y_offset;
         dst->i_align   = 0;
-        if (dst->p_picture)
-            picture_Release(dst->p_picture);
-        dst->p_picture = picture_Hold(region_picture);
         int fade_alpha = 255;
         if (subpic->b_fade) {
             mtime_t fade_start = subpic->i_start + 3 * (subpic->i_stop - subpic->i_start) / 4;
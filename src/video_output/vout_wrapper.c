@@ -173,6 +173,14 @@ void vout_EndWrapper(vout_thread_t *vout)
     vout_thread_sys_t *sys = vout->p;
 
     assert(!sys->display.filtered);
+    if (sys->decoder_pool) {
+        unsigned peak, starved;
+
+        picture_pool_GetStats(sys->decoder_pool, NULL, &peak, &starved);
+        msg_Dbg(vout, "decoder pool: %d pictures, %u used at most, "
+                "%u allocation failures",
+                picture_pool_GetSize(sys->decoder_pool), peak, starved);
+    }
     if (sys->private_pool)
         picture_pool_Delete(sys->private_pool);
 
@@ -0,0 +1,333 @@
+/*****************************************************************************
+ * mp4_sample_table.c: test and benchmark the MP4 chunks timing
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* It checks the sample times of the chunks against the expanded tables,
+ * and compares the opening time and memory with the per chunk copies of
+ * the stts and ctts tables that the demuxer used to make, on the tables of
+ * a 3 hours file. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include "../../../modules/demux/mp4/libmp4.h"
+#include "../../../modules/demux/mp4/sample_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+typedef struct
+{
+    const char *name;
+    uint32_t i_samples;
+    uint32_t i_chunks;
+    mp4_chunk_t *chunk;
+    MP4_Box_data_stts_t stts;
+    MP4_Box_data_ctts_t ctts;
+    bool b_ctts;
+    uint64_t *dts;       /* expanded, one more for the end */
+    int32_t *pts_delta;  /* expanded */
+} track_t;
+
+/* i_per_chunk samples per chunk, i_vfr runs of durations per 1000 samples,
+ * and a B-frames like ctts if b_ctts */
+static void TrackInit( track_t *tk, const char *name, uint32_t i_samples,
+                       uint32_t i_per_chunk, uint32_t i_delta, unsigned i_vfr,
+                       bool b_ctts )
+{
+    tk->name = name;
+    tk->i_samples = i_samples;
+    tk->b_ctts = b_ctts;
+
+    /* chunks of random sizes, some empty */
+    tk->chunk = calloc( 2 * i_samples + 1, sizeof( *tk->chunk ) );
+    assert( tk->chunk != NULL );
+    tk->i_chunks = 0;
+    for( uint32_t i_sample = 0; i_sample < i_samples; tk->i_chunks++ )
+    {
+        mp4_chunk_t *ck = &tk->chunk[tk->i_chunks];
+        uint32_t i_count = rand() % 50 ? 1 + rand() % ( 2 * i_per_chunk ) : 0;
+        ck->i_sample_first = i_sample;
+        ck->i_sample_count = __MIN( i_count, i_samples - i_sample );
+        i_sample += ck->i_sample_count;
+    }
+
+    tk->stts.i_entry_count = 0;
+    tk->stts.i_sample_count = malloc( i_samples * sizeof( uint32_t ) );
+    tk->stts.i_sample_delta = malloc( i_samples * sizeof( uint32_t ) );
+    tk->ctts.i_entry_count = 0;
+    tk->ctts.i_sample_count = malloc( i_samples * sizeof( uint32_t ) );
+    tk->ctts.i_sample_offset = malloc( i_samples * sizeof( int32_t ) );
+    tk->dts = malloc( ( i_samples + 1 ) * sizeof( *tk->dts ) );
+    tk->pts_delta = malloc( i_samples * sizeof( *tk->pts_delta ) );
+    assert( tk->stts.i_sample_count && tk->stts.i_sample_delta &&
+            tk->ctts.i_sample_count && tk->ctts.i_sample_offset &&
+            tk->dts && tk->pts_delta );
+
+    uint64_t i_dts = 0;
+    for( uint32_t i = 0; i < i_samples; )
+    {
+        uint32_t i_count = i_samples - i;
+        if( i_vfr )
+            i_count = __MIN( i_count, 1 + rand() % ( 2000 / i_vfr ) );
+        const uint32_t i_run_delta = i_vfr ? i_delta / 2 + rand() % i_delta
+                                           : i_delta;
+
+        tk->stts.i_sample_count[tk->stts.i_entry_count] = i_count;
+        tk->stts.i_sample_delta[tk->stts.i_entry_count++] = i_run_delta;
+        for( uint32_t j = 0; j < i_count; j++, i++ )
+        {
+            tk->dts[i] = i_dts;
+            i_dts += i_run_delta;
+        }
+    }
+    tk->dts[i_samples] = i_dts;
+
+    /* I P B B P B B ... */
+    for( uint32_t i = 0; i < i_samples; )
+    {
+        static const int32_t offsets[] = { 1, 3, 0, 0 };
+        const int32_t i_offset = offsets[i % 4] * i_delta;
+        uint32_t i_count = 1;
+        while( i + i_count < i_samples && offsets[(i + i_count) % 4] ==
+                                          offsets[i % 4] )
+            i_count++;
+
+        tk->ctts.i_sample_count[tk->ctts.i_entry_count] = i_count;
+        tk->ctts.i_sample_offset[tk->ctts.i_entry_count++] = i_offset;
+        for( uint32_t j = 0; j < i_count; j++, i++ )
+            tk->pts_delta[i] = i_offset;
+    }
+}
+
+static void TrackClean( track_t *tk )
+{
+    free( tk->chunk );
+    free( tk->stts.i_sample_count );
+    free( tk->stts.i_sample_delta );
+    free( tk->ctts.i_sample_count );
+    free( tk->ctts.i_sample_offset );
+    free( tk->dts );
+    free( tk->pts_delta );
+}
+
+static void TrackSetTiming( track_t *tk )
+{
+    uint64_t i_duration;
+
+    assert( !MP4_ChunksSetTiming( tk->chunk, tk->i_chunks, &tk->stts,
+                                  tk->b_ctts ? &tk->ctts : NULL,
+                                  &i_duration ) );
+    assert( i_duration == tk->dts[tk->i_samples] );
+}
+
+static void test_Timing( track_t *tk )
+{
+    TrackSetTiming( tk );
+
+    for( uint32_t i = 0; i < tk->i_chunks; i++ )
+    {
+        const mp4_chunk_t *ck = &tk->chunk[i];
+
+        assert( ck->i_first_dts == tk->dts[ck->i_sample_first] );
+        if( ck->i_sample_count > 0 )
+            assert( ck->i_last_dts ==
+                    tk->dts[ck->i_sample_first + ck->i_sample_count - 1] );
+
+        for( uint32_t j = 0; j <= ck->i_sample_count; j++ )
+        {
+            const uint32_t i_sample = ck->i_sample_first + j;
+            assert( MP4_ChunkGetDTS( ck, j ) == tk->dts[i_sample] );
+
+            int32_t i_delta;
+            if( j == ck->i_sample_count )
+                continue;
+            assert( MP4_ChunkGetPTSDelta( ck, j, &i_delta ) == tk->b_ctts );
+            assert( !tk->b_ctts || i_delta == tk->pts_delta[i_sample] );
+        }
+    }
+
+    /* Every time goes to the sample playing then */
+    for( unsigned n = 0; n < 10000; n++ )
+    {
+        const uint64_t i_time = rand() % ( tk->dts[tk->i_samples] + 1 );
+        const uint32_t i_chunk = MP4_ChunksFind( tk->chunk, tk->i_chunks,
+                                                 i_time );
+        const mp4_chunk_t *ck = &tk->chunk[i_chunk];
+        const uint32_t i_sample = ck->i_sample_first +
+                                  MP4_ChunkFindSample( ck, i_time );
+
+        assert( ck->i_first_dts <= i_time );
+        if( i_sample < tk->i_samples )
+        {
+            assert( i_sample < ck->i_sample_first + ck->i_sample_count );
+            assert( tk->dts[i_sample] <= i_time &&
+                    i_time < tk->dts[i_sample + 1] );
+        }
+        else
+            assert( i_time == tk->dts[tk->i_samples] );
+    }
+}
+
+static void test_Sync( void )
+{
+    uint32_t numbers[100];
+    MP4_Box_data_stss_t stss = { .i_sample_number = numbers };
+
+    for( unsigned n = 0; n < 1000; n++ )
+    {
+        stss.i_entry_count = 1 + rand() % 100;
+        numbers[0] = rand() % 10;
+        for( uint32_t i = 1; i < stss.i_entry_count; i++ )
+            numbers[i] = numbers[i - 1] + 1 + rand() % 30;
+
+        const uint32_t i_sample = rand() % ( numbers[stss.i_entry_count - 1]
+                                             + 10 );
+        uint32_t i_ref = 0;
+        while( i_ref + 1 < stss.i_entry_count &&
+               numbers[i_ref + 1] <= i_sample )
+            i_ref++;
+        assert( MP4_SyncSampleFind( &stss, i_sample ) == i_ref );
+    }
+}
+
+/* The per chunk copies of the runs that were made at the opening, with
+ * their size */
+static size_t Expand( track_t *tk, void **pp_alloc )
+{
+    size_t i_size = 0, i_alloc = 0;
+    uint32_t i_index = 0, i_used = 0;
+
+    for( uint32_t i = 0; i < tk->i_chunks; i++ )
+    {
+        uint32_t i_entry = 0;
+        for( int64_t i_left = tk->chunk[i].i_sample_count; i_left > 0; )
+        {
+            i_left -= tk->stts.i_sample_count[i_index + i_entry];
+            if( i_entry == 0 )
+                i_left += i_used;
+            i_entry++;
+        }
+
+        uint32_t *count = calloc( i_entry, sizeof( uint32_t ) );
+        uint32_t *delta = calloc( i_entry, sizeof( uint32_t ) );
+        assert( i_entry == 0 || ( count != NULL && delta != NULL ) );
+        pp_alloc[i_alloc++] = count;
+        pp_alloc[i_alloc++] = delta;
+        i_size += 2 * i_entry * sizeof( uint32_t );
+
+        uint32_t i_left = tk->chunk[i].i_sample_count;
+        for( uint32_t j = 0; j < i_entry; j++ )
+        {
+            const uint32_t i_run = __MIN( i_left,
+                                  tk->stts.i_sample_count[i_index] - i_used );
+            i_used += i_run;
+            i_left -= i_run;
+            count[j] = i_run;
+            delta[j] = tk->stts.i_sample_delta[i_index];
+            if( i_used >= tk->stts.i_sample_count[i_index] )
+            {
+                i_index++;
+                i_used = 0;
+            }
+        }
+    }
+    /* the ctts copies have about the same size as the stts ones */
+    if( tk->b_ctts )
+        i_size *= 2;
+    /* and the sample sizes */
+    return i_size + tk->i_samples * sizeof( uint32_t );
+}
+
+static void Benchmark( track_t *tk )
+{
+    void **pp_alloc = malloc( 2 * tk->i_chunks * sizeof( *pp_alloc ) );
+    assert( pp_alloc != NULL );
+
+    mtime_t i_start = mdate();
+    const size_t i_size = Expand( tk, pp_alloc );
+    const mtime_t i_expand = mdate() - i_start;
+    for( uint32_t i = 0; i < 2 * tk->i_chunks; i++ )
+        free( pp_alloc[i] );
+    free( pp_alloc );
+
+    i_start = mdate();
+    TrackSetTiming( tk );
+    const mtime_t i_timing = mdate() - i_start;
+
+    printf( "%s: %"PRIu32" samples, %"PRIu32" chunks, %"PRIu32" stts runs\n",
+            tk->name, tk->i_samples, tk->i_chunks, tk->stts.i_entry_count );
+    printf( " copies: %6.1f ms, %zu bytes in %"PRIu32" allocations%s\n",
+            i_expand / 1000., i_size, ( tk->b_ctts ? 4 : 2 ) * tk->i_chunks,
+            tk->b_ctts ? ", ctts ones not timed" : "" );
+    printf( " runs:   %6.1f ms, no allocation\n", i_timing / 1000. );
+
+    /* seeks: chunk then sample */
+    unsigned i_seeks = 0;
+    uint64_t i_sum = 0;
+    i_start = mdate();
+    mtime_t i_duration;
+    do
+    {
+        const uint64_t i_time = rand() % tk->dts[tk->i_samples];
+        const uint32_t i_chunk = MP4_ChunksFind( tk->chunk, tk->i_chunks,
+                                                 i_time );
+        i_sum += MP4_ChunkFindSample( &tk->chunk[i_chunk], i_time );
+        i_seeks++;
+        i_duration = mdate() - i_start;
+    } while( i_duration < CLOCK_FREQ / 10 );
+    printf( " seeks:  %8.0f per second\n",
+            (double)i_seeks * CLOCK_FREQ / i_duration );
+    (void)i_sum;
+}
+
+int main( void )
+{
+    srand( 0 );
+
+    test_Sync();
+
+    track_t tk;
+    TrackInit( &tk, "small cfr", 5000, 4, 1001, 0, false );
+    test_Timing( &tk );
+    TrackClean( &tk );
+    TrackInit( &tk, "small vfr", 5000, 4, 1001, 50, true );
+    test_Timing( &tk );
+    TrackClean( &tk );
+    TrackInit( &tk, "one sample chunks", 5000, 1, 40, 10, true );
+    test_Timing( &tk );
+    TrackClean( &tk );
+
+    /* 3 hours: 25 fps video, interleaved every sample or so, and AAC */
+    TrackInit( &tk, "3h video", 3 * 3600 * 25, 1, 3600, 0, true );
+    Benchmark( &tk );
+    TrackClean( &tk );
+    TrackInit( &tk, "3h vfr video", 3 * 3600 * 25, 1, 3600, 20, true );
+    Benchmark( &tk );
+    TrackClean( &tk );
+    TrackInit( &tk, "3h audio", 3 * 3600 * 48000 / 1024, 12, 1024, 0, false );
+    Benchmark( &tk );
+    TrackClean( &tk );
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+/*****************************************************************************
+ * ts_pid.c: test and benchmark the TS demuxer PID table
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* It compares the sparse PID table of the demuxer with the flat array of
+ * 8192 PIDs it replaced: memory per opened demuxer and PID lookups per
+ * second, on the PIDs of a single and of a multiple program stream. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include "../../../modules/demux/ts_pid.h"
+
+static size_t TableSize(const ts_pid_table_t *table)
+{
+    size_t size = sizeof(*table);
+
+    for (size_t i = 0; i < TS_PID_COUNT / TS_PID_CHUNK_SIZE; i++)
+        if (table->chunk[i] != NULL)
+            size += TS_PID_CHUNK_SIZE * sizeof(ts_pid_t);
+    return size;
+}
+
+static void test_Table(void)
+{
+    ts_pid_table_t table = { { NULL } };
+
+    assert(ts_pid_Next(&table, 0) == NULL);
+
+    ts_pid_t *pid = ts_pid_Get(&table, 0x101);
+    assert(pid->i_pid == 0x101 && !pid->b_valid && !pid->b_seen);
+    pid->b_valid = true;
+    assert(ts_pid_Get(&table, 0x101) == pid);
+
+    /* Only the chunk of the PID is created */
+    assert(ts_pid_Next(&table, 0)->i_pid == 0x100 - 0x100 % TS_PID_CHUNK_SIZE);
+    assert(ts_pid_Next(&table, 0x102)->i_pid == 0x102);
+    assert(ts_pid_Next(&table, 0x100 + TS_PID_CHUNK_SIZE) == NULL);
+
+    ts_pid_t *last = ts_pid_Get(&table, 8191);
+    assert(last->i_pid == 8191);
+    assert(ts_pid_Get(&table, 0x101) == pid && pid->b_valid);
+
+    /* Every created PID once, in order */
+    int count = 0, prev = -1;
+    ts_pid_Foreach(&table, it)
+    {
+        assert(it->i_pid > prev);
+        assert(it == ts_pid_Get(&table, it->i_pid));
+        prev = it->i_pid;
+        count++;
+    }
+    assert(count == 2 * TS_PID_CHUNK_SIZE && prev == 8191);
+    assert(TableSize(&table) == sizeof(table)
+                                + 2 * TS_PID_CHUNK_SIZE * sizeof(ts_pid_t));
+
+    ts_pid_TableClean(&table);
+    assert(ts_pid_Next(&table, 0) == NULL);
+}
+
+/* PIDs of the packets of a stream, with their usual proportions */
+static int *Packets(const int *pids, const unsigned *weights, size_t n,
+                    size_t count)
+{
+    unsigned total = 0;
+    for (size_t i = 0; i < n; i++)
+        total += weights[i];
+
+    int *packets = malloc(count * sizeof(*packets));
+    assert(packets != NULL);
+    for (size_t i = 0; i < count; i++) {
+        unsigned r = rand() % total;
+        size_t j = 0;
+        while (r >= weights[j])
+            r -= weights[j++];
+        packets[i] = pids[j];
+    }
+    return packets;
+}
+
+static void Benchmark(const char *name, const int *pids,
+                      const unsigned *weights, size_t n)
+{
+    enum { COUNT = 1 << 16 };
+    int *packets = Packets(pids, weights, n, COUNT);
+    ts_pid_t *flat = calloc(TS_PID_COUNT, sizeof(*flat));
+    ts_pid_table_t *table = calloc(1, sizeof(*table));
+    assert(flat != NULL && table != NULL);
+
+    for (size_t i = 0; i < n; i++)
+        ts_pid_Get(table, pids[i]);
+
+    const size_t size = TableSize(table);
+    printf("%s: %zu PIDs\n", name, n);
+    printf(" memory: flat %zu bytes, table %zu bytes\n",
+           TS_PID_COUNT * sizeof(*flat), size);
+
+    /* The demuxer marks each PID seen, like here */
+    for (int t = 0; t < 2; t++) {
+        unsigned loops = 0;
+        const mtime_t start = mdate();
+        mtime_t duration;
+        do {
+            if (t == 0)
+                for (size_t i = 0; i < COUNT; i++)
+                    flat[packets[i]].b_seen = true;
+            else
+                for (size_t i = 0; i < COUNT; i++)
+                    ts_pid_Get(table, packets[i])->b_seen = true;
+            loops++;
+            duration = mdate() - start;
+        } while (duration < CLOCK_FREQ / 4);
+
+        printf(" %-6s %8.1f Mpackets/s\n", t == 0 ? "flat" : "table",
+               (double)COUNT * loops * CLOCK_FREQ / duration / 1000000.);
+    }
+
+    /* The lookups did not create any PID */
+    assert(TableSize(table) == size);
+    ts_pid_TableClean(table);
+    free(table);
+    free(flat);
+    free(packets);
+}
+
+int main(void)
+{
+    srand(0);
+
+    test_Table();
+
+    /* PAT, SDT, EIT, TDT, PMT, video, 2 audio, subtitles, padding */
+    static const int spts[] = {
+        0x00, 0x11, 0x12, 0x14, 0x100, 0x101, 0x102, 0x103, 0x104, 0x1fff };
+    static const unsigned spts_weights[] = {
+        1, 1, 2, 1, 1, 800, 40, 40, 5, 20 };
+    Benchmark("single program", spts, spts_weights,
+              sizeof(spts) / sizeof(*spts));
+
+    /* DVB-T like multiplex: 8 programs spread over the PID range */
+    int mpts[4 + 8 * 4 + 1];
+    unsigned mpts_weights[sizeof(mpts) / sizeof(*mpts)];
+    size_t n = 0;
+    static const int psi[] = { 0x00, 0x11, 0x12, 0x14 };
+    for (size_t i = 0; i < 4; i++) {
+        mpts[n] = psi[i];
+        mpts_weights[n++] = 2;
+    }
+    for (int p = 0; p < 8; p++) {
+        const int base = 0x100 + p * 0x3c0;
+        mpts[n] = base;             mpts_weights[n++] = 1;   /* PMT */
+        mpts[n] = base + 0x11;      mpts_weights[n++] = 100; /* video */
+        mpts[n] = base + 0x14;      mpts_weights[n++] = 10;  /* audio */
+        mpts[n] = base + 0x20;      mpts_weights[n++] = 2;   /* teletext */
+    }
+    mpts[n] = 0x1fff;
+    mpts_weights[n++] = 30;
+    Benchmark("multiple programs", mpts, mpts_weights, n);
+
+    return 0;
+}
@@ -0,0 +1,250 @@
+/*****************************************************************************
+ * startcode.c: test and benchmark the 00 00 01 startcode lookup
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Usage: test_modules_packetizer_startcode [elementary stream files...]
+ * Without any file, the benchmark runs on synthetic data. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_block_helper.h>
+#include "../../../modules/packetizer/startcode_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+static const uint8_t startcode[3] = { 0x00, 0x00, 0x01 };
+
+static const struct {
+    const char *name;
+    block_startcode_helper_t helper;
+} helpers[] = {
+    { "bytes",   NULL },
+    { "C",       startcode_FindAnnexB_C },
+    { "words",   startcode_FindAnnexB_Bits },
+#if defined(HAVE_SSE2_INTRINSICS)
+    { "SSE2",    startcode_FindAnnexB_SSE2 },
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+    { "AVX2",    startcode_FindAnnexB_AVX2 },
+#endif
+#if defined(__ARM_NEON__)
+    { "NEON",    startcode_FindAnnexB_NEON },
+#endif
+};
+#define HELPERS (sizeof(helpers) / sizeof(*helpers))
+
+static bool Usable(const char *name)
+{
+#if defined(HAVE_SSE2_INTRINSICS)
+    if (!strcmp(name, "SSE2"))
+        return vlc_CPU_SSE2();
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+    if (!strcmp(name, "AVX2"))
+        return vlc_CPU_AVX2();
+#endif
+#if defined(__ARM_NEON__)
+    if (!strcmp(name, "NEON"))
+        return vlc_CPU_ARM_NEON();
+#endif
+    (void)name;
+    return true;
+}
+
+/* Mostly non null bytes, like compressed data, with some startcodes and
+ * some of their prefixes */
+static void Fill(uint8_t *p, size_t size, unsigned zero_rate)
+{
+    for (size_t i = 0; i < size; i++) {
+        p[i] = 1 + rand() % 255;
+        if (rand() % zero_rate == 0)
+            p[i] = 0;
+        if (rand() % (4 * zero_rate) == 0 && i + 3 <= size) {
+            memcpy(&p[i], startcode, 1 + rand() % 3);
+            i += 2;
+        }
+    }
+}
+
+/* It returns all the startcode offsets of the block chain */
+static size_t FindAll(block_t *chain, block_startcode_helper_t helper,
+                      size_t *offsets, size_t max)
+{
+    block_bytestream_t bs;
+    size_t count = 0;
+    size_t base = 0, offset = 0;
+
+    block_BytestreamInit(&bs);
+    bs.p_chain = bs.p_block = chain;
+
+    /* Skip up to each startcode, as the packetizers do */
+    while (count < max &&
+           !block_FindStartcodeFromOffset(&bs, &offset, startcode, 3, helper)) {
+        offsets[count++] = base + offset;
+        block_SkipBytes(&bs, offset);
+        base += offset;
+        offset = 1;
+    }
+    return count;
+}
+
+static block_t *Split(const uint8_t *data, size_t size, size_t max_block)
+{
+    block_t *chain = NULL;
+    block_t **last = &chain;
+
+    while (size > 0) {
+        size_t len = 1 + rand() % max_block;
+        if (len > size)
+            len = size;
+
+        block_t *block = block_Alloc(len);
+        assert(block != NULL);
+        memcpy(block->p_buffer, data, len);
+        *last = block;
+        last = &block->p_next;
+        data += len;
+        size -= len;
+    }
+    return chain;
+}
+
+static void test_Helpers(void)
+{
+    uint8_t buf[256 + 64];
+
+    /* Every alignment and end, against the reference */
+    for (unsigned n = 0; n < 2000; n++) {
+        Fill(buf, sizeof(buf), 1 + n % 8);
+        const size_t start = rand() % 64;
+        const size_t end = start + rand() % (sizeof(buf) - start);
+
+        const uint8_t *ref = startcode_FindAnnexB_C(&buf[start], &buf[end]);
+        for (size_t h = 1; h < HELPERS; h++) {
+            if (Usable(helpers[h].name))
+                assert(helpers[h].helper(&buf[start], &buf[end]) == ref);
+        }
+    }
+}
+
+static void test_Chains(void)
+{
+    enum { SIZE = 4096, MAX = 4096 };
+    uint8_t *data = malloc(SIZE);
+    size_t *ref = malloc(MAX * sizeof(*ref));
+    size_t *offsets = malloc(MAX * sizeof(*offsets));
+    assert(data != NULL && ref != NULL && offsets != NULL);
+
+    /* Startcodes crossing the block boundaries, blocks smaller than them */
+    for (unsigned n = 0; n < 200; n++) {
+        Fill(data, SIZE, 2 + n % 16);
+        block_t *chain = Split(data, SIZE, 1 + n % 97);
+
+        const size_t count = FindAll(chain, NULL, ref, MAX);
+        for (size_t h = 1; h < HELPERS; h++) {
+            if (!Usable(helpers[h].name))
+                continue;
+            assert(FindAll(chain, helpers[h].helper, offsets, MAX) == count);
+            assert(!memcmp(offsets, ref, count * sizeof(*ref)));
+        }
+        block_ChainRelease(chain);
+    }
+    free(offsets);
+    free(ref);
+    free(data);
+}
+
+static void Benchmark(const char *name, const uint8_t *data, size_t size)
+{
+    /* Packetizer input: demuxed blocks of about a TS payload or PES size */
+    block_t *chain = Split(data, size, 4096);
+    const size_t max = size / 3 + 1;
+    size_t *offsets = malloc(max * sizeof(*offsets));
+    assert(offsets != NULL);
+
+    printf("%s: %zu bytes\n", name, size);
+    for (size_t h = 0; h < HELPERS; h++) {
+        if (!Usable(helpers[h].name))
+            continue;
+
+        unsigned loops = 0;
+        size_t count;
+        const mtime_t start = mdate();
+        mtime_t duration;
+        do {
+            count = FindAll(chain, helpers[h].helper, offsets, max);
+            loops++;
+            duration = mdate() - start;
+        } while (duration < CLOCK_FREQ / 4);
+
+        printf(" %-6s %8.1f MB/s (%zu startcodes)\n", helpers[h].name,
+               (double)size * loops * CLOCK_FREQ / duration / 1000000.,
+               count);
+    }
+    free(offsets);
+    block_ChainRelease(chain);
+}
+
+int main(int argc, char **argv)
+{
+    srand(0);
+
+    test_Helpers();
+    test_Chains();
+
+    if (argc <= 1) {
+        const size_t size = 4 << 20;
+        uint8_t *data = malloc(size);
+        assert(data != NULL);
+        Fill(data, size, 256);
+        Benchmark("synthetic", data, size);
+        free(data);
+    }
+
+    for (int i = 1; i < argc; i++) {
+        FILE *file = fopen(argv[i], "rb");
+        if (file == NULL) {
+            perror(argv[i]);
+            return 1;
+        }
+        fseek(file, 0, SEEK_END);
+        const long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        uint8_t *data = malloc(size > 0 ? size : 1);
+        assert(data != NULL);
+        if (size <= 0 || fread(data, 1, size, file) != (size_t)size) {
+            fprintf(stderr, "%s: cannot read\n", argv[i]);
+            fclose(file);
+            return 1;
+        }
+        fclose(file);
+
+        Benchmark(argv[i], data, size);
+        free(data);
+    }
+    return 0;
+}
@@ -0,0 +1,268 @@
+/*****************************************************************************
+ * yuv_rgb.c: test the YUV to RGB conversion kernels
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#define MODULE_NAME yuv_rgb
+#define MODULE_STRING "yuv_rgb"
+#include "../../../modules/video_chroma/yuv_rgb.c"
+
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+/* Output formats: BGRX, RGBX, XBGR, RV24 both ways, RV16 and RV15 */
+static const struct {
+    vlc_fourcc_t chroma;
+    uint32_t     mask[3];
+} rgb_formats[] = {
+    { VLC_CODEC_RGB32, { 0x00ff0000, 0x0000ff00, 0x000000ff } },
+    { VLC_CODEC_RGB32, { 0x000000ff, 0x0000ff00, 0x00ff0000 } },
+    { VLC_CODEC_RGB32, { 0x0000ff00, 0x00ff0000, 0xff000000 } },
+    { VLC_CODEC_RGB24, { 0xff0000, 0x00ff00, 0x0000ff } },
+    { VLC_CODEC_RGB24, { 0x0000ff, 0x00ff00, 0xff0000 } },
+    { VLC_CODEC_RGB16, { 0xf800, 0x07e0, 0x001f } },
+    { VLC_CODEC_RGB15, { 0x7c00, 0x03e0, 0x001f } },
+};
+
+static const vlc_fourcc_t yuv_chromas[] = {
+    VLC_CODEC_I420, VLC_CODEC_YV12, VLC_CODEC_NV12, VLC_CODEC_I420_10L,
+};
+
+/* Y, U or V (c) sample of the pixel at (x, y): the base value, plus a sweep
+ * through all the values of each component if step is not null */
+static unsigned Sample(const uint8_t base[3], unsigned step,
+                       unsigned c, unsigned x, unsigned y)
+{
+    return (base[c] + step * (c + 1) * (x + 13 * y)) & 0xff;
+}
+
+static void FillYuv(picture_t *pic, vlc_fourcc_t chroma,
+                    const uint8_t base[3], unsigned step)
+{
+    for (int i = 0; i < pic->i_planes; i++) {
+        const plane_t *p = &pic->p[i];
+        /* The whole lines, as the chroma of an odd last pixel is not in the
+         * visible part */
+        unsigned width = p->i_pitch / p->i_pixel_pitch;
+        if (chroma == VLC_CODEC_NV12 && i > 0)
+            width /= 2;
+
+        for (int y = 0; y < p->i_lines; y++) {
+            uint8_t *line = &p->p_pixels[y * p->i_pitch];
+
+            for (unsigned x = 0; x < width; x++) {
+                if (i == 0) {
+                    const unsigned s = Sample(base, step, 0, x, y);
+                    if (chroma == VLC_CODEC_I420_10L) /* low bits dropped */
+                        ((uint16_t *)line)[x] = (s << 2) | ((x + y) & 3);
+                    else
+                        line[x] = s;
+                } else if (chroma == VLC_CODEC_NV12) {
+                    line[2 * x + 0] = Sample(base, step, 1, x, y);
+                    line[2 * x + 1] = Sample(base, step, 2, x, y);
+                } else {
+                    const unsigned c = (chroma == VLC_CODEC_YV12) ? 3 - i : i;
+                    const unsigned s = Sample(base, step, c, x, y);
+                    if (chroma == VLC_CODEC_I420_10L)
+                        ((uint16_t *)line)[x] = s << 2;
+                    else
+                        line[x] = s;
+                }
+            }
+        }
+    }
+}
+
+static uint32_t ReadPixel(const uint8_t *p, unsigned bytes)
+{
+    switch (bytes) {
+    case 2: {
+        uint16_t px;
+        memcpy(&px, p, sizeof(px));
+        return px;
+    }
+    case 3:
+#ifdef WORDS_BIGENDIAN
+        return (p[0] << 16) | (p[1] << 8) | p[2];
+#else
+        return p[0] | (p[1] << 8) | (p[2] << 16);
+#endif
+    default: {
+        uint32_t px;
+        memcpy(&px, p, sizeof(px));
+        return px;
+    }
+    }
+}
+
+/* R, G and B truncated and shifted into their masks */
+static uint32_t PackRgb(const uint32_t mask[3], const uint8_t rgb[3])
+{
+    uint32_t px = 0;
+
+    for (int c = 0; c < 3; c++) {
+        const unsigned bits  = popcount(mask[c]);
+        const unsigned shift = 32 - clz(mask[c]) - bits;
+        px |= (uint32_t)(rgb[c] >> (8 - bits)) << shift;
+    }
+    return px;
+}
+
+/* It converts a YUV picture filled by FillYuv() to the output format f,
+ * with the kernels k */
+static picture_t *ConvertYuv(const yuv_rgb_kernels_t *k, unsigned f,
+                             vlc_fourcc_t chroma,
+                             unsigned width, unsigned height,
+                             const uint8_t base[3], unsigned step,
+                             yuv_rgb_format_t *format)
+{
+    video_format_t src_fmt, dst_fmt;
+    video_format_Setup(&src_fmt, chroma, width, height, 1, 1);
+    video_format_Setup(&dst_fmt, rgb_formats[f].chroma, width, height, 1, 1);
+    dst_fmt.i_rmask = rgb_formats[f].mask[0];
+    dst_fmt.i_gmask = rgb_formats[f].mask[1];
+    dst_fmt.i_bmask = rgb_formats[f].mask[2];
+    video_format_FixRgb(&dst_fmt);
+
+    yuv_rgb_t conv = {
+        .kernels = k,
+        .chroma  = chroma,
+        .width   = width,
+        .height  = height,
+    };
+    assert(!SetupFormat(&conv.format, &dst_fmt));
+    conv.to_rgb = GetLineKernel(k, &conv.format);
+    *format = conv.format;
+
+    picture_t *src = picture_NewFromFormat(&src_fmt);
+    picture_t *dst = picture_NewFromFormat(&dst_fmt);
+    uint8_t *scratch = malloc(YUV_RGB_SCRATCH(width));
+    assert(src != NULL && dst != NULL && scratch != NULL);
+
+    FillYuv(src, chroma, base, step);
+    ConvertLines(&conv, scratch, dst, src, 0, height);
+
+    free(scratch);
+    picture_Release(src);
+    return dst;
+}
+
+/* Known colours of the BT.601 limited range, and the saturated corners */
+static void test_Colors(const yuv_rgb_kernels_t *k)
+{
+    static const struct {
+        uint8_t yuv[3];
+        uint8_t rgb[3];
+    } colors[] = {
+        { {  16, 128, 128 }, {   0,   0,   0 } }, /* black */
+        { { 235, 128, 128 }, { 255, 255, 255 } }, /* white */
+        { { 126, 128, 128 }, { 128, 128, 128 } }, /* grey */
+        { {  81,  90, 240 }, { 254,   0,   0 } }, /* red */
+        { { 145,  54,  34 }, {   0, 255,   1 } }, /* green */
+        { {  41, 240, 110 }, {   0,   0, 255 } }, /* blue */
+        { { 255, 255, 255 }, { 255, 125, 255 } },
+        { {   0,   0,   0 }, {   0, 136,   0 } },
+    };
+
+    for (size_t i = 0; i < sizeof(colors) / sizeof(*colors); i++) {
+        uint8_t rgb[3];
+        YuvToRgb(rgb, colors[i].yuv[0], colors[i].yuv[1], colors[i].yuv[2]);
+        assert(!memcmp(rgb, colors[i].rgb, 3));
+
+        for (size_t f = 0; f < sizeof(rgb_formats) / sizeof(*rgb_formats); f++)
+            for (size_t s = 0; s < sizeof(yuv_chromas) / sizeof(*yuv_chromas); s++) {
+                const unsigned width = 67, height = 3;
+                const uint32_t *mask = rgb_formats[f].mask;
+                const uint32_t expected = PackRgb(mask, colors[i].rgb);
+                yuv_rgb_format_t format;
+                picture_t *dst = ConvertYuv(k, f, yuv_chromas[s], width, height,
+                                            colors[i].yuv, 0, &format);
+
+                for (unsigned y = 0; y < height; y++)
+                    for (unsigned x = 0; x < width; x++) {
+                        const uint8_t *p = &dst->p[0].p_pixels[y * dst->p[0].i_pitch
+                                                               + x * format.bytes];
+                        uint32_t px = ReadPixel(p, format.bytes);
+                        assert((px & (mask[0] | mask[1] | mask[2])) == expected);
+                    }
+                picture_Release(dst);
+            }
+    }
+}
+
+/* The kernels give the same pixels as the C ones, on sweeps of the sample
+ * values, and for every count of pixels left at the end of the lines */
+static void test_Kernels(const yuv_rgb_kernels_t *k)
+{
+    static const uint8_t base[3] = { 0, 64, 192 };
+
+    for (size_t f = 0; f < sizeof(rgb_formats) / sizeof(*rgb_formats); f++)
+        for (size_t s = 0; s < sizeof(yuv_chromas) / sizeof(*yuv_chromas); s++)
+            for (unsigned width = 1; width <= 70; width++) {
+                const unsigned height = 3;
+                yuv_rgb_format_t format;
+                picture_t *ref = ConvertYuv(&kernels_c, f, yuv_chromas[s],
+                                            width, height, base, 3, &format);
+                picture_t *dst = ConvertYuv(k, f, yuv_chromas[s],
+                                            width, height, base, 3, &format);
+
+                for (unsigned y = 0; y < height; y++)
+                    assert(!memcmp(&ref->p[0].p_pixels[y * ref->p[0].i_pitch],
+                                   &dst->p[0].p_pixels[y * dst->p[0].i_pitch],
+                                   width * format.bytes));
+                picture_Release(ref);
+                picture_Release(dst);
+            }
+}
+
+/* The fixed point conversion is within 1 of the exact one */
+static void test_Precision(void)
+{
+    for (int y = 0; y < 256; y++)
+        for (int u = 0; u < 256; u++)
+            for (int v = 0; v < 256; v++) {
+                const double l = 1.164 * (y - 16);
+                const double exact[3] = {
+                    l + 1.596 * (v - 128),
+                    l - 0.392 * (u - 128) - 0.813 * (v - 128),
+                    l + 2.017 * (u - 128),
+                };
+                uint8_t rgb[3];
+
+                YuvToRgb(rgb, y, u, v);
+                for (int c = 0; c < 3; c++) {
+                    const double e = __MIN(__MAX(exact[c], 0.), 255.);
+                    const int rounded = e + .5;
+                    assert(abs(rgb[c] - rounded) <= 1);
+                }
+            }
+}
+
+int main(void)
+{
+    test_Precision();
+    test_Colors(&kernels_c);
+
+    const yuv_rgb_kernels_t *k = GetKernels();
+    if (k == NULL)
+        return 77;
+    test_Colors(k);
+    test_Kernels(k);
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*****************************************************************************
+ * blend.cpp: test the line based blenders against the reference templates
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#define MODULE_NAME blend
+#define MODULE_STRING "blend"
+#include "../../../modules/video_filter/blend.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+static void Randomize(picture_t *picture)
+{
+    for (int i = 0; i < picture->i_planes; i++) {
+        const plane_t *p = &picture->p[i];
+        for (int j = 0; j < p->i_lines * p->i_pitch; j++)
+            p->p_pixels[j] = rand() & 0xff;
+    }
+}
+
+static bool Equal(const picture_t *a, const picture_t *b)
+{
+    for (int i = 0; i < a->i_planes; i++) {
+        for (int y = 0; y < a->p[i].i_visible_lines; y++) {
+            if (memcmp(&a->p[i].p_pixels[y * a->p[i].i_pitch],
+                       &b->p[i].p_pixels[y * b->p[i].i_pitch],
+                       a->p[i].i_visible_pitch))
+                return false;
+        }
+    }
+    return true;
+}
+
+static void test_Blend(const char *name, const blend_kernels_t *k,
+                       vlc_fourcc_t dst_chroma, vlc_fourcc_t src_chroma,
+                       uint32_t rmask, uint32_t gmask, uint32_t bmask)
+{
+    blend_function_t reference = NULL;
+    for (size_t i = 0; i < sizeof(blends) / sizeof(*blends); i++)
+        if (blends[i].dst == dst_chroma && blends[i].src == src_chroma)
+            reference = blends[i].blend;
+    blend_lines_function_t lines = NULL;
+    for (size_t i = 0; i < sizeof(blends_lines) / sizeof(*blends_lines); i++)
+        if (blends_lines[i].dst == dst_chroma && blends_lines[i].src == src_chroma)
+            lines = blends_lines[i].blend;
+    assert(reference != NULL && lines != NULL);
+
+    printf("%s: %4.4s -> %4.4s\n", name,
+           (const char *)&src_chroma, (const char *)&dst_chroma);
+
+    static const struct {
+        unsigned width, height;
+        unsigned x, y;
+    } geometries[] = {
+        { 64, 32,  0,  0 },
+        { 67, 13,  1,  0 },
+        { 67, 13,  0,  1 },
+        { 33, 17,  5,  3 },
+        {  1,  1,  1,  1 },
+        {  3,  2,  2,  7 },
+        {173, 41, 10, 11 },
+    };
+    static const int alphas[] = { 255, 254, 128, 1 };
+
+    for (size_t g = 0; g < sizeof(geometries) / sizeof(*geometries); g++) {
+        const unsigned width  = geometries[g].width;
+        const unsigned height = geometries[g].height;
+        const unsigned x      = geometries[g].x;
+        const unsigned y      = geometries[g].y;
+
+        video_format_t src_fmt, dst_fmt;
+        video_format_Setup(&src_fmt, src_chroma, width, height, 1, 1);
+        video_format_Setup(&dst_fmt, dst_chroma, x + width + 3, y + height + 2, 1, 1);
+        dst_fmt.i_rmask = rmask;
+        dst_fmt.i_gmask = gmask;
+        dst_fmt.i_bmask = bmask;
+        video_format_FixRgb(&dst_fmt);
+        video_format_FixRgb(&src_fmt);
+
+        picture_t *src = picture_NewFromFormat(&src_fmt);
+        picture_t *ref = picture_NewFromFormat(&dst_fmt);
+        picture_t *dst = picture_NewFromFormat(&dst_fmt);
+        assert(src != NULL && ref != NULL && dst != NULL);
+
+        uint8_t *scratch = (uint8_t *)malloc(BLEND_LINES_SCRATCH(width));
+        assert(scratch != NULL);
+
+        for (size_t a = 0; a < sizeof(alphas) / sizeof(*alphas); a++) {
+            Randomize(src);
+            Randomize(ref);
+            picture_CopyPixels(dst, ref);
+
+            reference(CPicture(ref, &dst_fmt, x, y),
+                      CPicture(src, &src_fmt, 0, 0),
+                      width, height, alphas[a]);
+            lines(*k, scratch,
+                  CPicture(dst, &dst_fmt, x, y),
+                  CPicture(src, &src_fmt, 0, 0),
+                  width, height, alphas[a]);
+            assert(Equal(ref, dst));
+        }
+
+        free(scratch);
+        picture_Release(src);
+        picture_Release(ref);
+        picture_Release(dst);
+    }
+}
+
+static void test_Kernels(const char *name, const blend_kernels_t *k)
+{
+    static const vlc_fourcc_t yuv420[] = {
+        VLC_CODEC_I420, VLC_CODEC_J420, VLC_CODEC_YV12,
+        VLC_CODEC_NV12, VLC_CODEC_NV21,
+    };
+    for (size_t i = 0; i < sizeof(yuv420) / sizeof(*yuv420); i++) {
+        test_Blend(name, k, yuv420[i], VLC_CODEC_YUVA, 0, 0, 0);
+        test_Blend(name, k, yuv420[i], VLC_CODEC_RGBA, 0, 0, 0);
+    }
+    /* BGRX, RGBX, and a layout without dedicated SIMD code */
+    test_Blend(name, k, VLC_CODEC_RGB32, VLC_CODEC_RGBA,
+               0x00ff0000, 0x0000ff00, 0x000000ff);
+    test_Blend(name, k, VLC_CODEC_RGB32, VLC_CODEC_RGBA,
+               0x000000ff, 0x0000ff00, 0x00ff0000);
+    test_Blend(name, k, VLC_CODEC_RGB32, VLC_CODEC_RGBA,
+               0x0000ff00, 0x00ff0000, 0xff000000);
+}
+
+int main(void)
+{
+    srand(0);
+
+    test_Kernels("C", &kernels_c);
+#if defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_SSE2())
+        test_Kernels("SSE2", &kernels_sse2);
+#endif
+#if defined(HAVE_AVX2_INTRINSICS) && defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_AVX2())
+        test_Kernels("AVX2", &kernels_avx2);
+#endif
+#if defined(__ARM_NEON__)
+    if (vlc_CPU_ARM_NEON())
+        test_Kernels("NEON", &kernels_neon);
+#endif
+    return 0;
+}